@@ -8,6 +8,7 @@
 \*---------------------------------------------------------*/
 
 #include "DDPController.h"
+#include "RGBControllerIdleMonitor.h"
 #include "LogManager.h"
 #include <cstring>
 #include <algorithm>
@@ -33,6 +34,7 @@ DDPController::DDPController(const std::vector<DDPDevice>& device_list)
 DDPController::~DDPController()
 {
     keepalive_thread_run = false;
+    RGBControllerIdleMonitor::get()->Wake();
     if(keepalive_thread.joinable())
     {
         keepalive_thread.join();
@@ -243,7 +245,22 @@ void DDPController::KeepaliveThreadFunction()
 {
     while(keepalive_thread_run)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        /*-----------------------------------------------------*\
+        | Poll every 100ms, or sleep until the keepalive is due |
+        | while output is idle                                  |
+        \*-----------------------------------------------------*/
+        std::chrono::steady_clock::time_point due_time = std::chrono::steady_clock::time_point::max();
+
+        {
+            std::lock_guard<std::mutex> lock(last_update_mutex);
+
+            if(keepalive_time_ms != 0 && !last_colors.empty())
+            {
+                due_time = last_update_time + std::chrono::milliseconds(keepalive_time_ms);
+            }
+        }
+
+        RGBControllerIdleMonitor::get()->WaitKeepalive(std::chrono::milliseconds(100), due_time, keepalive_thread_run);
 
         if(keepalive_time_ms == 0)
             continue;
@@ -12,6 +12,7 @@
 #include <math.h>
 #include "LogManager.h"
 #include "RGBController_DMX.h"
+#include "RGBControllerIdleMonitor.h"
 
 using namespace std::chrono_literals;
 
@@ -104,6 +105,7 @@ RGBController_DMX::~RGBController_DMX()
     if(keepalive_thread != nullptr)
     {
         keepalive_thread_run = 0;
+        RGBControllerIdleMonitor::get()->Wake();
         keepalive_thread->join();
         delete keepalive_thread;
     }
@@ -221,12 +223,23 @@ void RGBController_DMX::DeviceUpdateMode()
 
 void RGBController_DMX::KeepaliveThreadFunction()
 {
+    std::chrono::steady_clock::duration keepalive_due = std::chrono::duration_cast<std::chrono::steady_clock::duration>(keepalive_delay * 0.95f);
+
     while(keepalive_thread_run.load())
     {
-        if((std::chrono::steady_clock::now() - last_update_time) > ( keepalive_delay * 0.95f ) )
+        std::chrono::steady_clock::time_point due_time = last_update_time + keepalive_due;
+
+        if(std::chrono::steady_clock::now() > due_time)
         {
             UpdateLEDs();
+
+            due_time = std::chrono::steady_clock::now() + keepalive_due;
         }
-        std::this_thread::sleep_for(keepalive_delay / 2);
+
+        /*-----------------------------------------------------*\
+        | Poll every half keepalive delay, or sleep until the   |
+        | keepalive is due while output is idle                 |
+        \*-----------------------------------------------------*/
+        RGBControllerIdleMonitor::get()->WaitKeepalive(keepalive_delay / 2, due_time, keepalive_thread_run);
     }
 }
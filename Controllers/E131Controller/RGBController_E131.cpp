@@ -11,7 +11,11 @@
 
 #include <e131.h>
 #include <math.h>
+#include <algorithm>
+#include <cstring>
 #include "RGBController_E131.h"
+#include "RGBControllerIdleMonitor.h"
+#include "RGBColorKernels.h"
 
 using namespace std::chrono_literals;
 
@@ -313,6 +317,7 @@ RGBController_E131::~RGBController_E131()
     if(keepalive_thread != nullptr)
     {
         keepalive_thread_run = 0;
+        RGBControllerIdleMonitor::get()->Wake();
         keepalive_thread->join();
         delete keepalive_thread;
     }
@@ -382,6 +387,8 @@ void RGBController_E131::DeviceUpdateLEDs()
 {
     int color_idx = 0;
 
+    const std::vector<RGBColor>& frame = GetFrame();
+
     last_update_time = std::chrono::steady_clock::now();
 
     for(std::size_t device_idx = 0; device_idx < devices.size(); device_idx++)
@@ -389,9 +396,16 @@ void RGBController_E131::DeviceUpdateLEDs()
         float universe_size = (float)devices[device_idx].universe_size;
         unsigned int total_universes = (unsigned int)ceil( ( ( devices[device_idx].num_leds * 3 ) + devices[device_idx].start_channel ) / universe_size );
         unsigned int channel_idx = devices[device_idx].start_channel;
-        unsigned int led_idx = 0;
-        unsigned int rgb_idx = 0;
-        bool         done = false;
+        unsigned int byte_idx = 0;
+        unsigned int byte_count = devices[device_idx].num_leds * 3;
+
+        /*-------------------------------------------------*\
+        | Pack this device's colors into channel data once, |
+        | then copy it into each universe in blocks         |
+        \*-------------------------------------------------*/
+        channel_buf.resize(byte_count);
+
+        PackRGBColors(channel_buf.data(), frame.data() + color_idx, devices[device_idx].num_leds, RGB_ORDER_RGB);
 
         for (unsigned int univ_idx = 0; univ_idx < total_universes; univ_idx++)
         {
@@ -399,40 +413,21 @@ void RGBController_E131::DeviceUpdateLEDs()
 
             for(std::size_t packet_idx = 0; packet_idx < packets.size(); packet_idx++)
             {
-                if(!done && (universes[packet_idx] == universe))
+                if((byte_idx < byte_count) && (universes[packet_idx] == universe) && (channel_idx <= universe_size))
                 {
-                    while(!done && (channel_idx <= universe_size))
-                    {
-                        switch(rgb_idx)
-                        {
-                            case 0:
-                                packets[packet_idx].dmp.prop_val[channel_idx] = RGBGetRValue( colors[color_idx] );
-                                rgb_idx = 1;
-                                break;
-                            case 1:
-                                packets[packet_idx].dmp.prop_val[channel_idx] = RGBGetGValue( colors[color_idx] );
-                                rgb_idx = 2;
-                                break;
-                            case 2:
-                                packets[packet_idx].dmp.prop_val[channel_idx] = RGBGetBValue( colors[color_idx] );
-                                rgb_idx = 0;
-                                led_idx++;
-                                color_idx++;
-                                break;
-                        }
+                    unsigned int copy_size = std::min(byte_count - byte_idx, (unsigned int)universe_size - channel_idx + 1);
 
-                        if(led_idx >= devices[device_idx].num_leds)
-                        {
-                            done = true;
-                        }
+                    memcpy(&packets[packet_idx].dmp.prop_val[channel_idx], &channel_buf[byte_idx], copy_size);
 
-                        channel_idx++;
-                    }
+                    byte_idx    += copy_size;
+                    channel_idx += copy_size;
                 }
             }
 
             channel_idx = 1;
         }
+
+        color_idx += byte_idx / 3;
     }
 
     for(std::size_t packet_idx = 0; packet_idx < packets.size(); packet_idx++)
@@ -459,12 +454,23 @@ void RGBController_E131::DeviceUpdateMode()
 
 void RGBController_E131::KeepaliveThreadFunction()
 {
+    std::chrono::steady_clock::duration keepalive_due = std::chrono::duration_cast<std::chrono::steady_clock::duration>(keepalive_delay * 0.95f);
+
     while(keepalive_thread_run.load())
     {
-        if((std::chrono::steady_clock::now() - last_update_time) > ( keepalive_delay * 0.95f ) )
+        std::chrono::steady_clock::time_point due_time = last_update_time + keepalive_due;
+
+        if(std::chrono::steady_clock::now() > due_time)
         {
             UpdateLEDs();
+
+            due_time = std::chrono::steady_clock::now() + keepalive_due;
         }
-        std::this_thread::sleep_for(keepalive_delay / 2);
+
+        /*-----------------------------------------------------*\
+        | Poll every half keepalive delay, or sleep until the   |
+        | keepalive is due while output is idle                 |
+        \*-----------------------------------------------------*/
+        RGBControllerIdleMonitor::get()->WaitKeepalive(keepalive_delay / 2, due_time, keepalive_thread_run);
     }
 }
@@ -81,6 +81,7 @@ private:
     std::vector<e131_packet_t> 	packets;
 	std::vector<e131_addr_t> 	dest_addrs;
 	std::vector<unsigned int> 	universes;
+    std::vector<unsigned char>  channel_buf;
 	int 						sockfd;
     std::thread *               keepalive_thread;
     std::atomic<bool>           keepalive_thread_run;
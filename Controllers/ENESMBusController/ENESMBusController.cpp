@@ -11,6 +11,7 @@
 
 #include <cstring>
 #include "ENESMBusController.h"
+#include "RGBColorKernels.h"
 #include "LogManager.h"
 
 static const char* ene_channels[] =                 /* ENE channel strings                  */
@@ -423,66 +424,70 @@ void ENESMBusController::SaveMode()
     ENERegisterWrite(ENE_REG_APPLY, ENE_SAVE_VAL);
 }
 
-void ENESMBusController::SetAllColorsDirect(RGBColor* colors)
+void ENESMBusController::SetAllColorsDirect(const RGBColor* colors)
 {
-    unsigned char* color_buf   = new unsigned char[led_count * 3];
-    unsigned int   bytes_sent  = 0;
-
-    for(unsigned int i = 0; i < (led_count * 3); i += 3)
-    {
-        color_buf[i + 0] = RGBGetRValue(colors[i / 3]);
-        color_buf[i + 1] = RGBGetBValue(colors[i / 3]);
-        color_buf[i + 2] = RGBGetGValue(colors[i / 3]);
-    }
+    SetColorsDirect(colors, 0, led_count);
+}
 
-    while(bytes_sent < (led_count * 3))
-    {
-        int bytes_to_send = (led_count * 3) - bytes_sent;
+void ENESMBusController::SetAllColorsEffect(const RGBColor* colors)
+{
+    SetColorsEffect(colors, 0, led_count);
+}
 
-        if(bytes_to_send > interface->GetMaxBlock())
-        {
-            bytes_to_send = interface->GetMaxBlock();
-        }
+int ENESMBusController::SetColorsDirect(const RGBColor* colors, unsigned int start, unsigned int count)
+{
+    return(WriteColorBlock(direct_reg, colors, start, count));
+}
 
-        ENERegisterWriteBlock(direct_reg + bytes_sent, &color_buf[bytes_sent], bytes_to_send);
+int ENESMBusController::SetColorsEffect(const RGBColor* colors, unsigned int start, unsigned int count)
+{
+    int result = WriteColorBlock(effect_reg, colors, start, count);
 
-        bytes_sent += bytes_to_send;
-    }
+    ENERegisterWrite(ENE_REG_APPLY, ENE_APPLY_VAL);
 
-    delete[] color_buf;
+    return(result);
 }
 
-void ENESMBusController::SetAllColorsEffect(RGBColor* colors)
+int ENESMBusController::WriteColorBlock(ene_register reg, const RGBColor* colors, unsigned int start, unsigned int count)
 {
-    unsigned char* color_buf   = new unsigned char[led_count * 3];
+    unsigned char* color_buf   = new unsigned char[count * 3];
     unsigned int   bytes_sent  = 0;
+    int            result      = 0;
 
-    for(unsigned int i = 0; i < (led_count * 3); i += 3)
-    {
-        color_buf[i + 0] = RGBGetRValue(colors[i / 3]);
-        color_buf[i + 1] = RGBGetBValue(colors[i / 3]);
-        color_buf[i + 2] = RGBGetGValue(colors[i / 3]);
-    }
+    PackRGBColors(color_buf, &colors[start], count, RGB_ORDER_RBG);
 
-    while(bytes_sent < (led_count * 3))
+    while(bytes_sent < (count * 3))
     {
-        int bytes_to_send = (led_count * 3) - bytes_sent;
+        int bytes_to_send = (count * 3) - bytes_sent;
 
         if(bytes_to_send > interface->GetMaxBlock())
         {
             bytes_to_send = interface->GetMaxBlock();
         }
 
-        ENERegisterWriteBlock(effect_reg + bytes_sent, &color_buf[bytes_sent], bytes_to_send);
+        result = ENERegisterWriteBlock(reg + (3 * start) + bytes_sent, &color_buf[bytes_sent], bytes_to_send);
+
+        /*-----------------------------------------------------*\
+        | Stop at the first failed block, the rest of the range |
+        | is resent in full with the next frame                 |
+        \*-----------------------------------------------------*/
+        if(result < 0)
+        {
+            break;
+        }
 
         bytes_sent += bytes_to_send;
     }
 
-    ENERegisterWrite(ENE_REG_APPLY, ENE_APPLY_VAL);
-
     delete[] color_buf;
-}
 
+    if(result < 0)
+    {
+        return(result);
+    }
+
+    return((int)bytes_sent);
+}
 
 void ENESMBusController::SetDirect(unsigned char direct)
 {
@@ -537,7 +542,7 @@ void ENESMBusController::ENERegisterWrite(ene_register reg, unsigned char val)
     interface->ENERegisterWrite(dev, reg, val);
 }
 
-void ENESMBusController::ENERegisterWriteBlock(ene_register reg, unsigned char * data, unsigned char sz)
+int ENESMBusController::ENERegisterWriteBlock(ene_register reg, unsigned char * data, unsigned char sz)
 {
-    interface->ENERegisterWriteBlock(dev, reg, data, sz);
+    return(interface->ENERegisterWriteBlock(dev, reg, data, sz));
 }
@@ -117,8 +117,10 @@ public:
     unsigned char GetLEDGreenEffect(unsigned int led);
     unsigned char GetLEDBlueEffect(unsigned int led);
     void          SaveMode();
-    void          SetAllColorsDirect(RGBColor* colors);
-    void          SetAllColorsEffect(RGBColor* colors);
+    void          SetAllColorsDirect(const RGBColor* colors);
+    void          SetAllColorsEffect(const RGBColor* colors);
+    int           SetColorsDirect(const RGBColor* colors, unsigned int start, unsigned int count);
+    int           SetColorsEffect(const RGBColor* colors, unsigned int start, unsigned int count);
     void          SetDirect(unsigned char direct);
     void          SetLEDColorDirect(unsigned int led, unsigned char red, unsigned char green, unsigned char blue);
     void          SetLEDColorEffect(unsigned int led, unsigned char red, unsigned char green, unsigned char blue);
@@ -129,7 +131,7 @@ public:
 
     unsigned char ENERegisterRead(ene_register reg);
     void          ENERegisterWrite(ene_register reg, unsigned char val);
-    void          ENERegisterWriteBlock(ene_register reg, unsigned char * data, unsigned char sz);
+    int           ENERegisterWriteBlock(ene_register reg, unsigned char * data, unsigned char sz);
 
 private:
     char                    device_version[16];
@@ -143,4 +145,6 @@ private:
     bool                    supports_mode_14;
     std::string             name;
     device_type             type;
+
+    int           WriteColorBlock(ene_register reg, const RGBColor* colors, unsigned int start, unsigned int count);
 };
@@ -37,5 +37,5 @@ public:
     virtual int                 GetMaxBlock() = 0;
     virtual unsigned char       ENERegisterRead(ene_dev_id dev, ene_register reg) = 0;
     virtual void                ENERegisterWrite(ene_dev_id dev, ene_register reg, unsigned char val) = 0;
-    virtual void                ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz) = 0;
+    virtual int                 ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz) = 0;
 };
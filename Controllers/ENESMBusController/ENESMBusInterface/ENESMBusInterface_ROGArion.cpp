@@ -51,12 +51,19 @@ void ENESMBusInterface_ROGArion::ENERegisterWrite(ene_dev_id /*dev*/, ene_regist
     SendPacket(reg, &val, sizeof(unsigned char));
 }
 
-void ENESMBusInterface_ROGArion::ENERegisterWriteBlock(ene_dev_id /*dev*/, ene_register reg, unsigned char * data, unsigned char sz)
+int ENESMBusInterface_ROGArion::ENERegisterWriteBlock(ene_dev_id /*dev*/, ene_register reg, unsigned char * data, unsigned char sz)
 {
-    SendPacket(reg, data, sz);
+    int result = SendPacket(reg, data, sz);
+
+    if(result < 0)
+    {
+        return(result);
+    }
+
+    return(sz);
 }
 
-void ENESMBusInterface_ROGArion::SendPacket
+int ENESMBusInterface_ROGArion::SendPacket
     (
     ene_register    reg,
     unsigned char * packet,
@@ -92,5 +99,5 @@ void ENESMBusInterface_ROGArion::SendPacket
     /*-----------------------------------------------------------------------------*\
     | Write SCSI packet                                                             |
     \*-----------------------------------------------------------------------------*/
-    scsi_write(scsi_dev, packet, packet_sz, cdb, 16, sense, 32);
+    return(scsi_write(scsi_dev, packet, packet_sz, cdb, 16, sense, 32));
 }
@@ -25,13 +25,13 @@ public:
     int                 GetMaxBlock();
     unsigned char       ENERegisterRead(ene_dev_id dev, ene_register reg);
     void                ENERegisterWrite(ene_dev_id dev, ene_register reg, unsigned char val);
-    void                ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz);
+    int                 ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz);
 
 private:
     scsi_device*    scsi_dev;
     std::string     path;
 
-    void SendPacket
+    int SendPacket
         (
         ene_register    reg,
         unsigned char * packet,
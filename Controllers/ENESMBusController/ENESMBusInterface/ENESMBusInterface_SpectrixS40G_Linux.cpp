@@ -187,7 +187,7 @@ void ENESMBusInterface_SpectrixS40G::ENERegisterWrite(ene_dev_id dev, ene_regist
 
 }
 
-void ENESMBusInterface_SpectrixS40G::ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz)
+int ENESMBusInterface_SpectrixS40G::ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz)
 {
   	struct nvme_passthru_cmd cfg;
 
@@ -206,10 +206,16 @@ void ENESMBusInterface_SpectrixS40G::ENERegisterWriteBlock(ene_dev_id dev, ene_r
     /*-----------------------------------------------------------------------------*\
     | Send the command to the device                                                |
     \*-----------------------------------------------------------------------------*/
-    nvme_admin_passthru(nvme_fd, cfg.opcode, cfg.flags, cfg.rsvd1,
+    int err = nvme_admin_passthru(nvme_fd, cfg.opcode, cfg.flags, cfg.rsvd1,
 				cfg.nsid, cfg.cdw2, cfg.cdw3, cfg.cdw10,
 				cfg.cdw11, cfg.cdw12, cfg.cdw13, cfg.cdw14,
 				cfg.cdw15, cfg.data_len, data, cfg.metadata_len,
 				metadata, cfg.timeout_ms, &result);
 
+    if(err != 0)
+    {
+        return(-1);
+    }
+
+    return(sz);
 }
@@ -24,7 +24,7 @@ public:
     int                 GetMaxBlock();
     unsigned char       ENERegisterRead(ene_dev_id dev, ene_register reg);
     void                ENERegisterWrite(ene_dev_id dev, ene_register reg, unsigned char val);
-    void                ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz);
+    int                 ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz);
 
 private:
     int         nvme_fd;
@@ -188,7 +188,7 @@ void ENESMBusInterface_SpectrixS40G::ENERegisterWrite(ene_dev_id dev, ene_regist
     }
 }
 
-void ENESMBusInterface_SpectrixS40G::ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz)
+int ENESMBusInterface_SpectrixS40G::ENERegisterWriteBlock(ene_dev_id dev, ene_register reg, unsigned char * data, unsigned char sz)
 {
     if(nvme_fd != INVALID_HANDLE_VALUE)
     {
@@ -256,6 +256,11 @@ void ENESMBusInterface_SpectrixS40G::ENERegisterWriteBlock(ene_dev_id dev, ene_r
         /*-----------------------------------------------------------------------------*\
         | Send the STORAGE_PROTOCOL_COMMAND to the device                               |
         \*-----------------------------------------------------------------------------*/
-        DeviceIoControl(nvme_fd, IOCTL_STORAGE_PROTOCOL_COMMAND, buffer, sizeof(buffer), buffer, sizeof(buffer), 0x0, (LPOVERLAPPED)0x0);
+        if(DeviceIoControl(nvme_fd, IOCTL_STORAGE_PROTOCOL_COMMAND, buffer, sizeof(buffer), buffer, sizeof(buffer), 0x0, (LPOVERLAPPED)0x0))
+        {
+            return(sz);
+        }
     }
+
+    return(-1);
 }
@@ -14,6 +14,12 @@
 #include "SettingsManager.h"
 #include "ResourceManager.h"
 
+/*---------------------------------------------------------*\
+| Dirty ranges separated by at most this many unchanged     |
+| LEDs are sent as a single block write                     |
+\*---------------------------------------------------------*/
+#define ENE_DIRTY_RANGE_MERGE_GAP   2
+
 /**------------------------------------------------------------------*\
     @name ENE SMBus Device
     @category RAM,Motherboard,GPU,Storage
@@ -57,6 +63,12 @@ RGBController_ENESMBus::RGBController_ENESMBus(ENESMBusController * controller_p
     location                    = controller->GetLocation();
     type                        = controller->GetType();
 
+    /*---------------------------------------------------------*\
+    | SMBus transfers are slow, so only send the LEDs that      |
+    | changed since the last update                             |
+    \*---------------------------------------------------------*/
+    flags                      |= CONTROLLER_FLAG_DIRTY_TRACKING;
+
     if((version.find("DIMM_LED") != std::string::npos) || (version.find("AUDA") != std::string::npos) )
     {
         vendor                  = "ENE";
@@ -289,23 +301,67 @@ int RGBController_ENESMBus::GetDeviceMode()
 
 void RGBController_ENESMBus::DeviceUpdateLEDs()
 {
-    if(GetMode() == 0)
+    const std::vector<RGBColor>&    frame           = GetFrame();
+    std::vector<led_range>          dirty_ranges    = GetDirtyRanges();
+    std::vector<led_range>          write_ranges;
+
+    /*---------------------------------------------------------*\
+    | Each block write costs a register address write and a     |
+    | block header on the bus, so resending a few unchanged     |
+    | LEDs between two dirty ranges is cheaper than starting a  |
+    | new write                                                 |
+    \*---------------------------------------------------------*/
+    for(std::size_t range_idx = 0; range_idx < dirty_ranges.size(); range_idx++)
     {
-        controller->SetAllColorsDirect(&colors[0]);
+        if(write_ranges.size() > 0)
+        {
+            led_range&      last_range  = write_ranges.back();
+            unsigned int    last_end    = last_range.start_idx + last_range.leds_count;
+
+            if((dirty_ranges[range_idx].start_idx - last_end) <= ENE_DIRTY_RANGE_MERGE_GAP)
+            {
+                last_range.leds_count = (dirty_ranges[range_idx].start_idx + dirty_ranges[range_idx].leds_count) - last_range.start_idx;
+                continue;
+            }
+        }
+
+        write_ranges.push_back(dirty_ranges[range_idx]);
     }
-    else
+
+    for(std::size_t range_idx = 0; range_idx < write_ranges.size(); range_idx++)
     {
-        controller->SetAllColorsEffect(&colors[0]);
-    }
+        int result;
+
+        if(GetMode() == 0)
+        {
+            result = controller->SetColorsDirect(frame.data(), write_ranges[range_idx].start_idx, write_ranges[range_idx].leds_count);
+        }
+        else
+        {
+            result = controller->SetColorsEffect(frame.data(), write_ranges[range_idx].start_idx, write_ranges[range_idx].leds_count);
+        }
 
+        ReportWriteResult(result);
+
+        /*-----------------------------------------------------*\
+        | A failed write leaves the device out of step with     |
+        | the last frame, which is then resent in full          |
+        \*-----------------------------------------------------*/
+        if(result < 0)
+        {
+            break;
+        }
+    }
 }
 
 void RGBController_ENESMBus::UpdateZoneLEDs(int zone)
 {
+    const std::vector<RGBColor>& frame = GetFrame();
+
     for(std::size_t led_idx = 0; led_idx < zones[zone].leds_count; led_idx++)
     {
         int           led   = zones[zone].leds[led_idx].value;
-        RGBColor      color = colors[led];
+        RGBColor      color = frame[led];
         unsigned char red   = RGBGetRValue(color);
         unsigned char grn   = RGBGetGValue(color);
         unsigned char blu   = RGBGetBValue(color);
@@ -319,11 +375,13 @@ void RGBController_ENESMBus::UpdateZoneLEDs(int zone)
             controller->SetLEDColorEffect(led, red, grn, blu);
         }
     }
+
+    InvalidateFrame();
 }
 
 void RGBController_ENESMBus::UpdateSingleLED(int led)
 {
-    RGBColor color    = colors[led];
+    RGBColor color    = GetFrame()[led];
     unsigned char red = RGBGetRValue(color);
     unsigned char grn = RGBGetGValue(color);
     unsigned char blu = RGBGetBValue(color);
@@ -336,6 +394,8 @@ void RGBController_ENESMBus::UpdateSingleLED(int led)
     {
         controller->SetLEDColorEffect(led, red, grn, blu);
     }
+
+    InvalidateFrame();
 }
 
 void RGBController_ENESMBus::SetupZones()
@@ -79,6 +79,13 @@ RGBController_MSIMysticLight185::RGBController_MSIMysticLight185
     location    = controller->GetDeviceLocation();
     serial      = controller->GetSerial();
 
+    /*-----------------------------------------------------*\
+    | Direct mode updates sleep between feature reports, so |
+    | run updates on a private thread rather than stalling  |
+    | a shared worker                                       |
+    \*-----------------------------------------------------*/
+    flags      |= CONTROLLER_FLAG_PRIVATE_THREAD;
+
     const std::vector<MSI_ZONE>* supported_zones = controller->GetSupportedZones();
 
     for(std::size_t i = 0; i < supported_zones->size(); ++i)
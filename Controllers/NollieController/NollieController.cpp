@@ -11,6 +11,7 @@
 
 #include <cstring>
 #include "NollieController.h"
+#include "RGBColorKernels.h"
 #include "StringUtils.h"
 
 using namespace std::chrono_literals;
@@ -122,12 +123,7 @@ void NollieController::SendPacket(unsigned char channel,RGBColor* colors,unsigne
     usb_buf[4] = num_colors % 256;
     if(num_colors)
     {
-        for(unsigned int color_idx = 0; color_idx < num_colors; color_idx++)
-        {
-            usb_buf[0x05 + (color_idx * 3)] = RGBGetGValue(colors[color_idx]);
-            usb_buf[0x06 + (color_idx * 3)] = RGBGetRValue(colors[color_idx]);
-            usb_buf[0x07 + (color_idx * 3)] = RGBGetBValue(colors[color_idx]);
-        }
+        PackRGBColors(&usb_buf[0x05], colors, num_colors, RGB_ORDER_GRB);
     }
 
     /*-----------------------------------------------------*\
@@ -174,16 +170,13 @@ void NollieController::SendPacketFS(unsigned char channel,unsigned char packet_i
     memset(usb_buf, 0x00, sizeof(usb_buf));
     usb_buf[0x00]   = 0x00;
     usb_buf[0x01]   = packet_id + channel * packet_interval;
-    for(unsigned int color_idx = 0; color_idx < num_colors; color_idx++)
+    if(dev_pid == NOLLIE8_PID || dev_pid == NOLLIE1_PID )
     {
-        usb_buf[0x02 + (color_idx * 3)] = RGBGetRValue(colors[color_idx]);
-        usb_buf[0x03 + (color_idx * 3)] = RGBGetGValue(colors[color_idx]);
-        usb_buf[0x04 + (color_idx * 3)] = RGBGetBValue(colors[color_idx]);
-        if(dev_pid == NOLLIE8_PID || dev_pid == NOLLIE1_PID )
-        {
-            usb_buf[0x02 + (color_idx * 3)] = RGBGetGValue(colors[color_idx]);
-            usb_buf[0x03 + (color_idx * 3)] = RGBGetRValue(colors[color_idx]);
-        }
+        PackRGBColors(&usb_buf[0x02], colors, num_colors, RGB_ORDER_GRB);
+    }
+    else
+    {
+        PackRGBColors(&usb_buf[0x02], colors, num_colors, RGB_ORDER_RGB);
     }
     hid_write(dev, usb_buf, 65);
 }
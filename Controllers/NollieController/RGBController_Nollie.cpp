@@ -35,6 +35,13 @@ RGBController_Nollie::RGBController_Nollie(NollieController* controller_ptr)
     location            = controller->GetLocationString();
     serial              = controller->GetSerialString();
 
+    /*-----------------------------------------------------*\
+    | Packet transmission sleeps between transfers, so run  |
+    | updates on a private thread rather than stalling a    |
+    | shared worker                                         |
+    \*-----------------------------------------------------*/
+    flags              |= CONTROLLER_FLAG_PRIVATE_THREAD;
+
     mode Direct;
     Direct.name         = "Direct";
     Direct.value        = 0xFFFF;
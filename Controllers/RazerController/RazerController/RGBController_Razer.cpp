@@ -37,6 +37,11 @@ RGBController_Razer::RGBController_Razer(RazerController* controller_ptr)
     serial                  = controller->GetSerialString();
     uint8_t max_brightness  = controller->GetMaxBrightness();
 
+    /*---------------------------------------------------------*\
+    | The device can be reopened by path after a USB reset      |
+    \*---------------------------------------------------------*/
+    flags                  |= CONTROLLER_FLAG_REOPEN;
+
     if(type == DEVICE_TYPE_KEYBOARD)
     {
         LOG_DEBUG("[%s] Checking Keyboard Layout", name.c_str());
@@ -309,7 +314,7 @@ void RGBController_Razer::ResizeZone(int /*zone*/, int /*new_size*/)
 
 void RGBController_Razer::DeviceUpdateLEDs()
 {
-    controller->SetLEDs(&colors[0]);
+    ReportWriteResult(controller->SetLEDs(GetFrame().data()));
 }
 
 void RGBController_Razer::UpdateZoneLEDs(int /*zone*/)
@@ -397,3 +402,8 @@ void RGBController_Razer::DeviceUpdateMode()
         controller->SetBrightness(255);
     }
 }
+
+bool RGBController_Razer::DeviceReopen()
+{
+    return(controller->Reopen());
+}
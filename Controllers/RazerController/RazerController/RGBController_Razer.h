@@ -43,6 +43,8 @@ public:
 
     void        DeviceUpdateMode();
 
+    bool        DeviceReopen();
+
 private:
     RazerController*    controller;
 };
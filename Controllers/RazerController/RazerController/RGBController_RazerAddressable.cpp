@@ -253,14 +253,15 @@ void RGBController_RazerAddressable::DeviceUpdateLEDs()
     | Only the Razer Chroma Addressable RGB Controller supports |
     | zone resizing                                             |
     \*---------------------------------------------------------*/
-    RGBColor    colors_buf[80 * 6];
+    const std::vector<RGBColor>&    frame           = GetFrame();
+    RGBColor                        colors_buf[80 * 6];
 
     for(unsigned int zone_id = 0; zone_id < zones.size(); zone_id++)
     {
-        memcpy(&colors_buf[(80 * zone_id)], zones[zone_id].colors, sizeof(RGBColor) * zones[zone_id].leds_count);
+        memcpy(&colors_buf[(80 * zone_id)], frame.data() + zones[zone_id].start_idx, sizeof(RGBColor) * zones[zone_id].leds_count);
     }
 
-    controller->SetLEDs(&colors_buf[0]);
+    ReportWriteResult(controller->SetLEDs(&colors_buf[0]));
 }
 
 void RGBController_RazerAddressable::UpdateZoneLEDs(int /*zone*/)
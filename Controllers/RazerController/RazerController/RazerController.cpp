@@ -25,6 +25,7 @@ RazerController::RazerController(hid_device* dev_handle, hid_device* dev_argb_ha
     location          = path;
     name              = dev_name;
     device_index      = 0;
+    write_result      = 0;
     guard_manager_ptr = new DeviceGuardManager(new RazerDeviceGuard());
 
     /*-----------------------------------------------------------------*\
@@ -205,6 +206,36 @@ RazerController::~RazerController()
     delete guard_manager_ptr;
 }
 
+/*---------------------------------------------------------*\
+| Reopen                                                    |
+|   Open the device path again after the handle has gone    |
+|   bad, such as after a USB reset.  Devices that use a     |
+|   separate ARGB interface cannot be reopened this way.    |
+\*---------------------------------------------------------*/
+bool RazerController::Reopen()
+{
+    if(dev_argb != dev)
+    {
+        return(false);
+    }
+
+    hid_device* new_dev = hid_open_path(location.c_str());
+
+    if(new_dev == NULL)
+    {
+        return(false);
+    }
+
+    DeviceGuardLock _ = guard_manager_ptr->AwaitExclusiveAccess();
+
+    hid_close(dev);
+
+    dev         = new_dev;
+    dev_argb    = new_dev;
+
+    return(true);
+}
+
 std::string RazerController::GetName()
 {
     return(name);
@@ -287,8 +318,10 @@ void RazerController::SetBrightness(unsigned char brightness)
     razer_set_brightness(brightness);
 }
 
-void RazerController::SetLEDs(RGBColor* colors)
+int RazerController::SetLEDs(const RGBColor* colors)
 {
+    write_result = 0;
+
     /*---------------------------------------------------------*\
     | Get the matrix layout information from the device list    |
     \*---------------------------------------------------------*/
@@ -338,6 +371,8 @@ void RazerController::SetLEDs(RGBColor* colors)
     | Delete the output array                                   |
     \*---------------------------------------------------------*/
     delete[] output_array;
+
+    return(write_result);
 }
 
 void RazerController::SetModeBreathingOneColor(unsigned char red, unsigned char grn, unsigned char blu)
@@ -1884,11 +1919,33 @@ int RazerController::razer_usb_send(razer_report* report)
     report->crc = razer_calculate_crc(report);
 
     DeviceGuardLock _ = guard_manager_ptr->AwaitExclusiveAccess();
-    return hid_send_feature_report(dev, (unsigned char*)report, sizeof(*report));
+    int result = hid_send_feature_report(dev, (unsigned char*)report, sizeof(*report));
+
+    if(result < 0)
+    {
+        write_result = result;
+    }
+    else if(write_result >= 0)
+    {
+        write_result += result;
+    }
+
+    return result;
 }
 
 int RazerController::razer_usb_send_argb(razer_argb_report* report)
 {
     DeviceGuardLock _ = guard_manager_ptr->AwaitExclusiveAccess();
-    return hid_send_feature_report(dev_argb, (unsigned char*)report, sizeof(*report));
+    int result = hid_send_feature_report(dev_argb, (unsigned char*)report, sizeof(*report));
+
+    if(result < 0)
+    {
+        write_result = result;
+    }
+    else if(write_result >= 0)
+    {
+        write_result += result;
+    }
+
+    return result;
 }
@@ -238,7 +238,9 @@ public:
 
     void                    SetBrightness(unsigned char brightness);
 
-    void                    SetLEDs(RGBColor* colors);
+    bool                    Reopen();
+
+    int                     SetLEDs(const RGBColor* colors);
     void                    SetAddressableZoneSizes(unsigned char zone_1_size, unsigned char zone_2_size, unsigned char zone_3_size, unsigned char zone_4_size, unsigned char zone_5_size, unsigned char zone_6_size);
 
     void                    SetModeBreathingRandom();
@@ -292,6 +294,12 @@ private:
     \*---------------------------------------------------------*/
     DeviceGuardManager*     guard_manager_ptr;
 
+    /*---------------------------------------------------------*\
+    | Result of the writes since SetLEDs() started, the total   |
+    | bytes written or the last negative error code             |
+    \*---------------------------------------------------------*/
+    std::atomic<int>        write_result;
+
     /*---------------------------------------------------------*\
     | Private functions based on OpenRazer                      |
     \*---------------------------------------------------------*/
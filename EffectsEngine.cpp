@@ -0,0 +1,546 @@
+/*---------------------------------------------------------*\
+| EffectsEngine.cpp                                         |
+|                                                           |
+|   OpenRGB in-process software effects engine              |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "EffectsEngine.h"
+#include "LogManager.h"
+#include "ResourceManager.h"
+
+static const float effect_pi = 3.14159265f;
+
+static const std::vector<RGBColor> default_palette =
+{
+    ToRGBColor(255, 0,   0  ),
+    ToRGBColor(0,   0,   255),
+};
+
+static const char* effect_names[EFFECT_COUNT] =
+{
+    "none",
+    "rainbow_wave",
+    "breathing",
+    "spectrum_cycle",
+    "gradient_scroll",
+};
+
+/*---------------------------------------------------------*\
+| Convert a hue in the range [0, 1) at full saturation and  |
+| the given value into an RGBColor                          |
+\*---------------------------------------------------------*/
+static RGBColor HueToRGBColor(float hue, float value)
+{
+    float           h       = (hue - std::floor(hue)) * 6.0f;
+    unsigned int    sector  = (unsigned int)h;
+    float           f       = h - (float)sector;
+    unsigned char   v       = (unsigned char)(value * 255.0f);
+    unsigned char   q       = (unsigned char)(value * 255.0f * (1.0f - f));
+    unsigned char   t       = (unsigned char)(value * 255.0f * f);
+
+    switch(sector % 6)
+    {
+        case 0:  return(ToRGBColor(v, t, 0));
+        case 1:  return(ToRGBColor(q, v, 0));
+        case 2:  return(ToRGBColor(0, v, t));
+        case 3:  return(ToRGBColor(0, q, v));
+        case 4:  return(ToRGBColor(t, 0, v));
+        default: return(ToRGBColor(v, 0, q));
+    }
+}
+
+/*---------------------------------------------------------*\
+| Blend two colors, weight 0.0 = color_a, 1.0 = color_b,    |
+| and scale the result by brightness                        |
+\*---------------------------------------------------------*/
+static RGBColor BlendRGBColor(RGBColor color_a, RGBColor color_b, float weight, float brightness)
+{
+    float           weight_a    = (1.0f - weight) * brightness;
+    float           weight_b    = weight * brightness;
+    unsigned char   red         = (unsigned char)((RGBGetRValue(color_a) * weight_a) + (RGBGetRValue(color_b) * weight_b));
+    unsigned char   grn         = (unsigned char)((RGBGetGValue(color_a) * weight_a) + (RGBGetGValue(color_b) * weight_b));
+    unsigned char   blu         = (unsigned char)((RGBGetBValue(color_a) * weight_a) + (RGBGetBValue(color_b) * weight_b));
+
+    return(ToRGBColor(red, grn, blu));
+}
+
+EffectsEngine::EffectsEngine()
+{
+    EffectsThread           = NULL;
+    EffectsThreadRunning    = false;
+    effects_frame_rate      = EFFECTS_ENGINE_DEFAULT_FRAME_RATE;
+    spatial_index_valid     = false;
+}
+
+EffectsEngine::~EffectsEngine()
+{
+    /*-----------------------------------------------------*\
+    | Stop the effects thread                               |
+    \*-----------------------------------------------------*/
+    EffectsMutex.lock();
+    EffectsThreadRunning = false;
+    EffectsMutex.unlock();
+
+    EffectsCV.notify_all();
+
+    if(EffectsThread)
+    {
+        EffectsThread->join();
+        delete EffectsThread;
+        EffectsThread = NULL;
+    }
+}
+
+void EffectsEngine::SetEffect(RGBController* controller, effect_settings settings)
+{
+    if(settings.effect == EFFECT_NONE || settings.effect >= EFFECT_COUNT)
+    {
+        ClearEffect(controller);
+        return;
+    }
+
+    if(settings.speed == 0)
+    {
+        settings.speed = EFFECTS_ENGINE_DEFAULT_SPEED;
+    }
+
+    LOG_INFO("[EffectsEngine] Running %s on %s", GetEffectName(settings.effect).c_str(), controller->GetName().c_str());
+
+    /*-----------------------------------------------------*\
+    | Switch the controller to its per-LED custom mode so   |
+    | that the rendered colors are shown                    |
+    \*-----------------------------------------------------*/
+    controller->SetCustomMode();
+    controller->UpdateMode();
+
+    EffectsMutex.lock();
+
+    bool found = false;
+
+    for(std::size_t target_idx = 0; target_idx < effect_targets.size(); target_idx++)
+    {
+        if(effect_targets[target_idx].controller == controller)
+        {
+            effect_targets[target_idx].settings = settings;
+            found = true;
+            break;
+        }
+    }
+
+    if(!found)
+    {
+        effect_target new_target;
+
+        new_target.controller           = controller;
+        new_target.settings             = settings;
+        new_target.positions_generation = 0;
+
+        effect_targets.push_back(new_target);
+
+        spatial_index_valid     = false;
+    }
+
+    /*-----------------------------------------------------*\
+    | Start the effects thread on first use                 |
+    \*-----------------------------------------------------*/
+    if(EffectsThread == NULL)
+    {
+        EffectsThreadRunning    = true;
+        EffectsThread           = new std::thread(&EffectsEngine::EffectsThreadFunction, this);
+    }
+
+    EffectsMutex.unlock();
+
+    EffectsCV.notify_all();
+}
+
+bool EffectsEngine::GetEffect(RGBController* controller, effect_settings* settings)
+{
+    std::lock_guard<std::mutex> lock(EffectsMutex);
+
+    for(std::size_t target_idx = 0; target_idx < effect_targets.size(); target_idx++)
+    {
+        if(effect_targets[target_idx].controller == controller)
+        {
+            *settings = effect_targets[target_idx].settings;
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+/*---------------------------------------------------------*\
+| ClearEffect                                               |
+|   Stop rendering to a controller.  Takes the effects      |
+|   and commit mutexes in turn, so once this returns the    |
+|   effects thread is no longer touching the controller and |
+|   it may be deleted.  The spatial index is cleared too,   |
+|   as it may still point to the controller.                |
+\*---------------------------------------------------------*/
+void EffectsEngine::ClearEffect(RGBController* controller)
+{
+    EffectsMutex.lock();
+
+    for(std::size_t target_idx = 0; target_idx < effect_targets.size(); target_idx++)
+    {
+        if(effect_targets[target_idx].controller == controller)
+        {
+            effect_targets.erase(effect_targets.begin() + target_idx);
+
+            spatial_index.Clear();
+            spatial_index_valid = false;
+            break;
+        }
+    }
+
+    EffectsMutex.unlock();
+
+    /*-----------------------------------------------------*\
+    | Wait for any frame group still being committed        |
+    \*-----------------------------------------------------*/
+    EffectsCommitMutex.lock();
+    EffectsCommitMutex.unlock();
+}
+
+void EffectsEngine::ClearEffects()
+{
+    EffectsMutex.lock();
+
+    effect_targets.clear();
+
+    spatial_index.Clear();
+    spatial_index_valid = false;
+
+    EffectsMutex.unlock();
+
+    EffectsCommitMutex.lock();
+    EffectsCommitMutex.unlock();
+}
+
+unsigned int EffectsEngine::GetFrameRate()
+{
+    std::lock_guard<std::mutex> lock(EffectsMutex);
+
+    return(effects_frame_rate);
+}
+
+void EffectsEngine::SetFrameRate(unsigned int frame_rate)
+{
+    if(frame_rate == 0)
+    {
+        frame_rate = EFFECTS_ENGINE_DEFAULT_FRAME_RATE;
+    }
+
+    if(frame_rate > EFFECTS_ENGINE_MAX_FRAME_RATE)
+    {
+        frame_rate = EFFECTS_ENGINE_MAX_FRAME_RATE;
+    }
+
+    EffectsMutex.lock();
+    effects_frame_rate = frame_rate;
+    EffectsMutex.unlock();
+
+    EffectsCV.notify_all();
+}
+
+std::string EffectsEngine::GetEffectName(effect_type effect)
+{
+    if(effect >= EFFECT_COUNT)
+    {
+        return(effect_names[EFFECT_NONE]);
+    }
+
+    return(effect_names[effect]);
+}
+
+effect_type EffectsEngine::GetEffectType(std::string name)
+{
+    for(effect_type effect = 0; effect < EFFECT_COUNT; effect++)
+    {
+        if(name == effect_names[effect])
+        {
+            return(effect);
+        }
+    }
+
+    return(EFFECT_NONE);
+}
+
+/*---------------------------------------------------------*\
+| EffectsThreadFunction                                     |
+|   Renders every active effect once per tick on a fixed    |
+|   schedule.  Ticks that are missed because rendering or   |
+|   updating ran long are dropped rather than bunched up.   |
+\*---------------------------------------------------------*/
+void EffectsEngine::EffectsThreadFunction()
+{
+    std::unique_lock<std::mutex> lock(EffectsMutex);
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point next_tick  = start_time;
+
+    while(EffectsThreadRunning)
+    {
+        /*-------------------------------------------------*\
+        | Sleep while there is nothing to render            |
+        \*-------------------------------------------------*/
+        if(effect_targets.empty())
+        {
+            EffectsCV.wait(lock, [this]{ return(!EffectsThreadRunning || !effect_targets.empty()); });
+
+            next_tick = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        if(now < next_tick)
+        {
+            EffectsCV.wait_until(lock, next_tick);
+            continue;
+        }
+
+        double time = std::chrono::duration<double>(now - start_time).count();
+
+        UpdateSpatialIndex();
+
+        effect_controllers.clear();
+        effect_frames.resize(effect_targets.size());
+
+        for(std::size_t target_idx = 0; target_idx < effect_targets.size(); target_idx++)
+        {
+            RenderEffect(effect_targets[target_idx], time, effect_frames[target_idx]);
+
+            effect_controllers.push_back(effect_targets[target_idx].controller);
+        }
+
+        std::chrono::nanoseconds tick_interval(1000000000ULL / effects_frame_rate);
+
+        /*-------------------------------------------------*\
+        | Take the commit mutex before releasing the        |
+        | effects mutex, so that a controller cleared in    |
+        | between is not deleted while it is committed      |
+        \*-------------------------------------------------*/
+        EffectsCommitMutex.lock();
+
+        lock.unlock();
+
+        /*-------------------------------------------------*\
+        | Write the rendered frames through each            |
+        | controller's frame write lock and commit them as  |
+        | one group so the devices update together          |
+        \*-------------------------------------------------*/
+        for(std::size_t controller_idx = 0; controller_idx < effect_controllers.size(); controller_idx++)
+        {
+            std::vector<RGBColor>& frame = effect_frames[controller_idx];
+
+            effect_controllers[controller_idx]->SetLEDRange(0, frame.data(), (unsigned int)frame.size());
+        }
+
+        ResourceManager::get()->CommitFrameGroup(effect_controllers);
+
+        EffectsCommitMutex.unlock();
+
+        lock.lock();
+
+        /*-------------------------------------------------*\
+        | Schedule the next tick                            |
+        \*-------------------------------------------------*/
+
+        next_tick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(tick_interval);
+
+        if(next_tick < now)
+        {
+            next_tick = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(tick_interval);
+        }
+    }
+}
+
+/*---------------------------------------------------------*\
+| UpdateSpatialIndex                                        |
+|   Rebuild the spatial index over every target when the    |
+|   targets have changed or an indexed controller's LEDs or |
+|   positions have.  The shared bounding box may move, so   |
+|   every target's positions are rebuilt too.               |
+\*---------------------------------------------------------*/
+void EffectsEngine::UpdateSpatialIndex()
+{
+    /*-----------------------------------------------------*\
+    | A target whose positions were replaced may have just  |
+    | gained or lost them, which the index cannot notice    |
+    \*-----------------------------------------------------*/
+    for(std::size_t target_idx = 0; target_idx < effect_targets.size(); target_idx++)
+    {
+        effect_target& target = effect_targets[target_idx];
+
+        if(target.positions_generation != target.controller->GetLEDPositionsGeneration())
+        {
+            spatial_index_valid = false;
+        }
+    }
+
+    if(spatial_index_valid && !spatial_index.IsStale())
+    {
+        return;
+    }
+
+    effect_controllers.clear();
+
+    for(std::size_t target_idx = 0; target_idx < effect_targets.size(); target_idx++)
+    {
+        effect_target& target = effect_targets[target_idx];
+
+        effect_controllers.push_back(target.controller);
+
+        target.positions.clear();
+        target.positions_generation = target.controller->GetLEDPositionsGeneration();
+    }
+
+    spatial_index.Build(effect_controllers);
+
+    spatial_index_valid = true;
+}
+
+/*---------------------------------------------------------*\
+| BuildPositions                                            |
+|   Assign each LED a position along the X axis.  LEDs with |
+|   physical positions use their X coordinate in the shared |
+|   bounding box of all indexed controllers.  Otherwise,    |
+|   matrix zones use the LED's column in the matrix map,    |
+|   all other zones use the LED's index within the zone.    |
+\*---------------------------------------------------------*/
+void EffectsEngine::BuildPositions(RGBController* controller, std::vector<float>& positions)
+{
+    const RGBControllerLayout& layout = controller->GetLayout();
+
+    positions.assign(controller->colors.size(), 0.0f);
+
+    /*-----------------------------------------------------*\
+    | Use the physical X coordinates when the controller    |
+    | is in the spatial index                               |
+    \*-----------------------------------------------------*/
+    std::vector<led_position> led_positions;
+
+    if(spatial_index.GetPositions(controller, led_positions) && (led_positions.size() == positions.size()))
+    {
+        for(std::size_t led_idx = 0; led_idx < positions.size(); led_idx++)
+        {
+            positions[led_idx] = led_positions[led_idx].x;
+        }
+
+        return;
+    }
+
+    for(unsigned int zone_idx = 0; zone_idx < layout.GetZoneCount(); zone_idx++)
+    {
+        unsigned int            zone_start  = layout.GetZoneStart(zone_idx);
+        unsigned int            zone_leds   = layout.GetZoneLEDCount(zone_idx);
+        const unsigned int*     matrix_map  = layout.GetMatrixMap(zone_idx);
+
+        if(matrix_map != NULL)
+        {
+            unsigned int height = layout.GetMatrixHeight(zone_idx);
+            unsigned int width  = layout.GetMatrixWidth(zone_idx);
+
+            for(unsigned int y = 0; y < height; y++)
+            {
+                for(unsigned int x = 0; x < width; x++)
+                {
+                    unsigned int led = matrix_map[(y * width) + x];
+
+                    if(led != LAYOUT_NO_LED && led < positions.size())
+                    {
+                        positions[led] = ((float)x + 0.5f) / (float)width;
+                    }
+                }
+            }
+        }
+        else
+        {
+            for(unsigned int led = 0; led < zone_leds && (zone_start + led) < positions.size(); led++)
+            {
+                positions[zone_start + led] = ((float)led + 0.5f) / (float)zone_leds;
+            }
+        }
+    }
+}
+
+/*---------------------------------------------------------*\
+| RenderEffect                                              |
+|   Render one frame of a target's effect into colors,      |
+|   sized to the controller's LED count                     |
+\*---------------------------------------------------------*/
+void EffectsEngine::RenderEffect(effect_target& target, double time, std::vector<RGBColor>& colors)
+{
+    RGBController*          controller  = target.controller;
+    effect_settings&        settings    = target.settings;
+
+    colors.resize(controller->colors.size());
+
+    if(target.positions.size() != colors.size())
+    {
+        BuildPositions(controller, target.positions);
+    }
+
+    /*-----------------------------------------------------*\
+    | Effect phase in cycles, wrapped into [0, 1)           |
+    \*-----------------------------------------------------*/
+    double  cycles  = (time * (double)settings.speed) / 60.0;
+    float   phase   = (float)(cycles - std::floor(cycles));
+
+    /*-----------------------------------------------------*\
+    | Default palette for effects that use colors           |
+    \*-----------------------------------------------------*/
+    const std::vector<RGBColor>& palette = settings.colors.empty() ? default_palette : settings.colors;
+
+    switch(settings.effect)
+    {
+        case EFFECT_RAINBOW_WAVE:
+            for(std::size_t led_idx = 0; led_idx < colors.size(); led_idx++)
+            {
+                colors[led_idx] = HueToRGBColor(target.positions[led_idx] + phase, 1.0f);
+            }
+            break;
+
+        case EFFECT_SPECTRUM_CYCLE:
+            std::fill(colors.begin(), colors.end(), HueToRGBColor(phase, 1.0f));
+            break;
+
+        case EFFECT_BREATHING:
+            {
+                /*-----------------------------------------*\
+                | One full breath per cycle, stepping to    |
+                | the next palette color on each breath     |
+                \*-----------------------------------------*/
+                RGBColor    color       = palette[(std::size_t)cycles % palette.size()];
+                float       brightness  = 0.5f - (0.5f * std::cos(phase * 2.0f * effect_pi));
+
+                std::fill(colors.begin(), colors.end(), BlendRGBColor(color, color, 0.0f, brightness));
+            }
+            break;
+
+        case EFFECT_GRADIENT_SCROLL:
+            for(std::size_t led_idx = 0; led_idx < colors.size(); led_idx++)
+            {
+                /*-----------------------------------------*\
+                | The gradient wraps from the last palette  |
+                | color back to the first so it scrolls     |
+                | without a seam                            |
+                \*-----------------------------------------*/
+                float           position    = target.positions[led_idx] - phase + 1.0f;
+                float           scaled      = (position - std::floor(position)) * (float)palette.size();
+                std::size_t     color_idx   = (std::size_t)scaled % palette.size();
+                std::size_t     next_idx    = (color_idx + 1) % palette.size();
+
+                colors[led_idx] = BlendRGBColor(palette[color_idx], palette[next_idx], scaled - std::floor(scaled), 1.0f);
+            }
+            break;
+    }
+}
@@ -0,0 +1,125 @@
+/*---------------------------------------------------------*\
+| EffectsEngine.h                                           |
+|                                                           |
+|   OpenRGB in-process software effects engine              |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RGBController.h"
+#include "RGBControllerSpatialIndex.h"
+
+/*---------------------------------------------------------*\
+| Effect Types                                              |
+\*---------------------------------------------------------*/
+typedef unsigned int effect_type;
+
+enum
+{
+    EFFECT_NONE                 = 0,    /* No effect                            */
+    EFFECT_RAINBOW_WAVE         = 1,    /* Hue wave moving across the device    */
+    EFFECT_BREATHING            = 2,    /* Fade in and out through colors       */
+    EFFECT_SPECTRUM_CYCLE       = 3,    /* Whole device cycles through hues     */
+    EFFECT_GRADIENT_SCROLL      = 4,    /* Color gradient moving across device  */
+    EFFECT_COUNT                        /* Number of effect types               */
+};
+
+/*---------------------------------------------------------*\
+| Effect Defaults                                           |
+\*---------------------------------------------------------*/
+#define EFFECTS_ENGINE_DEFAULT_FRAME_RATE   30
+#define EFFECTS_ENGINE_MAX_FRAME_RATE       240
+#define EFFECTS_ENGINE_DEFAULT_SPEED        30
+
+/*---------------------------------------------------------*\
+| Effect Settings                                           |
+|   speed is given in effect cycles per minute.  Breathing  |
+|   and gradient scroll use the colors list, falling back   |
+|   to a default palette when it is empty.                  |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    effect_type             effect;
+    unsigned int            speed;
+    std::vector<RGBColor>   colors;
+} effect_settings;
+
+class EffectsEngine
+{
+public:
+    EffectsEngine();
+    ~EffectsEngine();
+
+    void                    SetEffect(RGBController* controller, effect_settings settings);
+    bool                    GetEffect(RGBController* controller, effect_settings* settings);
+    void                    ClearEffect(RGBController* controller);
+    void                    ClearEffects();
+
+    unsigned int            GetFrameRate();
+    void                    SetFrameRate(unsigned int frame_rate);
+
+    static std::string      GetEffectName(effect_type effect);
+    static effect_type      GetEffectType(std::string name);
+
+private:
+    /*-----------------------------------------------------*\
+    | Per-controller effect state.  LED positions are       |
+    | normalized to [0, 1] along the X axis.  Controllers   |
+    | with LED positions share the spatial index's bounding |
+    | box, so an effect spans all of them.  Others use the  |
+    | position within each zone.  Positions are rebuilt     |
+    | when the LED count changes or the index is rebuilt,   |
+    | which also happens when the controller's position     |
+    | generation no longer matches positions_generation.    |
+    \*-----------------------------------------------------*/
+    typedef struct
+    {
+        RGBController*          controller;
+        effect_settings         settings;
+        std::vector<float>      positions;
+        unsigned int            positions_generation;
+    } effect_target;
+
+    void                    EffectsThreadFunction();
+
+    void                    BuildPositions(RGBController* controller, std::vector<float>& positions);
+    void                    UpdateSpatialIndex();
+    void                    RenderEffect(effect_target& target, double time, std::vector<RGBColor>& colors);
+
+    std::thread*            EffectsThread;
+    std::atomic<bool>       EffectsThreadRunning;
+    std::mutex              EffectsMutex;
+    std::condition_variable EffectsCV;
+
+    unsigned int            effects_frame_rate;
+    std::vector<effect_target> effect_targets;
+    std::vector<RGBController*> effect_controllers;
+
+    /*-----------------------------------------------------*\
+    | Frames are rendered into effect_frames under the      |
+    | effects mutex and written to the controllers and      |
+    | committed under the commit mutex only, so that        |
+    | callers are not held up by device updates.            |
+    | ClearEffect() waits on the commit mutex before it     |
+    | returns.                                              |
+    \*-----------------------------------------------------*/
+    std::mutex              EffectsCommitMutex;
+    std::vector<std::vector<RGBColor>> effect_frames;
+
+    /*-----------------------------------------------------*\
+    | Index of the LED positions of every target, rebuilt   |
+    | by the effects thread when targets are added or       |
+    | removed and when it goes stale                        |
+    \*-----------------------------------------------------*/
+    RGBControllerSpatialIndex   spatial_index;
+    bool                        spatial_index_valid;
+};
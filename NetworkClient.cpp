@@ -9,9 +9,11 @@
 |   SPDX-License-Identifier: GPL-2.0-or-later               |
 \*---------------------------------------------------------*/
 
+#include <algorithm>
 #include <cstring>
 #include "NetworkClient.h"
 #include "RGBController_Network.h"
+#include "RGBControllerIdleMonitor.h"
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -43,6 +45,9 @@ NetworkClient::NetworkClient(std::vector<RGBController *>& control) : controller
     server_protocol_version             = 0;
     server_reinitialize                 = false;
     change_in_progress                  = false;
+    server_idle_stats_received          = false;
+
+    memset(&server_idle_stats, 0, sizeof(server_idle_stats));
 
     ListenThread            = NULL;
     ConnectionThread        = NULL;
@@ -112,6 +117,37 @@ bool NetworkClient::GetOnline()
     return(server_connected && client_string_sent && protocol_initialized && server_initialized);
 }
 
+/*---------------------------------------------------------*\
+| GetServerIdleStats                                        |
+|   Request the server's idle state and wakeup statistics,  |
+|   waiting up to 1s for the reply.  Servers older than     |
+|   protocol 11 and offline servers report all zeros.       |
+\*---------------------------------------------------------*/
+idle_stats NetworkClient::GetServerIdleStats()
+{
+    std::unique_lock<std::mutex> lock(server_idle_stats_mutex);
+
+    if(!GetOnline() || (GetProtocolVersion() < 11))
+    {
+        idle_stats stats;
+
+        memset(&stats, 0, sizeof(stats));
+
+        return(stats);
+    }
+
+    server_idle_stats_received = false;
+
+    SendRequest_IdleStats();
+
+    server_idle_stats_cv.wait_for(lock, std::chrono::seconds(1), [this]
+    {
+        return(server_idle_stats_received);
+    });
+
+    return(server_idle_stats);
+}
+
 void NetworkClient::RegisterClientInfoChangeCallback(NetClientCallback new_callback, void * new_callback_arg)
 {
     ClientInfoChangeCallbacks.push_back(new_callback);
@@ -403,12 +439,25 @@ void NetworkClient::ConnectionThreadFunction()
             \*---------------------------------------------------------*/
             connection_cv.wait_for(lock, 1ms);
         }
+        else if(server_connected && server_initialized && RGBControllerIdleMonitor::get()->IsIdle())
+        {
+            /*---------------------------------------------------------*\
+            | Wait 10 sec or until the thread is requested to stop or   |
+            | the connection is lost while output is idle               |
+            \*---------------------------------------------------------*/
+            if(!connection_cv.wait_for(lock, 10s, [this]{ return(!client_active || !server_connected); }))
+            {
+                RGBControllerIdleMonitor::get()->RecordWakeup(IDLE_WAKEUP_SDK);
+            }
+        }
         else
         {
             /*---------------------------------------------------------*\
             | Wait 1 sec or until the thread is requested to stop       |
             \*---------------------------------------------------------*/
             connection_cv.wait_for(lock, 1s);
+
+            RGBControllerIdleMonitor::get()->RecordWakeup(IDLE_WAKEUP_SDK);
         }
     }
 }
@@ -434,6 +483,7 @@ int NetworkClient::recv_select(SOCKET s, char *buf, int len, int flags)
         }
         else if(rv == 0)
         {
+            RGBControllerIdleMonitor::get()->RecordWakeup(IDLE_WAKEUP_SDK);
             continue;
         }
         else
@@ -444,108 +494,95 @@ int NetworkClient::recv_select(SOCKET s, char *buf, int len, int flags)
     }
 }
 
+int NetworkClient::send_packet(NetPacketHeader * header, const void * data, unsigned int size)
+{
+    /*---------------------------------------------------------*\
+    | Send the header and data with one call so that an update  |
+    | costs one syscall and, with TCP_NODELAY, one TCP segment  |
+    \*---------------------------------------------------------*/
+    const char *    buffers[2]  = { (const char *)header, (const char *)data };
+    int             lengths[2]  = { sizeof(NetPacketHeader), (int)size };
+
+    return(net_send_buffers(client_sock, buffers, lengths, (size > 0) ? 2 : 1, MSG_NOSIGNAL));
+}
+
 void NetworkClient::ListenThreadFunction()
 {
     printf("Network client listener started\n");
 
+    NetPacketReader reader;
+
     /*---------------------------------------------------------*\
     | This thread handles messages received from the server     |
     \*---------------------------------------------------------*/
     while(server_connected == true)
     {
-        NetPacketHeader header;
-        int             bytes_read  = 0;
-        char *          data        = NULL;
-
-        for(unsigned int i = 0; i < 4; i++)
-        {
-            /*---------------------------------------------------------*\
-            | Read byte of magic                                        |
-            \*---------------------------------------------------------*/
-            bytes_read = recv_select(client_sock, &header.pkt_magic[i], 1, 0);
-
-            if(bytes_read <= 0)
-            {
-                goto listen_done;
-            }
-
-            /*---------------------------------------------------------*\
-            | Test characters of magic "ORGB"                           |
-            \*---------------------------------------------------------*/
-            if(header.pkt_magic[i] != openrgb_sdk_magic[i])
-            {
-                continue;
-            }
-        }
-
         /*---------------------------------------------------------*\
-        | If we get to this point, the magic is correct.  Read the  |
-        | rest of the header                                        |
+        | Receive as much as is available, then handle every        |
+        | complete packet received so far                           |
         \*---------------------------------------------------------*/
-        bytes_read = 0;
-        do
+        unsigned int    buffer_size;
+        char *          buffer      = reader.GetReceiveBuffer(&buffer_size);
+        int             bytes_read  = recv_select(client_sock, buffer, buffer_size, 0);
+
+        if(bytes_read <= 0)
         {
-            int tmp_bytes_read = 0;
+            goto listen_done;
+        }
 
-            tmp_bytes_read = recv_select(client_sock, (char *)&header.pkt_dev_idx + bytes_read, sizeof(header) - sizeof(header.pkt_magic) - bytes_read, 0);
+        reader.Received(bytes_read);
 
-            bytes_read += tmp_bytes_read;
+        while(1)
+        {
+            NetPacketHeader header;
+            char *          data;
+            int             result      = reader.NextPacket(&header, &data);
 
-            if(tmp_bytes_read <= 0)
+            if(result == NET_PACKET_INCOMPLETE)
+            {
+                break;
+            }
+            else if(result == NET_PACKET_TOO_LARGE)
             {
                 goto listen_done;
             }
 
-        } while(bytes_read != sizeof(header) - sizeof(header.pkt_magic));
-
-        /*---------------------------------------------------------*\
-        | Header received, now receive the data                     |
-        \*---------------------------------------------------------*/
-        if(header.pkt_size > 0)
-        {
-            bytes_read = 0;
-
-            data = new char[header.pkt_size];
-
-            do
+            /*---------------------------------------------------*\
+            | Entire packet received, select functionality based  |
+            | on packet ID                                        |
+            \*---------------------------------------------------*/
+            switch(header.pkt_id)
             {
-                int tmp_bytes_read = 0;
-
-                tmp_bytes_read = recv_select(client_sock, &data[(unsigned int)bytes_read], header.pkt_size - bytes_read, 0);
-
-                if(tmp_bytes_read <= 0)
-                {
-                    goto listen_done;
-                }
-                bytes_read += tmp_bytes_read;
-
-            } while ((unsigned int)bytes_read < header.pkt_size);
-        }
-
-        /*---------------------------------------------------------*\
-        | Entire request received, select functionality based on    |
-        | request ID                                                |
-        \*---------------------------------------------------------*/
-        switch(header.pkt_id)
-        {
-            case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
-                ProcessReply_ControllerCount(header.pkt_size, data);
-                break;
-
-            case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
-                ProcessReply_ControllerData(header.pkt_size, data, header.pkt_dev_idx);
-                break;
-
-            case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
-                ProcessReply_ProtocolVersion(header.pkt_size, data);
-                break;
-
-            case NET_PACKET_ID_DEVICE_LIST_UPDATED:
-                ProcessRequest_DeviceListChanged();
-                break;
+                case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
+                    ProcessReply_ControllerCount(header.pkt_size, data);
+                    break;
+
+                case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
+                    ProcessReply_ControllerData(header.pkt_size, data, header.pkt_dev_idx);
+                    break;
+
+                case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
+                    ProcessReply_ProtocolVersion(header.pkt_size, data);
+                    break;
+
+                case NET_PACKET_ID_REQUEST_IDLE_STATS:
+                    ProcessReply_IdleStats(header.pkt_size, data);
+                    break;
+
+                case NET_PACKET_ID_RGBCONTROLLER_GETLATENCYSTATS:
+                    ProcessReply_RGBController_LatencyStats(header.pkt_size, data, header.pkt_dev_idx);
+                    break;
+
+                case NET_PACKET_ID_RGBCONTROLLER_GETHEALTH:
+                case NET_PACKET_ID_RGBCONTROLLER_HEALTHCHANGED:
+                    ProcessReply_RGBController_Health(header.pkt_size, data, header.pkt_dev_idx);
+                    break;
+
+                case NET_PACKET_ID_DEVICE_LIST_UPDATED:
+                    ProcessRequest_DeviceListChanged();
+                    break;
+            }
         }
-
-        delete[] data;
     }
 
 listen_done:
@@ -586,6 +623,11 @@ listen_done:
 
     ControllerListMutex.unlock();
 
+    /*---------------------------------------------------------*\
+    | Wake the connection thread so that it reconnects          |
+    \*---------------------------------------------------------*/
+    connection_cv.notify_all();
+
     /*---------------------------------------------------------*\
     | Client info has changed, call the callbacks               |
     \*---------------------------------------------------------*/
@@ -606,6 +648,102 @@ void NetworkClient::WaitOnControllerData()
     return;
 }
 
+/*---------------------------------------------------------*\
+| UpdateLEDsGroup                                           |
+|   Send the colors of every controller in the group that   |
+|   belongs to this client's server in one packet, and      |
+|   remove those controllers from the group.  Controllers   |
+|   are left in the group if the server is older than       |
+|   protocol 12, or if the controller list is being changed |
+|   at the time, so that the caller updates them one by     |
+|   one instead.                                            |
+\*---------------------------------------------------------*/
+void NetworkClient::UpdateLEDsGroup(std::vector<RGBController *>& group, bool commit_together)
+{
+    unsigned int protocol_version = GetProtocolVersion();
+
+    if(!GetOnline() || (protocol_version < 12))
+    {
+        return;
+    }
+
+    /*---------------------------------------------------------*\
+    | The controller list lock is held while callbacks run, so  |
+    | do not wait for it from the caller's update loop          |
+    \*---------------------------------------------------------*/
+    if(!ControllerListMutex.try_lock())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(update_group_mutex);
+
+    unsigned int data_size   = 3 * sizeof(unsigned int);
+    unsigned int group_flags = commit_together ? NET_UPDATELEDSGROUP_FLAG_COMMIT_TOGETHER : 0;
+    unsigned int num_devices = 0;
+    bool         encoded     = (protocol_version >= 13);
+
+    if(encoded)
+    {
+        group_flags |= NET_UPDATELEDSGROUP_FLAG_ENCODED;
+    }
+
+    update_group_buf.resize(data_size);
+
+    for(std::size_t group_idx = 0; group_idx < group.size();)
+    {
+        std::vector<RGBController *>::iterator controller_it = std::find(server_controllers.begin(), server_controllers.end(), group[group_idx]);
+
+        if(controller_it == server_controllers.end())
+        {
+            group_idx++;
+            continue;
+        }
+
+        /*-----------------------------------------------------*\
+        | Append the device index and its color description.    |
+        | Every controller in server_controllers was created by |
+        | this client as an RGBController_Network.              |
+        \*-----------------------------------------------------*/
+        unsigned int dev_idx     = (unsigned int)(controller_it - server_controllers.begin());
+        unsigned int colors_size = 0;
+
+        if(encoded)
+        {
+            colors_size = ((RGBController_Network *)group[group_idx])->EncodeColors(update_group_colors);
+        }
+        else
+        {
+            colors_size = group[group_idx]->GetColorDescription(update_group_colors, protocol_version);
+        }
+
+        update_group_buf.resize(data_size + sizeof(dev_idx) + colors_size);
+
+        memcpy(&update_group_buf[data_size], &dev_idx, sizeof(dev_idx));
+        data_size += sizeof(dev_idx);
+
+        memcpy(&update_group_buf[data_size], update_group_colors.data(), colors_size);
+        data_size += colors_size;
+
+        num_devices++;
+
+        group.erase(group.begin() + group_idx);
+    }
+
+    ControllerListMutex.unlock();
+
+    if(num_devices == 0)
+    {
+        return;
+    }
+
+    memcpy(&update_group_buf[0], &data_size, sizeof(data_size));
+    memcpy(&update_group_buf[sizeof(data_size)], &group_flags, sizeof(group_flags));
+    memcpy(&update_group_buf[2 * sizeof(data_size)], &num_devices, sizeof(num_devices));
+
+    SendRequest_RGBController_UpdateLEDsGroup(update_group_buf.data(), data_size);
+}
+
 void NetworkClient::ProcessReply_ControllerCount(unsigned int data_size, char * data)
 {
     if(data_size == sizeof(unsigned int))
@@ -633,10 +771,14 @@ void NetworkClient::ProcessReply_ControllerData(unsigned int data_size, char * d
         new_controller->ReadDeviceDescription((unsigned char *)data, GetProtocolVersion());
 
         /*-----------------------------------------------------*\
-        | Mark this controller as remote owned                  |
+        | Mark this controller as remote owned.  Zone and LED   |
+        | updates are sent as smaller packets.  Implementation  |
+        | flags from servers that still send them would make    |
+        | this controller skip frames the server needs.         |
         \*-----------------------------------------------------*/
-        new_controller->flags &= ~CONTROLLER_FLAG_LOCAL;
+        new_controller->flags &= ~(CONTROLLER_FLAG_LOCAL | CONTROLLER_FLAGS_IMPLEMENTATION);
         new_controller->flags |= CONTROLLER_FLAG_REMOTE;
+        new_controller->flags |= CONTROLLER_FLAG_PARTIAL_UPDATES;
 
         ControllerListMutex.lock();
 
@@ -677,6 +819,68 @@ void NetworkClient::ProcessReply_ProtocolVersion(unsigned int data_size, char *
     }
 }
 
+void NetworkClient::ProcessReply_IdleStats(unsigned int data_size, char * data)
+{
+    /*---------------------------------------------------------*\
+    | Verify the statistics size (first 4 bytes of data)        |
+    | matches the packet size in the header                     |
+    \*---------------------------------------------------------*/
+    if((data_size < sizeof(unsigned int)) || (data_size != *((unsigned int*)data)))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(server_idle_stats_mutex);
+
+    if(RGBControllerIdleMonitor::ReadStatsDescription((unsigned char *)data, data_size, server_idle_stats))
+    {
+        server_idle_stats_received = true;
+        server_idle_stats_cv.notify_all();
+    }
+}
+
+void NetworkClient::ProcessReply_RGBController_LatencyStats(unsigned int data_size, char * data, unsigned int dev_idx)
+{
+    /*---------------------------------------------------------*\
+    | Verify the statistics size (first 4 bytes of data)        |
+    | matches the packet size in the header                     |
+    \*---------------------------------------------------------*/
+    if((data_size < sizeof(unsigned int)) || (data_size != *((unsigned int*)data)))
+    {
+        return;
+    }
+
+    ControllerListMutex.lock();
+
+    if(dev_idx < server_controllers.size())
+    {
+        ((RGBController_Network *)server_controllers[dev_idx])->ReadLatencyStatsDescription((unsigned char *)data, data_size);
+    }
+
+    ControllerListMutex.unlock();
+}
+
+void NetworkClient::ProcessReply_RGBController_Health(unsigned int data_size, char * data, unsigned int dev_idx)
+{
+    /*---------------------------------------------------------*\
+    | Verify the health size (first 4 bytes of data) matches    |
+    | the packet size in the header                             |
+    \*---------------------------------------------------------*/
+    if((data_size < sizeof(unsigned int)) || (data_size != *((unsigned int*)data)))
+    {
+        return;
+    }
+
+    ControllerListMutex.lock();
+
+    if(dev_idx < server_controllers.size())
+    {
+        ((RGBController_Network *)server_controllers[dev_idx])->ReadHealthDescription((unsigned char *)data, data_size);
+    }
+
+    ControllerListMutex.unlock();
+}
+
 void NetworkClient::ProcessRequest_DeviceListChanged()
 {
     change_in_progress = true;
@@ -737,8 +941,7 @@ void NetworkClient::SendData_ClientString()
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_SET_CLIENT_NAME, (unsigned int)strlen(client_name.c_str()) + 1);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)client_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    send_packet(&reply_hdr, client_name.c_str(), reply_hdr.pkt_size);
     send_in_progress.unlock();
 }
 
@@ -749,7 +952,7 @@ void NetworkClient::SendRequest_ControllerCount()
     InitNetPacketHeader(&request_hdr, 0, NET_PACKET_ID_REQUEST_CONTROLLER_COUNT, 0);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+    send_packet(&request_hdr, NULL, 0);
     send_in_progress.unlock();
 }
 
@@ -770,7 +973,7 @@ void NetworkClient::SendRequest_ControllerData(unsigned int dev_idx)
         request_hdr.pkt_size     = 0;
 
         send_in_progress.lock();
-        send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+        send_packet(&request_hdr, NULL, 0);
         send_in_progress.unlock();
     }
     else
@@ -791,12 +994,22 @@ void NetworkClient::SendRequest_ControllerData(unsigned int dev_idx)
         }
 
         send_in_progress.lock();
-        send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-        send(client_sock, (char *)&protocol_version, sizeof(unsigned int), MSG_NOSIGNAL);
+        send_packet(&request_hdr, &protocol_version, sizeof(unsigned int));
         send_in_progress.unlock();
     }
 }
 
+void NetworkClient::SendRequest_IdleStats()
+{
+    NetPacketHeader request_hdr;
+
+    InitNetPacketHeader(&request_hdr, 0, NET_PACKET_ID_REQUEST_IDLE_STATS, 0);
+
+    send_in_progress.lock();
+    send_packet(&request_hdr, NULL, 0);
+    send_in_progress.unlock();
+}
+
 void NetworkClient::SendRequest_ProtocolVersion()
 {
     NetPacketHeader request_hdr;
@@ -807,8 +1020,7 @@ void NetworkClient::SendRequest_ProtocolVersion()
     request_data             = OPENRGB_SDK_PROTOCOL_VERSION;
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)&request_data, sizeof(unsigned int), MSG_NOSIGNAL);
+    send_packet(&request_hdr, &request_data, sizeof(unsigned int));
     send_in_progress.unlock();
 }
 
@@ -821,7 +1033,7 @@ void NetworkClient::SendRequest_RescanDevices()
         InitNetPacketHeader(&request_hdr, 0, NET_PACKET_ID_REQUEST_RESCAN_DEVICES, 0);
 
         send_in_progress.lock();
-        send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+        send_packet(&request_hdr, NULL, 0);
         send_in_progress.unlock();
     }
 }
@@ -841,8 +1053,7 @@ void NetworkClient::SendRequest_RGBController_ClearSegments(unsigned int dev_idx
     request_data[0]          = zone;
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)&request_data, sizeof(request_data), MSG_NOSIGNAL);
+    send_packet(&request_hdr, &request_data, sizeof(request_data));
     send_in_progress.unlock();
 }
 
@@ -858,8 +1069,7 @@ void NetworkClient::SendRequest_RGBController_AddSegment(unsigned int dev_idx, u
     InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_ADDSEGMENT, size);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, 0);
+    send_packet(&request_hdr, data, size);
     send_in_progress.unlock();
 }
 
@@ -879,8 +1089,7 @@ void NetworkClient::SendRequest_RGBController_ResizeZone(unsigned int dev_idx, i
     request_data[1]          = new_size;
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)&request_data, sizeof(request_data), MSG_NOSIGNAL);
+    send_packet(&request_hdr, &request_data, sizeof(request_data));
     send_in_progress.unlock();
 }
 
@@ -896,8 +1105,39 @@ void NetworkClient::SendRequest_RGBController_UpdateLEDs(unsigned int dev_idx, u
     InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS, size);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, 0);
+    send_packet(&request_hdr, data, size);
+    send_in_progress.unlock();
+}
+
+void NetworkClient::SendRequest_RGBController_UpdateLEDsGroup(unsigned char * data, unsigned int size)
+{
+    if(change_in_progress)
+    {
+        return;
+    }
+
+    NetPacketHeader request_hdr;
+
+    InitNetPacketHeader(&request_hdr, 0, NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSGROUP, size);
+
+    send_in_progress.lock();
+    send_packet(&request_hdr, data, size);
+    send_in_progress.unlock();
+}
+
+void NetworkClient::SendRequest_RGBController_UpdateLEDsEncoded(unsigned int dev_idx, unsigned char * data, unsigned int size)
+{
+    if(change_in_progress)
+    {
+        return;
+    }
+
+    NetPacketHeader request_hdr;
+
+    InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSENCODED, size);
+
+    send_in_progress.lock();
+    send_packet(&request_hdr, data, size);
     send_in_progress.unlock();
 }
 
@@ -913,8 +1153,7 @@ void NetworkClient::SendRequest_RGBController_UpdateZoneLEDs(unsigned int dev_id
     InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS, size);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    send_packet(&request_hdr, data, size);
     send_in_progress.unlock();
 }
 
@@ -930,8 +1169,7 @@ void NetworkClient::SendRequest_RGBController_UpdateSingleLED(unsigned int dev_i
     InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED, size);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    send_packet(&request_hdr, data, size);
     send_in_progress.unlock();
 }
 
@@ -947,7 +1185,7 @@ void NetworkClient::SendRequest_RGBController_SetCustomMode(unsigned int dev_idx
     InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE, 0);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+    send_packet(&request_hdr, NULL, 0);
     send_in_progress.unlock();
 }
 
@@ -963,8 +1201,7 @@ void NetworkClient::SendRequest_RGBController_UpdateMode(unsigned int dev_idx, u
     InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE, size);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    send_packet(&request_hdr, data, size);
     send_in_progress.unlock();
 }
 
@@ -980,8 +1217,94 @@ void NetworkClient::SendRequest_RGBController_SaveMode(unsigned int dev_idx, uns
     InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_SAVEMODE, size);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&request_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)data, size, MSG_NOSIGNAL);
+    send_packet(&request_hdr, data, size);
+    send_in_progress.unlock();
+}
+
+void NetworkClient::SendRequest_RGBController_SetColorCorrection(unsigned int dev_idx, color_correction correction)
+{
+    if(change_in_progress)
+    {
+        return;
+    }
+
+    /*---------------------------------------------------------*\
+    | Color correction requires protocol version 6 or higher    |
+    \*---------------------------------------------------------*/
+    if(GetProtocolVersion() < 6)
+    {
+        return;
+    }
+
+    NetPacketHeader request_hdr;
+    unsigned char   request_data[(4 * sizeof(float)) + sizeof(unsigned char)];
+
+    InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_SETCOLORCORRECTION, sizeof(request_data));
+
+    memcpy(&request_data[0 * sizeof(float)], &correction.gamma,      sizeof(float));
+    memcpy(&request_data[1 * sizeof(float)], &correction.red_gain,   sizeof(float));
+    memcpy(&request_data[2 * sizeof(float)], &correction.green_gain, sizeof(float));
+    memcpy(&request_data[3 * sizeof(float)], &correction.blue_gain,  sizeof(float));
+    memcpy(&request_data[4 * sizeof(float)], &correction.brightness, sizeof(unsigned char));
+
+    send_in_progress.lock();
+    send_packet(&request_hdr, &request_data, sizeof(request_data));
+    send_in_progress.unlock();
+}
+
+void NetworkClient::SendRequest_RGBController_GetLatencyStats(unsigned int dev_idx)
+{
+    if(change_in_progress)
+    {
+        return;
+    }
+
+    NetPacketHeader request_hdr;
+
+    InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_GETLATENCYSTATS, 0);
+
+    send_in_progress.lock();
+    send_packet(&request_hdr, NULL, 0);
+    send_in_progress.unlock();
+}
+
+void NetworkClient::SendRequest_RGBController_GetHealth(unsigned int dev_idx)
+{
+    if(change_in_progress)
+    {
+        return;
+    }
+
+    NetPacketHeader request_hdr;
+
+    InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_GETHEALTH, 0);
+
+    send_in_progress.lock();
+    send_packet(&request_hdr, NULL, 0);
+    send_in_progress.unlock();
+}
+
+void NetworkClient::SendRequest_RGBController_SetLEDPositions(unsigned int dev_idx, unsigned char * data, unsigned int size)
+{
+    if(change_in_progress)
+    {
+        return;
+    }
+
+    /*---------------------------------------------------------*\
+    | LED positions require protocol version 9 or higher        |
+    \*---------------------------------------------------------*/
+    if(GetProtocolVersion() < 9)
+    {
+        return;
+    }
+
+    NetPacketHeader request_hdr;
+
+    InitNetPacketHeader(&request_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_SETLEDPOSITIONS, size);
+
+    send_in_progress.lock();
+    send_packet(&request_hdr, data, size);
     send_in_progress.unlock();
 }
 
@@ -992,8 +1315,7 @@ void NetworkClient::SendRequest_LoadProfile(std::string profile_name)
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_REQUEST_LOAD_PROFILE, (unsigned int)strlen(profile_name.c_str()) + 1);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)profile_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    send_packet(&reply_hdr, profile_name.c_str(), reply_hdr.pkt_size);
     send_in_progress.unlock();
 }
 
@@ -1004,8 +1326,7 @@ void NetworkClient::SendRequest_SaveProfile(std::string profile_name)
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_REQUEST_SAVE_PROFILE, (unsigned int)strlen(profile_name.c_str()) + 1);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)profile_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    send_packet(&reply_hdr, profile_name.c_str(), reply_hdr.pkt_size);
     send_in_progress.unlock();
 }
 
@@ -1016,8 +1337,7 @@ void NetworkClient::SendRequest_DeleteProfile(std::string profile_name)
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_REQUEST_DELETE_PROFILE, (unsigned int)strlen(profile_name.c_str()) + 1);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
-    send(client_sock, (char *)profile_name.c_str(), reply_hdr.pkt_size, MSG_NOSIGNAL);
+    send_packet(&reply_hdr, profile_name.c_str(), reply_hdr.pkt_size);
     send_in_progress.unlock();
 }
 
@@ -1028,7 +1348,7 @@ void NetworkClient::SendRequest_GetProfileList()
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_REQUEST_PROFILE_LIST, 0);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&reply_hdr, sizeof(NetPacketHeader), MSG_NOSIGNAL);
+    send_packet(&reply_hdr, NULL, 0);
     send_in_progress.unlock();
 }
 
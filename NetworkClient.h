@@ -15,6 +15,7 @@
 #include <thread>
 #include <condition_variable>
 #include "RGBController.h"
+#include "RGBControllerIdleMonitor.h"
 #include "NetworkProtocol.h"
 #include "net_port.h"
 
@@ -34,6 +35,8 @@ public:
     unsigned int    GetProtocolVersion();
     bool            GetOnline();
 
+    idle_stats      GetServerIdleStats();
+
     void            ClearCallbacks();
     void            RegisterClientInfoChangeCallback(NetClientCallback new_callback, void * new_callback_arg);
 
@@ -49,9 +52,14 @@ public:
 
     void            WaitOnControllerData();
 
+    void            UpdateLEDsGroup(std::vector<RGBController *>& group, bool commit_together);
+
     void        ProcessReply_ControllerCount(unsigned int data_size, char * data);
     void        ProcessReply_ControllerData(unsigned int data_size, char * data, unsigned int dev_idx);
     void        ProcessReply_ProtocolVersion(unsigned int data_size, char * data);
+    void        ProcessReply_RGBController_LatencyStats(unsigned int data_size, char * data, unsigned int dev_idx);
+    void        ProcessReply_RGBController_Health(unsigned int data_size, char * data, unsigned int dev_idx);
+    void        ProcessReply_IdleStats(unsigned int data_size, char * data);
 
     void        ProcessRequest_DeviceListChanged();
 
@@ -60,6 +68,7 @@ public:
     void        SendRequest_ControllerCount();
     void        SendRequest_ControllerData(unsigned int dev_idx);
     void        SendRequest_ProtocolVersion();
+    void        SendRequest_IdleStats();
 
     void        SendRequest_RescanDevices();
 
@@ -70,12 +79,22 @@ public:
     void        SendRequest_RGBController_UpdateLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size);
     void        SendRequest_RGBController_UpdateZoneLEDs(unsigned int dev_idx, unsigned char * data, unsigned int size);
     void        SendRequest_RGBController_UpdateSingleLED(unsigned int dev_idx, unsigned char * data, unsigned int size);
+    void        SendRequest_RGBController_UpdateLEDsGroup(unsigned char * data, unsigned int size);
+    void        SendRequest_RGBController_UpdateLEDsEncoded(unsigned int dev_idx, unsigned char * data, unsigned int size);
 
     void        SendRequest_RGBController_SetCustomMode(unsigned int dev_idx);
 
     void        SendRequest_RGBController_UpdateMode(unsigned int dev_idx, unsigned char * data, unsigned int size);
     void        SendRequest_RGBController_SaveMode(unsigned int dev_idx, unsigned char * data, unsigned int size);
 
+    void        SendRequest_RGBController_SetColorCorrection(unsigned int dev_idx, color_correction correction);
+
+    void        SendRequest_RGBController_GetLatencyStats(unsigned int dev_idx);
+
+    void        SendRequest_RGBController_GetHealth(unsigned int dev_idx);
+
+    void        SendRequest_RGBController_SetLEDPositions(unsigned int dev_idx, unsigned char * data, unsigned int size);
+
 
     std::vector<std::string> * ProcessReply_ProfileList(unsigned int data_size, char * data);
 
@@ -118,12 +137,25 @@ private:
     std::mutex      connection_mutex;
     std::condition_variable connection_cv;
 
+    idle_stats      server_idle_stats;
+    bool            server_idle_stats_received;
+    std::mutex      server_idle_stats_mutex;
+    std::condition_variable server_idle_stats_cv;
+
     std::thread *   ConnectionThread;
     std::thread *   ListenThread;
 
+    /*---------------------------------------------------------*\
+    | Buffers for grouped LED updates, reused between frames    |
+    \*---------------------------------------------------------*/
+    std::mutex                  update_group_mutex;
+    std::vector<unsigned char>  update_group_buf;
+    std::vector<unsigned char>  update_group_colors;
+
     std::mutex                          ClientInfoChangeMutex;
     std::vector<NetClientCallback>      ClientInfoChangeCallbacks;
     std::vector<void *>                 ClientInfoChangeCallbackArgs;
 
     int recv_select(SOCKET s, char *buf, int len, int flags);
+    int send_packet(NetPacketHeader * header, const void * data, unsigned int size);
 };
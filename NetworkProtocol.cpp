@@ -9,6 +9,7 @@
 |   SPDX-License-Identifier: GPL-2.0-or-later               |
 \*---------------------------------------------------------*/
 
+#include <algorithm>
 #include <cstring>
 #include "NetworkProtocol.h"
 
@@ -31,3 +32,106 @@ void InitNetPacketHeader
     pkt_hdr->pkt_id       = pkt_id;
     pkt_hdr->pkt_size     = pkt_size;
 }
+
+NetPacketReader::NetPacketReader()
+{
+    Reset();
+}
+
+void NetPacketReader::Reset()
+{
+    read_pos    = 0;
+    write_pos   = 0;
+    packet_size = 0;
+}
+
+char * NetPacketReader::GetReceiveBuffer(unsigned int * size)
+{
+    /*-----------------------------------------------------*\
+    | Move unread bytes to the front of the buffer when the |
+    | free space at the end runs low or the packet being    |
+    | received would not fit                                |
+    \*-----------------------------------------------------*/
+    if(read_pos == write_pos)
+    {
+        read_pos    = 0;
+        write_pos   = 0;
+    }
+    else if((read_pos > 0)
+         && (((buffer.size() - write_pos) < NET_PACKET_READER_CHUNK_SIZE)
+          || (buffer.size() < ((std::size_t)read_pos + packet_size))))
+    {
+        memmove(buffer.data(), buffer.data() + read_pos, write_pos - read_pos);
+
+        write_pos  -= read_pos;
+        read_pos    = 0;
+    }
+
+    /*-----------------------------------------------------*\
+    | Grow the buffer to fit the packet being received, and |
+    | always leave room for at least one chunk              |
+    \*-----------------------------------------------------*/
+    std::size_t needed_size = std::max((std::size_t)read_pos + packet_size, (std::size_t)write_pos + NET_PACKET_READER_CHUNK_SIZE);
+
+    if(buffer.size() < needed_size)
+    {
+        buffer.resize(needed_size);
+    }
+
+    *size = (unsigned int)(buffer.size() - write_pos);
+
+    return(buffer.data() + write_pos);
+}
+
+void NetPacketReader::Received(unsigned int bytes)
+{
+    write_pos += bytes;
+}
+
+int NetPacketReader::NextPacket(NetPacketHeader * header, char ** data)
+{
+    packet_size = 0;
+
+    /*-----------------------------------------------------*\
+    | Skip bytes until the buffer starts with magic "ORGB"  |
+    \*-----------------------------------------------------*/
+    while(read_pos < write_pos)
+    {
+        unsigned int magic_bytes = std::min(write_pos - read_pos, (unsigned int)sizeof(openrgb_sdk_magic));
+
+        if(memcmp(buffer.data() + read_pos, openrgb_sdk_magic, magic_bytes) == 0)
+        {
+            break;
+        }
+
+        read_pos++;
+    }
+
+    if((write_pos - read_pos) < sizeof(NetPacketHeader))
+    {
+        return(NET_PACKET_INCOMPLETE);
+    }
+
+    memcpy(header, buffer.data() + read_pos, sizeof(NetPacketHeader));
+
+    if(header->pkt_size > NET_PACKET_MAX_DATA_SIZE)
+    {
+        return(NET_PACKET_TOO_LARGE);
+    }
+
+    /*-----------------------------------------------------*\
+    | Wait for the rest of the packet, remembering its size |
+    | so that the next receive has room for all of it       |
+    \*-----------------------------------------------------*/
+    if((write_pos - read_pos - sizeof(NetPacketHeader)) < header->pkt_size)
+    {
+        packet_size = (unsigned int)sizeof(NetPacketHeader) + header->pkt_size;
+
+        return(NET_PACKET_INCOMPLETE);
+    }
+
+    *data       = (header->pkt_size > 0) ? (buffer.data() + read_pos + sizeof(NetPacketHeader)) : NULL;
+    read_pos   += (unsigned int)sizeof(NetPacketHeader) + header->pkt_size;
+
+    return(NET_PACKET_READY);
+}
@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <vector>
+
 /*---------------------------------------------------------------------*\
 | OpenRGB SDK protocol version                                          |
 |                                                                       |
@@ -21,8 +23,16 @@
 |   4:      Add segments field to zones, network plugins (Release 0.9)  |
 |   5:      Zone flags, controller flags, resizable effects-only zones  |
                 (Release 1.0)                                           |
+|   6:      Per-device color correction                                 |
+|   7:      32-bit LED, color, and matrix size counts                   |
+|   8:      Per-device frame latency statistics                         |
+|   9:      Per-LED physical positions                                  |
+|   10:     Per-device health state and health change notifications     |
+|   11:     Idle state and thread wakeup statistics                     |
+|   12:     Grouped UpdateLEDs for several devices in one packet        |
+|   13:     Encoded UpdateLEDs with changed runs of packed RGB values   |
 \*---------------------------------------------------------------------*/
-#define OPENRGB_SDK_PROTOCOL_VERSION    5
+#define OPENRGB_SDK_PROTOCOL_VERSION    13
 
 /*-----------------------------------------------------*\
 | Default Interface to bind to.                         |
@@ -73,6 +83,8 @@ enum
     NET_PACKET_ID_REQUEST_PLUGIN_LIST           = 200,  /* Request list of plugins                              */
     NET_PACKET_ID_PLUGIN_SPECIFIC               = 201,  /* Interact with a plugin                               */
 
+    NET_PACKET_ID_REQUEST_IDLE_STATS            = 250,  /* Request idle state and thread wakeup statistics      */
+
     /*----------------------------------------------------------------------------------------------------------*\
     | RGBController class functions                                                                              |
     \*----------------------------------------------------------------------------------------------------------*/
@@ -83,10 +95,30 @@ enum
     NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS      = 1050, /* RGBController::UpdateLEDs()                          */
     NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS  = 1051, /* RGBController::UpdateZoneLEDs()                      */
     NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED = 1052, /* RGBController::UpdateSingleLED()                     */
+    NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSGROUP = 1053, /* RGBController::UpdateLEDs() on a group of devices    */
+    NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSENCODED = 1054, /* RGBController::UpdateLEDs() with encoded colors  */
 
     NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE   = 1100, /* RGBController::SetCustomMode()                       */
     NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE      = 1101, /* RGBController::UpdateMode()                          */
     NET_PACKET_ID_RGBCONTROLLER_SAVEMODE        = 1102, /* RGBController::SaveMode()                            */
+
+    NET_PACKET_ID_RGBCONTROLLER_SETCOLORCORRECTION = 1150, /* RGBController::SetColorCorrection()               */
+
+    NET_PACKET_ID_RGBCONTROLLER_GETLATENCYSTATS = 1200, /* RGBController::GetLatencyStats()                     */
+
+    NET_PACKET_ID_RGBCONTROLLER_SETLEDPOSITIONS = 1250, /* RGBController::SetLEDPositions()                     */
+
+    NET_PACKET_ID_RGBCONTROLLER_GETHEALTH       = 1300, /* RGBController::GetHealth()                           */
+    NET_PACKET_ID_RGBCONTROLLER_HEALTHCHANGED   = 1301, /* Indicate to clients that device health has changed   */
+};
+
+/*-----------------------------------------------------*\
+| NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSGROUP flags     |
+\*-----------------------------------------------------*/
+enum
+{
+    NET_UPDATELEDSGROUP_FLAG_COMMIT_TOGETHER    = (1 << 0), /* Commit the frames as one frame group */
+    NET_UPDATELEDSGROUP_FLAG_ENCODED            = (1 << 1), /* Device colors are encoded (13+)      */
 };
 
 void InitNetPacketHeader
@@ -96,3 +128,51 @@ void InitNetPacketHeader
     unsigned int        pkt_id,
     unsigned int        pkt_size
     );
+
+/*-----------------------------------------------------*\
+| Largest packet data accepted by NetPacketReader and   |
+| the least free space offered to each receive call     |
+\*-----------------------------------------------------*/
+#define NET_PACKET_MAX_DATA_SIZE        (16 * 1024 * 1024)
+#define NET_PACKET_READER_CHUNK_SIZE    (64 * 1024)
+
+enum
+{
+    NET_PACKET_INCOMPLETE,                          /* More data must be received       */
+    NET_PACKET_READY,                               /* A complete packet was read       */
+    NET_PACKET_TOO_LARGE,                           /* Packet data exceeds the limit    */
+};
+
+/*-----------------------------------------------------*\
+| NetPacketReader                                       |
+|   Buffers the bytes received on one connection so     |
+|   that each receive call can take everything that is  |
+|   available and several pipelined packets can be read |
+|   from it.  Unread bytes are moved to the front of    |
+|   the buffer before receiving more, so every packet's |
+|   data is contiguous and is returned in place.  The   |
+|   buffer only grows to fit the largest packet seen.   |
+|                                                       |
+|   Receive into GetReceiveBuffer(), pass the number of |
+|   bytes received to Received(), then call             |
+|   NextPacket() until it stops returning               |
+|   NET_PACKET_READY.  Data returned by NextPacket() is |
+|   valid until the next call to GetReceiveBuffer().    |
+\*-----------------------------------------------------*/
+class NetPacketReader
+{
+public:
+    NetPacketReader();
+
+    char *              GetReceiveBuffer(unsigned int * size);
+    void                Received(unsigned int bytes);
+    int                 NextPacket(NetPacketHeader * header, char ** data);
+
+    void                Reset();
+
+private:
+    std::vector<char>   buffer;
+    unsigned int        read_pos;
+    unsigned int        write_pos;
+    unsigned int        packet_size;
+};
@@ -12,13 +12,20 @@
 #include <cstring>
 #include "NetworkServer.h"
 #include "LogManager.h"
+#include "RGBControllerIdleMonitor.h"
+
+#include <algorithm>
 
 #ifndef WIN32
 #include <sys/ioctl.h>
 #include <netinet/tcp.h>
 #include <sys/types.h>
 #include <arpa/inet.h>
-#else
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#ifdef WIN32
 #include <ws2tcpip.h>
 #endif
 #include <memory.h>
@@ -36,13 +43,32 @@ const char yes = 1;
 
 using namespace std::chrono_literals;
 
+#ifdef _WIN32
+#define MSG_NOSIGNAL 0
+#endif
+
+/*---------------------------------------------------------*\
+| Check whether a socket call failed only because the       |
+| nonblocking socket was not ready                          |
+\*---------------------------------------------------------*/
+static bool SocketWouldBlock()
+{
+#ifdef _WIN32
+    return(WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR));
+#endif
+}
+
 NetworkClientInfo::NetworkClientInfo()
 {
     client_string           = "Client";
     client_ip               = OPENRGB_SDK_HOST;
     client_sock             = INVALID_SOCKET;
-    client_listen_thread    = nullptr;
     client_protocol_version = 0;
+    send_offset             = 0;
+    send_failed             = false;
+    send_waiting            = false;
 }
 
 NetworkClientInfo::~NetworkClientInfo()
@@ -50,7 +76,6 @@ NetworkClientInfo::~NetworkClientInfo()
     if(client_sock != INVALID_SOCKET)
     {
         LOG_INFO("[NetworkServer] Closing server connection: %s", client_ip.c_str());
-        delete client_listen_thread;
         shutdown(client_sock, SD_RECEIVE);
         closesocket(client_sock);
     }
@@ -63,11 +88,15 @@ NetworkServer::NetworkServer(std::vector<RGBController *>& control) : controller
     server_online               = false;
     server_listening            = false;
     legacy_workaround_enabled   = false;
-
-    for(int i = 0; i < MAXSOCK; i++)
-    {
-        ConnectionThread[i] = nullptr;
-    }
+    max_clients                 = NET_SERVER_DEFAULT_MAX_CLIENTS;
+    socket_count                = 0;
+    ServerThread                = nullptr;
+    GroupCommitThread           = nullptr;
+    group_commit_running        = false;
+    RequestWorkerThread         = nullptr;
+    request_work_running        = false;
+    wake_sock[0]                = INVALID_SOCKET;
+    wake_sock[1]                = INVALID_SOCKET;
 
     profile_manager  = nullptr;
 }
@@ -92,16 +121,105 @@ void NetworkServer::ClientInfoChanged()
     ClientInfoChangeMutex.unlock();
 }
 
+static void NetworkServerHealthChangeCallback(void* this_ptr, RGBController* controller, device_health health)
+{
+    NetworkServer* this_obj = (NetworkServer*)this_ptr;
+
+    this_obj->ControllerHealthChanged(controller, health);
+}
+
 void NetworkServer::DeviceListChanged()
 {
     /*---------------------------------------------------------*\
     | Indicate to the clients that the controller list has      |
     | changed                                                   |
     \*---------------------------------------------------------*/
+    ServerClientsMutex.lock();
+
     for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
     {
         SendRequest_DeviceListChanged(ServerClients[client_idx]->client_sock);
     }
+
+    ServerClientsMutex.unlock();
+
+    /*---------------------------------------------------------*\
+    | Track the health of the new controller list.  Clients     |
+    | request the controller data again, which they can follow  |
+    | with GetHealth(), so only later changes are sent.         |
+    \*---------------------------------------------------------*/
+    ControllerHealthMutex.lock();
+
+    health_controllers = controllers;
+
+    ControllerHealthMutex.unlock();
+
+    /*---------------------------------------------------------*\
+    | Drop commits for controllers that may have been removed   |
+    \*---------------------------------------------------------*/
+    GroupCommitMutex.lock();
+
+    group_commit_pending.clear();
+
+    GroupCommitMutex.unlock();
+
+    RequestWorkMutex.lock();
+
+    request_work_pending.erase(std::remove_if(request_work_pending.begin(), request_work_pending.end(), [](const NetworkServerWork& work)
+    {
+        return(work.controller != nullptr);
+    }), request_work_pending.end());
+
+    RequestWorkMutex.unlock();
+
+    for(unsigned int controller_idx = 0; controller_idx < controllers.size(); controller_idx++)
+    {
+        controllers[controller_idx]->UnregisterHealthCallback(this);
+        controllers[controller_idx]->RegisterHealthCallback(NetworkServerHealthChangeCallback, this);
+    }
+}
+
+/*---------------------------------------------------------*\
+| ControllerHealthChanged                                   |
+|   Called from a controller's update thread when its       |
+|   health state changes.  Sends the new health to all      |
+|   clients that support protocol 10.  The health is passed |
+|   in by the controller, so that the state sent is the one |
+|   that changed.                                           |
+\*---------------------------------------------------------*/
+void NetworkServer::ControllerHealthChanged(RGBController * controller, device_health health)
+{
+    ControllerHealthMutex.lock();
+
+    std::vector<RGBController *>::iterator controller_it = std::find(health_controllers.begin(), health_controllers.end(), controller);
+    bool                                   controller_found = (controller_it != health_controllers.end());
+    unsigned int                           controller_idx   = (unsigned int)(controller_it - health_controllers.begin());
+
+    ControllerHealthMutex.unlock();
+
+    /*---------------------------------------------------------*\
+    | Ignore controllers the clients have not been told about   |
+    \*---------------------------------------------------------*/
+    if(!controller_found)
+    {
+        return;
+    }
+
+    std::vector<unsigned char> health_data;
+
+    device_health_to_description(health, health_data);
+
+    ServerClientsMutex.lock();
+
+    for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+    {
+        if(ServerClients[client_idx]->client_protocol_version >= 10)
+        {
+            SendRequest_HealthChanged(ServerClients[client_idx]->client_sock, controller_idx, health_data);
+        }
+    }
+
+    ServerClientsMutex.unlock();
 }
 
 void NetworkServer::ServerListeningChanged()
@@ -141,6 +259,8 @@ bool NetworkServer::GetListening()
 
 unsigned int NetworkServer::GetNumClients()
 {
+    std::lock_guard<std::mutex> lock(ServerClientsMutex);
+
     return (unsigned int)ServerClients.size();
 }
 
@@ -229,6 +349,16 @@ void NetworkServer::SetLegacyWorkaroundEnable(bool enable)
     legacy_workaround_enabled = enable;
 }
 
+void NetworkServer::SetMaxClients(unsigned int new_max_clients)
+{
+    max_clients = new_max_clients;
+}
+
+unsigned int NetworkServer::GetMaxClients()
+{
+    return(max_clients);
+}
+
 void NetworkServer::SetPort(unsigned short new_port)
 {
     if(server_online == false)
@@ -335,16 +465,35 @@ void NetworkServer::StartServer()
     }
 
     freeaddrinfo(result);
-    server_online = true;
 
     /*---------------------------------------------------------*\
-    | Start the connection thread                               |
+    | Create the socket pair that wakes the server thread.      |
+    | Both ends are nonblocking, as a full wakeup socket means  |
+    | a wakeup is already pending.                              |
     \*---------------------------------------------------------*/
-    for(int curr_socket = 0; curr_socket < socket_count; curr_socket++)
+    if(!net_socket_pair(wake_sock))
     {
-        ConnectionThread[curr_socket] = new std::thread(&NetworkServer::ConnectionThreadFunction, this, curr_socket);
-        ConnectionThread[curr_socket]->detach();
+        LOG_ERROR("[NetworkServer] Could not create server thread wakeup sockets.");
+        WSACleanup();
+        return;
     }
+
+    u_long arg = 1;
+    ioctlsocket(wake_sock[0], FIONBIO, &arg);
+    ioctlsocket(wake_sock[1], FIONBIO, &arg);
+
+    server_online = true;
+
+    /*---------------------------------------------------------*\
+    | Start the group commit, request worker, and server        |
+    | threads                                                   |
+    \*---------------------------------------------------------*/
+    group_commit_running = true;
+    request_work_running = true;
+
+    GroupCommitThread   = new std::thread(&NetworkServer::GroupCommitThreadFunction, this);
+    RequestWorkerThread = new std::thread(&NetworkServer::RequestWorkerThreadFunction, this);
+    ServerThread        = new std::thread(&NetworkServer::ServerThreadFunction, this);
 }
 
 void NetworkServer::StopServer()
@@ -352,6 +501,54 @@ void NetworkServer::StopServer()
     int curr_socket;
     server_online = false;
 
+    /*---------------------------------------------------------*\
+    | Wake the server thread and wait for it to close           |
+    \*---------------------------------------------------------*/
+    WakeServerThread();
+
+    if(ServerThread)
+    {
+        ServerThread->join();
+        delete ServerThread;
+        ServerThread = nullptr;
+    }
+
+    /*---------------------------------------------------------*\
+    | Stop the group commit thread once no more groups can      |
+    | arrive                                                    |
+    \*---------------------------------------------------------*/
+    GroupCommitMutex.lock();
+    group_commit_running = false;
+    group_commit_pending.clear();
+    GroupCommitMutex.unlock();
+
+    GroupCommitCV.notify_one();
+
+    if(GroupCommitThread)
+    {
+        GroupCommitThread->join();
+        delete GroupCommitThread;
+        GroupCommitThread = nullptr;
+    }
+
+    /*---------------------------------------------------------*\
+    | Stop the request worker thread, dropping work that has    |
+    | not started                                               |
+    \*---------------------------------------------------------*/
+    RequestWorkMutex.lock();
+    request_work_running = false;
+    request_work_pending.clear();
+    RequestWorkMutex.unlock();
+
+    RequestWorkCV.notify_one();
+
+    if(RequestWorkerThread)
+    {
+        RequestWorkerThread->join();
+        delete RequestWorkerThread;
+        RequestWorkerThread = nullptr;
+    }
+
     ServerClientsMutex.lock();
 
     for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
@@ -363,621 +560,1103 @@ void NetworkServer::StopServer()
 
     for(curr_socket = 0; curr_socket < socket_count; curr_socket++)
     {
-        shutdown(server_sock[curr_socket], SD_RECEIVE);
         closesocket(server_sock[curr_socket]);
     }
 
     ServerClientsMutex.unlock();
 
-    for(curr_socket = 0; curr_socket < socket_count; curr_socket++)
+    socket_count = 0;
+
+    for(int wake_idx = 0; wake_idx < 2; wake_idx++)
     {
-        if(ConnectionThread[curr_socket])
+        if(wake_sock[wake_idx] != INVALID_SOCKET)
         {
-            delete ConnectionThread[curr_socket];
-            ConnectionThread[curr_socket] = nullptr;
+            closesocket(wake_sock[wake_idx]);
+            wake_sock[wake_idx] = INVALID_SOCKET;
         }
     }
 
-    socket_count = 0;
-
     /*---------------------------------------------------------*\
     | Client info has changed, call the callbacks               |
     \*---------------------------------------------------------*/
     ClientInfoChanged();
 }
 
-void NetworkServer::ConnectionThreadFunction(int socket_idx)
+void NetworkServer::ServerThreadFunction()
 {
     /*---------------------------------------------------------*\
-    | This thread handles client connections                    |
+    | This thread accepts client connections and receives and   |
+    | handles the packets of every client                       |
     \*---------------------------------------------------------*/
-    LOG_INFO("[NetworkServer] Network connection thread started on port %hu", GetPort());
+    LOG_INFO("[NetworkServer] Network server thread started on port %hu", GetPort());
 
-    while(server_online == true)
+#ifdef __linux__
+    int epoll_fd = epoll_create1(0);
+
+    if(epoll_fd < 0)
     {
-        /*---------------------------------------------------------*\
-        | Create new socket for client connection                   |
-        \*---------------------------------------------------------*/
-        NetworkClientInfo * client_info = new NetworkClientInfo();
+        LOG_ERROR("[NetworkServer] Could not create epoll instance");
+        server_online = false;
+
+        return;
+    }
+#endif
+
+    /*---------------------------------------------------------*\
+    | Listen for incoming client connections on each server     |
+    | socket.  Server sockets are nonblocking so that accepting |
+    | stops once no connections are pending.                    |
+    \*---------------------------------------------------------*/
+    for(int socket_idx = 0; socket_idx < socket_count; socket_idx++)
+    {
+        u_long arg = 1;
+        ioctlsocket(server_sock[socket_idx], FIONBIO, &arg);
 
-        /*---------------------------------------------------------*\
-        | Listen for incoming client connection on the server       |
-        | socket.  This call blocks until a connection is           |
-        | established                                               |
-        \*---------------------------------------------------------*/
         if(listen(server_sock[socket_idx], 10) < 0)
         {
-            LOG_INFO("[NetworkServer] Connection thread closed");
+            LOG_INFO("[NetworkServer] Server thread closed");
             server_online = false;
 
+#ifdef __linux__
+            close(epoll_fd);
+#endif
             return;
         }
 
-        server_listening = true;
-        ServerListeningChanged();
-
-        /*---------------------------------------------------------*\
-        | Accept the client connection                              |
-        \*---------------------------------------------------------*/
-        client_info->client_sock = accept_select((int)server_sock[socket_idx]);
+#ifdef __linux__
+        struct epoll_event event;
 
-        if(client_info->client_sock < 0)
-        {
-            LOG_INFO("[NetworkServer] Connection thread closed");
-            server_online = false;
+        event.events    = EPOLLIN;
+        event.data.fd   = server_sock[socket_idx];
 
-            server_listening = false;
-            ServerListeningChanged();
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_sock[socket_idx], &event);
+#endif
+    }
 
-            return;
-        }
+#ifdef __linux__
+    /*---------------------------------------------------------*\
+    | Wake up when another thread writes to the wakeup socket   |
+    \*---------------------------------------------------------*/
+    struct epoll_event wake_event;
 
-        /*---------------------------------------------------------*\
-        | Get the new client socket and store it in the clients     |
-        | vector                                                    |
-        \*---------------------------------------------------------*/
-        u_long arg = 0;
-        ioctlsocket(client_info->client_sock, FIONBIO, &arg);
-        setsockopt(client_info->client_sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    wake_event.events   = EPOLLIN;
+    wake_event.data.fd  = wake_sock[1];
 
-        /*---------------------------------------------------------*\
-        | Discover the remote hosts IP                              |
-        \*---------------------------------------------------------*/
-        struct sockaddr_storage tmp_addr;
-        char ipstr[INET6_ADDRSTRLEN];
-        socklen_t len;
-        len = sizeof(tmp_addr);
-        getpeername(client_info->client_sock, (struct sockaddr*)&tmp_addr, &len);
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_sock[1], &wake_event);
+#endif
 
-        if(tmp_addr.ss_family == AF_INET)
-        {
-            struct sockaddr_in *s_4 = (struct sockaddr_in *)&tmp_addr;
-            inet_ntop(AF_INET, &s_4->sin_addr, ipstr, sizeof(ipstr));
-            client_info->client_ip = ipstr;
-        }
-        else
-        {
-            struct sockaddr_in6 *s_6 = (struct sockaddr_in6 *)&tmp_addr;
-            inet_ntop(AF_INET6, &s_6->sin6_addr, ipstr, sizeof(ipstr));
-            client_info->client_ip = ipstr;
-        }
+    server_listening = true;
+    ServerListeningChanged();
 
-        /*---------------------------------------------------------*\
-        | We need to lock before the thread could possibly finish   |
-        \*---------------------------------------------------------*/
-        ServerClientsMutex.lock();
+    while(server_online == true)
+    {
+        std::vector<SOCKET> read_socks;
+        std::vector<SOCKET> write_socks;
 
         /*---------------------------------------------------------*\
-        | Start a listener thread for the new client socket         |
+        | Close clients whose data could not be sent or queued, and |
+        | wait for writability on clients with queued data          |
         \*---------------------------------------------------------*/
-        client_info->client_listen_thread = new std::thread(&NetworkServer::ListenThreadFunction, this, client_info);
-        client_info->client_listen_thread->detach();
-
-        ServerClients.push_back(client_info);
-        ServerClientsMutex.unlock();
+        for(std::size_t client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+        {
+            NetworkClientInfo * client_info = ServerClients[client_idx];
 
-        /*---------------------------------------------------------*\
-        | Client info has changed, call the callbacks               |
-        \*---------------------------------------------------------*/
-        ClientInfoChanged();
-    }
+            client_info->send_mutex.lock();
+            bool send_failed    = client_info->send_failed;
+            bool send_pending   = (client_info->send_offset < client_info->send_queue.size());
+            client_info->send_mutex.unlock();
 
-    LOG_INFO("[NetworkServer] Connection thread closed");
-    server_online = false;
-    server_listening = false;
-    ServerListeningChanged();
-}
+            if(send_failed)
+            {
+#ifdef __linux__
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_info->client_sock, NULL);
+#endif
 
-int NetworkServer::accept_select(int sockfd)
-{
-    fd_set              set;
-    struct timeval      timeout;
+                RemoveClient(client_info);
+                client_idx--;
+                continue;
+            }
 
-    while(1)
-    {
-        timeout.tv_sec          = TCP_TIMEOUT_SECONDS;
-        timeout.tv_usec         = 0;
+#ifdef __linux__
+            if(send_pending != client_info->send_waiting)
+            {
+                struct epoll_event event;
 
-        FD_ZERO(&set);
-        FD_SET(sockfd, &set);
+                event.events    = EPOLLIN | (send_pending ? (uint32_t)EPOLLOUT : 0u);
+                event.data.fd   = client_info->client_sock;
 
-        int rv = select(sockfd + 1, &set, NULL, NULL, &timeout);
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client_info->client_sock, &event);
+            }
+#endif
 
-        if(rv == SOCKET_ERROR || server_online == false)
-        {
-            return -1;
-        }
-        else if(rv == 0)
-        {
-            continue;
-        }
-        else
-        {
-            return(accept((int)sockfd, NULL, NULL));
+            client_info->send_waiting = send_pending;
         }
-    }
-}
 
-int NetworkServer::recv_select(SOCKET s, char *buf, int len, int flags)
-{
-    fd_set              set;
-    struct timeval      timeout;
-
-    while(1)
-    {
-        timeout.tv_sec          = TCP_TIMEOUT_SECONDS;
-        timeout.tv_usec         = 0;
+        /*---------------------------------------------------------*\
+        | Wait for any socket to become ready, timing out less      |
+        | often while output is idle                                |
+        \*---------------------------------------------------------*/
+        int timeout_sec = RGBControllerIdleMonitor::get()->IsIdle() ? TCP_IDLE_TIMEOUT_SECONDS : TCP_TIMEOUT_SECONDS;
 
-        FD_ZERO(&set);
-        FD_SET(s, &set);
+#ifdef __linux__
+        struct epoll_event events[NET_SERVER_MAX_EVENTS];
 
-        int rv = select((int)s + 1, &set, NULL, NULL, &timeout);
+        int rv = epoll_wait(epoll_fd, events, NET_SERVER_MAX_EVENTS, timeout_sec * 1000);
 
-        if(rv == SOCKET_ERROR || server_online == false)
-        {
-            return 0;
-        }
-        else if(rv == 0)
+        if(rv < 0 && errno == EINTR)
         {
             continue;
         }
-        else
-        {
-            return(recv(s, buf, len, flags));
-        }
-    }
-}
-
-void NetworkServer::ListenThreadFunction(NetworkClientInfo * client_info)
-{
-    SOCKET client_sock = client_info->client_sock;
-
-    LOG_INFO("[NetworkServer] Network server started");
-
-    /*---------------------------------------------------------*\
-    | This thread handles messages received from clients        |
-    \*---------------------------------------------------------*/
-    while(server_online == true)
-    {
-        NetPacketHeader header;
-        int             bytes_read  = 0;
-        char *          data        = NULL;
 
-        for(unsigned int i = 0; i < 4; i++)
+        for(int event_idx = 0; event_idx < rv; event_idx++)
         {
-            /*---------------------------------------------------------*\
-            | Read byte of magic                                        |
-            \*---------------------------------------------------------*/
-            bytes_read = recv_select(client_sock, &header.pkt_magic[i], 1, 0);
-
-            if(bytes_read <= 0)
+            if(events[event_idx].events & EPOLLOUT)
             {
-                LOG_ERROR("[NetworkServer] recv_select failed receiving magic, closing listener");
-                goto listen_done;
+                write_socks.push_back(events[event_idx].data.fd);
             }
 
-            /*---------------------------------------------------------*\
-            | Test characters of magic "ORGB"                           |
-            \*---------------------------------------------------------*/
-            if(header.pkt_magic[i] != openrgb_sdk_magic[i])
+            if(events[event_idx].events & ~EPOLLOUT)
             {
-                LOG_ERROR("[NetworkServer] Invalid magic received");
-                continue;
+                read_socks.push_back(events[event_idx].data.fd);
             }
         }
+#else
+        fd_set          read_set;
+        fd_set          write_set;
+        struct timeval  timeout;
+        SOCKET          max_sock = wake_sock[1];
 
-        /*---------------------------------------------------------*\
-        | If we get to this point, the magic is correct.  Read the  |
-        | rest of the header                                        |
-        \*---------------------------------------------------------*/
-        bytes_read = 0;
-        do
-        {
-            int tmp_bytes_read = 0;
+        timeout.tv_sec  = timeout_sec;
+        timeout.tv_usec = 0;
+
+        FD_ZERO(&read_set);
+        FD_ZERO(&write_set);
 
-            tmp_bytes_read = recv_select(client_sock, (char *)&header.pkt_dev_idx + bytes_read, sizeof(header) - sizeof(header.pkt_magic) - bytes_read, 0);
+        FD_SET(wake_sock[1], &read_set);
 
-            bytes_read += tmp_bytes_read;
+        for(int socket_idx = 0; socket_idx < socket_count; socket_idx++)
+        {
+            FD_SET(server_sock[socket_idx], &read_set);
+            max_sock = std::max(max_sock, server_sock[socket_idx]);
+        }
+
+        for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+        {
+            FD_SET(ServerClients[client_idx]->client_sock, &read_set);
+            max_sock = std::max(max_sock, ServerClients[client_idx]->client_sock);
 
-            if(tmp_bytes_read <= 0)
+            if(ServerClients[client_idx]->send_waiting)
             {
-                LOG_ERROR("[NetworkServer] recv_select failed receiving header, closing listener");
-                goto listen_done;
+                FD_SET(ServerClients[client_idx]->client_sock, &write_set);
             }
+        }
 
-        } while(bytes_read != sizeof(header) - sizeof(header.pkt_magic));
+        int rv = select((int)max_sock + 1, &read_set, &write_set, NULL, &timeout);
 
-        /*---------------------------------------------------------*\
-        | Header received, now receive the data                     |
-        \*---------------------------------------------------------*/
-        bytes_read = 0;
-        if(header.pkt_size > 0)
+        if(rv > 0)
         {
-            data = new char[header.pkt_size];
-
-            do
+            if(FD_ISSET(wake_sock[1], &read_set))
             {
-                int tmp_bytes_read = 0;
+                read_socks.push_back(wake_sock[1]);
+            }
 
-                tmp_bytes_read = recv_select(client_sock, &data[(unsigned int)bytes_read], header.pkt_size - bytes_read, 0);
+            for(int socket_idx = 0; socket_idx < socket_count; socket_idx++)
+            {
+                if(FD_ISSET(server_sock[socket_idx], &read_set))
+                {
+                    read_socks.push_back(server_sock[socket_idx]);
+                }
+            }
 
-                if(tmp_bytes_read <= 0)
+            for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+            {
+                if(FD_ISSET(ServerClients[client_idx]->client_sock, &write_set))
                 {
-                    LOG_ERROR("[NetworkServer] recv_select failed receiving data, closing listener");
-                    goto listen_done;
+                    write_socks.push_back(ServerClients[client_idx]->client_sock);
                 }
-                bytes_read += tmp_bytes_read;
 
-            } while ((unsigned int)bytes_read < header.pkt_size);
+                if(FD_ISSET(ServerClients[client_idx]->client_sock, &read_set))
+                {
+                    read_socks.push_back(ServerClients[client_idx]->client_sock);
+                }
+            }
         }
+#endif
 
-        /*---------------------------------------------------------*\
-        | Entire request received, select functionality based on    |
-        | request ID                                                |
-        \*---------------------------------------------------------*/
-        switch(header.pkt_id)
+        if(rv == SOCKET_ERROR || server_online == false)
         {
-            case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
-                SendReply_ControllerCount(client_sock);
-                break;
-
-            case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
-                {
-                    unsigned int protocol_version = 0;
+            break;
+        }
+        else if(rv == 0)
+        {
+            RGBControllerIdleMonitor::get()->RecordWakeup(IDLE_WAKEUP_SDK);
+            continue;
+        }
+
+        /*---------------------------------------------------------*\
+        | Send queued data to clients that can take more.  Clients  |
+        | that fail are closed at the top of the next pass.         |
+        \*---------------------------------------------------------*/
+        for(std::size_t write_idx = 0; write_idx < write_socks.size(); write_idx++)
+        {
+            for(std::size_t client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+            {
+                NetworkClientInfo * client_info = ServerClients[client_idx];
+
+                if(client_info->client_sock == write_socks[write_idx])
+                {
+                    client_info->send_mutex.lock();
 
-                    if(header.pkt_size == sizeof(unsigned int))
+                    if(!FlushSend(client_info))
                     {
-                        memcpy(&protocol_version, data, sizeof(unsigned int));
+                        client_info->send_failed = true;
                     }
 
-                    SendReply_ControllerData(client_sock, header.pkt_dev_idx, protocol_version);
+                    client_info->send_mutex.unlock();
+                    break;
                 }
-                break;
+            }
+        }
 
-            case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
-                SendReply_ProtocolVersion(client_sock);
-                ProcessRequest_ClientProtocolVersion(client_sock, header.pkt_size, data);
-                break;
+        for(std::size_t ready_idx = 0; ready_idx < read_socks.size(); ready_idx++)
+        {
+            SOCKET  ready_sock  = read_socks[ready_idx];
+            bool    is_server   = false;
 
-            case NET_PACKET_ID_SET_CLIENT_NAME:
-                if(data == NULL)
+            /*---------------------------------------------------------*\
+            | Drain the wakeup socket.  Whoever woke the thread has     |
+            | already changed the state that is checked on each pass.   |
+            \*---------------------------------------------------------*/
+            if(ready_sock == wake_sock[1])
+            {
+                char wake_buf[64];
+
+                while(recv(wake_sock[1], wake_buf, sizeof(wake_buf), 0) > 0)
                 {
-                    break;
                 }
 
-                ProcessRequest_ClientString(client_sock, header.pkt_size, data);
-                break;
-
-            case NET_PACKET_ID_REQUEST_RESCAN_DEVICES:
-                ProcessRequest_RescanDevices();
-                break;
+                continue;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_RESIZEZONE:
-                if(data == NULL)
+            for(int socket_idx = 0; socket_idx < socket_count; socket_idx++)
+            {
+                if(server_sock[socket_idx] == ready_sock)
                 {
+                    is_server = true;
                     break;
                 }
+            }
 
-                if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size == (2 * sizeof(int))))
+            /*---------------------------------------------------------*\
+            | Accept every pending connection on a server socket        |
+            \*---------------------------------------------------------*/
+            if(is_server)
+            {
+                NetworkClientInfo * client_info;
+
+                while((client_info = AcceptClient(ready_sock)) != nullptr)
                 {
-                    int zone;
-                    int new_size;
+#ifdef __linux__
+                    struct epoll_event event;
 
-                    memcpy(&zone, data, sizeof(int));
-                    memcpy(&new_size, data + sizeof(int), sizeof(int));
+                    event.events    = EPOLLIN;
+                    event.data.fd   = client_info->client_sock;
 
-                    controllers[header.pkt_dev_idx]->ResizeZone(zone, new_size);
-                    profile_manager->SaveProfile("sizes", true);
+                    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_info->client_sock, &event);
+#endif
+
+                    ServerClientsMutex.lock();
+                    ServerClients.push_back(client_info);
+                    ServerClientsMutex.unlock();
+
+                    /*---------------------------------------------------------*\
+                    | Client info has changed, call the callbacks               |
+                    \*---------------------------------------------------------*/
+                    ClientInfoChanged();
                 }
-                break;
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS:
-                if(data == NULL)
+                continue;
+            }
+
+            /*---------------------------------------------------------*\
+            | Receive from a client socket, closing the connection if   |
+            | it was closed or sent an invalid packet                   |
+            \*---------------------------------------------------------*/
+            NetworkClientInfo * client_info = nullptr;
+
+            for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+            {
+                if(ServerClients[client_idx]->client_sock == ready_sock)
                 {
+                    client_info = ServerClients[client_idx];
                     break;
                 }
+            }
 
-                /*---------------------------------------------------------*\
-                | Verify the color description size (first 4 bytes of data) |
-                | matches the packet size in the header                     |
-                |                                                           |
-                | If protocol version is 4 or below and the legacy SDK      |
-                | compatibility workaround is enabled, ignore this check.   |
-                | This allows backwards compatibility with old versions of  |
-                | SDK applications that didn't properly implement the size  |
-                | field.                                                    |
-                \*---------------------------------------------------------*/
-                if((header.pkt_size == *((unsigned int*)data))
-                || ((client_info->client_protocol_version <= 4)
-                 && (legacy_workaround_enabled)))
+            if(client_info != nullptr && !ReceiveClientData(client_info))
+            {
+#ifdef __linux__
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_info->client_sock, NULL);
+#endif
+
+                RemoveClient(client_info);
+            }
+        }
+    }
+
+#ifdef __linux__
+    close(epoll_fd);
+#endif
+
+    LOG_INFO("[NetworkServer] Server thread closed");
+    server_online = false;
+    server_listening = false;
+    ServerListeningChanged();
+}
+
+/*---------------------------------------------------------*\
+| GroupCommitThreadFunction                                 |
+|   Commit the controllers of grouped updates as frame      |
+|   groups, away from the server thread                     |
+\*---------------------------------------------------------*/
+void NetworkServer::GroupCommitThreadFunction()
+{
+    std::vector<RGBController *> commit_group;
+
+    std::unique_lock<std::mutex> lock(GroupCommitMutex);
+
+    while(1)
+    {
+        GroupCommitCV.wait(lock, [this]
+        {
+            return((group_commit_running == false)
+                || (group_commit_pending.empty() == false));
+        });
+
+        if(group_commit_running == false)
+        {
+            break;
+        }
+
+        commit_group.swap(group_commit_pending);
+        group_commit_pending.clear();
+
+        lock.unlock();
+
+        ResourceManager::get()->CommitFrameGroup(commit_group);
+
+        lock.lock();
+    }
+}
+
+/*---------------------------------------------------------*\
+| RequestWorkerThreadFunction                               |
+|   Run queued request work in the order it was queued,     |
+|   away from the server thread                             |
+\*---------------------------------------------------------*/
+void NetworkServer::RequestWorkerThreadFunction()
+{
+    std::vector<NetworkServerWork> work_list;
+
+    std::unique_lock<std::mutex> lock(RequestWorkMutex);
+
+    while(1)
+    {
+        RequestWorkCV.wait(lock, [this]
+        {
+            return((request_work_running == false)
+                || (request_work_pending.empty() == false));
+        });
+
+        if(request_work_running == false)
+        {
+            break;
+        }
+
+        work_list.swap(request_work_pending);
+        request_work_pending.clear();
+
+        lock.unlock();
+
+        for(std::size_t work_idx = 0; work_idx < work_list.size(); work_idx++)
+        {
+            work_list[work_idx].function();
+        }
+
+        work_list.clear();
+
+        lock.lock();
+    }
+}
+
+/*---------------------------------------------------------*\
+| QueueRequestWork                                          |
+|   Queue work for the request worker thread.  Pass the     |
+|   controller the work uses, or nullptr if it uses none,   |
+|   so that the work can be dropped if the controller list  |
+|   changes before it runs.                                 |
+\*---------------------------------------------------------*/
+void NetworkServer::QueueRequestWork(RGBController * controller, std::function<void()> function)
+{
+    NetworkServerWork work;
+
+    work.controller = controller;
+    work.function   = function;
+
+    RequestWorkMutex.lock();
+
+    request_work_pending.push_back(work);
+
+    RequestWorkMutex.unlock();
+
+    RequestWorkCV.notify_one();
+}
+
+/*---------------------------------------------------------*\
+| AcceptClient                                              |
+|   Accept a pending connection on a server socket.         |
+|   Returns nullptr once no connections are pending.        |
+|   Connections over the client limit are closed right away |
+\*---------------------------------------------------------*/
+NetworkClientInfo * NetworkServer::AcceptClient(SOCKET server_socket)
+{
+    while(1)
+    {
+        SOCKET client_sock = accept(server_socket, NULL, NULL);
+
+        if(client_sock == INVALID_SOCKET)
+        {
+            return(nullptr);
+        }
+
+        bool at_limit = (ServerClients.size() >= max_clients);
+
+#ifndef __linux__
+        /*---------------------------------------------------------*\
+        | select() can only wait on FD_SETSIZE sockets, including   |
+        | the wakeup socket                                         |
+        \*---------------------------------------------------------*/
+        at_limit = at_limit || ((ServerClients.size() + socket_count + 1) >= FD_SETSIZE);
+#ifndef WIN32
+        at_limit = at_limit || (client_sock >= FD_SETSIZE);
+#endif
+#endif
+
+        if(at_limit)
+        {
+            LOG_WARNING("[NetworkServer] Client limit of %u reached, closing new connection", max_clients.load());
+            closesocket(client_sock);
+            continue;
+        }
+
+        NetworkClientInfo * client_info = new NetworkClientInfo();
+
+        client_info->client_sock = client_sock;
+
+        /*---------------------------------------------------------*\
+        | Client sockets are nonblocking so that a client that does |
+        | not read its replies cannot stall the server thread.      |
+        | Data that cannot be sent right away is queued.            |
+        \*---------------------------------------------------------*/
+        u_long arg = 1;
+        ioctlsocket(client_info->client_sock, FIONBIO, &arg);
+        setsockopt(client_info->client_sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        /*---------------------------------------------------------*\
+        | Discover the remote hosts IP                              |
+        \*---------------------------------------------------------*/
+        struct sockaddr_storage tmp_addr;
+        char ipstr[INET6_ADDRSTRLEN];
+        socklen_t len;
+        len = sizeof(tmp_addr);
+        getpeername(client_info->client_sock, (struct sockaddr*)&tmp_addr, &len);
+
+        if(tmp_addr.ss_family == AF_INET)
+        {
+            struct sockaddr_in *s_4 = (struct sockaddr_in *)&tmp_addr;
+            inet_ntop(AF_INET, &s_4->sin_addr, ipstr, sizeof(ipstr));
+            client_info->client_ip = ipstr;
+        }
+        else
+        {
+            struct sockaddr_in6 *s_6 = (struct sockaddr_in6 *)&tmp_addr;
+            inet_ntop(AF_INET6, &s_6->sin6_addr, ipstr, sizeof(ipstr));
+            client_info->client_ip = ipstr;
+        }
+
+        LOG_INFO("[NetworkServer] Accepted connection: %s", client_info->client_ip.c_str());
+
+        return(client_info);
+    }
+}
+
+/*---------------------------------------------------------*\
+| ReceiveClientData                                         |
+|   Receive as much as a client has sent with a single      |
+|   recv() and handle each complete packet.  Returns false  |
+|   if the connection should be closed.                     |
+\*---------------------------------------------------------*/
+bool NetworkServer::ReceiveClientData(NetworkClientInfo * client_info)
+{
+    unsigned int    buffer_size;
+    char *          buffer      = client_info->recv_reader.GetReceiveBuffer(&buffer_size);
+    int             bytes_read  = recv(client_info->client_sock, buffer, buffer_size, 0);
+
+    if(bytes_read < 0 && SocketWouldBlock())
+    {
+        return(true);
+    }
+
+    if(bytes_read <= 0)
+    {
+        return(false);
+    }
+
+    client_info->recv_reader.Received(bytes_read);
+
+    while(1)
+    {
+        NetPacketHeader header;
+        char *          data;
+        int             result      = client_info->recv_reader.NextPacket(&header, &data);
+
+        if(result == NET_PACKET_INCOMPLETE)
+        {
+            return(true);
+        }
+        else if(result == NET_PACKET_TOO_LARGE)
+        {
+            LOG_ERROR("[NetworkServer] Packet of %u bytes exceeds the %u byte limit, closing connection", header.pkt_size, NET_PACKET_MAX_DATA_SIZE);
+            return(false);
+        }
+
+        if(!ProcessPacket(client_info, header, data))
+        {
+            return(false);
+        }
+
+        /*---------------------------------------------------------*\
+        | Stop handling requests from a client that is closed for   |
+        | not reading its replies                                   |
+        \*---------------------------------------------------------*/
+        std::lock_guard<std::mutex> lock(client_info->send_mutex);
+
+        if(client_info->send_failed)
+        {
+            return(false);
+        }
+    }
+}
+
+/*---------------------------------------------------------*\
+| ProcessPacket                                             |
+|   Handle a complete packet received from a client.        |
+|   Returns false if the connection should be closed.       |
+|                                                           |
+|   This runs on the server thread, which serves every      |
+|   client, so handlers must not block.  Replies, color     |
+|   updates, and changes to controller data are handled     |
+|   here.  Work that may block, such as saving or loading   |
+|   profiles, mode changes, rescans, and plugin callbacks,  |
+|   is queued for the request worker thread with any packet |
+|   data it needs copied.                                   |
+\*---------------------------------------------------------*/
+bool NetworkServer::ProcessPacket(NetworkClientInfo * client_info, NetPacketHeader & header, char * data)
+{
+    SOCKET client_sock = client_info->client_sock;
+
+    /*---------------------------------------------------------*\
+    | Select functionality based on request ID                  |
+    \*---------------------------------------------------------*/
+    switch(header.pkt_id)
+    {
+        case NET_PACKET_ID_REQUEST_CONTROLLER_COUNT:
+            SendReply_ControllerCount(client_sock);
+            break;
+
+        case NET_PACKET_ID_REQUEST_CONTROLLER_DATA:
+            {
+                unsigned int protocol_version = 0;
+
+                if(header.pkt_size == sizeof(unsigned int))
                 {
-                    if(header.pkt_dev_idx < controllers.size())
-                    {
-                        controllers[header.pkt_dev_idx]->SetColorDescription((unsigned char *)data);
-                        controllers[header.pkt_dev_idx]->UpdateLEDs();
-                    }
+                    memcpy(&protocol_version, data, sizeof(unsigned int));
                 }
-                else
+
+                SendReply_ControllerData(client_sock, header.pkt_dev_idx, protocol_version);
+            }
+            break;
+
+        case NET_PACKET_ID_REQUEST_PROTOCOL_VERSION:
+            SendReply_ProtocolVersion(client_sock);
+            ProcessRequest_ClientProtocolVersion(client_sock, header.pkt_size, data);
+            break;
+
+        case NET_PACKET_ID_SET_CLIENT_NAME:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            ProcessRequest_ClientString(client_sock, header.pkt_size, data);
+            break;
+
+        case NET_PACKET_ID_REQUEST_RESCAN_DEVICES:
+            QueueRequestWork(nullptr, [this]()
+            {
+                ProcessRequest_RescanDevices();
+            });
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_RESIZEZONE:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size == (2 * sizeof(int))))
+            {
+                int zone;
+                int new_size;
+
+                memcpy(&zone, data, sizeof(int));
+                memcpy(&new_size, data + sizeof(int), sizeof(int));
+
+                controllers[header.pkt_dev_idx]->ResizeZone(zone, new_size);
+                QueueRequestWork(nullptr, [this]()
                 {
-                    LOG_ERROR("[NetworkServer] UpdateLEDs packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, *((unsigned int*)data));
-                    goto listen_done;
-                }
+                    profile_manager->SaveProfile("sizes", true);
+                });
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS:
-                if(data == NULL)
+            /*---------------------------------------------------------*\
+            | Verify the color description size (first 4 bytes of data) |
+            | matches the packet size in the header                     |
+            |                                                           |
+            | If protocol version is 4 or below and the legacy SDK      |
+            | compatibility workaround is enabled, ignore this check.   |
+            | This allows backwards compatibility with old versions of  |
+            | SDK applications that didn't properly implement the size  |
+            | field.                                                    |
+            \*---------------------------------------------------------*/
+            if((header.pkt_size == *((unsigned int*)data))
+            || ((client_info->client_protocol_version <= 4)
+             && (legacy_workaround_enabled)))
+            {
+                if(header.pkt_dev_idx < controllers.size())
                 {
-                    break;
+                    controllers[header.pkt_dev_idx]->SetColorDescription((unsigned char *)data, client_info->client_protocol_version);
+                    controllers[header.pkt_dev_idx]->UpdateLEDs();
                 }
+            }
+            else
+            {
+                LOG_ERROR("[NetworkServer] UpdateLEDs packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, *((unsigned int*)data));
+                return(false);
+            }
+            break;
 
-                /*---------------------------------------------------------*\
-                | Verify the color description size (first 4 bytes of data) |
-                | matches the packet size in the header                     |
-                |                                                           |
-                | If protocol version is 4 or below and the legacy SDK      |
-                | compatibility workaround is enabled, ignore this check.   |
-                | This allows backwards compatibility with old versions of  |
-                | SDK applications that didn't properly implement the size  |
-                | field.                                                    |
-                \*---------------------------------------------------------*/
-                if((header.pkt_size == *((unsigned int*)data))
-                || ((client_info->client_protocol_version <= 4)
-                 && (legacy_workaround_enabled)))
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATEZONELEDS:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            /*---------------------------------------------------------*\
+            | Verify the color description size (first 4 bytes of data) |
+            | matches the packet size in the header                     |
+            |                                                           |
+            | If protocol version is 4 or below and the legacy SDK      |
+            | compatibility workaround is enabled, ignore this check.   |
+            | This allows backwards compatibility with old versions of  |
+            | SDK applications that didn't properly implement the size  |
+            | field.                                                    |
+            \*---------------------------------------------------------*/
+            if((header.pkt_size == *((unsigned int*)data))
+            || ((client_info->client_protocol_version <= 4)
+             && (legacy_workaround_enabled)))
+            {
+                if(header.pkt_dev_idx < controllers.size())
                 {
-                    if(header.pkt_dev_idx < controllers.size())
-                    {
-                        int zone;
+                    int zone;
 
-                        memcpy(&zone, &data[sizeof(unsigned int)], sizeof(int));
+                    memcpy(&zone, &data[sizeof(unsigned int)], sizeof(int));
 
-                        controllers[header.pkt_dev_idx]->SetZoneColorDescription((unsigned char *)data);
-                        controllers[header.pkt_dev_idx]->UpdateZoneLEDs(zone);
-                    }
+                    controllers[header.pkt_dev_idx]->SetZoneColorDescription((unsigned char *)data, client_info->client_protocol_version);
+                    controllers[header.pkt_dev_idx]->QueueZoneLEDs(zone);
                 }
-                else
+            }
+            else
+            {
+                LOG_ERROR("[NetworkServer] UpdateZoneLEDs packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, *((unsigned int*)data));
+                return(false);
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            /*---------------------------------------------------------*\
+            | Verify the single LED color description size (8 bytes)    |
+            | matches the packet size in the header                     |
+            \*---------------------------------------------------------*/
+            if(header.pkt_size == (sizeof(int) + sizeof(RGBColor)))
+            {
+                if(header.pkt_dev_idx < controllers.size())
                 {
-                    LOG_ERROR("[NetworkServer] UpdateZoneLEDs packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, *((unsigned int*)data));
-                    goto listen_done;
+                    int led;
+
+                    memcpy(&led, data, sizeof(int));
+
+                    controllers[header.pkt_dev_idx]->SetSingleLEDColorDescription((unsigned char *)data);
+                    controllers[header.pkt_dev_idx]->QueueSingleLED(led);
                 }
+            }
+            else
+            {
+                LOG_ERROR("[NetworkServer] UpdateSingleLED packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, (sizeof(int) + sizeof(RGBColor)));
+                return(false);
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSGROUP:
+            if((data == NULL) || (client_info->client_protocol_version < 12))
+            {
+                break;
+            }
+
+            if(!ProcessRequest_RGBController_UpdateLEDsGroup(client_info->client_protocol_version, header.pkt_size, data))
+            {
+                LOG_ERROR("[NetworkServer] UpdateLEDsGroup packet has invalid size. Packet size: %d", header.pkt_size);
+                return(false);
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSENCODED:
+            if((data == NULL) || (client_info->client_protocol_version < 13))
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATESINGLELED:
-                if(data == NULL)
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                if(!controllers[header.pkt_dev_idx]->SetEncodedColorDescription((unsigned char *)data, header.pkt_size))
                 {
-                    break;
+                    LOG_ERROR("[NetworkServer] UpdateLEDsEncoded packet is malformed. Packet size: %d", header.pkt_size);
+                    return(false);
                 }
 
-                /*---------------------------------------------------------*\
-                | Verify the single LED color description size (8 bytes)    |
-                | matches the packet size in the header                     |
-                \*---------------------------------------------------------*/
-                if(header.pkt_size == (sizeof(int) + sizeof(RGBColor)))
+                controllers[header.pkt_dev_idx]->UpdateLEDs();
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE:
+            if(header.pkt_dev_idx < controllers.size())
+            {
+                RGBController * controller = controllers[header.pkt_dev_idx];
+
+                QueueRequestWork(controller, [controller]()
                 {
-                    if(header.pkt_dev_idx < controllers.size())
-                    {
-                        int led;
+                    controller->SetCustomMode();
+                });
+            }
+            break;
 
-                        memcpy(&led, data, sizeof(int));
+        case NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE:
+            if(data == NULL)
+            {
+                break;
+            }
 
-                        controllers[header.pkt_dev_idx]->SetSingleLEDColorDescription((unsigned char *)data);
-                        controllers[header.pkt_dev_idx]->UpdateSingleLED(led);
-                    }
-                }
-                else
+            /*---------------------------------------------------------*\
+            | Verify the mode description size (first 4 bytes of data)  |
+            | matches the packet size in the header                     |
+            |                                                           |
+            | If protocol version is 4 or below and the legacy SDK      |
+            | compatibility workaround is enabled, ignore this check.   |
+            | This allows backwards compatibility with old versions of  |
+            | SDK applications that didn't properly implement the size  |
+            | field.                                                    |
+            \*---------------------------------------------------------*/
+            if((header.pkt_size == *((unsigned int*)data))
+            || ((client_info->client_protocol_version <= 4)
+             && (legacy_workaround_enabled)))
+            {
+                if(header.pkt_dev_idx < controllers.size())
                 {
-                    LOG_ERROR("[NetworkServer] UpdateSingleLED packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, (sizeof(int) + sizeof(RGBColor)));
-                    goto listen_done;
+                    RGBController * controller = controllers[header.pkt_dev_idx];
+
+                    controller->SetModeDescription((unsigned char *)data, client_info->client_protocol_version);
+
+                    QueueRequestWork(controller, [controller]()
+                    {
+                        controller->UpdateMode();
+                    });
                 }
+            }
+            else
+            {
+                LOG_ERROR("[NetworkServer] UpdateMode packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, *((unsigned int*)data));
+                return(false);
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_SAVEMODE:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_SETCUSTOMMODE:
+            /*---------------------------------------------------------*\
+            | Verify the mode description size (first 4 bytes of data)  |
+            | matches the packet size in the header                     |
+            |                                                           |
+            | If protocol version is 4 or below and the legacy SDK      |
+            | compatibility workaround is enabled, ignore this check.   |
+            | This allows backwards compatibility with old versions of  |
+            | SDK applications that didn't properly implement the size  |
+            | field.                                                    |
+            \*---------------------------------------------------------*/
+            if((header.pkt_size == *((unsigned int*)data))
+            || ((client_info->client_protocol_version <= 4)
+             && (legacy_workaround_enabled)))
+            {
                 if(header.pkt_dev_idx < controllers.size())
                 {
-                    controllers[header.pkt_dev_idx]->SetCustomMode();
+                    RGBController * controller = controllers[header.pkt_dev_idx];
+
+                    controller->SetModeDescription((unsigned char *)data, client_info->client_protocol_version);
+
+                    QueueRequestWork(controller, [controller]()
+                    {
+                        controller->SaveMode();
+                    });
                 }
+            }
+            break;
+
+        case NET_PACKET_ID_REQUEST_PROFILE_LIST:
+            SendReply_ProfileList(client_sock);
+            break;
+
+        case NET_PACKET_ID_REQUEST_SAVE_PROFILE:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_UPDATEMODE:
-                if(data == NULL)
+            if(profile_manager)
+            {
+                std::string profile_name;
+                profile_name.assign(data, header.pkt_size);
+
+                QueueRequestWork(nullptr, [this, profile_name]()
                 {
-                    break;
-                }
+                    profile_manager->SaveProfile(profile_name);
+                });
+            }
 
-                /*---------------------------------------------------------*\
-                | Verify the mode description size (first 4 bytes of data)  |
-                | matches the packet size in the header                     |
-                |                                                           |
-                | If protocol version is 4 or below and the legacy SDK      |
-                | compatibility workaround is enabled, ignore this check.   |
-                | This allows backwards compatibility with old versions of  |
-                | SDK applications that didn't properly implement the size  |
-                | field.                                                    |
-                \*---------------------------------------------------------*/
-                if((header.pkt_size == *((unsigned int*)data))
-                || ((client_info->client_protocol_version <= 4)
-                 && (legacy_workaround_enabled)))
+            break;
+
+        case NET_PACKET_ID_REQUEST_LOAD_PROFILE:
+            if(data == NULL)
+            {
+                break;
+            }
+
+            {
+                std::string profile_name;
+                profile_name.assign(data, header.pkt_size);
+
+                QueueRequestWork(nullptr, [this, profile_name]()
                 {
-                    if(header.pkt_dev_idx < controllers.size())
+                    if(profile_manager)
                     {
-                        controllers[header.pkt_dev_idx]->SetModeDescription((unsigned char *)data, client_info->client_protocol_version);
-                        controllers[header.pkt_dev_idx]->UpdateMode();
+                        profile_manager->LoadProfile(profile_name);
                     }
-                }
-                else
-                {
-                    LOG_ERROR("[NetworkServer] UpdateMode packet has invalid size. Packet size: %d, Data size: %d", header.pkt_size, *((unsigned int*)data));
-                    goto listen_done;
-                }
+
+                    for(RGBController* controller : controllers)
+                    {
+                        controller->UpdateLEDs();
+                    }
+                });
+            }
+
+            break;
+
+        case NET_PACKET_ID_REQUEST_DELETE_PROFILE:
+            if(data == NULL)
+            {
                 break;
+            }
+
+            if(profile_manager)
+            {
+                std::string profile_name;
+                profile_name.assign(data, header.pkt_size);
 
-            case NET_PACKET_ID_RGBCONTROLLER_SAVEMODE:
-                if(data == NULL)
+                QueueRequestWork(nullptr, [this, profile_name]()
                 {
-                    break;
-                }
+                    profile_manager->DeleteProfile(profile_name);
+                });
+            }
+
+            break;
+
+        case NET_PACKET_ID_REQUEST_PLUGIN_LIST:
+            SendReply_PluginList(client_sock);
+            break;
+
+        case NET_PACKET_ID_PLUGIN_SPECIFIC:
+            if((data == NULL) || (header.pkt_size < sizeof(unsigned int)))
+            {
+                break;
+            }
+
+            if(header.pkt_dev_idx < plugins.size())
+            {
+                NetworkPlugin               plugin = plugins[header.pkt_dev_idx];
+                unsigned int                plugin_pkt_type;
+                std::vector<unsigned char>  plugin_data(data + sizeof(unsigned int), data + header.pkt_size);
+
+                memcpy(&plugin_pkt_type, data, sizeof(unsigned int));
 
                 /*---------------------------------------------------------*\
-                | Verify the mode description size (first 4 bytes of data)  |
-                | matches the packet size in the header                     |
-                |                                                           |
-                | If protocol version is 4 or below and the legacy SDK      |
-                | compatibility workaround is enabled, ignore this check.   |
-                | This allows backwards compatibility with old versions of  |
-                | SDK applications that didn't properly implement the size  |
-                | field.                                                    |
+                | Plugin callbacks may block, so call them on the request   |
+                | worker thread, which queues the reply if the client is    |
+                | still connected                                           |
                 \*---------------------------------------------------------*/
-                if((header.pkt_size == *((unsigned int*)data))
-                || ((client_info->client_protocol_version <= 4)
-                 && (legacy_workaround_enabled)))
+                QueueRequestWork(nullptr, [this, client_sock, plugin, plugin_pkt_type, plugin_data]() mutable
                 {
-                    if(header.pkt_dev_idx < controllers.size())
-                    {
-                        controllers[header.pkt_dev_idx]->SetModeDescription((unsigned char *)data, client_info->client_protocol_version);
-                        controllers[header.pkt_dev_idx]->SaveMode();
-                    }
-                }
-                break;
+                    unsigned int    plugin_pkt_size = (unsigned int)plugin_data.size();
+                    unsigned char*  output          = plugin.callback(plugin.callback_arg, plugin_pkt_type, plugin_data.data(), &plugin_pkt_size);
 
-            case NET_PACKET_ID_REQUEST_PROFILE_LIST:
-                SendReply_ProfileList(client_sock);
-                break;
+                    if(output != nullptr)
+                    {
+                        ServerClientsMutex.lock();
 
-            case NET_PACKET_ID_REQUEST_SAVE_PROFILE:
-                if(data == NULL)
-                {
-                    break;
-                }
+                        SendReply_PluginSpecific(client_sock, plugin_pkt_type, output, plugin_pkt_size);
 
-                if(profile_manager)
-                {
-                    std::string profile_name;
-                    profile_name.assign(data, header.pkt_size);
+                        ServerClientsMutex.unlock();
+                    }
+                });
+            }
+            break;
 
-                    profile_manager->SaveProfile(profile_name);
-                }
+        case NET_PACKET_ID_REQUEST_IDLE_STATS:
+            SendReply_IdleStats(client_sock);
+            break;
 
+        case NET_PACKET_ID_RGBCONTROLLER_CLEARSEGMENTS:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_REQUEST_LOAD_PROFILE:
-                if(data == NULL)
-                {
-                    break;
-                }
-
-                if(profile_manager)
-                {
-                    std::string profile_name;
-                    profile_name.assign(data, header.pkt_size);
+            if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size == sizeof(int)))
+            {
+                int zone;
 
-                    profile_manager->LoadProfile(profile_name);
-                }
+                memcpy(&zone, data, sizeof(int));
 
-                for(RGBController* controller : controllers)
+                controllers[header.pkt_dev_idx]->ClearSegments(zone);
+                QueueRequestWork(nullptr, [this]()
                 {
-                    controller->UpdateLEDs();
-                }
+                    profile_manager->SaveProfile("sizes", true);
+                });
+            }
+            break;
 
+        case NET_PACKET_ID_RGBCONTROLLER_SETCOLORCORRECTION:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_REQUEST_DELETE_PROFILE:
-                if(data == NULL)
-                {
-                    break;
-                }
-
-                if(profile_manager)
-                {
-                    std::string profile_name;
-                    profile_name.assign(data, header.pkt_size);
+            if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size == ((4 * sizeof(float)) + sizeof(unsigned char))))
+            {
+                color_correction correction;
 
-                    profile_manager->DeleteProfile(profile_name);
-                }
+                memcpy(&correction.gamma,      data + (0 * sizeof(float)), sizeof(float));
+                memcpy(&correction.red_gain,   data + (1 * sizeof(float)), sizeof(float));
+                memcpy(&correction.green_gain, data + (2 * sizeof(float)), sizeof(float));
+                memcpy(&correction.blue_gain,  data + (3 * sizeof(float)), sizeof(float));
+                memcpy(&correction.brightness, data + (4 * sizeof(float)), sizeof(unsigned char));
 
-                break;
+                controllers[header.pkt_dev_idx]->SetColorCorrection(correction);
+            }
+            break;
 
-            case NET_PACKET_ID_REQUEST_PLUGIN_LIST:
-                SendReply_PluginList(client_sock);
-                break;
+        case NET_PACKET_ID_RGBCONTROLLER_GETLATENCYSTATS:
+            SendReply_LatencyStats(client_sock, header.pkt_dev_idx);
+            break;
 
-            case NET_PACKET_ID_PLUGIN_SPECIFIC:
-                {
-                    unsigned int plugin_pkt_type = *((unsigned int*)(data));
-                    unsigned int plugin_pkt_size = header.pkt_size - (sizeof(unsigned int));
-                    unsigned char* plugin_data = (unsigned char*)(data + sizeof(unsigned int));
+        case NET_PACKET_ID_RGBCONTROLLER_GETHEALTH:
+            SendReply_Health(client_sock, header.pkt_dev_idx);
+            break;
 
-                    if(header.pkt_dev_idx < plugins.size())
-                    {
-                        NetworkPlugin plugin = plugins[header.pkt_dev_idx];
-                        unsigned char* output = plugin.callback(plugin.callback_arg, plugin_pkt_type, plugin_data, &plugin_pkt_size);
-                        if(output != nullptr)
-                        {
-                            SendReply_PluginSpecific(client_sock, plugin_pkt_type, output, plugin_pkt_size);
-                        }
-                    }
-                    break;
-                }
+        case NET_PACKET_ID_RGBCONTROLLER_SETLEDPOSITIONS:
+            if(data == NULL)
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_CLEARSEGMENTS:
-                if(data == NULL)
-                {
-                    break;
-                }
-
-                if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size == sizeof(int)))
+            /*---------------------------------------------------------*\
+            | Verify the positions description size (first 4 bytes of   |
+            | data) matches the packet size in the header               |
+            \*---------------------------------------------------------*/
+            if((header.pkt_dev_idx < controllers.size()) && (header.pkt_size >= sizeof(unsigned int)) && (header.pkt_size == *((unsigned int*)data)))
+            {
+                controllers[header.pkt_dev_idx]->SetLEDPositionsDescription((unsigned char *)data, header.pkt_size);
+                QueueRequestWork(nullptr, [this]()
                 {
-                    int zone;
-
-                    memcpy(&zone, data, sizeof(int));
-
-                    controllers[header.pkt_dev_idx]->ClearSegments(zone);
                     profile_manager->SaveProfile("sizes", true);
-                }
+                });
+            }
+            break;
+
+        case NET_PACKET_ID_RGBCONTROLLER_ADDSEGMENT:
+            if((data == NULL) || (header.pkt_size < sizeof(unsigned int)))
+            {
                 break;
+            }
 
-            case NET_PACKET_ID_RGBCONTROLLER_ADDSEGMENT:
+            {
+                /*---------------------------------------------------------*\
+                | Verify the segment description size (first 4 bytes of     |
+                | data) matches the packet size in the header               |
+                \*---------------------------------------------------------*/
+                if(header.pkt_size == *((unsigned int*)data))
                 {
-                    /*---------------------------------------------------------*\
-                    | Verify the segment description size (first 4 bytes of     |
-                    | data) matches the packet size in the header               |
-                    \*---------------------------------------------------------*/
-                    if(header.pkt_size == *((unsigned int*)data))
+                    if(header.pkt_dev_idx < controllers.size())
                     {
-                        if(header.pkt_dev_idx < controllers.size())
+                        controllers[header.pkt_dev_idx]->SetSegmentDescription((unsigned char *)data);
+                        QueueRequestWork(nullptr, [this]()
                         {
-                            controllers[header.pkt_dev_idx]->SetSegmentDescription((unsigned char *)data);
                             profile_manager->SaveProfile("sizes", true);
-                        }
+                        });
                     }
                 }
-                break;
-        }
-
-        delete[] data;
+            }
+            break;
     }
 
-listen_done:
 
+    return(true);
+}
+
+void NetworkServer::RemoveClient(NetworkClientInfo * client_info)
+{
     ServerClientsMutex.lock();
 
     for(unsigned int this_idx = 0; this_idx < ServerClients.size(); this_idx++)
@@ -990,8 +1669,6 @@ listen_done:
         }
     }
 
-    client_info = nullptr;
-
     ServerClientsMutex.unlock();
 
     /*---------------------------------------------------------*\
@@ -1055,6 +1732,140 @@ void NetworkServer::ProcessRequest_RescanDevices()
     ResourceManager::get()->RescanDevices();
 }
 
+/*---------------------------------------------------------*\
+| ProcessRequest_RGBController_UpdateLEDsGroup              |
+|   Apply the colors for each device in the group, then     |
+|   update them either as one frame group or one at a time. |
+|   Returns false if the packet is malformed.               |
+\*---------------------------------------------------------*/
+bool NetworkServer::ProcessRequest_RGBController_UpdateLEDsGroup(unsigned int protocol_version, unsigned int data_size, char * data)
+{
+    unsigned int data_ptr    = 0;
+    unsigned int group_size  = 0;
+    unsigned int group_flags = 0;
+    unsigned int num_devices = 0;
+
+    if(data_size < (3 * sizeof(unsigned int)))
+    {
+        return(false);
+    }
+
+    memcpy(&group_size, &data[data_ptr], sizeof(group_size));
+    data_ptr += sizeof(group_size);
+
+    memcpy(&group_flags, &data[data_ptr], sizeof(group_flags));
+    data_ptr += sizeof(group_flags);
+
+    memcpy(&num_devices, &data[data_ptr], sizeof(num_devices));
+    data_ptr += sizeof(num_devices);
+
+    if(group_size != data_size)
+    {
+        return(false);
+    }
+
+    /*---------------------------------------------------------*\
+    | From protocol 13, each device's colors may be encoded     |
+    \*---------------------------------------------------------*/
+    bool encoded = (protocol_version >= 13) && (group_flags & NET_UPDATELEDSGROUP_FLAG_ENCODED);
+
+    update_group.clear();
+
+    /*---------------------------------------------------------*\
+    | Check the framing of every device before applying any of  |
+    | them, so that a malformed packet changes no colors        |
+    \*---------------------------------------------------------*/
+    unsigned int devices_ptr = data_ptr;
+
+    for(unsigned int pass = 0; pass < 2; pass++)
+    {
+        data_ptr = devices_ptr;
+
+        for(unsigned int device_idx = 0; device_idx < num_devices; device_idx++)
+        {
+            unsigned int dev_idx     = 0;
+            unsigned int colors_size = 0;
+            unsigned int num_colors  = 0;
+
+            /*-------------------------------------------------*\
+            | Each device is its index followed by the same     |
+            | color description as                              |
+            | NET_PACKET_ID_RGBCONTROLLER_UPDATELEDS which,     |
+            | from protocol 12, always has a 32-bit count, or   |
+            | by an encoded color description.  Both start with |
+            | their size and a 32-bit count.                    |
+            \*-------------------------------------------------*/
+            if((data_size - data_ptr) < (3 * sizeof(unsigned int)))
+            {
+                return(false);
+            }
+
+            memcpy(&dev_idx, &data[data_ptr], sizeof(dev_idx));
+            data_ptr += sizeof(dev_idx);
+
+            memcpy(&colors_size, &data[data_ptr], sizeof(colors_size));
+            memcpy(&num_colors, &data[data_ptr + sizeof(colors_size)], sizeof(num_colors));
+
+            if((colors_size > (data_size - data_ptr))
+            || (colors_size < (2 * sizeof(unsigned int)))
+            || (!encoded && (num_colors > ((colors_size - (2 * sizeof(unsigned int))) / sizeof(RGBColor)))))
+            {
+                return(false);
+            }
+
+            if((pass == 1) && (dev_idx < controllers.size()))
+            {
+                /*---------------------------------------------*\
+                | SetEncodedColorDescription checks the runs    |
+                | itself, leaving this device unchanged if they |
+                | are invalid                                   |
+                \*---------------------------------------------*/
+                if(encoded)
+                {
+                    if(!controllers[dev_idx]->SetEncodedColorDescription((unsigned char *)&data[data_ptr], colors_size))
+                    {
+                        return(false);
+                    }
+                }
+                else
+                {
+                    controllers[dev_idx]->SetColorDescription((unsigned char *)&data[data_ptr], protocol_version);
+                }
+
+                update_group.push_back(controllers[dev_idx]);
+            }
+
+            data_ptr += colors_size;
+        }
+    }
+
+    if(group_flags & NET_UPDATELEDSGROUP_FLAG_COMMIT_TOGETHER)
+    {
+        GroupCommitMutex.lock();
+
+        for(std::size_t group_idx = 0; group_idx < update_group.size(); group_idx++)
+        {
+            if(std::find(group_commit_pending.begin(), group_commit_pending.end(), update_group[group_idx]) == group_commit_pending.end())
+            {
+                group_commit_pending.push_back(update_group[group_idx]);
+            }
+        }
+
+        GroupCommitMutex.unlock();
+
+        GroupCommitCV.notify_one();
+    }
+    else
+    {
+        for(std::size_t group_idx = 0; group_idx < update_group.size(); group_idx++)
+        {
+            update_group[group_idx]->UpdateLEDs();
+        }
+    }
+
+    return(true);
+}
+
 void NetworkServer::SendReply_ControllerCount(SOCKET client_sock)
 {
     NetPacketHeader reply_hdr;
@@ -1065,8 +1876,7 @@ void NetworkServer::SendReply_ControllerCount(SOCKET client_sock)
     reply_data = (unsigned int)controllers.size();
 
     send_in_progress.lock();
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)&reply_data, sizeof(unsigned int), 0);
+    SendPacket(client_sock, &reply_hdr, &reply_data, sizeof(unsigned int));
     send_in_progress.unlock();
 }
 
@@ -1074,23 +1884,63 @@ void NetworkServer::SendReply_ControllerData(SOCKET client_sock, unsigned int de
 {
     if(dev_idx < controllers.size())
     {
-        NetPacketHeader reply_hdr;
-        unsigned char *reply_data = controllers[dev_idx]->GetDeviceDescription(protocol_version);
-        unsigned int   reply_size;
-
-        memcpy(&reply_size, reply_data, sizeof(reply_size));
+        NetPacketHeader             reply_hdr;
+        std::vector<unsigned char>  reply_data;
+        unsigned int                reply_size = controllers[dev_idx]->GetDeviceDescription(reply_data, protocol_version);
 
         InitNetPacketHeader(&reply_hdr, dev_idx, NET_PACKET_ID_REQUEST_CONTROLLER_DATA, reply_size);
 
         send_in_progress.lock();
-        send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-        send(client_sock, (const char *)reply_data, reply_size, 0);
+        SendPacket(client_sock, &reply_hdr, reply_data.data(), reply_size);
+        send_in_progress.unlock();
+    }
+}
+
+void NetworkServer::SendReply_Health(SOCKET client_sock, unsigned int dev_idx)
+{
+    if(dev_idx < controllers.size())
+    {
+        NetPacketHeader             reply_hdr;
+        std::vector<unsigned char>  reply_data;
+        unsigned int                reply_size = controllers[dev_idx]->GetHealthDescription(reply_data);
+
+        InitNetPacketHeader(&reply_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_GETHEALTH, reply_size);
+
+        send_in_progress.lock();
+        SendPacket(client_sock, &reply_hdr, reply_data.data(), reply_size);
         send_in_progress.unlock();
+    }
+}
+
+void NetworkServer::SendReply_LatencyStats(SOCKET client_sock, unsigned int dev_idx)
+{
+    if(dev_idx < controllers.size())
+    {
+        NetPacketHeader             reply_hdr;
+        std::vector<unsigned char>  reply_data;
+        unsigned int                reply_size = controllers[dev_idx]->GetLatencyStatsDescription(reply_data);
+
+        InitNetPacketHeader(&reply_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_GETLATENCYSTATS, reply_size);
 
-        delete[] reply_data;
+        send_in_progress.lock();
+        SendPacket(client_sock, &reply_hdr, reply_data.data(), reply_size);
+        send_in_progress.unlock();
     }
 }
 
+void NetworkServer::SendReply_IdleStats(SOCKET client_sock)
+{
+    NetPacketHeader             reply_hdr;
+    std::vector<unsigned char>  reply_data;
+    unsigned int                reply_size = RGBControllerIdleMonitor::get()->GetStatsDescription(reply_data);
+
+    InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_REQUEST_IDLE_STATS, reply_size);
+
+    send_in_progress.lock();
+    SendPacket(client_sock, &reply_hdr, reply_data.data(), reply_size);
+    send_in_progress.unlock();
+}
+
 void NetworkServer::SendReply_ProtocolVersion(SOCKET client_sock)
 {
     NetPacketHeader reply_hdr;
@@ -1101,8 +1951,7 @@ void NetworkServer::SendReply_ProtocolVersion(SOCKET client_sock)
     reply_data = OPENRGB_SDK_PROTOCOL_VERSION;
 
     send_in_progress.lock();
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)&reply_data, sizeof(unsigned int), 0);
+    SendPacket(client_sock, &reply_hdr, &reply_data, sizeof(unsigned int));
     send_in_progress.unlock();
 }
 
@@ -1113,7 +1962,18 @@ void NetworkServer::SendRequest_DeviceListChanged(SOCKET client_sock)
     InitNetPacketHeader(&pkt_hdr, 0, NET_PACKET_ID_DEVICE_LIST_UPDATED, 0);
 
     send_in_progress.lock();
-    send(client_sock, (char *)&pkt_hdr, sizeof(NetPacketHeader), 0);
+    SendPacket(client_sock, &pkt_hdr, NULL, 0);
+    send_in_progress.unlock();
+}
+
+void NetworkServer::SendRequest_HealthChanged(SOCKET client_sock, unsigned int dev_idx, std::vector<unsigned char>& data)
+{
+    NetPacketHeader pkt_hdr;
+
+    InitNetPacketHeader(&pkt_hdr, dev_idx, NET_PACKET_ID_RGBCONTROLLER_HEALTHCHANGED, (unsigned int)data.size());
+
+    send_in_progress.lock();
+    SendPacket(client_sock, &pkt_hdr, data.data(), (unsigned int)data.size());
     send_in_progress.unlock();
 }
 
@@ -1133,8 +1993,7 @@ void NetworkServer::SendReply_ProfileList(SOCKET client_sock)
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_REQUEST_PROFILE_LIST, reply_size);
 
     send_in_progress.lock();
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)reply_data, reply_size, 0);
+    SendPacket(client_sock, &reply_hdr, reply_data, reply_size);
     send_in_progress.unlock();
 }
 
@@ -1233,8 +2092,7 @@ void NetworkServer::SendReply_PluginList(SOCKET client_sock)
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_REQUEST_PLUGIN_LIST, reply_size);
 
     send_in_progress.lock();
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)data_buf, reply_size, 0);
+    SendPacket(client_sock, &reply_hdr, data_buf, reply_size);
     send_in_progress.unlock();
 
     delete [] data_buf;
@@ -1246,15 +2104,147 @@ void NetworkServer::SendReply_PluginSpecific(SOCKET client_sock, unsigned int pk
 
     InitNetPacketHeader(&reply_hdr, 0, NET_PACKET_ID_PLUGIN_SPECIFIC, data_size + sizeof(pkt_type));
 
+    const char *    buffers[3]  = { (const char *)&reply_hdr, (const char *)&pkt_type, (const char *)data };
+    int             lengths[3]  = { sizeof(NetPacketHeader), sizeof(pkt_type), (int)data_size };
+
     send_in_progress.lock();
-    send(client_sock, (const char *)&reply_hdr, sizeof(NetPacketHeader), 0);
-    send(client_sock, (const char *)&pkt_type, sizeof(pkt_type), 0);
-    send(client_sock, (const char *)data, data_size, 0);
+    QueueSend(client_sock, buffers, lengths, 3);
     send_in_progress.unlock();
 
     delete [] data;
 }
 
+void NetworkServer::SendPacket(SOCKET client_sock, NetPacketHeader * header, const void * data, unsigned int data_size)
+{
+    /*---------------------------------------------------------*\
+    | Queue the header and data together so that they leave in  |
+    | a single TCP segment where possible                       |
+    \*---------------------------------------------------------*/
+    const char *    buffers[2]  = { (const char *)header, (const char *)data };
+    int             lengths[2]  = { sizeof(NetPacketHeader), (int)data_size };
+
+    QueueSend(client_sock, buffers, lengths, (data_size > 0) ? 2 : 1);
+}
+
+/*---------------------------------------------------------*\
+| QueueSend                                                 |
+|   Append buffers to a client's send queue and send as     |
+|   much of the queue as the socket takes.  The server      |
+|   thread sends the rest once the socket is writable.  A   |
+|   client whose queue would exceed                         |
+|   NET_SERVER_MAX_SEND_QUEUE_SIZE is disconnected.         |
+|   The client list must not change during the call, so     |
+|   call on the server thread or with ServerClientsMutex    |
+|   held.                                                   |
+\*---------------------------------------------------------*/
+void NetworkServer::QueueSend(SOCKET client_sock, const char * buffers[], const int lengths[], int count)
+{
+    NetworkClientInfo * client_info = nullptr;
+
+    for(unsigned int client_idx = 0; client_idx < ServerClients.size(); client_idx++)
+    {
+        if(ServerClients[client_idx]->client_sock == client_sock)
+        {
+            client_info = ServerClients[client_idx];
+            break;
+        }
+    }
+
+    if(client_info == nullptr)
+    {
+        return;
+    }
+
+    std::size_t total = 0;
+
+    for(int buffer_idx = 0; buffer_idx < count; buffer_idx++)
+    {
+        total += lengths[buffer_idx];
+    }
+
+    std::lock_guard<std::mutex> lock(client_info->send_mutex);
+
+    if(client_info->send_failed)
+    {
+        return;
+    }
+
+    /*---------------------------------------------------------*\
+    | Drop the part of the queue that was already sent once it  |
+    | is at least half of the queue, so that the rest is not    |
+    | moved on every call                                       |
+    \*---------------------------------------------------------*/
+    if((client_info->send_offset > 0) && (client_info->send_offset >= (client_info->send_queue.size() / 2)))
+    {
+        client_info->send_queue.erase(client_info->send_queue.begin(), client_info->send_queue.begin() + client_info->send_offset);
+        client_info->send_offset = 0;
+    }
+
+    if((client_info->send_queue.size() - client_info->send_offset + total) > NET_SERVER_MAX_SEND_QUEUE_SIZE)
+    {
+        LOG_WARNING("[NetworkServer] Client %s is not reading its data, closing connection", client_info->client_ip.c_str());
+
+        client_info->send_failed = true;
+    }
+    else
+    {
+        for(int buffer_idx = 0; buffer_idx < count; buffer_idx++)
+        {
+            client_info->send_queue.insert(client_info->send_queue.end(), buffers[buffer_idx], buffers[buffer_idx] + lengths[buffer_idx]);
+        }
+
+        if(!FlushSend(client_info))
+        {
+            client_info->send_failed = true;
+        }
+    }
+
+    /*---------------------------------------------------------*\
+    | Have the server thread wait for writability or close the  |
+    | client                                                    |
+    \*---------------------------------------------------------*/
+    if(client_info->send_failed || (client_info->send_offset < client_info->send_queue.size()))
+    {
+        WakeServerThread();
+    }
+}
+
+/*---------------------------------------------------------*\
+| FlushSend                                                 |
+|   Send queued data until the socket would block.  Must be |
+|   called with the client's send_mutex held.  Returns      |
+|   false if the connection failed.                         |
+\*---------------------------------------------------------*/
+bool NetworkServer::FlushSend(NetworkClientInfo * client_info)
+{
+    while(client_info->send_offset < client_info->send_queue.size())
+    {
+        int bytes_sent = send(client_info->client_sock, &client_info->send_queue[client_info->send_offset], (int)(client_info->send_queue.size() - client_info->send_offset), MSG_NOSIGNAL);
+
+        if(bytes_sent < 0)
+        {
+            return(SocketWouldBlock());
+        }
+
+        client_info->send_offset += bytes_sent;
+    }
+
+    client_info->send_queue.clear();
+    client_info->send_offset = 0;
+
+    return(true);
+}
+
+void NetworkServer::WakeServerThread()
+{
+    if(wake_sock[0] != INVALID_SOCKET)
+    {
+        char wake_byte = 0;
+
+        send(wake_sock[0], &wake_byte, 1, MSG_NOSIGNAL);
+    }
+}
+
 void NetworkServer::SetProfileManager(ProfileManagerInterface* profile_manager_pointer)
 {
     profile_manager = profile_manager_pointer;
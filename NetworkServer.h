@@ -14,6 +14,8 @@
 #include <mutex>
 #include <thread>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
 #include "RGBController.h"
 #include "NetworkProtocol.h"
 #include "net_port.h"
@@ -22,6 +24,20 @@
 
 #define MAXSOCK 32
 #define TCP_TIMEOUT_SECONDS 5
+#define TCP_IDLE_TIMEOUT_SECONDS 60
+
+/*---------------------------------------------------------*\
+| Default limit on connected clients and most socket events |
+| handled per wait                                          |
+\*---------------------------------------------------------*/
+#define NET_SERVER_DEFAULT_MAX_CLIENTS  64
+#define NET_SERVER_MAX_EVENTS           64
+
+/*---------------------------------------------------------*\
+| Most data queued for a client that is not reading it      |
+| before the client is disconnected                         |
+\*---------------------------------------------------------*/
+#define NET_SERVER_MAX_SEND_QUEUE_SIZE  (16 * 1024 * 1024)
 
 typedef void (*NetServerCallback)(void *);
 typedef unsigned char* (*NetPluginCallback)(void *, unsigned int, unsigned char*, unsigned int*);
@@ -36,6 +52,16 @@ struct NetworkPlugin
     unsigned int protocol_version;
 };
 
+/*---------------------------------------------------------*\
+| Request work run on the request worker thread.  Work for  |
+| a controller is dropped when the controller list changes. |
+\*---------------------------------------------------------*/
+struct NetworkServerWork
+{
+    RGBController *         controller;
+    std::function<void()>   function;
+};
+
 class NetworkClientInfo
 {
 public:
@@ -43,10 +69,23 @@ public:
     ~NetworkClientInfo();
 
     SOCKET          client_sock;
-    std::thread *   client_listen_thread;
     std::string     client_string;
     unsigned int    client_protocol_version;
     std::string     client_ip;
+
+    NetPacketReader recv_reader;
+
+    /*---------------------------------------------------------*\
+    | Data waiting for the socket to become writable.  Any      |
+    | thread may queue data, so the queue is guarded by         |
+    | send_mutex.  send_waiting is only used by the server      |
+    | thread to track whether it waits for writability.         |
+    \*---------------------------------------------------------*/
+    std::mutex          send_mutex;
+    std::vector<char>   send_queue;
+    std::size_t         send_offset;
+    bool                send_failed;
+    bool                send_waiting;
 };
 
 class NetworkServer
@@ -66,6 +105,7 @@ public:
 
     void                                ClientInfoChanged();
     void                                DeviceListChanged();
+    void                                ControllerHealthChanged(RGBController * controller, device_health health);
     void                                RegisterClientInfoChangeCallback(NetServerCallback, void * new_callback_arg);
 
     void                                ServerListeningChanged();
@@ -73,27 +113,36 @@ public:
 
     void                                SetHost(std::string host);
     void                                SetLegacyWorkaroundEnable(bool enable);
+    void                                SetMaxClients(unsigned int new_max_clients);
+    unsigned int                        GetMaxClients();
     void                                SetPort(unsigned short new_port);
 
     void                                StartServer();
     void                                StopServer();
 
-    void                                ConnectionThreadFunction(int socket_idx);
-    void                                ListenThreadFunction(NetworkClientInfo * client_sock);
+    void                                ServerThreadFunction();
+    void                                GroupCommitThreadFunction();
+    void                                RequestWorkerThreadFunction();
 
     void                                ProcessRequest_ClientProtocolVersion(SOCKET client_sock, unsigned int data_size, char * data);
     void                                ProcessRequest_ClientString(SOCKET client_sock, unsigned int data_size, char * data);
     void                                ProcessRequest_RescanDevices();
+    bool                                ProcessRequest_RGBController_UpdateLEDsGroup(unsigned int protocol_version, unsigned int data_size, char * data);
 
     void                                SendReply_ControllerCount(SOCKET client_sock);
     void                                SendReply_ControllerData(SOCKET client_sock, unsigned int dev_idx, unsigned int protocol_version);
+    void                                SendReply_LatencyStats(SOCKET client_sock, unsigned int dev_idx);
+    void                                SendReply_Health(SOCKET client_sock, unsigned int dev_idx);
     void                                SendReply_ProtocolVersion(SOCKET client_sock);
 
     void                                SendRequest_DeviceListChanged(SOCKET client_sock);
+    void                                SendRequest_HealthChanged(SOCKET client_sock, unsigned int dev_idx, std::vector<unsigned char>& data);
     void                                SendReply_ProfileList(SOCKET client_sock);
     void                                SendReply_PluginList(SOCKET client_sock);
     void                                SendReply_PluginSpecific(SOCKET client_sock, unsigned int pkt_type, unsigned char* data, unsigned int data_size);
 
+    void                                SendReply_IdleStats(SOCKET client_sock);
+
     void                                SetProfileManager(ProfileManagerInterface* profile_manager_pointer);
 
     void                                RegisterPlugin(NetworkPlugin plugin);
@@ -109,12 +158,20 @@ protected:
 
     std::mutex                          ServerClientsMutex;
     std::vector<NetworkClientInfo *>    ServerClients;
-    std::thread *                       ConnectionThread[MAXSOCK];
+    std::thread *                       ServerThread;
 
     std::mutex                          ClientInfoChangeMutex;
     std::vector<NetServerCallback>      ClientInfoChangeCallbacks;
     std::vector<void *>                 ClientInfoChangeCallbackArgs;
 
+    /*---------------------------------------------------------*\
+    | Controller list as last sent to clients, used to find the |
+    | index of a controller whose health changed without        |
+    | touching the shared list from a device thread             |
+    \*---------------------------------------------------------*/
+    std::mutex                          ControllerHealthMutex;
+    std::vector<RGBController *>        health_controllers;
+
     std::mutex                          ServerListeningChangeMutex;
     std::vector<NetServerCallback>      ServerListeningChangeCallbacks;
     std::vector<void *>                 ServerListeningChangeCallbackArgs;
@@ -125,15 +182,59 @@ protected:
 
     std::mutex                          send_in_progress;
 
+    /*---------------------------------------------------------*\
+    | Controllers of the group being updated, kept to reuse its |
+    | storage.  Only used on the server thread.                 |
+    \*---------------------------------------------------------*/
+    std::vector<RGBController *>        update_group;
+
+    /*---------------------------------------------------------*\
+    | Controllers of grouped updates waiting to be committed    |
+    | together.  Commits run on their own thread, as they may   |
+    | send to other SDK servers, and groups that arrive before  |
+    | a commit starts are merged into it.                       |
+    \*---------------------------------------------------------*/
+    std::thread *                       GroupCommitThread;
+    std::mutex                          GroupCommitMutex;
+    std::condition_variable             GroupCommitCV;
+    std::vector<RGBController *>        group_commit_pending;
+    bool                                group_commit_running;
+
+    /*---------------------------------------------------------*\
+    | Requests that may block, such as profile changes, mode    |
+    | changes, rescans, and plugin callbacks.  They run in the  |
+    | order they arrived on a worker thread, so that the server |
+    | thread keeps handling the other clients meanwhile.        |
+    \*---------------------------------------------------------*/
+    std::thread *                       RequestWorkerThread;
+    std::mutex                          RequestWorkMutex;
+    std::condition_variable             RequestWorkCV;
+    std::vector<NetworkServerWork>      request_work_pending;
+    bool                                request_work_running;
+
 private:
 #ifdef WIN32
     WSADATA     wsa;
 #endif
 
     bool            legacy_workaround_enabled;
+    std::atomic<unsigned int> max_clients;
     int             socket_count;
     SOCKET          server_sock[MAXSOCK];
 
-    int             accept_select(int sockfd);
-    int             recv_select(SOCKET s, char *buf, int len, int flags);
+    /*---------------------------------------------------------*\
+    | Connected socket pair used to wake the server thread.     |
+    | Writing to the first socket makes the second readable.    |
+    \*---------------------------------------------------------*/
+    SOCKET          wake_sock[2];
+
+    NetworkClientInfo * AcceptClient(SOCKET server_socket);
+    bool            ReceiveClientData(NetworkClientInfo * client_info);
+    bool            ProcessPacket(NetworkClientInfo * client_info, NetPacketHeader & header, char * data);
+    void            QueueRequestWork(RGBController * controller, std::function<void()> function);
+    void            SendPacket(SOCKET client_sock, NetPacketHeader * header, const void * data, unsigned int data_size);
+    void            QueueSend(SOCKET client_sock, const char * buffers[], const int lengths[], int count);
+    bool            FlushSend(NetworkClientInfo * client_info);
+    void            WakeServerThread();
+    void            RemoveClient(NetworkClientInfo * client_info);
 };
@@ -173,6 +173,7 @@ HEADERS +=
     Colors.h                                                                                    \
     dependencies/ColorWheel/ColorWheel.h                                                        \
     dependencies/json/nlohmann/json.hpp                                                         \
+    EffectsEngine.h                                                                             \
     LogManager.h                                                                                \
     NetworkClient.h                                                                             \
     NetworkProtocol.h                                                                           \
@@ -203,10 +204,15 @@ HEADERS +=
     SuspendResume/SuspendResume.h                                                               \
     AutoStart/AutoStart.h                                                                       \
     KeyboardLayoutManager/KeyboardLayoutManager.h                                               \
+    RGBController/RGBColorKernels.h                                                             \
     RGBController/RGBController.h                                                               \
     RGBController/RGBController_Dummy.h                                                         \
+    RGBController/RGBControllerIdleMonitor.h                                                    \
     RGBController/RGBControllerKeyNames.h                                                       \
+    RGBController/RGBControllerSpatialIndex.h                                                   \
+    RGBController/RGBControllerWorkerPool.h                                                     \
     RGBController/RGBController_Network.h                                                       \
+    RGBController/RGBController_Virtual.h                                                       \
     startup/startup.h                                                                           \
 
 SOURCES +=                                                                                      \
@@ -245,6 +251,7 @@ SOURCES +=
     startup/startup.cpp                                                                         \
     cli.cpp                                                                                     \
     dmiinfo/dmiinfo.cpp                                                                         \
+    EffectsEngine.cpp                                                                           \
     LogManager.cpp                                                                              \
     NetworkClient.cpp                                                                           \
     NetworkProtocol.cpp                                                                         \
@@ -268,10 +275,15 @@ SOURCES +=
     StringUtils.cpp                                                                             \
     AutoStart/AutoStart.cpp                                                                     \
     KeyboardLayoutManager/KeyboardLayoutManager.cpp                                             \
+    RGBController/RGBColorKernels.cpp                                                           \
     RGBController/RGBController.cpp                                                             \
     RGBController/RGBController_Dummy.cpp                                                       \
+    RGBController/RGBControllerIdleMonitor.cpp                                                  \
     RGBController/RGBControllerKeyNames.cpp                                                     \
+    RGBController/RGBControllerSpatialIndex.cpp                                                 \
+    RGBController/RGBControllerWorkerPool.cpp                                                   \
     RGBController/RGBController_Network.cpp                                                     \
+    RGBController/RGBController_Virtual.cpp                                                     \
 
 RESOURCES +=                                                                                    \
     qt/resources.qrc                                                                            \
@@ -79,8 +79,11 @@ bool ProfileManager::SaveProfile(std::string profile_name, bool sizes)
         controller_file.write((char *)&profile_version, sizeof(unsigned int));
 
         /*---------------------------------------------------------*\
-        | Write controller data for each controller                 |
+        | Write controller data for each controller.  The same      |
+        | buffer is reused for every controller.                    |
         \*---------------------------------------------------------*/
+        std::vector<unsigned char> controller_data;
+
         for(std::size_t controller_index = 0; controller_index < controllers.size(); controller_index++)
         {
             /*-----------------------------------------------------*\
@@ -93,14 +96,9 @@ bool ProfileManager::SaveProfile(std::string profile_name, bool sizes)
                 break;
             }
 
-            unsigned char *controller_data = controllers[controller_index]->GetDeviceDescription(profile_version);
-            unsigned int controller_size;
-
-            memcpy(&controller_size, controller_data, sizeof(controller_size));
-
-            controller_file.write((const char *)controller_data, controller_size);
+            unsigned int controller_size = controllers[controller_index]->GetDeviceDescription(controller_data, profile_version);
 
-            delete[] controller_data;
+            controller_file.write((const char *)controller_data.data(), controller_size);
         }
 
         /*---------------------------------------------------------*\
@@ -318,6 +316,15 @@ bool ProfileManager::LoadDeviceFromListWithOptions
                         }
                     }
                 }
+
+                /*---------------------------------------------------------*\
+                | Restore LED positions once the zones are sized, as the    |
+                | positions must cover every LED                            |
+                \*---------------------------------------------------------*/
+                if(temp_controller->led_positions.size() == load_controller->leds.size())
+                {
+                    load_controller->SetLEDPositions(temp_controller->led_positions);
+                }
             }
 
             /*---------------------------------------------------------*\
@@ -365,10 +372,7 @@ bool ProfileManager::LoadDeviceFromListWithOptions
                 \*---------------------------------------------------------*/
                 if(temp_controller->colors.size() == load_controller->colors.size())
                 {
-                    for(std::size_t color_index = 0; color_index < temp_controller->colors.size(); color_index++)
-                    {
-                        load_controller->colors[color_index] = temp_controller->colors[color_index];
-                    }
+                    load_controller->SetLEDRange(0, temp_controller->colors.data(), (unsigned int)temp_controller->colors.size());
                 }
             }
 
@@ -0,0 +1,681 @@
+/*---------------------------------------------------------*\
+| RGBColorKernels.cpp                                       |
+|                                                           |
+|   Vectorized conversions between RGBColor buffers and     |
+|   the packed byte layouts used by device protocols        |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <atomic>
+#include "RGBColorKernels.h"
+
+/*---------------------------------------------------------*\
+| SIMD support.  On x86-64, SSE2 is always available and    |
+| the SSSE3 and AVX2 kernels are compiled for their target  |
+| and selected at runtime.  On little-endian ARM, NEON is   |
+| used when the compiler enables it.  Everything else uses  |
+| the scalar kernels.                                       |
+\*---------------------------------------------------------*/
+#if defined(__x86_64__) || defined(_M_X64)
+#define RGBCOLORKERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define KERNEL_TARGET_SSSE3
+#define KERNEL_TARGET_AVX2
+#else
+#define KERNEL_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define KERNEL_TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define RGBCOLORKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+/*---------------------------------------------------------*\
+| Byte offset within an RGBColor of each output channel,    |
+| indexed by channel order                                  |
+\*---------------------------------------------------------*/
+static const unsigned char order_channels[6][3] =
+{
+    { 0, 1, 2 },    /* RGB */
+    { 0, 2, 1 },    /* RBG */
+    { 1, 0, 2 },    /* GRB */
+    { 1, 2, 0 },    /* GBR */
+    { 2, 0, 1 },    /* BRG */
+    { 2, 1, 0 },    /* BGR */
+};
+
+/*---------------------------------------------------------*\
+| Highest kernel level allowed by SetRGBColorKernelsLimit() |
+\*---------------------------------------------------------*/
+static std::atomic<unsigned int> kernels_limit(RGB_KERNELS_AVX2);
+
+static inline unsigned char GetChannel(RGBColor color, unsigned char channel)
+{
+    return((unsigned char)((color >> (8 * channel)) & 0xFF));
+}
+
+static inline unsigned char ScaleChannel(unsigned int value, unsigned int scale)
+{
+    /*-----------------------------------------------------*\
+    | Exact rounded division by 255 without a divide, kept  |
+    | identical to the SIMD kernels                         |
+    \*-----------------------------------------------------*/
+    unsigned int x = (value * scale) + 128;
+
+    return((unsigned char)((x + (x >> 8)) >> 8));
+}
+
+#ifdef RGBCOLORKERNELS_X86
+/*---------------------------------------------------------*\
+| CPU feature detection                                     |
+\*---------------------------------------------------------*/
+static bool DetectSSSE3()
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuid(info, 1);
+
+    return((info[2] & (1 << 9)) != 0);
+#else
+    return(__builtin_cpu_supports("ssse3"));
+#endif
+}
+
+static bool DetectAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    /*-----------------------------------------------------*\
+    | AVX2 needs both CPU support and the OS saving the YMM |
+    | registers                                             |
+    \*-----------------------------------------------------*/
+    __cpuid(info, 0);
+
+    if(info[0] < 7)
+    {
+        return(false);
+    }
+
+    __cpuid(info, 1);
+
+    if((info[2] & (1 << 27)) == 0)
+    {
+        return(false);
+    }
+
+    if((_xgetbv(0) & 0x06) != 0x06)
+    {
+        return(false);
+    }
+
+    __cpuidex(info, 7, 0);
+
+    return((info[1] & (1 << 5)) != 0);
+#else
+    return(__builtin_cpu_supports("avx2"));
+#endif
+}
+
+static bool HasSSSE3()
+{
+    static const bool supported = DetectSSSE3();
+
+    return(supported);
+}
+
+static bool HasAVX2()
+{
+    static const bool supported = DetectAVX2();
+
+    return(supported);
+}
+
+/*---------------------------------------------------------*\
+| Kernel selection, checking both the CPU and the limit     |
+\*---------------------------------------------------------*/
+static bool UseSSE2()
+{
+    return(kernels_limit.load(std::memory_order_relaxed) >= RGB_KERNELS_128);
+}
+
+static bool UseSSSE3()
+{
+    return(UseSSE2() && HasSSSE3());
+}
+
+static bool UseAVX2()
+{
+    return((kernels_limit.load(std::memory_order_relaxed) >= RGB_KERNELS_AVX2) && HasAVX2());
+}
+
+/*---------------------------------------------------------*\
+| Shuffle mask builders.  Masks are built for one group of  |
+| 4 LEDs and repeated across each 128-bit lane.             |
+\*---------------------------------------------------------*/
+static void BuildPackMask(unsigned char* mask, const unsigned char* channels)
+{
+    for(unsigned int byte_idx = 0; byte_idx < 16; byte_idx++)
+    {
+        mask[byte_idx] = 0x80;
+    }
+
+    for(unsigned int led_idx = 0; led_idx < 4; led_idx++)
+    {
+        for(unsigned int channel_idx = 0; channel_idx < 3; channel_idx++)
+        {
+            mask[(led_idx * 3) + channel_idx] = (unsigned char)((led_idx * 4) + channels[channel_idx]);
+        }
+    }
+}
+
+static void BuildUnpackMask(unsigned char* mask, const unsigned char* channels)
+{
+    for(unsigned int byte_idx = 0; byte_idx < 16; byte_idx++)
+    {
+        mask[byte_idx] = 0x80;
+    }
+
+    for(unsigned int led_idx = 0; led_idx < 4; led_idx++)
+    {
+        for(unsigned int channel_idx = 0; channel_idx < 3; channel_idx++)
+        {
+            mask[(led_idx * 4) + channels[channel_idx]] = (unsigned char)((led_idx * 3) + channel_idx);
+        }
+    }
+}
+
+static void BuildPaddedMask(unsigned char* mask, const unsigned char* channels)
+{
+    for(unsigned int led_idx = 0; led_idx < 4; led_idx++)
+    {
+        for(unsigned int channel_idx = 0; channel_idx < 3; channel_idx++)
+        {
+            mask[(led_idx * 4) + channel_idx] = (unsigned char)((led_idx * 4) + channels[channel_idx]);
+        }
+
+        mask[(led_idx * 4) + 3] = 0x80;
+    }
+}
+
+/*---------------------------------------------------------*\
+| SSE2 kernels                                              |
+\*---------------------------------------------------------*/
+static std::size_t ScaleRGBColorsSSE2(RGBColor* dst, const RGBColor* src, std::size_t count, unsigned char scale)
+{
+    const __m128i   zero        = _mm_setzero_si128();
+    const __m128i   scale_vec   = _mm_set1_epi16(scale);
+    const __m128i   round_vec   = _mm_set1_epi16(128);
+    std::size_t     led_idx     = 0;
+
+    for(; (led_idx + 4) <= count; led_idx += 4)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)(src + led_idx));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(in, zero), scale_vec), round_vec);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(in, zero), scale_vec), round_vec);
+
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        _mm_storeu_si128((__m128i*)(dst + led_idx), _mm_packus_epi16(lo, hi));
+    }
+
+    return(led_idx);
+}
+
+/*---------------------------------------------------------*\
+| SSSE3 kernels                                             |
+\*---------------------------------------------------------*/
+KERNEL_TARGET_SSSE3
+static std::size_t PackRGBColorsSSSE3(unsigned char* dst, const RGBColor* src, std::size_t count, const unsigned char* channels)
+{
+    unsigned char   mask_bytes[16];
+    std::size_t     led_idx     = 0;
+
+    BuildPackMask(mask_bytes, channels);
+
+    const __m128i   mask        = _mm_loadu_si128((const __m128i*)mask_bytes);
+
+    /*-----------------------------------------------------*\
+    | Each step writes 16 bytes for 12 bytes of output, so  |
+    | stop while the spare 4 bytes still land in dst        |
+    \*-----------------------------------------------------*/
+    for(; (led_idx + 6) <= count; led_idx += 4)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)(src + led_idx));
+
+        _mm_storeu_si128((__m128i*)(dst + (led_idx * 3)), _mm_shuffle_epi8(in, mask));
+    }
+
+    return(led_idx);
+}
+
+KERNEL_TARGET_SSSE3
+static std::size_t UnpackRGBColorsSSSE3(RGBColor* dst, const unsigned char* src, std::size_t count, const unsigned char* channels)
+{
+    unsigned char   mask_bytes[16];
+    std::size_t     led_idx     = 0;
+
+    BuildUnpackMask(mask_bytes, channels);
+
+    const __m128i   mask        = _mm_loadu_si128((const __m128i*)mask_bytes);
+
+    /*-----------------------------------------------------*\
+    | Each step reads 16 bytes for 12 bytes of input        |
+    \*-----------------------------------------------------*/
+    for(; (led_idx + 6) <= count; led_idx += 4)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)(src + (led_idx * 3)));
+
+        _mm_storeu_si128((__m128i*)(dst + led_idx), _mm_shuffle_epi8(in, mask));
+    }
+
+    return(led_idx);
+}
+
+KERNEL_TARGET_SSSE3
+static std::size_t PackRGBColorsPaddedSSSE3(unsigned char* dst, const RGBColor* src, std::size_t count, const unsigned char* channels)
+{
+    unsigned char   mask_bytes[16];
+    std::size_t     led_idx     = 0;
+
+    BuildPaddedMask(mask_bytes, channels);
+
+    const __m128i   mask        = _mm_loadu_si128((const __m128i*)mask_bytes);
+
+    for(; (led_idx + 4) <= count; led_idx += 4)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)(src + led_idx));
+
+        _mm_storeu_si128((__m128i*)(dst + (led_idx * 4)), _mm_shuffle_epi8(in, mask));
+    }
+
+    return(led_idx);
+}
+
+/*---------------------------------------------------------*\
+| AVX2 kernels.  Byte shuffles only work within each        |
+| 128-bit lane, so whole dwords are moved between lanes     |
+| with a cross-lane permute.                                |
+\*---------------------------------------------------------*/
+KERNEL_TARGET_AVX2
+static std::size_t PackRGBColorsAVX2(unsigned char* dst, const RGBColor* src, std::size_t count, const unsigned char* channels)
+{
+    unsigned char   mask_bytes[16];
+    std::size_t     led_idx     = 0;
+
+    BuildPackMask(mask_bytes, channels);
+
+    const __m256i   mask        = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)mask_bytes));
+    const __m256i   compact     = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+    /*-----------------------------------------------------*\
+    | Each step writes 32 bytes for 24 bytes of output      |
+    \*-----------------------------------------------------*/
+    for(; (led_idx + 11) <= count; led_idx += 8)
+    {
+        __m256i in  = _mm256_loadu_si256((const __m256i*)(src + led_idx));
+        __m256i out = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(in, mask), compact);
+
+        _mm256_storeu_si256((__m256i*)(dst + (led_idx * 3)), out);
+    }
+
+    return(led_idx);
+}
+
+KERNEL_TARGET_AVX2
+static std::size_t UnpackRGBColorsAVX2(RGBColor* dst, const unsigned char* src, std::size_t count, const unsigned char* channels)
+{
+    unsigned char   mask_bytes[16];
+    std::size_t     led_idx     = 0;
+
+    BuildUnpackMask(mask_bytes, channels);
+
+    const __m256i   mask        = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)mask_bytes));
+    const __m256i   expand      = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+
+    /*-----------------------------------------------------*\
+    | Each step reads 32 bytes for 24 bytes of input        |
+    \*-----------------------------------------------------*/
+    for(; (led_idx + 11) <= count; led_idx += 8)
+    {
+        __m256i in  = _mm256_loadu_si256((const __m256i*)(src + (led_idx * 3)));
+        __m256i out = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(in, expand), mask);
+
+        _mm256_storeu_si256((__m256i*)(dst + led_idx), out);
+    }
+
+    return(led_idx);
+}
+
+KERNEL_TARGET_AVX2
+static std::size_t PackRGBColorsPaddedAVX2(unsigned char* dst, const RGBColor* src, std::size_t count, const unsigned char* channels)
+{
+    unsigned char   mask_bytes[16];
+    std::size_t     led_idx     = 0;
+
+    BuildPaddedMask(mask_bytes, channels);
+
+    const __m256i   mask        = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)mask_bytes));
+
+    for(; (led_idx + 8) <= count; led_idx += 8)
+    {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(src + led_idx));
+
+        _mm256_storeu_si256((__m256i*)(dst + (led_idx * 4)), _mm256_shuffle_epi8(in, mask));
+    }
+
+    return(led_idx);
+}
+
+KERNEL_TARGET_AVX2
+static std::size_t ScaleRGBColorsAVX2(RGBColor* dst, const RGBColor* src, std::size_t count, unsigned char scale)
+{
+    const __m256i   zero        = _mm256_setzero_si256();
+    const __m256i   scale_vec   = _mm256_set1_epi16(scale);
+    const __m256i   round_vec   = _mm256_set1_epi16(128);
+    std::size_t     led_idx     = 0;
+
+    for(; (led_idx + 8) <= count; led_idx += 8)
+    {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(src + led_idx));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(in, zero), scale_vec), round_vec);
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(in, zero), scale_vec), round_vec);
+
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+        _mm256_storeu_si256((__m256i*)(dst + led_idx), _mm256_packus_epi16(lo, hi));
+    }
+
+    return(led_idx);
+}
+
+KERNEL_TARGET_AVX2
+static std::size_t ApplyRGBColorLUTAVX2(RGBColor* dst, const RGBColor* src, std::size_t count, const unsigned int* lut)
+{
+    const __m256i   byte_mask   = _mm256_set1_epi32(0xFF);
+    std::size_t     led_idx     = 0;
+
+    for(; (led_idx + 8) <= count; led_idx += 8)
+    {
+        __m256i in  = _mm256_loadu_si256((const __m256i*)(src + led_idx));
+        __m256i red = _mm256_and_si256(in, byte_mask);
+        __m256i grn = _mm256_and_si256(_mm256_srli_epi32(in, 8), byte_mask);
+        __m256i blu = _mm256_and_si256(_mm256_srli_epi32(in, 16), byte_mask);
+
+        __m256i out = _mm256_i32gather_epi32((const int*)(lut + 0),   red, 4);
+        out = _mm256_or_si256(out, _mm256_i32gather_epi32((const int*)(lut + 256), grn, 4));
+        out = _mm256_or_si256(out, _mm256_i32gather_epi32((const int*)(lut + 512), blu, 4));
+
+        _mm256_storeu_si256((__m256i*)(dst + led_idx), out);
+    }
+
+    return(led_idx);
+}
+#endif
+
+#ifdef RGBCOLORKERNELS_NEON
+static bool UseNEON()
+{
+    return(kernels_limit.load(std::memory_order_relaxed) >= RGB_KERNELS_128);
+}
+
+/*---------------------------------------------------------*\
+| NEON kernels.  The interleaved loads and stores split 16  |
+| LEDs into one register per channel, so reordering is just |
+| a matter of picking registers.                            |
+\*---------------------------------------------------------*/
+static std::size_t PackRGBColorsNEON(unsigned char* dst, const RGBColor* src, std::size_t count, const unsigned char* channels)
+{
+    std::size_t led_idx = 0;
+
+    for(; (led_idx + 16) <= count; led_idx += 16)
+    {
+        uint8x16x4_t in = vld4q_u8((const uint8_t*)(src + led_idx));
+        uint8x16x3_t out;
+
+        out.val[0] = in.val[channels[0]];
+        out.val[1] = in.val[channels[1]];
+        out.val[2] = in.val[channels[2]];
+
+        vst3q_u8(dst + (led_idx * 3), out);
+    }
+
+    return(led_idx);
+}
+
+static std::size_t UnpackRGBColorsNEON(RGBColor* dst, const unsigned char* src, std::size_t count, const unsigned char* channels)
+{
+    std::size_t led_idx = 0;
+
+    for(; (led_idx + 16) <= count; led_idx += 16)
+    {
+        uint8x16x3_t in = vld3q_u8(src + (led_idx * 3));
+        uint8x16x4_t out;
+
+        out.val[channels[0]] = in.val[0];
+        out.val[channels[1]] = in.val[1];
+        out.val[channels[2]] = in.val[2];
+        out.val[3]           = vdupq_n_u8(0);
+
+        vst4q_u8((uint8_t*)(dst + led_idx), out);
+    }
+
+    return(led_idx);
+}
+
+static std::size_t PackRGBColorsPaddedNEON(unsigned char* dst, const RGBColor* src, std::size_t count, const unsigned char* channels)
+{
+    std::size_t led_idx = 0;
+
+    for(; (led_idx + 16) <= count; led_idx += 16)
+    {
+        uint8x16x4_t in = vld4q_u8((const uint8_t*)(src + led_idx));
+        uint8x16x4_t out;
+
+        out.val[0] = in.val[channels[0]];
+        out.val[1] = in.val[channels[1]];
+        out.val[2] = in.val[channels[2]];
+        out.val[3] = vdupq_n_u8(0);
+
+        vst4q_u8(dst + (led_idx * 4), out);
+    }
+
+    return(led_idx);
+}
+
+static std::size_t ScaleRGBColorsNEON(RGBColor* dst, const RGBColor* src, std::size_t count, unsigned char scale)
+{
+    const uint8x8_t     scale_vec   = vdup_n_u8(scale);
+    const uint16x8_t    round_vec   = vdupq_n_u16(128);
+    std::size_t         led_idx     = 0;
+
+    for(; (led_idx + 4) <= count; led_idx += 4)
+    {
+        uint8x16_t  in  = vld1q_u8((const uint8_t*)(src + led_idx));
+        uint16x8_t  lo  = vaddq_u16(vmull_u8(vget_low_u8(in),  scale_vec), round_vec);
+        uint16x8_t  hi  = vaddq_u16(vmull_u8(vget_high_u8(in), scale_vec), round_vec);
+
+        lo = vaddq_u16(lo, vshrq_n_u16(lo, 8));
+        hi = vaddq_u16(hi, vshrq_n_u16(hi, 8));
+
+        vst1q_u8((uint8_t*)(dst + led_idx), vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+    }
+
+    return(led_idx);
+}
+#endif
+
+void SetRGBColorKernelsLimit(unsigned int level)
+{
+    kernels_limit = level;
+}
+
+unsigned int GetRGBColorKernelsLevel()
+{
+#if defined(RGBCOLORKERNELS_X86)
+    if(UseAVX2())
+    {
+        return(RGB_KERNELS_AVX2);
+    }
+    else if(UseSSE2())
+    {
+        return(RGB_KERNELS_128);
+    }
+#elif defined(RGBCOLORKERNELS_NEON)
+    if(UseNEON())
+    {
+        return(RGB_KERNELS_128);
+    }
+#endif
+
+    return(RGB_KERNELS_SCALAR);
+}
+
+void PackRGBColors(unsigned char* dst, const RGBColor* src, std::size_t count, unsigned int order)
+{
+    const unsigned char*    channels    = order_channels[order];
+    std::size_t             led_idx     = 0;
+
+#if defined(RGBCOLORKERNELS_X86)
+    if(UseAVX2())
+    {
+        led_idx = PackRGBColorsAVX2(dst, src, count, channels);
+    }
+    else if(UseSSSE3())
+    {
+        led_idx = PackRGBColorsSSSE3(dst, src, count, channels);
+    }
+#elif defined(RGBCOLORKERNELS_NEON)
+    if(UseNEON())
+    {
+        led_idx = PackRGBColorsNEON(dst, src, count, channels);
+    }
+#endif
+
+    for(; led_idx < count; led_idx++)
+    {
+        dst[(led_idx * 3) + 0] = GetChannel(src[led_idx], channels[0]);
+        dst[(led_idx * 3) + 1] = GetChannel(src[led_idx], channels[1]);
+        dst[(led_idx * 3) + 2] = GetChannel(src[led_idx], channels[2]);
+    }
+}
+
+void UnpackRGBColors(RGBColor* dst, const unsigned char* src, std::size_t count, unsigned int order)
+{
+    const unsigned char*    channels    = order_channels[order];
+    std::size_t             led_idx     = 0;
+
+#if defined(RGBCOLORKERNELS_X86)
+    if(UseAVX2())
+    {
+        led_idx = UnpackRGBColorsAVX2(dst, src, count, channels);
+    }
+    else if(UseSSSE3())
+    {
+        led_idx = UnpackRGBColorsSSSE3(dst, src, count, channels);
+    }
+#elif defined(RGBCOLORKERNELS_NEON)
+    if(UseNEON())
+    {
+        led_idx = UnpackRGBColorsNEON(dst, src, count, channels);
+    }
+#endif
+
+    for(; led_idx < count; led_idx++)
+    {
+        dst[led_idx] = ((RGBColor)src[(led_idx * 3) + 0] << (8 * channels[0]))
+                     | ((RGBColor)src[(led_idx * 3) + 1] << (8 * channels[1]))
+                     | ((RGBColor)src[(led_idx * 3) + 2] << (8 * channels[2]));
+    }
+}
+
+void PackRGBColorsPadded(unsigned char* dst, const RGBColor* src, std::size_t count, unsigned int order)
+{
+    const unsigned char*    channels    = order_channels[order];
+    std::size_t             led_idx     = 0;
+
+#if defined(RGBCOLORKERNELS_X86)
+    if(UseAVX2())
+    {
+        led_idx = PackRGBColorsPaddedAVX2(dst, src, count, channels);
+    }
+    else if(UseSSSE3())
+    {
+        led_idx = PackRGBColorsPaddedSSSE3(dst, src, count, channels);
+    }
+#elif defined(RGBCOLORKERNELS_NEON)
+    if(UseNEON())
+    {
+        led_idx = PackRGBColorsPaddedNEON(dst, src, count, channels);
+    }
+#endif
+
+    for(; led_idx < count; led_idx++)
+    {
+        dst[(led_idx * 4) + 0] = GetChannel(src[led_idx], channels[0]);
+        dst[(led_idx * 4) + 1] = GetChannel(src[led_idx], channels[1]);
+        dst[(led_idx * 4) + 2] = GetChannel(src[led_idx], channels[2]);
+        dst[(led_idx * 4) + 3] = 0;
+    }
+}
+
+void ScaleRGBColors(RGBColor* dst, const RGBColor* src, std::size_t count, unsigned char scale)
+{
+    std::size_t led_idx = 0;
+
+#if defined(RGBCOLORKERNELS_X86)
+    if(UseAVX2())
+    {
+        led_idx = ScaleRGBColorsAVX2(dst, src, count, scale);
+    }
+    else if(UseSSE2())
+    {
+        led_idx = ScaleRGBColorsSSE2(dst, src, count, scale);
+    }
+#elif defined(RGBCOLORKERNELS_NEON)
+    if(UseNEON())
+    {
+        led_idx = ScaleRGBColorsNEON(dst, src, count, scale);
+    }
+#endif
+
+    for(; led_idx < count; led_idx++)
+    {
+        dst[led_idx] = ((RGBColor)ScaleChannel(GetChannel(src[led_idx], 0), scale) << 0)
+                     | ((RGBColor)ScaleChannel(GetChannel(src[led_idx], 1), scale) << 8)
+                     | ((RGBColor)ScaleChannel(GetChannel(src[led_idx], 2), scale) << 16)
+                     | ((RGBColor)ScaleChannel(GetChannel(src[led_idx], 3), scale) << 24);
+    }
+}
+
+void ApplyRGBColorLUT(RGBColor* dst, const RGBColor* src, std::size_t count, const unsigned int* lut)
+{
+    std::size_t led_idx = 0;
+
+    /*-----------------------------------------------------*\
+    | Only AVX2 has a gather instruction, other targets use |
+    | the scalar lookups                                    |
+    \*-----------------------------------------------------*/
+#if defined(RGBCOLORKERNELS_X86)
+    if(UseAVX2())
+    {
+        led_idx = ApplyRGBColorLUTAVX2(dst, src, count, lut);
+    }
+#endif
+
+    for(; led_idx < count; led_idx++)
+    {
+        RGBColor color = src[led_idx];
+
+        dst[led_idx] = lut[  0 + GetChannel(color, 0)]
+                     | lut[256 + GetChannel(color, 1)]
+                     | lut[512 + GetChannel(color, 2)];
+    }
+}
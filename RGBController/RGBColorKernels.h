@@ -0,0 +1,85 @@
+/*---------------------------------------------------------*\
+| RGBColorKernels.h                                         |
+|                                                           |
+|   Vectorized conversions between RGBColor buffers and     |
+|   the packed byte layouts used by device protocols        |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#pragma once
+
+#include <cstddef>
+#include "RGBController.h"
+
+/*---------------------------------------------------------*\
+| Channel orders.  The name lists the channels in the order |
+| they appear in the device's byte stream.                  |
+\*---------------------------------------------------------*/
+enum
+{
+    RGB_ORDER_RGB,
+    RGB_ORDER_RBG,
+    RGB_ORDER_GRB,
+    RGB_ORDER_GBR,
+    RGB_ORDER_BRG,
+    RGB_ORDER_BGR,
+};
+
+/*---------------------------------------------------------*\
+| Kernel levels, from the plain scalar loops up to the      |
+| widest vector instructions                                |
+\*---------------------------------------------------------*/
+enum
+{
+    RGB_KERNELS_SCALAR,         /* Scalar loops only            */
+    RGB_KERNELS_128,            /* SSE2/SSSE3 or NEON, 128-bit  */
+    RGB_KERNELS_AVX2,           /* AVX2, 256-bit                */
+};
+
+/*---------------------------------------------------------*\
+| Limit the kernels to at most the given level, so that the |
+| vector kernels can be checked against and timed against   |
+| the scalar ones.  The default is RGB_KERNELS_AVX2, which  |
+| uses the widest kernels the CPU supports.                 |
+\*---------------------------------------------------------*/
+void SetRGBColorKernelsLimit(unsigned int level);
+
+/*---------------------------------------------------------*\
+| Returns the highest kernel level in use, taking both the  |
+| CPU and the limit into account                            |
+\*---------------------------------------------------------*/
+unsigned int GetRGBColorKernelsLevel();
+
+/*---------------------------------------------------------*\
+| Pack count colors into 3 bytes per LED in the given order |
+\*---------------------------------------------------------*/
+void PackRGBColors(unsigned char* dst, const RGBColor* src, std::size_t count, unsigned int order);
+
+/*---------------------------------------------------------*\
+| Unpack count LEDs of 3 bytes each in the given order into |
+| RGBColor values                                           |
+\*---------------------------------------------------------*/
+void UnpackRGBColors(RGBColor* dst, const unsigned char* src, std::size_t count, unsigned int order);
+
+/*---------------------------------------------------------*\
+| Pack count colors into 4 bytes per LED, the three color   |
+| channels in the given order followed by a zero pad byte   |
+\*---------------------------------------------------------*/
+void PackRGBColorsPadded(unsigned char* dst, const RGBColor* src, std::size_t count, unsigned int order);
+
+/*---------------------------------------------------------*\
+| Scale each channel of count colors by scale / 255, with   |
+| rounding.  dst and src may be the same buffer.            |
+\*---------------------------------------------------------*/
+void ScaleRGBColors(RGBColor* dst, const RGBColor* src, std::size_t count, unsigned char scale);
+
+/*---------------------------------------------------------*\
+| Map each channel of count colors through a lookup table.  |
+| lut holds 3 tables of 256 entries (red, green, blue), and |
+| each entry is already shifted into its channel position,  |
+| so the result is the OR of the three lookups.  dst and    |
+| src may be the same buffer.                               |
+\*---------------------------------------------------------*/
+void ApplyRGBColorLUT(RGBColor* dst, const RGBColor* src, std::size_t count, const unsigned int* lut);
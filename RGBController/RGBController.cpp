@@ -10,11 +10,167 @@
 |   SPDX-License-Identifier: GPL-2.0-or-later               |
 \*---------------------------------------------------------*/
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include "RGBController.h"
+#include "LogManager.h"
+#include "RGBColorKernels.h"
+#include "RGBControllerIdleMonitor.h"
+#include "RGBControllerWorkerPool.h"
 
 using namespace std::chrono_literals;
 
+/*---------------------------------------------------------*\
+| The published frame slot holds a buffer index plus a flag |
+| marking it as not yet picked up by the update thread      |
+\*---------------------------------------------------------*/
+#define FRAME_IDX_MASK      0x03
+#define FRAME_FLAG_NEW      0x04
+
+/*---------------------------------------------------------*\
+| Delay between attempts to reopen a failed device, doubled |
+| after each failed attempt                                 |
+\*---------------------------------------------------------*/
+#define DEVICE_REOPEN_BACKOFF_MIN_MS    500
+#define DEVICE_REOPEN_BACKOFF_MAX_MS    30000
+
+/*---------------------------------------------------------*\
+| Update scope values other than a zone or LED index        |
+\*---------------------------------------------------------*/
+#define UPDATE_SCOPE_NONE   -1
+#define UPDATE_SCOPE_ALL    -2
+
+/*---------------------------------------------------------*\
+| Hash of a frame's colors (64-bit FNV-1a over each color), |
+| used to tell frames that change the output from repeats   |
+\*---------------------------------------------------------*/
+static unsigned long long HashFrame(const std::vector<RGBColor>& frame)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for(std::size_t color_idx = 0; color_idx < frame.size(); color_idx++)
+    {
+        hash ^= frame[color_idx];
+        hash *= 1099511628211ULL;
+    }
+
+    return(hash);
+}
+
+/*---------------------------------------------------------*\
+| Protocol version 7 widened the LED count, color count,    |
+| LED alternate name count, and zone matrix size fields     |
+| from 16 to 32 bits.  Older versions carry the low 16 bits |
+| of the count, as they always have.                        |
+| The color description functions that do not take a        |
+| protocol version keep the 16 bit counts they always sent. |
+\*---------------------------------------------------------*/
+#define COUNT_LEGACY_PROTOCOL_VERSION   6
+
+static unsigned int ProtocolCount(std::size_t count, unsigned int protocol_version)
+{
+    if(protocol_version >= 7)
+    {
+        return((unsigned int)count);
+    }
+
+    return((unsigned short)count);
+}
+
+static unsigned int CountSize(unsigned int protocol_version)
+{
+    if(protocol_version >= 7)
+    {
+        return(sizeof(unsigned int));
+    }
+
+    return(sizeof(unsigned short));
+}
+
+static void WriteCount(unsigned char* data_buf, unsigned int& data_ptr, unsigned int count, unsigned int protocol_version)
+{
+    if(protocol_version >= 7)
+    {
+        memcpy(&data_buf[data_ptr], &count, sizeof(unsigned int));
+        data_ptr += sizeof(unsigned int);
+    }
+    else
+    {
+        unsigned short short_count = (unsigned short)count;
+
+        memcpy(&data_buf[data_ptr], &short_count, sizeof(unsigned short));
+        data_ptr += sizeof(unsigned short);
+    }
+}
+
+static unsigned int ReadCount(unsigned char* data_buf, unsigned int& data_ptr, unsigned int protocol_version)
+{
+    if(protocol_version >= 7)
+    {
+        unsigned int count;
+
+        memcpy(&count, &data_buf[data_ptr], sizeof(unsigned int));
+        data_ptr += sizeof(unsigned int);
+
+        return(count);
+    }
+    else
+    {
+        unsigned short short_count;
+
+        memcpy(&short_count, &data_buf[data_ptr], sizeof(unsigned short));
+        data_ptr += sizeof(unsigned short);
+
+        return(short_count);
+    }
+}
+
+/*---------------------------------------------------------*\
+| Size of an encoded color run header: start index (4),     |
+| LED count (2) and run type (1)                            |
+\*---------------------------------------------------------*/
+#define COLOR_RUN_HEADER_SIZE   7
+
+/*---------------------------------------------------------*\
+| Append runs of the given type covering count LEDs from    |
+| start, split so that no run exceeds COLOR_RUN_MAX_LENGTH  |
+\*---------------------------------------------------------*/
+static void WriteColorRuns(unsigned char* data_buf, unsigned int& data_ptr, unsigned int& num_runs, unsigned char run_type, const RGBColor* run_colors, unsigned int start, unsigned int count)
+{
+    while(count > 0)
+    {
+        unsigned short run_length = (unsigned short)std::min(count, (unsigned int)COLOR_RUN_MAX_LENGTH);
+        unsigned int   num_values = (run_type == COLOR_RUN_FILL) ? 1 : run_length;
+
+        memcpy(&data_buf[data_ptr], &start, sizeof(start));
+        data_ptr += sizeof(start);
+
+        memcpy(&data_buf[data_ptr], &run_length, sizeof(run_length));
+        data_ptr += sizeof(run_length);
+
+        data_buf[data_ptr++] = run_type;
+
+        for(unsigned int value_idx = 0; value_idx < num_values; value_idx++)
+        {
+            RGBColor color = run_colors[value_idx];
+
+            data_buf[data_ptr++] = (unsigned char)RGBGetRValue(color);
+            data_buf[data_ptr++] = (unsigned char)RGBGetGValue(color);
+            data_buf[data_ptr++] = (unsigned char)RGBGetBValue(color);
+        }
+
+        if(run_type != COLOR_RUN_FILL)
+        {
+            run_colors += run_length;
+        }
+
+        start += run_length;
+        count -= run_length;
+        num_runs++;
+    }
+}
+
 mode::mode()
 {
     name           = "";
@@ -56,18 +212,341 @@ zone::~zone()
 
 }
 
+RGBControllerLayout::RGBControllerLayout()
+{
+    zone_count  = 0;
+    led_count   = 0;
+    arena.assign(1, 0);
+}
+
+void RGBControllerLayout::Build(const std::vector<zone>& zones, const std::vector<unsigned int>& zone_led_counts)
+{
+    /*---------------------------------------------------------*\
+    | Size the arena up front so it is allocated only once      |
+    \*---------------------------------------------------------*/
+    std::size_t arena_size = 0;
+
+    zone_count  = (unsigned int)zones.size();
+    led_count   = 0;
+
+    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
+    {
+        led_count += zone_led_counts[zone_idx];
+
+        if((zones[zone_idx].type == ZONE_TYPE_MATRIX) && (zones[zone_idx].matrix_map != NULL))
+        {
+            arena_size += zones[zone_idx].matrix_map->height * zones[zone_idx].matrix_map->width;
+        }
+    }
+
+    arena_size += (5 * zone_count) + 1 + led_count;
+
+    arena.assign(arena_size, 0);
+
+    unsigned int* zone_starts       = &arena[0];
+    unsigned int* zone_types        = &arena[zone_count + 1];
+    unsigned int* matrix_offsets    = &arena[(2 * zone_count) + 1];
+    unsigned int* matrix_heights    = &arena[(3 * zone_count) + 1];
+    unsigned int* matrix_widths     = &arena[(4 * zone_count) + 1];
+    std::size_t   led_zones_offset  = (5 * zone_count) + 1;
+    std::size_t   matrix_offset     = led_zones_offset + led_count;
+    unsigned int  zone_start        = 0;
+
+    for(unsigned int zone_idx = 0; zone_idx < zone_count; zone_idx++)
+    {
+        const zone& cur_zone = zones[zone_idx];
+
+        zone_starts[zone_idx]   = zone_start;
+        zone_types[zone_idx]    = (unsigned int)cur_zone.type;
+
+        for(unsigned int led_idx = 0; led_idx < zone_led_counts[zone_idx]; led_idx++)
+        {
+            arena[led_zones_offset + zone_start + led_idx] = zone_idx;
+        }
+
+        /*-----------------------------------------------------*\
+        | Copy the matrix map, translating zone-relative LED    |
+        | indices into device LED indices                       |
+        \*-----------------------------------------------------*/
+        if((cur_zone.type == ZONE_TYPE_MATRIX) && (cur_zone.matrix_map != NULL))
+        {
+            unsigned int map_size = cur_zone.matrix_map->height * cur_zone.matrix_map->width;
+
+            matrix_offsets[zone_idx] = (unsigned int)matrix_offset;
+            matrix_heights[zone_idx] = cur_zone.matrix_map->height;
+            matrix_widths[zone_idx]  = cur_zone.matrix_map->width;
+
+            for(unsigned int map_idx = 0; map_idx < map_size; map_idx++)
+            {
+                unsigned int value = cur_zone.matrix_map->map[map_idx];
+
+                if((value == LAYOUT_NO_LED) || (value >= zone_led_counts[zone_idx]))
+                {
+                    arena[matrix_offset + map_idx] = LAYOUT_NO_LED;
+                }
+                else
+                {
+                    arena[matrix_offset + map_idx] = zone_start + value;
+                }
+            }
+
+            matrix_offset += map_size;
+        }
+
+        zone_start += zone_led_counts[zone_idx];
+    }
+
+    zone_starts[zone_count] = led_count;
+}
+
+unsigned int RGBControllerLayout::GetZoneCount() const
+{
+    return(zone_count);
+}
+
+unsigned int RGBControllerLayout::GetLEDCount() const
+{
+    return(led_count);
+}
+
+unsigned int RGBControllerLayout::GetZoneStart(unsigned int zone_idx) const
+{
+    return(arena[zone_idx]);
+}
+
+unsigned int RGBControllerLayout::GetZoneLEDCount(unsigned int zone_idx) const
+{
+    return(arena[zone_idx + 1] - arena[zone_idx]);
+}
+
+zone_type RGBControllerLayout::GetZoneType(unsigned int zone_idx) const
+{
+    return((zone_type)arena[zone_count + 1 + zone_idx]);
+}
+
+unsigned int RGBControllerLayout::GetLEDZone(unsigned int led_idx) const
+{
+    return(arena[(5 * zone_count) + 1 + led_idx]);
+}
+
+unsigned int RGBControllerLayout::GetMatrixHeight(unsigned int zone_idx) const
+{
+    return(arena[(3 * zone_count) + 1 + zone_idx]);
+}
+
+unsigned int RGBControllerLayout::GetMatrixWidth(unsigned int zone_idx) const
+{
+    return(arena[(4 * zone_count) + 1 + zone_idx]);
+}
+
+const unsigned int* RGBControllerLayout::GetMatrixMap(unsigned int zone_idx) const
+{
+    unsigned int offset = arena[(2 * zone_count) + 1 + zone_idx];
+
+    if(offset == 0)
+    {
+        return(NULL);
+    }
+
+    return(&arena[offset]);
+}
+
+RGBControllerLatencyHistogram::RGBControllerLatencyHistogram()
+{
+    Reset();
+}
+
+void RGBControllerLatencyHistogram::Record(unsigned int value)
+{
+    buckets[GetBucket(value)]++;
+
+    count++;
+    sum += value;
+
+    if(value > max)
+    {
+        max = value;
+    }
+}
+
+void RGBControllerLatencyHistogram::Reset()
+{
+    memset(buckets, 0, sizeof(buckets));
+
+    count   = 0;
+    sum     = 0;
+    max     = 0;
+}
+
+latency_stats RGBControllerLatencyHistogram::GetStats() const
+{
+    latency_stats       stats;
+    unsigned long long  p50_target  = (count + 1) / 2;
+    unsigned long long  p99_target  = ((count * 99) + 99) / 100;
+    unsigned long long  cumulative  = 0;
+
+    stats.count = count;
+    stats.p50   = 0;
+    stats.p99   = 0;
+    stats.max   = max;
+    stats.mean  = 0;
+
+    if(count == 0)
+    {
+        return(stats);
+    }
+
+    stats.mean  = (unsigned int)(sum / count);
+
+    /*-------------------------------------------------*\
+    | Report the upper bound of the bucket holding each |
+    | percentile, capped at the largest sample seen     |
+    \*-------------------------------------------------*/
+    for(unsigned int bucket_idx = 0; bucket_idx < LATENCY_HISTOGRAM_BUCKETS; bucket_idx++)
+    {
+        if(buckets[bucket_idx] == 0)
+        {
+            continue;
+        }
+
+        cumulative += buckets[bucket_idx];
+
+        if((stats.p50 == 0) && (cumulative >= p50_target))
+        {
+            stats.p50 = std::min(GetBucketUpperBound(bucket_idx), max);
+        }
+
+        if(cumulative >= p99_target)
+        {
+            stats.p99 = std::min(GetBucketUpperBound(bucket_idx), max);
+            break;
+        }
+    }
+
+    return(stats);
+}
+
+unsigned int RGBControllerLatencyHistogram::GetBucket(unsigned int value)
+{
+    if(value < 8)
+    {
+        return(value);
+    }
+
+    /*-------------------------------------------------*\
+    | The top bit selects the power of two and the next |
+    | three bits select one of its 8 buckets            |
+    \*-------------------------------------------------*/
+    unsigned int msb = 3;
+
+    while((msb < 31) && ((value >> (msb + 1)) != 0))
+    {
+        msb++;
+    }
+
+    return(8 + ((msb - 3) * 8) + ((value >> (msb - 3)) & 7));
+}
+
+unsigned int RGBControllerLatencyHistogram::GetBucketUpperBound(unsigned int bucket)
+{
+    if(bucket < 8)
+    {
+        return(bucket);
+    }
+
+    unsigned int        shift = (bucket - 8) / 8;
+    unsigned long long  lower = (unsigned long long)(8 + ((bucket - 8) % 8)) << shift;
+
+    return((unsigned int)(lower + (1ULL << shift) - 1));
+}
+
 RGBController::RGBController()
 {
     flags       = 0;
-    DeviceThreadRunning = true;
-    DeviceCallThread = new std::thread(&RGBController::DeviceCallThreadFunction, this);
+
+    CallFlag_UpdateLEDs     = false;
+    CallFlag_UpdateMode     = false;
+    DeviceCallPending       = false;
+    ModeCacheValid          = false;
+    ModeCacheActive         = 0;
+    DeviceCallQueued        = false;
+    DeviceCallDeferred      = false;
+    DeviceCallLatency       = 0;
+    DeviceCallLatencyMax    = 0;
+
+    FrameWriteIdx           = 0;
+    FramePublished          = 1;
+    FrameReadIdx            = 2;
+    FrameReaderThread       = std::thread::id();
+    FrameRateLimit          = 0;
+    FrameReleaseTime        = 0;
+    FramesRequested         = 0;
+    FramesTransmitted       = 0;
+    FramesDropped           = 0;
+    FrameHash               = 0;
+    FrameLastValid          = false;
+
+    ColorCorrection.gamma       = 1.0f;
+    ColorCorrection.red_gain    = 1.0f;
+    ColorCorrection.green_gain  = 1.0f;
+    ColorCorrection.blue_gain   = 1.0f;
+    ColorCorrection.brightness  = 255;
+    ColorCorrectionEnabled      = false;
+
+    LEDPositionsGeneration      = 0;
+
+    Health.state                = DEVICE_HEALTH_UNKNOWN;
+    Health.last_result          = 0;
+    Health.failures_in_row      = 0;
+    Health.writes               = 0;
+    Health.failures             = 0;
+    Health.bytes_written        = 0;
+    Health.bytes_per_sec        = 0;
+    HealthWindowStart           = std::chrono::steady_clock::now();
+    HealthWindowBytes           = 0;
+
+    ReopenPending               = false;
+    ReopenNextTime              = 0;
+    ReopenBackoff               = 0;
+
+    UpdateScopeZone             = UPDATE_SCOPE_NONE;
+    UpdateScopeLED              = UPDATE_SCOPE_NONE;
+
+    /*---------------------------------------------------------*\
+    | The device call thread or worker is attached on the first |
+    | update request, once the implementation has set its flags |
+    \*---------------------------------------------------------*/
+    DeviceThreadRunning     = false;
+    DeviceCallThread        = nullptr;
+    DeviceCallWorker        = -1;
 }
 
 RGBController::~RGBController()
 {
-    DeviceThreadRunning = false;
-    DeviceCallThread->join();
-    delete DeviceCallThread;
+    /*---------------------------------------------------------*\
+    | Make sure the shared worker is no longer using this       |
+    | controller                                                |
+    \*---------------------------------------------------------*/
+    if(DeviceCallWorker >= 0)
+    {
+        RGBControllerWorkerPool::get()->DetachController(this, DeviceCallWorker);
+    }
+
+    /*---------------------------------------------------------*\
+    | Wake the private device call thread so that it sees the   |
+    | stop request, then wait for it to exit                    |
+    \*---------------------------------------------------------*/
+    if(DeviceCallThread != nullptr)
+    {
+        DeviceCallMutex.lock();
+        DeviceThreadRunning = false;
+        DeviceCallMutex.unlock();
+
+        DeviceCallCV.notify_all();
+
+        DeviceCallThread->join();
+        delete DeviceCallThread;
+    }
 
     leds.clear();
     colors.clear();
@@ -128,7 +607,7 @@ std::string RGBController::GetLEDName(unsigned int led)
     return(leds[led].name);
 }
 
-unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_version)
+unsigned int RGBController::GetDeviceDescription(std::vector<unsigned char>& data_vec, unsigned int protocol_version)
 {
     unsigned int data_ptr = 0;
     unsigned int data_size = 0;
@@ -144,15 +623,16 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
     unsigned short location_len     = (unsigned short)strlen(location.c_str())    + 1;
     unsigned short num_modes        = (unsigned short)modes.size();
     unsigned short num_zones        = (unsigned short)zones.size();
-    unsigned short num_leds         = (unsigned short)leds.size();
-    unsigned short num_colors       = (unsigned short)colors.size();
-    unsigned short num_led_alt_names= (unsigned short)led_alt_names.size();
+    unsigned int   num_leds         = ProtocolCount(leds.size(), protocol_version);
+    unsigned int   num_colors       = ProtocolCount(colors.size(), protocol_version);
+    unsigned int   num_led_alt_names= ProtocolCount(led_alt_names.size(), protocol_version);
+    unsigned int   num_led_positions= ProtocolCount(led_positions.size(), protocol_version);
 
     unsigned short *mode_name_len   = new unsigned short[num_modes];
     unsigned short *zone_name_len   = new unsigned short[num_zones];
     unsigned short *led_name_len    = new unsigned short[num_leds];
 
-    unsigned short *zone_matrix_len = new unsigned short[num_zones];
+    unsigned int   *zone_matrix_len = new unsigned int[num_zones];
     unsigned short *mode_num_colors = new unsigned short[num_modes];
 
     data_size += sizeof(data_size);
@@ -218,10 +698,10 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
         }
         else
         {
-            zone_matrix_len[zone_index] = (unsigned short)((2 * sizeof(unsigned int)) + (zones[zone_index].matrix_map->height * zones[zone_index].matrix_map->width * sizeof(unsigned int)));
+            zone_matrix_len[zone_index] = ProtocolCount((2 * sizeof(unsigned int)) + (zones[zone_index].matrix_map->height * zones[zone_index].matrix_map->width * sizeof(unsigned int)), protocol_version);
         }
 
-        data_size += sizeof(zone_matrix_len[zone_index]);
+        data_size += CountSize(protocol_version);
         data_size += zone_matrix_len[zone_index];
 
         if(protocol_version >= 4)
@@ -258,9 +738,9 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
         }
     }
 
-    data_size += sizeof(num_leds);
+    data_size += CountSize(protocol_version);
 
-    for(int led_index = 0; led_index < num_leds; led_index++)
+    for(unsigned int led_index = 0; led_index < num_leds; led_index++)
     {
         led_name_len[led_index] = (unsigned short)strlen(leds[led_index].name.c_str()) + 1;
 
@@ -277,12 +757,12 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
         /*-----------------------------------------------------*\
         | Number of LED alternate names                         |
         \*-----------------------------------------------------*/
-        data_size += sizeof(num_led_alt_names);
+        data_size += CountSize(protocol_version);
 
         /*-----------------------------------------------------*\
         | LED alternate name strings                            |
         \*-----------------------------------------------------*/
-        for(std::size_t led_idx = 0; led_idx < led_alt_names.size(); led_idx++)
+        for(std::size_t led_idx = 0; led_idx < num_led_alt_names; led_idx++)
         {
             data_size += sizeof(unsigned short);
             data_size += (unsigned int)strlen(led_alt_names[led_idx].c_str()) + 1;
@@ -297,13 +777,25 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
         data_size += sizeof(flags);
     }
 
-    data_size += sizeof(num_colors);
+    /*---------------------------------------------------------*\
+    | LED positions                                             |
+    \*---------------------------------------------------------*/
+    if(protocol_version >= 9)
+    {
+        data_size += CountSize(protocol_version);
+        data_size += num_led_positions * (3 * sizeof(float));
+    }
+
+    data_size += CountSize(protocol_version);
     data_size += num_colors * sizeof(RGBColor);
 
     /*---------------------------------------------------------*\
-    | Create data buffer                                        |
+    | Size the data buffer.  The buffer only reallocates when   |
+    | it has to grow, so a reused buffer costs no allocation.   |
     \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
 
     /*---------------------------------------------------------*\
     | Copy in data size                                         |
@@ -485,13 +977,10 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
         /*---------------------------------------------------------*\
         | Copy in mode mode colors                                  |
         \*---------------------------------------------------------*/
-        for(int color_index = 0; color_index < mode_num_colors[mode_index]; color_index++)
+        if(mode_num_colors[mode_index] > 0)
         {
-            /*---------------------------------------------------------*\
-            | Copy in color (data)                                      |
-            \*---------------------------------------------------------*/
-            memcpy(&data_buf[data_ptr], &modes[mode_index].colors[color_index], sizeof(modes[mode_index].colors[color_index]));
-            data_ptr += sizeof(modes[mode_index].colors[color_index]);
+            memcpy(&data_buf[data_ptr], modes[mode_index].colors.data(), mode_num_colors[mode_index] * sizeof(RGBColor));
+            data_ptr += mode_num_colors[mode_index] * sizeof(RGBColor);
         }
     }
 
@@ -576,8 +1065,7 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
         /*---------------------------------------------------------*\
         | Copy in size of zone matrix                               |
         \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zone_matrix_len[zone_index], sizeof(zone_matrix_len[zone_index]));
-        data_ptr += sizeof(zone_matrix_len[zone_index]);
+        WriteCount(data_buf, data_ptr, zone_matrix_len[zone_index], protocol_version);
 
         /*---------------------------------------------------------*\
         | Copy in matrix data if size is nonzero                    |
@@ -671,13 +1159,12 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
     /*---------------------------------------------------------*\
     | Copy in number of LEDs (data)                             |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_leds, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    WriteCount(data_buf, data_ptr, num_leds, protocol_version);
 
     /*---------------------------------------------------------*\
     | Copy in LEDs                                              |
     \*---------------------------------------------------------*/
-    for(int led_index = 0; led_index < num_leds; led_index++)
+    for(unsigned int led_index = 0; led_index < num_leds; led_index++)
     {
         /*---------------------------------------------------------*\
         | Copy in LED name (size+data)                              |
@@ -699,19 +1186,15 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
     /*---------------------------------------------------------*\
     | Copy in number of colors (data)                           |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_colors, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    WriteCount(data_buf, data_ptr, num_colors, protocol_version);
 
     /*---------------------------------------------------------*\
     | Copy in colors                                            |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    if(num_colors > 0)
     {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &colors[color_index], sizeof(colors[color_index]));
-        data_ptr += sizeof(colors[color_index]);
+        memcpy(&data_buf[data_ptr], colors.data(), num_colors * sizeof(RGBColor));
+        data_ptr += num_colors * sizeof(RGBColor);
     }
 
     /*---------------------------------------------------------*\
@@ -722,10 +1205,9 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
         /*---------------------------------------------------------*\
         | Number of LED alternate name strings                      |
         \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &num_led_alt_names, sizeof(num_led_alt_names));
-        data_ptr += sizeof(num_led_alt_names);
+        WriteCount(data_buf, data_ptr, num_led_alt_names, protocol_version);
 
-        for(std::size_t led_idx = 0; led_idx < led_alt_names.size(); led_idx++)
+        for(std::size_t led_idx = 0; led_idx < num_led_alt_names; led_idx++)
         {
             /*---------------------------------------------------------*\
             | Copy in LED alternate name (size+data)                    |
@@ -741,12 +1223,29 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
     }
 
     /*---------------------------------------------------------*\
-    | Controller flags data                                     |
+    | Controller flags data, without the flags that only        |
+    | describe this instance's implementation                   |
     \*---------------------------------------------------------*/
     if(protocol_version >= 5)
     {
-        memcpy(&data_buf[data_ptr], &flags, sizeof(flags));
-        data_ptr += sizeof(flags);
+        unsigned int description_flags = flags & ~CONTROLLER_FLAGS_IMPLEMENTATION;
+
+        memcpy(&data_buf[data_ptr], &description_flags, sizeof(description_flags));
+        data_ptr += sizeof(description_flags);
+    }
+
+    /*---------------------------------------------------------*\
+    | LED positions data                                        |
+    \*---------------------------------------------------------*/
+    if(protocol_version >= 9)
+    {
+        WriteCount(data_buf, data_ptr, num_led_positions, protocol_version);
+
+        for(std::size_t led_idx = 0; led_idx < num_led_positions; led_idx++)
+        {
+            memcpy(&data_buf[data_ptr], &led_positions[led_idx], 3 * sizeof(float));
+            data_ptr += 3 * sizeof(float);
+        }
     }
 
     delete[] mode_name_len;
@@ -756,6 +1255,18 @@ unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_versio
     delete[] zone_matrix_len;
     delete[] mode_num_colors;
 
+    return(data_size);
+}
+
+unsigned char * RGBController::GetDeviceDescription(unsigned int protocol_version)
+{
+    std::vector<unsigned char>  data_vec;
+    unsigned int                data_size = GetDeviceDescription(data_vec, protocol_version);
+
+    unsigned char *data_buf = new unsigned char[data_size];
+
+    memcpy(data_buf, data_vec.data(), data_size);
+
     return(data_buf);
 }
 
@@ -1016,9 +1527,7 @@ void RGBController::ReadDeviceDescription(unsigned char* data_buf, unsigned int
         /*---------------------------------------------------------*\
         | Copy in size of zone matrix                               |
         \*---------------------------------------------------------*/
-        unsigned short zone_matrix_len;
-        memcpy(&zone_matrix_len, &data_buf[data_ptr], sizeof(zone_matrix_len));
-        data_ptr += sizeof(zone_matrix_len);
+        unsigned int zone_matrix_len = ReadCount(data_buf, data_ptr, protocol_version);
 
         /*---------------------------------------------------------*\
         | Copy in matrix data if size is nonzero                    |
@@ -1125,14 +1634,12 @@ void RGBController::ReadDeviceDescription(unsigned char* data_buf, unsigned int
     /*---------------------------------------------------------*\
     | Copy in number of LEDs (data)                             |
     \*---------------------------------------------------------*/
-    unsigned short num_leds;
-    memcpy(&num_leds, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned int num_leds = ReadCount(data_buf, data_ptr, protocol_version);
 
     /*---------------------------------------------------------*\
     | Copy in LEDs                                              |
     \*---------------------------------------------------------*/
-    for(int led_index = 0; led_index < num_leds; led_index++)
+    for(unsigned int led_index = 0; led_index < num_leds; led_index++)
     {
         led new_led;
 
@@ -1158,24 +1665,19 @@ void RGBController::ReadDeviceDescription(unsigned char* data_buf, unsigned int
     /*---------------------------------------------------------*\
     | Copy in number of colors (data)                           |
     \*---------------------------------------------------------*/
-    unsigned short num_colors;
-    memcpy(&num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned int num_colors = ReadCount(data_buf, data_ptr, protocol_version);
 
     /*---------------------------------------------------------*\
     | Copy in colors                                            |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
-    {
-        RGBColor new_color;
+    std::size_t colors_start = colors.size();
 
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-        data_ptr += sizeof(RGBColor);
+    colors.resize(colors_start + num_colors);
 
-        colors.push_back(new_color);
+    if(num_colors > 0)
+    {
+        memcpy(&colors[colors_start], &data_buf[data_ptr], num_colors * sizeof(RGBColor));
+        data_ptr += num_colors * sizeof(RGBColor);
     }
 
     /*---------------------------------------------------------*\
@@ -1186,12 +1688,9 @@ void RGBController::ReadDeviceDescription(unsigned char* data_buf, unsigned int
         /*---------------------------------------------------------*\
         | Copy in number of LED alternate names                     |
         \*---------------------------------------------------------*/
-        unsigned short num_led_alt_names;
-
-        memcpy(&num_led_alt_names, &data_buf[data_ptr], sizeof(num_led_alt_names));
-        data_ptr += sizeof(num_led_alt_names);
+        unsigned int num_led_alt_names = ReadCount(data_buf, data_ptr, protocol_version);
 
-        for(int led_idx = 0; led_idx < num_led_alt_names; led_idx++)
+        for(unsigned int led_idx = 0; led_idx < num_led_alt_names; led_idx++)
         {
             unsigned short string_length = 0;
 
@@ -1215,13 +1714,31 @@ void RGBController::ReadDeviceDescription(unsigned char* data_buf, unsigned int
         data_ptr += sizeof(flags);
     }
 
+    /*---------------------------------------------------------*\
+    | Copy in LED positions data                                |
+    \*---------------------------------------------------------*/
+    if(protocol_version >= 9)
+    {
+        unsigned int num_led_positions = ReadCount(data_buf, data_ptr, protocol_version);
+
+        led_positions.resize(num_led_positions);
+
+        for(unsigned int led_idx = 0; led_idx < num_led_positions; led_idx++)
+        {
+            memcpy(&led_positions[led_idx], &data_buf[data_ptr], 3 * sizeof(float));
+            data_ptr += 3 * sizeof(float);
+        }
+
+        LEDPositionsGeneration++;
+    }
+
     /*---------------------------------------------------------*\
     | Setup colors                                              |
     \*---------------------------------------------------------*/
     SetupColors();
 }
 
-unsigned char * RGBController::GetModeDescription(int mode, unsigned int protocol_version)
+unsigned int RGBController::GetModeDescription(std::vector<unsigned char>& data_vec, int mode, unsigned int protocol_version)
 {
     unsigned int data_ptr = 0;
     unsigned int data_size = 0;
@@ -1261,9 +1778,12 @@ unsigned char * RGBController::GetModeDescription(int mode, unsigned int protoco
     data_size += (mode_num_colors * sizeof(RGBColor));
 
     /*---------------------------------------------------------*\
-    | Create data buffer                                        |
+    | Size the data buffer.  The buffer only reallocates when   |
+    | it has to grow, so a reused buffer costs no allocation.   |
     \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
 
     /*---------------------------------------------------------*\
     | Copy in data size                                         |
@@ -1371,15 +1891,24 @@ unsigned char * RGBController::GetModeDescription(int mode, unsigned int protoco
     /*---------------------------------------------------------*\
     | Copy in mode mode colors                                  |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < mode_num_colors; color_index++)
+    if(mode_num_colors > 0)
     {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &modes[mode].colors[color_index], sizeof(modes[mode].colors[color_index]));
-        data_ptr += sizeof(modes[mode].colors[color_index]);
+        memcpy(&data_buf[data_ptr], modes[mode].colors.data(), mode_num_colors * sizeof(RGBColor));
+        data_ptr += mode_num_colors * sizeof(RGBColor);
     }
 
+    return(data_size);
+}
+
+unsigned char * RGBController::GetModeDescription(int mode, unsigned int protocol_version)
+{
+    std::vector<unsigned char>  data_vec;
+    unsigned int                data_size = GetModeDescription(data_vec, mode, protocol_version);
+
+    unsigned char *data_buf = new unsigned char[data_size];
+
+    memcpy(data_buf, data_vec.data(), data_size);
+
     return(data_buf);
 }
 
@@ -1522,24 +2051,27 @@ void RGBController::SetModeDescription(unsigned char* data_buf, unsigned int pro
     }
 }
 
-unsigned char * RGBController::GetColorDescription()
+unsigned int RGBController::GetColorDescription(std::vector<unsigned char>& data_vec, unsigned int protocol_version)
 {
     unsigned int data_ptr = 0;
     unsigned int data_size = 0;
 
-    unsigned short num_colors = (unsigned short)colors.size();
+    unsigned int num_colors = ProtocolCount(colors.size(), protocol_version);
 
     /*---------------------------------------------------------*\
     | Calculate data size                                       |
     \*---------------------------------------------------------*/
     data_size += sizeof(data_size);
-    data_size += sizeof(num_colors);
+    data_size += CountSize(protocol_version);
     data_size += num_colors * sizeof(RGBColor);
 
     /*---------------------------------------------------------*\
-    | Create data buffer                                        |
+    | Size the data buffer.  The buffer only reallocates when   |
+    | it has to grow, so a reused buffer costs no allocation.   |
     \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
 
     /*---------------------------------------------------------*\
     | Copy in data size                                         |
@@ -1550,34 +2082,50 @@ unsigned char * RGBController::GetColorDescription()
     /*---------------------------------------------------------*\
     | Copy in number of colors (data)                           |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_colors, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    WriteCount(data_buf, data_ptr, num_colors, protocol_version);
 
     /*---------------------------------------------------------*\
     | Copy in colors                                            |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    if(num_colors > 0)
     {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &colors[color_index], sizeof(colors[color_index]));
-        data_ptr += sizeof(colors[color_index]);
+        memcpy(&data_buf[data_ptr], colors.data(), num_colors * sizeof(RGBColor));
+        data_ptr += num_colors * sizeof(RGBColor);
     }
 
+    return(data_size);
+}
+
+unsigned char * RGBController::GetColorDescription(unsigned int protocol_version)
+{
+    std::vector<unsigned char>  data_vec;
+    unsigned int                data_size = GetColorDescription(data_vec, protocol_version);
+
+    unsigned char *data_buf = new unsigned char[data_size];
+
+    memcpy(data_buf, data_vec.data(), data_size);
+
     return(data_buf);
 }
 
+unsigned char * RGBController::GetColorDescription()
+{
+    return(GetColorDescription(COUNT_LEGACY_PROTOCOL_VERSION));
+}
+
 void RGBController::SetColorDescription(unsigned char* data_buf)
+{
+    SetColorDescription(data_buf, COUNT_LEGACY_PROTOCOL_VERSION);
+}
+
+void RGBController::SetColorDescription(unsigned char* data_buf, unsigned int protocol_version)
 {
     unsigned int data_ptr = sizeof(unsigned int);
 
     /*---------------------------------------------------------*\
     | Copy in number of colors (data)                           |
     \*---------------------------------------------------------*/
-    unsigned short num_colors;
-    memcpy(&num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned int num_colors = ReadCount(data_buf, data_ptr, protocol_version);
 
     /*---------------------------------------------------------*\
     | Check if we aren't reading beyond the list of colors.     |
@@ -1590,39 +2138,36 @@ void RGBController::SetColorDescription(unsigned char* data_buf)
     /*---------------------------------------------------------*\
     | Copy in colors                                            |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    if(num_colors > 0)
     {
-        RGBColor new_color;
-
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-        data_ptr += sizeof(RGBColor);
+        std::lock_guard<std::mutex> lock(FrameWriteMutex);
 
-        colors[color_index] = new_color;
+        memcpy(colors.data(), &data_buf[data_ptr], num_colors * sizeof(RGBColor));
     }
 }
 
-unsigned char * RGBController::GetZoneColorDescription(int zone)
+unsigned int RGBController::GetZoneColorDescription(std::vector<unsigned char>& data_vec, int zone, unsigned int protocol_version)
 {
     unsigned int data_ptr = 0;
     unsigned int data_size = 0;
 
-    unsigned short num_colors = zones[zone].leds_count;
+    unsigned int num_colors = ProtocolCount(zones[zone].leds_count, protocol_version);
 
     /*---------------------------------------------------------*\
     | Calculate data size                                       |
     \*---------------------------------------------------------*/
     data_size += sizeof(data_size);
     data_size += sizeof(zone);
-    data_size += sizeof(num_colors);
+    data_size += CountSize(protocol_version);
     data_size += num_colors * sizeof(RGBColor);
 
     /*---------------------------------------------------------*\
-    | Create data buffer                                        |
+    | Size the data buffer.  The buffer only reallocates when   |
+    | it has to grow, so a reused buffer costs no allocation.   |
     \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
 
     /*---------------------------------------------------------*\
     | Copy in data size                                         |
@@ -1639,25 +2184,43 @@ unsigned char * RGBController::GetZoneColorDescription(int zone)
     /*---------------------------------------------------------*\
     | Copy in number of colors (data)                           |
     \*---------------------------------------------------------*/
-    memcpy(&data_buf[data_ptr], &num_colors, sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    WriteCount(data_buf, data_ptr, num_colors, protocol_version);
 
     /*---------------------------------------------------------*\
     | Copy in colors                                            |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    if(num_colors > 0)
     {
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&data_buf[data_ptr], &zones[zone].colors[color_index], sizeof(zones[zone].colors[color_index]));
-        data_ptr += sizeof(zones[zone].colors[color_index]);
+        memcpy(&data_buf[data_ptr], zones[zone].colors, num_colors * sizeof(RGBColor));
+        data_ptr += num_colors * sizeof(RGBColor);
     }
 
+    return(data_size);
+}
+
+unsigned char * RGBController::GetZoneColorDescription(int zone, unsigned int protocol_version)
+{
+    std::vector<unsigned char>  data_vec;
+    unsigned int                data_size = GetZoneColorDescription(data_vec, zone, protocol_version);
+
+    unsigned char *data_buf = new unsigned char[data_size];
+
+    memcpy(data_buf, data_vec.data(), data_size);
+
     return(data_buf);
 }
 
+unsigned char * RGBController::GetZoneColorDescription(int zone)
+{
+    return(GetZoneColorDescription(zone, COUNT_LEGACY_PROTOCOL_VERSION));
+}
+
 void RGBController::SetZoneColorDescription(unsigned char* data_buf)
+{
+    SetZoneColorDescription(data_buf, COUNT_LEGACY_PROTOCOL_VERSION);
+}
+
+void RGBController::SetZoneColorDescription(unsigned char* data_buf, unsigned int protocol_version)
 {
     unsigned int data_ptr = sizeof(unsigned int);
     unsigned int zone_idx;
@@ -1671,7 +2234,7 @@ void RGBController::SetZoneColorDescription(unsigned char* data_buf)
     /*---------------------------------------------------------*\
     | Check if we aren't reading beyond the list of zones.      |
     \*---------------------------------------------------------*/
-    if(((size_t)zone_idx) > zones.size())
+    if(((size_t)zone_idx) >= zones.size())
     {
         return;
     }
@@ -1679,34 +2242,53 @@ void RGBController::SetZoneColorDescription(unsigned char* data_buf)
     /*---------------------------------------------------------*\
     | Copy in number of colors (data)                           |
     \*---------------------------------------------------------*/
-    unsigned short num_colors;
-    memcpy(&num_colors, &data_buf[data_ptr], sizeof(unsigned short));
-    data_ptr += sizeof(unsigned short);
+    unsigned int num_colors = ReadCount(data_buf, data_ptr, protocol_version);
 
     /*---------------------------------------------------------*\
-    | Copy in colors                                            |
+    | Check if we aren't reading beyond the zone's colors.      |
     \*---------------------------------------------------------*/
-    for(int color_index = 0; color_index < num_colors; color_index++)
+    if(num_colors > zones[zone_idx].leds_count)
     {
-        RGBColor new_color;
+        return;
+    }
 
-        /*---------------------------------------------------------*\
-        | Copy in color (data)                                      |
-        \*---------------------------------------------------------*/
-        memcpy(&new_color, &data_buf[data_ptr], sizeof(RGBColor));
-        data_ptr += sizeof(RGBColor);
+    /*---------------------------------------------------------*\
+    | Copy in colors                                            |
+    \*---------------------------------------------------------*/
+    if(num_colors > 0)
+    {
+        std::lock_guard<std::mutex> lock(FrameWriteMutex);
 
-        zones[zone_idx].colors[color_index] = new_color;
+        memcpy(zones[zone_idx].colors, &data_buf[data_ptr], num_colors * sizeof(RGBColor));
     }
 }
 
-unsigned char * RGBController::GetSingleLEDColorDescription(int led)
+unsigned int RGBController::GetSingleLEDColorDescription(std::vector<unsigned char>& data_vec, int led)
 {
     /*---------------------------------------------------------*\
     | Fixed size descrption:                                    |
     |       int:      LED index                                 |
     |       RGBColor: LED color                                 |
     \*---------------------------------------------------------*/
+    data_vec.resize(sizeof(int) + sizeof(RGBColor));
+
+    unsigned char *data_buf = data_vec.data();
+
+    /*---------------------------------------------------------*\
+    | Copy in LED index                                         |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[0], &led, sizeof(int));
+
+    /*---------------------------------------------------------*\
+    | Copy in LED color                                         |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[sizeof(led)], &colors[led], sizeof(RGBColor));
+
+    return((unsigned int)data_vec.size());
+}
+
+unsigned char * RGBController::GetSingleLEDColorDescription(int led)
+{
     unsigned char *data_buf = new unsigned char[sizeof(int) + sizeof(RGBColor)];
 
     /*---------------------------------------------------------*\
@@ -1739,7 +2321,7 @@ void RGBController::SetSingleLEDColorDescription(unsigned char* data_buf)
     /*---------------------------------------------------------*\
     | Check if we aren't reading beyond the list of leds.       |
     \*---------------------------------------------------------*/
-    if(((size_t)led_idx) > leds.size())
+    if(((size_t)led_idx) >= colors.size())
     {
         return;
     }
@@ -1747,10 +2329,194 @@ void RGBController::SetSingleLEDColorDescription(unsigned char* data_buf)
     /*---------------------------------------------------------*\
     | Copy in LED color                                         |
     \*---------------------------------------------------------*/
+    std::lock_guard<std::mutex> lock(FrameWriteMutex);
+
     memcpy(&colors[led_idx], &data_buf[sizeof(led_idx)], sizeof(RGBColor));
 }
 
-unsigned char * RGBController::GetSegmentDescription(int zone, segment new_segment)
+/*---------------------------------------------------------*\
+| GetEncodedColorDescription                                |
+|   Describe the colors that differ from the reference as   |
+|   runs of packed RGB values, then bring the reference up  |
+|   to date.  A reference that does not match the LED count |
+|   (such as an empty one) sends every LED.                 |
+\*---------------------------------------------------------*/
+unsigned int RGBController::GetEncodedColorDescription(std::vector<unsigned char>& data_vec, std::vector<RGBColor>& reference)
+{
+    unsigned int data_ptr   = 2 * sizeof(unsigned int);
+    unsigned int num_runs   = 0;
+    unsigned int num_leds   = (unsigned int)colors.size();
+    bool         full_frame = (reference.size() != colors.size());
+
+    if(full_frame)
+    {
+        reference.assign(num_leds, 0);
+    }
+
+    /*---------------------------------------------------------*\
+    | Size the data buffer for the worst case of one run per    |
+    | LED.  It is trimmed to the encoded size afterwards.       |
+    \*---------------------------------------------------------*/
+    data_vec.resize(data_ptr + (num_leds * (COLOR_RUN_HEADER_SIZE + 3)));
+
+    unsigned char *data_buf = data_vec.data();
+
+    unsigned int led_idx = 0;
+
+    while(led_idx < num_leds)
+    {
+        if(!full_frame && (colors[led_idx] == reference[led_idx]))
+        {
+            led_idx++;
+            continue;
+        }
+
+        /*-----------------------------------------------------*\
+        | Extend the changed range over further changes and     |
+        | over unchanged gaps too short to be worth a new run   |
+        \*-----------------------------------------------------*/
+        unsigned int last_changed = led_idx;
+        unsigned int scan_idx     = led_idx + 1;
+
+        while((scan_idx < num_leds) && ((scan_idx - last_changed) <= (COLOR_RUN_MAX_GAP + 1)))
+        {
+            if(full_frame || (colors[scan_idx] != reference[scan_idx]))
+            {
+                last_changed = scan_idx;
+            }
+
+            scan_idx++;
+        }
+
+        unsigned int range_end = last_changed + 1;
+
+        /*-----------------------------------------------------*\
+        | Send repeated colors in the range as fill runs and    |
+        | everything between them as literal runs               |
+        \*-----------------------------------------------------*/
+        unsigned int literal_start = led_idx;
+        unsigned int repeat_start  = led_idx;
+
+        while(repeat_start < range_end)
+        {
+            unsigned int repeat_end = repeat_start + 1;
+
+            while((repeat_end < range_end) && (colors[repeat_end] == colors[repeat_start]))
+            {
+                repeat_end++;
+            }
+
+            if((repeat_end - repeat_start) >= COLOR_RUN_MIN_FILL)
+            {
+                WriteColorRuns(data_buf, data_ptr, num_runs, COLOR_RUN_LITERAL, &colors[literal_start], literal_start, repeat_start - literal_start);
+                WriteColorRuns(data_buf, data_ptr, num_runs, COLOR_RUN_FILL, &colors[repeat_start], repeat_start, repeat_end - repeat_start);
+
+                literal_start = repeat_end;
+            }
+
+            repeat_start = repeat_end;
+        }
+
+        WriteColorRuns(data_buf, data_ptr, num_runs, COLOR_RUN_LITERAL, &colors[literal_start], literal_start, range_end - literal_start);
+
+        memcpy(&reference[led_idx], &colors[led_idx], (range_end - led_idx) * sizeof(RGBColor));
+
+        led_idx = range_end;
+    }
+
+    /*---------------------------------------------------------*\
+    | Copy in data size and number of runs                      |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[0], &data_ptr, sizeof(data_ptr));
+    memcpy(&data_buf[sizeof(data_ptr)], &num_runs, sizeof(num_runs));
+
+    data_vec.resize(data_ptr);
+
+    return(data_ptr);
+}
+
+/*---------------------------------------------------------*\
+| SetEncodedColorDescription                                |
+|   Apply an encoded color description.  The whole          |
+|   description is checked against the data size and LED    |
+|   count before any color is changed.  Returns false if it |
+|   is malformed.                                           |
+\*---------------------------------------------------------*/
+bool RGBController::SetEncodedColorDescription(unsigned char* data_buf, unsigned int data_size)
+{
+    unsigned int encoded_size = 0;
+    unsigned int num_runs     = 0;
+
+    if(data_size < (2 * sizeof(unsigned int)))
+    {
+        return(false);
+    }
+
+    memcpy(&encoded_size, &data_buf[0], sizeof(encoded_size));
+    memcpy(&num_runs, &data_buf[sizeof(encoded_size)], sizeof(num_runs));
+
+    if(encoded_size != data_size)
+    {
+        return(false);
+    }
+
+    std::lock_guard<std::mutex> lock(FrameWriteMutex);
+
+    for(unsigned int pass = 0; pass < 2; pass++)
+    {
+        unsigned int data_ptr = 2 * sizeof(unsigned int);
+
+        for(unsigned int run_idx = 0; run_idx < num_runs; run_idx++)
+        {
+            unsigned int   start      = 0;
+            unsigned short run_length = 0;
+            unsigned char  run_type   = 0;
+
+            if((data_size - data_ptr) < COLOR_RUN_HEADER_SIZE)
+            {
+                return(false);
+            }
+
+            memcpy(&start, &data_buf[data_ptr], sizeof(start));
+            data_ptr += sizeof(start);
+
+            memcpy(&run_length, &data_buf[data_ptr], sizeof(run_length));
+            data_ptr += sizeof(run_length);
+
+            run_type = data_buf[data_ptr++];
+
+            unsigned int num_values = (run_type == COLOR_RUN_FILL) ? 1 : run_length;
+
+            if(((run_type != COLOR_RUN_LITERAL) && (run_type != COLOR_RUN_FILL))
+            || (start > colors.size())
+            || (run_length > (colors.size() - start))
+            || ((data_size - data_ptr) < (num_values * 3)))
+            {
+                return(false);
+            }
+
+            /*-------------------------------------------------*\
+            | Colors are only written on the second pass, once  |
+            | every run is known to be valid                    |
+            \*-------------------------------------------------*/
+            if(pass == 1)
+            {
+                for(unsigned int led_idx = 0; led_idx < run_length; led_idx++)
+                {
+                    unsigned char* value = &data_buf[data_ptr + (3 * ((run_type == COLOR_RUN_FILL) ? 0 : led_idx))];
+
+                    colors[start + led_idx] = ToRGBColor(value[0], value[1], value[2]);
+                }
+            }
+
+            data_ptr += num_values * 3;
+        }
+    }
+
+    return(true);
+}
+
+unsigned int RGBController::GetSegmentDescription(std::vector<unsigned char>& data_vec, int zone, segment new_segment)
 {
     unsigned int data_ptr = 0;
     unsigned int data_size = 0;
@@ -1780,9 +2546,12 @@ unsigned char * RGBController::GetSegmentDescription(int zone, segment new_segme
     data_size += sizeof(new_segment.leds_count);
 
     /*---------------------------------------------------------*\
-    | Create data buffer                                        |
+    | Size the data buffer.  The buffer only reallocates when   |
+    | it has to grow, so a reused buffer costs no allocation.   |
     \*---------------------------------------------------------*/
-    unsigned char *data_buf = new unsigned char[data_size];
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
 
     /*---------------------------------------------------------*\
     | Copy in data size                                         |
@@ -1828,6 +2597,18 @@ unsigned char * RGBController::GetSegmentDescription(int zone, segment new_segme
     memcpy(&data_buf[data_ptr], &new_segment.leds_count, sizeof(new_segment.leds_count));
     data_ptr += sizeof(new_segment.leds_count);
 
+    return(data_size);
+}
+
+unsigned char * RGBController::GetSegmentDescription(int zone, segment new_segment)
+{
+    std::vector<unsigned char>  data_vec;
+    unsigned int                data_size = GetSegmentDescription(data_vec, zone, new_segment);
+
+    unsigned char *data_buf = new unsigned char[data_size];
+
+    memcpy(data_buf, data_vec.data(), data_size);
+
     return(data_buf);
 }
 
@@ -1943,6 +2724,23 @@ void RGBController::SetupColors()
 
         total_led_count += zone_led_count;
     }
+
+    /*---------------------------------------------------------*\
+    | Rebuild the flat layout from the new zone configuration   |
+    \*---------------------------------------------------------*/
+    std::vector<unsigned int> zone_led_counts(zones.size());
+
+    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
+    {
+        zone_led_counts[zone_idx] = GetLEDsInZone((unsigned int)zone_idx);
+    }
+
+    Layout.Build(zones, zone_led_counts);
+}
+
+const RGBControllerLayout& RGBController::GetLayout()
+{
+    return(Layout);
 }
 
 unsigned int RGBController::GetLEDsInZone(unsigned int zone)
@@ -1972,8 +2770,15 @@ RGBColor RGBController::GetLED(unsigned int led)
     }
 }
 
+/*---------------------------------------------------------*\
+| Color writers hold the frame write lock so that a         |
+| PublishFrame() on another thread never copies a partly    |
+| written frame                                             |
+\*---------------------------------------------------------*/
 void RGBController::SetLED(unsigned int led, RGBColor color)
 {
+    std::lock_guard<std::mutex> lock(FrameWriteMutex);
+
     if(led < colors.size())
     {
         colors[led] = color;
@@ -1982,14 +2787,21 @@ void RGBController::SetLED(unsigned int led, RGBColor color)
 
 void RGBController::SetAllLEDs(RGBColor color)
 {
+    std::lock_guard<std::mutex> lock(FrameWriteMutex);
+
     for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
     {
-        SetAllZoneLEDs((int)zone_idx, color);
+        for(std::size_t color_idx = 0; color_idx < GetLEDsInZone((unsigned int)zone_idx); color_idx++)
+        {
+            zones[zone_idx].colors[color_idx] = color;
+        }
     }
 }
 
 void RGBController::SetAllZoneLEDs(int zone, RGBColor color)
 {
+    std::lock_guard<std::mutex> lock(FrameWriteMutex);
+
     for (std::size_t color_idx = 0; color_idx < GetLEDsInZone(zone); color_idx++)
     {
         zones[zone].colors[color_idx] = color;
@@ -2032,6 +2844,11 @@ void RGBController::ClearCallbacks()
 {
     UpdateCallbacks.clear();
     UpdateCallbackArgs.clear();
+
+    HealthCallbackMutex.lock();
+    HealthCallbacks.clear();
+    HealthCallbackArgs.clear();
+    HealthCallbackMutex.unlock();
 }
 
 void RGBController::SignalUpdate()
@@ -2050,104 +2867,1329 @@ void RGBController::SignalUpdate()
 }
 void RGBController::UpdateLEDs()
 {
+    MergeUpdateScope(UPDATE_SCOPE_ALL, UPDATE_SCOPE_ALL);
+    PublishFrame();
+
+    FrameReleaseTime    = 0;
     CallFlag_UpdateLEDs = true;
 
+    SignalDeviceCall();
+
     SignalUpdate();
 }
 
-void RGBController::UpdateMode()
+/*---------------------------------------------------------*\
+| UpdateLEDsAt                                              |
+|   Publish the current colors like UpdateLEDs(), but hold  |
+|   the frame on the device update thread until the given   |
+|   release time.  A later UpdateLEDs() or UpdateLEDsAt()   |
+|   replaces both the frame and its release time.           |
+\*---------------------------------------------------------*/
+void RGBController::UpdateLEDsAt(std::chrono::steady_clock::time_point release_time)
 {
-    CallFlag_UpdateMode = true;
-}
+    MergeUpdateScope(UPDATE_SCOPE_ALL, UPDATE_SCOPE_ALL);
+    PublishFrame();
 
-void RGBController::SaveMode()
-{
-    DeviceSaveMode();
-}
+    FrameReleaseTime    = (long long)release_time.time_since_epoch().count();
+    CallFlag_UpdateLEDs = true;
 
-void RGBController::DeviceUpdateLEDs()
-{
+    SignalDeviceCall();
 
+    SignalUpdate();
 }
 
-void RGBController::SetCustomMode()
+/*---------------------------------------------------------*\
+| QueueZoneLEDs                                             |
+|   Publish the current colors like UpdateLEDs() for a      |
+|   change limited to one zone.  If every update requested  |
+|   since the last frame was sent falls within that zone,   |
+|   devices with CONTROLLER_FLAG_PARTIAL_UPDATES are sent   |
+|   the zone with UpdateZoneLEDs() instead of a full frame. |
+\*---------------------------------------------------------*/
+void RGBController::QueueZoneLEDs(int zone)
 {
-    /*-------------------------------------------------*\
-    | Search the Controller's mode list for a suitable  |
-    | per-LED custom mode in the following order:       |
-    | 1.    Direct                                      |
-    | 2.    Custom                                      |
-    | 3.    Static                                      |
-    \*-------------------------------------------------*/
-    #define NUM_CUSTOM_MODE_NAMES 3
-
-    const std::string custom_mode_names[] =
+    if((zone < 0) || ((std::size_t)zone >= zones.size()))
+    {
+        return;
+    }
+
+    int led = UPDATE_SCOPE_ALL;
+
+    if(zones[zone].leds_count == 1)
+    {
+        led = (int)zones[zone].start_idx;
+    }
+
+    MergeUpdateScope(zone, led);
+    PublishFrame();
+
+    FrameReleaseTime    = 0;
+    CallFlag_UpdateLEDs = true;
+
+    SignalDeviceCall();
+
+    SignalUpdate();
+}
+
+/*---------------------------------------------------------*\
+| QueueSingleLED                                            |
+|   Publish the current colors like UpdateLEDs() for a      |
+|   change to one LED, sent with UpdateSingleLED() if no    |
+|   other LED was updated since the last frame was sent     |
+\*---------------------------------------------------------*/
+void RGBController::QueueSingleLED(int led)
+{
+    if((led < 0) || ((std::size_t)led >= leds.size()))
+    {
+        return;
+    }
+
+    int zone = UPDATE_SCOPE_ALL;
+
+    for(std::size_t zone_idx = 0; zone_idx < zones.size(); zone_idx++)
+    {
+        if(((unsigned int)led >= zones[zone_idx].start_idx)
+        && ((unsigned int)led < (zones[zone_idx].start_idx + zones[zone_idx].leds_count)))
+        {
+            zone = (int)zone_idx;
+            break;
+        }
+    }
+
+    MergeUpdateScope(zone, led);
+    PublishFrame();
+
+    FrameReleaseTime    = 0;
+    CallFlag_UpdateLEDs = true;
+
+    SignalDeviceCall();
+
+    SignalUpdate();
+}
+
+/*---------------------------------------------------------*\
+| MergeUpdateScope                                          |
+|   Widen the pending update scope to cover a zone and LED. |
+|   A scope covering two different zones or LEDs becomes    |
+|   UPDATE_SCOPE_ALL.                                       |
+\*---------------------------------------------------------*/
+void RGBController::MergeUpdateScope(int zone, int led)
+{
+    std::lock_guard<std::mutex> lock(UpdateScopeMutex);
+
+    if(UpdateScopeZone == UPDATE_SCOPE_NONE)
+    {
+        UpdateScopeZone = zone;
+    }
+    else if(UpdateScopeZone != zone)
+    {
+        UpdateScopeZone = UPDATE_SCOPE_ALL;
+    }
+
+    if(UpdateScopeLED == UPDATE_SCOPE_NONE)
+    {
+        UpdateScopeLED = led;
+    }
+    else if(UpdateScopeLED != led)
+    {
+        UpdateScopeLED = UPDATE_SCOPE_ALL;
+    }
+}
+
+/*---------------------------------------------------------*\
+| DeviceUpdateScope                                         |
+|   Send the pending update with the cheapest device call   |
+|   that covers it and reset the scope.  Only devices with  |
+|   CONTROLLER_FLAG_PARTIAL_UPDATES get partial calls.      |
+\*---------------------------------------------------------*/
+void RGBController::DeviceUpdateScope()
+{
+    UpdateScopeMutex.lock();
+
+    int zone        = UpdateScopeZone;
+    int led         = UpdateScopeLED;
+
+    UpdateScopeZone = UPDATE_SCOPE_NONE;
+    UpdateScopeLED  = UPDATE_SCOPE_NONE;
+
+    UpdateScopeMutex.unlock();
+
+    if(!(flags & CONTROLLER_FLAG_PARTIAL_UPDATES))
+    {
+        DeviceUpdateLEDs();
+    }
+    else if(led >= 0)
+    {
+        UpdateSingleLED(led);
+    }
+    else if(zone >= 0)
+    {
+        UpdateZoneLEDs(zone);
+    }
+    else
+    {
+        DeviceUpdateLEDs();
+    }
+}
+
+void RGBController::UpdateMode()
+{
+    /*-------------------------------------------------*\
+    | Skip the device call if the mode has not changed  |
+    | since it was last sent.  Remote devices may be    |
+    | changed by other clients, so always send those.   |
+    \*-------------------------------------------------*/
+    if(!(flags & CONTROLLER_FLAG_REMOTE) && !UpdateModeCache())
+    {
+        return;
+    }
+
+    RGBControllerIdleMonitor::get()->NotifyActivity();
+
+    CallFlag_UpdateMode = true;
+
+    SignalDeviceCall();
+}
+
+void RGBController::InvalidateMode()
+{
+    std::lock_guard<std::mutex> lock(ModeCacheMutex);
+
+    ModeCacheValid = false;
+}
+
+/*---------------------------------------------------------*\
+| RequestReopen                                             |
+|   Reopen the device on its update thread, such as after   |
+|   the system resumes from suspend, and then restore its   |
+|   mode and colors.  Ignored by devices that do not set    |
+|   CONTROLLER_FLAG_REOPEN.                                 |
+\*---------------------------------------------------------*/
+void RGBController::RequestReopen()
+{
+    if(!(flags & CONTROLLER_FLAG_REOPEN))
+    {
+        return;
+    }
+
+    ReopenNextTime      = 0;
+    ReopenPending       = true;
+    CallFlag_UpdateMode = true;
+
+    SignalDeviceCall();
+}
+
+/*---------------------------------------------------------*\
+| ReopenDevice                                              |
+|   Attempt a pending reopen on the update thread.  Returns |
+|   true once the device is open again, with its last mode  |
+|   and frame queued to be sent.                            |
+\*---------------------------------------------------------*/
+bool RGBController::ReopenDevice(std::chrono::steady_clock::time_point call_time)
+{
+    if(call_time.time_since_epoch().count() < ReopenNextTime.load())
+    {
+        return(false);
+    }
+
+    if(!DeviceReopen())
+    {
+        ReopenBackoff   = std::min(std::max(ReopenBackoff * 2, (unsigned int)DEVICE_REOPEN_BACKOFF_MIN_MS), (unsigned int)DEVICE_REOPEN_BACKOFF_MAX_MS);
+        ReopenNextTime  = (long long)(call_time + std::chrono::milliseconds(ReopenBackoff)).time_since_epoch().count();
+
+        LOG_DEBUG("[%s] Reopen failed, retrying in %u ms", name.c_str(), ReopenBackoff);
+
+        return(false);
+    }
+
+    LOG_INFO("[%s] Device reopened", name.c_str());
+
+    ReopenPending   = false;
+    ReopenNextTime  = 0;
+    ReopenBackoff   = 0;
+
+    /*-------------------------------------------------*\
+    | Start the failure count over on the new handle so |
+    | that the device fails and is reopened again if    |
+    | its writes keep failing                           |
+    \*-------------------------------------------------*/
+    HealthMutex.lock();
+
+    device_health_state old_state = Health.state;
+
+    Health.state            = DEVICE_HEALTH_UNKNOWN;
+    Health.failures_in_row  = 0;
+
+    device_health health    = Health;
+
+    HealthMutex.unlock();
+
+    if(old_state != DEVICE_HEALTH_UNKNOWN)
+    {
+        SignalHealthChanged(health);
+    }
+
+    /*-------------------------------------------------*\
+    | The device may have lost its state, so resend the |
+    | active mode and the current colors in full        |
+    \*-------------------------------------------------*/
+    InvalidateMode();
+    MergeUpdateScope(UPDATE_SCOPE_ALL, UPDATE_SCOPE_ALL);
+    PublishFrame();
+
+    FrameReleaseTime    = 0;
+    FrameLastValid      = false;
+    CallFlag_UpdateMode = true;
+    CallFlag_UpdateLEDs = true;
+
+    return(true);
+}
+
+/*---------------------------------------------------------*\
+| UpdateModeCache                                           |
+|   Compare the active mode and its settings to the last    |
+|   mode sent.  Returns true and records the new state if   |
+|   anything changed.                                       |
+\*---------------------------------------------------------*/
+bool RGBController::UpdateModeCache()
+{
+    std::lock_guard<std::mutex> lock(ModeCacheMutex);
+
+    if((active_mode < 0) || ((std::size_t)active_mode >= modes.size()))
+    {
+        ModeCacheValid = false;
+        return(true);
+    }
+
+    const mode& active = modes[active_mode];
+
+    if(ModeCacheValid
+    && (ModeCacheActive            == active_mode      )
+    && (ModeCacheState.value       == active.value     )
+    && (ModeCacheState.speed       == active.speed     )
+    && (ModeCacheState.brightness  == active.brightness)
+    && (ModeCacheState.direction   == active.direction )
+    && (ModeCacheState.color_mode  == active.color_mode)
+    && (ModeCacheState.colors      == active.colors    ))
+    {
+        return(false);
+    }
+
+    ModeCacheValid              = true;
+    ModeCacheActive             = active_mode;
+    ModeCacheState.value        = active.value;
+    ModeCacheState.speed        = active.speed;
+    ModeCacheState.brightness   = active.brightness;
+    ModeCacheState.direction    = active.direction;
+    ModeCacheState.color_mode   = active.color_mode;
+    ModeCacheState.colors       = active.colors;
+
+    return(true);
+}
+
+void RGBController::PublishFrame()
+{
+    /*-------------------------------------------------*\
+    | Only writers contend on this mutex, the update    |
+    | thread never takes it                             |
+    \*-------------------------------------------------*/
+    FrameWriteMutex.lock();
+
+    FrameBuffers[FrameWriteIdx].assign(colors.begin(), colors.end());
+    FrameTimes[FrameWriteIdx] = std::chrono::steady_clock::now();
+
+    unsigned long long  frame_hash      = HashFrame(FrameBuffers[FrameWriteIdx]);
+    bool                frame_changed   = (frame_hash != FrameHash);
+
+    FrameHash = frame_hash;
+
+    unsigned int replaced = FramePublished.exchange(FrameWriteIdx | FRAME_FLAG_NEW);
+
+    FrameWriteIdx = replaced & FRAME_IDX_MASK;
+
+    FrameWriteMutex.unlock();
+
+    /*-------------------------------------------------*\
+    | Frames repeating the last colors published, such  |
+    | as keepalive frames, leave the output idle        |
+    \*-------------------------------------------------*/
+    if(frame_changed)
+    {
+        RGBControllerIdleMonitor::get()->NotifyActivity();
+    }
+
+    /*-------------------------------------------------*\
+    | If the frame we replaced was never picked up by   |
+    | the update thread, it has been dropped            |
+    \*-------------------------------------------------*/
+    FramesRequested++;
+
+    if(replaced & FRAME_FLAG_NEW)
+    {
+        FramesDropped++;
+    }
+}
+
+/*---------------------------------------------------------*\
+| SetLEDRange                                               |
+|   Copy a range of colors into the colors vector while     |
+|   holding the frame write lock, so that a PublishFrame()  |
+|   on another thread never copies a partly written range.  |
+|   The range is clipped to the LEDs of the controller.     |
+\*---------------------------------------------------------*/
+void RGBController::SetLEDRange(unsigned int start_idx, const RGBColor* range_colors, unsigned int count)
+{
+    FrameWriteMutex.lock();
+
+    if(start_idx < colors.size())
+    {
+        count = std::min(count, (unsigned int)colors.size() - start_idx);
+
+        memcpy(&colors[start_idx], range_colors, count * sizeof(RGBColor));
+    }
+
+    FrameWriteMutex.unlock();
+}
+
+bool RGBController::AcquireFrame()
+{
+    if((FramePublished.load() & FRAME_FLAG_NEW) == 0)
+    {
+        return(false);
+    }
+
+    FrameReadIdx = FramePublished.exchange(FrameReadIdx) & FRAME_IDX_MASK;
+
+    /*-------------------------------------------------*\
+    | Apply color correction to the new frame.  The     |
+    | read buffer belongs to this thread, so it is      |
+    | corrected in place.                               |
+    \*-------------------------------------------------*/
+    ColorCorrectionMutex.lock();
+
+    if(ColorCorrectionEnabled)
+    {
+        std::vector<RGBColor>& frame = FrameBuffers[FrameReadIdx];
+
+        ApplyRGBColorLUT(frame.data(), frame.data(), frame.size(), ColorCorrectionLUT);
+    }
+
+    ColorCorrectionMutex.unlock();
+
+    return(true);
+}
+
+const std::vector<RGBColor>& RGBController::GetFrame()
+{
+    if((FrameReaderThread.load() == std::this_thread::get_id())
+    && (FrameBuffers[FrameReadIdx].size() == colors.size()))
+    {
+        return(FrameBuffers[FrameReadIdx]);
+    }
+
+    /*-------------------------------------------------*\
+    | Outside of the update thread, such as from a      |
+    | keepalive thread or a direct UpdateZoneLEDs()     |
+    | call, correct a copy of the live colors so that   |
+    | every frame a device sends is corrected           |
+    \*-------------------------------------------------*/
+    std::lock_guard<std::mutex> lock(ColorCorrectionMutex);
+
+    if(!ColorCorrectionEnabled)
+    {
+        return(colors);
+    }
+
+    FrameDirect.resize(colors.size());
+
+    ApplyRGBColorLUT(FrameDirect.data(), colors.data(), colors.size(), ColorCorrectionLUT);
+
+    return(FrameDirect);
+}
+
+void RGBController::SignalDeviceCall()
+{
+    int worker_idx;
+
+    DeviceCallMutex.lock();
+
+    /*-------------------------------------------------*\
+    | Record the time of the oldest outstanding request |
+    | so the update can measure how long it took to     |
+    | start the hardware write                          |
+    \*-------------------------------------------------*/
+    if(!DeviceCallPending)
+    {
+        DeviceCallPending       = true;
+        DeviceCallRequestTime   = std::chrono::steady_clock::now();
+    }
+
+    /*-------------------------------------------------*\
+    | On the first request, either start a private      |
+    | device call thread or attach to the shared worker |
+    | pool                                              |
+    \*-------------------------------------------------*/
+    if((DeviceCallThread == nullptr) && (DeviceCallWorker < 0))
+    {
+        if(flags & CONTROLLER_FLAG_PRIVATE_THREAD)
+        {
+            DeviceThreadRunning = true;
+            DeviceCallThread    = new std::thread(&RGBController::DeviceCallThreadFunction, this);
+        }
+        else
+        {
+            DeviceCallWorker    = RGBControllerWorkerPool::get()->AttachController(this);
+        }
+    }
+
+    worker_idx = DeviceCallWorker;
+
+    DeviceCallMutex.unlock();
+
+    if(worker_idx >= 0)
+    {
+        RGBControllerWorkerPool::get()->ScheduleController(this, worker_idx);
+    }
+    else
+    {
+        DeviceCallCV.notify_one();
+    }
+}
+
+void RGBController::SaveMode()
+{
+    DeviceSaveMode();
+}
+
+void RGBController::DeviceUpdateLEDs()
+{
+
+}
+
+void RGBController::SetCustomMode()
+{
+    /*-------------------------------------------------*\
+    | Search the Controller's mode list for a suitable  |
+    | per-LED custom mode in the following order:       |
+    | 1.    Direct                                      |
+    | 2.    Custom                                      |
+    | 3.    Static                                      |
+    \*-------------------------------------------------*/
+    #define NUM_CUSTOM_MODE_NAMES 3
+
+    const std::string custom_mode_names[] =
     {
         "Direct",
         "Custom",
         "Static"
     };
 
-    for(unsigned int custom_mode_idx = 0; custom_mode_idx < NUM_CUSTOM_MODE_NAMES; custom_mode_idx++)
+    for(unsigned int custom_mode_idx = 0; custom_mode_idx < NUM_CUSTOM_MODE_NAMES; custom_mode_idx++)
+    {
+        for(unsigned int mode_idx = 0; mode_idx < modes.size(); mode_idx++)
+        {
+            if((modes[mode_idx].name == custom_mode_names[custom_mode_idx])
+            && ((modes[mode_idx].color_mode == MODE_COLORS_PER_LED)
+             || (modes[mode_idx].color_mode == MODE_COLORS_MODE_SPECIFIC)))
+            {
+                active_mode = mode_idx;
+                return;
+            }
+        }
+    }
+}
+
+void RGBController::DeviceUpdateMode()
+{
+
+}
+
+bool RGBController::DeviceReopen()
+{
+    return(false);
+}
+
+void RGBController::DeviceCallThreadFunction()
+{
+    std::chrono::steady_clock::time_point   next_call_time;
+    bool                                    deferred = false;
+
+    while(DeviceThreadRunning.load() == true)
+    {
+        /*-------------------------------------------------*\
+        | Sleep until there is work to do or the thread is  |
+        | asked to stop                                     |
+        \*-------------------------------------------------*/
+        {
+            std::unique_lock<std::mutex> lock(DeviceCallMutex);
+
+            if(deferred)
+            {
+                /*-----------------------------------------*\
+                | An LED update is waiting for the frame    |
+                | rate limit, wait for its time slot unless |
+                | a mode update comes in first              |
+                \*-----------------------------------------*/
+                DeviceCallCV.wait_until(lock, next_call_time, [this]
+                {
+                    return((DeviceThreadRunning.load() == false)
+                        || (CallFlag_UpdateMode.load() == true));
+                });
+            }
+            else
+            {
+                /*-----------------------------------------*\
+                | A request that arrived during the         |
+                | previous write may already have been      |
+                | consumed, so only keep its timestamp if   |
+                | work is still flagged                     |
+                \*-----------------------------------------*/
+                if((CallFlag_UpdateMode.load() == false)
+                && (CallFlag_UpdateLEDs.load() == false))
+                {
+                    DeviceCallPending = false;
+                }
+
+                DeviceCallCV.wait(lock, [this]
+                {
+                    return((DeviceThreadRunning.load() == false)
+                        || (CallFlag_UpdateMode.load() == true)
+                        || (CallFlag_UpdateLEDs.load() == true));
+                });
+            }
+
+            RGBControllerIdleMonitor::get()->RecordWakeup(IDLE_WAKEUP_DEVICE_THREAD);
+
+            if(DeviceThreadRunning.load() == false)
+            {
+                break;
+            }
+        }
+
+        deferred = ProcessDeviceCalls(next_call_time);
+    }
+}
+
+bool RGBController::ProcessDeviceCalls(std::chrono::steady_clock::time_point& next_call_time)
+{
+    std::chrono::steady_clock::time_point request_time;
+    std::chrono::steady_clock::time_point call_time = std::chrono::steady_clock::now();
+
+    /*-------------------------------------------------*\
+    | While a failed device cannot be reopened, drop    |
+    | its updates instead of writing to a dead handle   |
+    | and come back for the next attempt.  The latest   |
+    | mode and colors are restored once it reopens.     |
+    \*-------------------------------------------------*/
+    if(ReopenPending.load() && !ReopenDevice(call_time))
+    {
+        CallFlag_UpdateMode = false;
+        CallFlag_UpdateLEDs = false;
+
+        DeviceCallMutex.lock();
+        DeviceCallPending   = false;
+        DeviceCallMutex.unlock();
+
+        next_call_time = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ReopenNextTime.load()));
+
+        return(true);
+    }
+
+    /*-------------------------------------------------*\
+    | Hold back the LED update if the previous frame    |
+    | was sent less than one frame interval ago, or if  |
+    | the frame has a release time that has not been    |
+    | reached.  Any frames published in the meantime    |
+    | are coalesced and only the latest one is sent.    |
+    \*-------------------------------------------------*/
+    bool leds_deferred = false;
+
+    if(CallFlag_UpdateLEDs.load() == true)
+    {
+        next_call_time = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(FrameReleaseTime.load()));
+
+        if((FrameRateLimit.load() > 0) && (FrameNextTime > next_call_time))
+        {
+            next_call_time = FrameNextTime;
+        }
+
+        leds_deferred = (call_time < next_call_time);
+    }
+
+    if(leds_deferred)
+    {
+        if(CallFlag_UpdateMode.load() == false)
+        {
+            return(true);
+        }
+    }
+
+    DeviceCallMutex.lock();
+    request_time        = DeviceCallRequestTime;
+    DeviceCallPending   = leds_deferred;
+    DeviceCallMutex.unlock();
+
+    if((CallFlag_UpdateMode.load() == false)
+    && (CallFlag_UpdateLEDs.load() == false))
+    {
+        return(false);
+    }
+
+    /*-------------------------------------------------*\
+    | Measure the wake-to-write latency in microseconds |
+    \*-------------------------------------------------*/
+    unsigned int latency = (unsigned int)std::chrono::duration_cast<std::chrono::microseconds>(call_time - request_time).count();
+
+    DeviceCallLatency = latency;
+
+    if(latency > DeviceCallLatencyMax.load())
+    {
+        DeviceCallLatencyMax = latency;
+    }
+
+    if(CallFlag_UpdateMode.load() == true)
+    {
+        if(flags & CONTROLLER_FLAG_RESET_BEFORE_UPDATE)
+        {
+            CallFlag_UpdateMode = false;
+            DeviceUpdateMode();
+        }
+        else
+        {
+            DeviceUpdateMode();
+            CallFlag_UpdateMode = false;
+        }
+
+        /*---------------------------------------------*\
+        | A mode change may reset the LEDs on the       |
+        | device, so resend the next frame in full      |
+        \*---------------------------------------------*/
+        MergeUpdateScope(UPDATE_SCOPE_ALL, UPDATE_SCOPE_ALL);
+
+        FrameLastValid = false;
+    }
+    if(!leds_deferred && CallFlag_UpdateLEDs.exchange(false))
+    {
+        /*---------------------------------------------*\
+        | Pick up the latest published frame and make   |
+        | it visible to DeviceUpdateLEDs() on this      |
+        | thread only.  The flag is cleared first, so a |
+        | frame published during the write below sets   |
+        | it again and is sent on the next pass.        |
+        \*---------------------------------------------*/
+        bool frame_acquired = AcquireFrame();
+
+        FrameReaderThread = std::this_thread::get_id();
+
+        if(FrameRateLimit.load() > 0)
+        {
+            FrameNextTime = call_time + std::chrono::microseconds(1000000 / FrameRateLimit.load());
+        }
+
+        /*---------------------------------------------*\
+        | Controllers tracking dirty LEDs skip frames   |
+        | that are identical to the last one sent       |
+        \*---------------------------------------------*/
+        if((flags & CONTROLLER_FLAG_DIRTY_TRACKING) && !UpdateDirtyRanges(GetFrame()))
+        {
+            UpdateScopeMutex.lock();
+            UpdateScopeZone     = UPDATE_SCOPE_NONE;
+            UpdateScopeLED      = UPDATE_SCOPE_NONE;
+            UpdateScopeMutex.unlock();
+        }
+        else
+        {
+            FramesTransmitted++;
+
+            HealthMutex.lock();
+            unsigned long long failures = Health.failures;
+            HealthMutex.unlock();
+
+            std::chrono::steady_clock::time_point write_start = std::chrono::steady_clock::now();
+
+            DeviceUpdateScope();
+
+            std::chrono::steady_clock::time_point write_end = std::chrono::steady_clock::now();
+
+            /*-----------------------------------------*\
+            | Only remember the frame as sent if no     |
+            | write failed while sending it, otherwise  |
+            | resend the next frame in full             |
+            \*-----------------------------------------*/
+            if(flags & CONTROLLER_FLAG_DIRTY_TRACKING)
+            {
+                HealthMutex.lock();
+                bool write_failed = (Health.failures != failures);
+                HealthMutex.unlock();
+
+                if(write_failed)
+                {
+                    FrameLastValid = false;
+                }
+                else
+                {
+                    CommitDirtyRanges(GetFrame());
+                }
+            }
+
+            /*-----------------------------------------*\
+            | Record the frame's path from publication  |
+            | to the end of the device write            |
+            \*-----------------------------------------*/
+            if(frame_acquired)
+            {
+                std::chrono::steady_clock::time_point frame_time = FrameTimes[FrameReadIdx];
+
+                LatencyMutex.lock();
+                LatencyHistograms[LATENCY_STAGE_QUEUE].Record((unsigned int)std::chrono::duration_cast<std::chrono::microseconds>(write_start - frame_time).count());
+                LatencyHistograms[LATENCY_STAGE_WRITE].Record((unsigned int)std::chrono::duration_cast<std::chrono::microseconds>(write_end - write_start).count());
+                LatencyHistograms[LATENCY_STAGE_TOTAL].Record((unsigned int)std::chrono::duration_cast<std::chrono::microseconds>(write_end - frame_time).count());
+                LatencyMutex.unlock();
+            }
+        }
+
+        FrameReaderThread = std::thread::id();
+    }
+
+    return(leds_deferred);
+}
+
+void RGBController::SetFrameRateLimit(unsigned int fps)
+{
+    FrameRateLimit = fps;
+}
+
+unsigned int RGBController::GetFrameRateLimit()
+{
+    return(FrameRateLimit.load());
+}
+
+unsigned long long RGBController::GetFramesRequested()
+{
+    return(FramesRequested.load());
+}
+
+unsigned long long RGBController::GetFramesTransmitted()
+{
+    return(FramesTransmitted.load());
+}
+
+unsigned long long RGBController::GetFramesDropped()
+{
+    return(FramesDropped.load());
+}
+
+std::vector<latency_stats> RGBController::GetLatencyStats()
+{
+    std::vector<latency_stats> stats;
+
+    LatencyMutex.lock();
+
+    for(unsigned int stage_idx = 0; stage_idx < LATENCY_STAGE_COUNT; stage_idx++)
+    {
+        stats.push_back(LatencyHistograms[stage_idx].GetStats());
+    }
+
+    LatencyMutex.unlock();
+
+    return(stats);
+}
+
+void RGBController::ResetLatencyStats()
+{
+    LatencyMutex.lock();
+
+    for(unsigned int stage_idx = 0; stage_idx < LATENCY_STAGE_COUNT; stage_idx++)
+    {
+        LatencyHistograms[stage_idx].Reset();
+    }
+
+    LatencyMutex.unlock();
+}
+
+unsigned int RGBController::GetLatencyStatsDescription(std::vector<unsigned char>& data_vec)
+{
+    std::vector<latency_stats> stats = GetLatencyStats();
+
+    unsigned int    data_ptr    = 0;
+    unsigned int    data_size   = 0;
+    unsigned short  num_stages  = (unsigned short)stats.size();
+
+    /*---------------------------------------------------------*\
+    | Calculate data size                                       |
+    \*---------------------------------------------------------*/
+    data_size += sizeof(data_size);
+    data_size += sizeof(num_stages);
+    data_size += num_stages * (sizeof(unsigned long long) + (4 * sizeof(unsigned int)));
+
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
+
+    /*---------------------------------------------------------*\
+    | Copy in data size                                         |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
+    data_ptr += sizeof(data_size);
+
+    /*---------------------------------------------------------*\
+    | Copy in number of stages                                  |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &num_stages, sizeof(num_stages));
+    data_ptr += sizeof(num_stages);
+
+    /*---------------------------------------------------------*\
+    | Copy in each stage's statistics                           |
+    \*---------------------------------------------------------*/
+    for(unsigned short stage_idx = 0; stage_idx < num_stages; stage_idx++)
+    {
+        memcpy(&data_buf[data_ptr], &stats[stage_idx].count, sizeof(stats[stage_idx].count));
+        data_ptr += sizeof(stats[stage_idx].count);
+
+        memcpy(&data_buf[data_ptr], &stats[stage_idx].p50, sizeof(stats[stage_idx].p50));
+        data_ptr += sizeof(stats[stage_idx].p50);
+
+        memcpy(&data_buf[data_ptr], &stats[stage_idx].p99, sizeof(stats[stage_idx].p99));
+        data_ptr += sizeof(stats[stage_idx].p99);
+
+        memcpy(&data_buf[data_ptr], &stats[stage_idx].max, sizeof(stats[stage_idx].max));
+        data_ptr += sizeof(stats[stage_idx].max);
+
+        memcpy(&data_buf[data_ptr], &stats[stage_idx].mean, sizeof(stats[stage_idx].mean));
+        data_ptr += sizeof(stats[stage_idx].mean);
+    }
+
+    return(data_size);
+}
+
+/*---------------------------------------------------------*\
+| ReportWriteResult                                         |
+|   Record the result of a hardware write and update the    |
+|   health state.  Called by device implementations, which  |
+|   pass a byte count on success or a negative error code.  |
+\*---------------------------------------------------------*/
+void RGBController::ReportWriteResult(int result)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    HealthMutex.lock();
+
+    device_health_state old_state = Health.state;
+
+    Health.last_result = result;
+    Health.writes++;
+
+    if(result < 0)
     {
-        for(unsigned int mode_idx = 0; mode_idx < modes.size(); mode_idx++)
+        Health.failures++;
+        Health.failures_in_row++;
+
+        if(Health.failures_in_row >= DEVICE_HEALTH_FAILURE_LIMIT)
         {
-            if((modes[mode_idx].name == custom_mode_names[custom_mode_idx])
-            && ((modes[mode_idx].color_mode == MODE_COLORS_PER_LED)
-             || (modes[mode_idx].color_mode == MODE_COLORS_MODE_SPECIFIC)))
+            Health.state = DEVICE_HEALTH_FAILED;
+        }
+        else if(Health.state != DEVICE_HEALTH_FAILED)
+        {
+            Health.state = DEVICE_HEALTH_DEGRADED;
+        }
+    }
+    else
+    {
+        Health.failures_in_row  = 0;
+        Health.bytes_written   += result;
+        HealthWindowBytes      += result;
+        Health.state            = DEVICE_HEALTH_OK;
+    }
+
+    UpdateHealthRate(now);
+
+    device_health       health    = Health;
+    device_health_state new_state = Health.state;
+
+    HealthMutex.unlock();
+
+    if(new_state != old_state)
+    {
+        if(new_state == DEVICE_HEALTH_FAILED)
+        {
+            LOG_WARNING("[%s] Device writes are failing, last error %d", name.c_str(), result);
+
+            /*---------------------------------------------*\
+            | Try to reopen the device on the next update   |
+            \*---------------------------------------------*/
+            if(flags & CONTROLLER_FLAG_REOPEN)
             {
-                active_mode = mode_idx;
-                return;
+                ReopenPending = true;
             }
         }
+
+        SignalHealthChanged(health);
     }
 }
 
-void RGBController::DeviceUpdateMode()
+/*---------------------------------------------------------*\
+| UpdateHealthRate                                          |
+|   Close the byte rate window once a second has passed.    |
+|   Must be called with HealthMutex held.                   |
+\*---------------------------------------------------------*/
+void RGBController::UpdateHealthRate(std::chrono::steady_clock::time_point now)
 {
+    long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - HealthWindowStart).count();
 
+    if(elapsed >= 1000000)
+    {
+        Health.bytes_per_sec    = (unsigned int)((HealthWindowBytes * 1000000ULL) / (unsigned long long)elapsed);
+        HealthWindowBytes       = 0;
+        HealthWindowStart       = now;
+    }
 }
 
-void RGBController::DeviceCallThreadFunction()
+device_health RGBController::GetHealth()
 {
-    CallFlag_UpdateLEDs = false;
-    CallFlag_UpdateMode = false;
+    device_health health;
 
-    while(DeviceThreadRunning.load() == true)
+    HealthMutex.lock();
+
+    UpdateHealthRate(std::chrono::steady_clock::now());
+
+    health = Health;
+
+    HealthMutex.unlock();
+
+    return(health);
+}
+
+unsigned int RGBController::GetHealthDescription(std::vector<unsigned char>& data_vec)
+{
+    return(device_health_to_description(GetHealth(), data_vec));
+}
+
+void RGBController::RegisterHealthCallback(RGBControllerHealthCallback new_callback, void * new_callback_arg)
+{
+    HealthCallbackMutex.lock();
+    HealthCallbacks.push_back(new_callback);
+    HealthCallbackArgs.push_back(new_callback_arg);
+    HealthCallbackMutex.unlock();
+}
+
+void RGBController::UnregisterHealthCallback(void * callback_arg)
+{
+    HealthCallbackMutex.lock();
+
+    for(unsigned int callback_idx = 0; callback_idx < HealthCallbackArgs.size(); callback_idx++)
     {
-        if(CallFlag_UpdateMode.load() == true)
+        if(HealthCallbackArgs[callback_idx] == callback_arg)
         {
-            if(flags & CONTROLLER_FLAG_RESET_BEFORE_UPDATE)
-            {
-                CallFlag_UpdateMode = false;
-                DeviceUpdateMode();
-            }
-            else
-            {
-                DeviceUpdateMode();
-                CallFlag_UpdateMode = false;
-            }
+            HealthCallbackArgs.erase(HealthCallbackArgs.begin() + callback_idx);
+            HealthCallbacks.erase(HealthCallbacks.begin() + callback_idx);
+
+            break;
         }
-        if(CallFlag_UpdateLEDs.load() == true)
+    }
+
+    HealthCallbackMutex.unlock();
+}
+
+void RGBController::SignalHealthChanged(device_health health)
+{
+    HealthCallbackMutex.lock();
+
+    /*-------------------------------------------------*\
+    | Health state has changed, call the callbacks      |
+    \*-------------------------------------------------*/
+    for(unsigned int callback_idx = 0; callback_idx < HealthCallbacks.size(); callback_idx++)
+    {
+        HealthCallbacks[callback_idx](HealthCallbackArgs[callback_idx], this, health);
+    }
+
+    HealthCallbackMutex.unlock();
+}
+
+void RGBController::SetColorCorrection(color_correction correction)
+{
+    float gains[3] = { correction.red_gain, correction.green_gain, correction.blue_gain };
+
+    /*-------------------------------------------------*\
+    | Ignore values that cannot produce a valid table   |
+    \*-------------------------------------------------*/
+    if(!std::isfinite(correction.gamma) || (correction.gamma <= 0.0f))
+    {
+        return;
+    }
+
+    for(unsigned int channel_idx = 0; channel_idx < 3; channel_idx++)
+    {
+        if(!std::isfinite(gains[channel_idx]) || (gains[channel_idx] < 0.0f))
         {
-            if(flags & CONTROLLER_FLAG_RESET_BEFORE_UPDATE)
-            {
-                CallFlag_UpdateLEDs = false;
-                DeviceUpdateLEDs();
-            }
-            else
-            {
-                DeviceUpdateLEDs();
-                CallFlag_UpdateLEDs = false;
-            }
+            return;
         }
-        else
+    }
+
+    ColorCorrectionMutex.lock();
+
+    ColorCorrection         = correction;
+    ColorCorrectionEnabled  = (correction.gamma      != 1.0f)
+                           || (correction.red_gain   != 1.0f)
+                           || (correction.green_gain != 1.0f)
+                           || (correction.blue_gain  != 1.0f)
+                           || (correction.brightness != 255);
+
+    /*-------------------------------------------------*\
+    | Build the lookup tables: gamma first, then the    |
+    | channel gain and brightness cap                   |
+    \*-------------------------------------------------*/
+    for(unsigned int channel_idx = 0; channel_idx < 3; channel_idx++)
+    {
+        for(unsigned int value = 0; value < 256; value++)
+        {
+            float corrected = std::pow(value / 255.0f, correction.gamma) * gains[channel_idx] * correction.brightness;
+
+            corrected = std::min(std::max(corrected + 0.5f, 0.0f), 255.0f);
+
+            ColorCorrectionLUT[(channel_idx * 256) + value] = ((unsigned int)corrected) << (8 * channel_idx);
+        }
+    }
+
+    ColorCorrectionMutex.unlock();
+}
+
+color_correction RGBController::GetColorCorrection()
+{
+    color_correction correction;
+
+    ColorCorrectionMutex.lock();
+    correction = ColorCorrection;
+    ColorCorrectionMutex.unlock();
+
+    return(correction);
+}
+
+/*---------------------------------------------------------*\
+| SetLEDPositions                                           |
+|   Positions must be given for every LED.  An empty list   |
+|   removes the positions.                                  |
+\*---------------------------------------------------------*/
+void RGBController::SetLEDPositions(std::vector<led_position> positions)
+{
+    if((positions.size() != 0) && (positions.size() != leds.size()))
+    {
+        return;
+    }
+
+    for(std::size_t led_idx = 0; led_idx < positions.size(); led_idx++)
+    {
+        if(!std::isfinite(positions[led_idx].x)
+        || !std::isfinite(positions[led_idx].y)
+        || !std::isfinite(positions[led_idx].z))
+        {
+            return;
+        }
+    }
+
+    led_positions = positions;
+
+    LEDPositionsGeneration++;
+}
+
+std::vector<led_position> RGBController::GetLEDPositions()
+{
+    return(led_positions);
+}
+
+unsigned int RGBController::GetLEDPositionsDescription(std::vector<unsigned char>& data_vec)
+{
+    unsigned int    data_ptr        = 0;
+    unsigned int    data_size       = 0;
+    unsigned int    num_positions   = (unsigned int)led_positions.size();
+
+    /*---------------------------------------------------------*\
+    | Calculate data size                                       |
+    \*---------------------------------------------------------*/
+    data_size += sizeof(data_size);
+    data_size += sizeof(num_positions);
+    data_size += num_positions * (3 * sizeof(float));
+
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
+
+    /*---------------------------------------------------------*\
+    | Copy in data size                                         |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
+    data_ptr += sizeof(data_size);
+
+    /*---------------------------------------------------------*\
+    | Copy in number of positions                               |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &num_positions, sizeof(num_positions));
+    data_ptr += sizeof(num_positions);
+
+    /*---------------------------------------------------------*\
+    | Copy in positions (x, y, z)                               |
+    \*---------------------------------------------------------*/
+    for(unsigned int led_idx = 0; led_idx < num_positions; led_idx++)
+    {
+        memcpy(&data_buf[data_ptr], &led_positions[led_idx].x, sizeof(float));
+        data_ptr += sizeof(float);
+
+        memcpy(&data_buf[data_ptr], &led_positions[led_idx].y, sizeof(float));
+        data_ptr += sizeof(float);
+
+        memcpy(&data_buf[data_ptr], &led_positions[led_idx].z, sizeof(float));
+        data_ptr += sizeof(float);
+    }
+
+    return(data_size);
+}
+
+void RGBController::SetLEDPositionsDescription(unsigned char* data_buf, unsigned int data_size)
+{
+    unsigned int data_ptr       = sizeof(unsigned int);
+    unsigned int num_positions  = 0;
+
+    /*---------------------------------------------------------*\
+    | Check that the buffer holds the number of positions and   |
+    | every position it claims to                               |
+    \*---------------------------------------------------------*/
+    if(data_size < (2 * sizeof(unsigned int)))
+    {
+        return;
+    }
+
+    memcpy(&num_positions, &data_buf[data_ptr], sizeof(num_positions));
+    data_ptr += sizeof(num_positions);
+
+    if((num_positions > ((data_size - data_ptr) / (3 * sizeof(float)))))
+    {
+        return;
+    }
+
+    std::vector<led_position> positions(num_positions);
+
+    for(unsigned int led_idx = 0; led_idx < num_positions; led_idx++)
+    {
+        memcpy(&positions[led_idx].x, &data_buf[data_ptr], sizeof(float));
+        data_ptr += sizeof(float);
+
+        memcpy(&positions[led_idx].y, &data_buf[data_ptr], sizeof(float));
+        data_ptr += sizeof(float);
+
+        memcpy(&positions[led_idx].z, &data_buf[data_ptr], sizeof(float));
+        data_ptr += sizeof(float);
+    }
+
+    SetLEDPositions(positions);
+}
+
+unsigned int RGBController::GetLEDPositionsGeneration()
+{
+    return(LEDPositionsGeneration.load());
+}
+
+std::vector<led_range> RGBController::GetDirtyRanges()
+{
+    if((flags & CONTROLLER_FLAG_DIRTY_TRACKING)
+    && (FrameReaderThread.load() == std::this_thread::get_id()))
+    {
+        return(FrameDirtyRanges);
+    }
+
+    std::vector<led_range>  ranges;
+    led_range               range;
+
+    range.start_idx     = 0;
+    range.leds_count    = (unsigned int)colors.size();
+
+    ranges.push_back(range);
+
+    return(ranges);
+}
+
+void RGBController::InvalidateFrame()
+{
+    FrameLastValid = false;
+}
+
+bool RGBController::UpdateDirtyRanges(const std::vector<RGBColor>& frame)
+{
+    FrameDirtyRanges.clear();
+
+    /*-------------------------------------------------*\
+    | Without a valid copy of the last frame sent, the  |
+    | whole frame is dirty.  The invalidation flag is   |
+    | consumed here so that an invalidation during the  |
+    | write that follows is kept for the next frame.    |
+    | FrameLast itself is only updated by               |
+    | CommitDirtyRanges() once the write has succeeded. |
+    \*-------------------------------------------------*/
+    if(!FrameLastValid.exchange(true) || (FrameLast.size() != frame.size()))
+    {
+        led_range range;
+
+        range.start_idx     = 0;
+        range.leds_count    = (unsigned int)frame.size();
+
+        FrameDirtyRanges.push_back(range);
+
+        return(true);
+    }
+
+    /*-------------------------------------------------*\
+    | Collect runs of LEDs that changed since the last  |
+    | frame sent                                        |
+    \*-------------------------------------------------*/
+    for(std::size_t led_idx = 0; led_idx < frame.size();)
+    {
+        if(frame[led_idx] == FrameLast[led_idx])
+        {
+            led_idx++;
+            continue;
+        }
+
+        led_range range;
+
+        range.start_idx = (unsigned int)led_idx;
+
+        while((led_idx < frame.size()) && (frame[led_idx] != FrameLast[led_idx]))
         {
-           std::this_thread::sleep_for(1ms);
+            led_idx++;
         }
+
+        range.leds_count = (unsigned int)led_idx - range.start_idx;
+
+        FrameDirtyRanges.push_back(range);
+    }
+
+    return(FrameDirtyRanges.size() > 0);
+}
+
+void RGBController::CommitDirtyRanges(const std::vector<RGBColor>& frame)
+{
+    if(FrameLast.size() != frame.size())
+    {
+        FrameLast.assign(frame.begin(), frame.end());
+        return;
+    }
+
+    for(std::size_t range_idx = 0; range_idx < FrameDirtyRanges.size(); range_idx++)
+    {
+        const led_range& range = FrameDirtyRanges[range_idx];
+
+        std::copy(frame.begin() + range.start_idx, frame.begin() + range.start_idx + range.leds_count, FrameLast.begin() + range.start_idx);
     }
 }
 
+unsigned int RGBController::GetDeviceCallLatency()
+{
+    return(DeviceCallLatency.load());
+}
+
+unsigned int RGBController::GetDeviceCallLatencyMax()
+{
+    return(DeviceCallLatencyMax.load());
+}
+
 void RGBController::DeviceSaveMode()
 {
     /*-------------------------------------------------*\
@@ -2165,6 +4207,60 @@ void RGBController::AddSegment(int zone, segment new_segment)
     zones[zone].segments.push_back(new_segment);
 }
 
+unsigned int device_health_to_description(device_health health, std::vector<unsigned char>& data_vec)
+{
+    unsigned int    data_ptr    = 0;
+    unsigned int    data_size   = 0;
+
+    /*---------------------------------------------------------*\
+    | Calculate data size                                       |
+    \*---------------------------------------------------------*/
+    data_size += sizeof(data_size);
+    data_size += sizeof(health.state);
+    data_size += sizeof(health.last_result);
+    data_size += sizeof(health.failures_in_row);
+    data_size += sizeof(health.writes);
+    data_size += sizeof(health.failures);
+    data_size += sizeof(health.bytes_written);
+    data_size += sizeof(health.bytes_per_sec);
+
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
+
+    /*---------------------------------------------------------*\
+    | Copy in data size                                         |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
+    data_ptr += sizeof(data_size);
+
+    /*---------------------------------------------------------*\
+    | Copy in health fields                                     |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &health.state, sizeof(health.state));
+    data_ptr += sizeof(health.state);
+
+    memcpy(&data_buf[data_ptr], &health.last_result, sizeof(health.last_result));
+    data_ptr += sizeof(health.last_result);
+
+    memcpy(&data_buf[data_ptr], &health.failures_in_row, sizeof(health.failures_in_row));
+    data_ptr += sizeof(health.failures_in_row);
+
+    memcpy(&data_buf[data_ptr], &health.writes, sizeof(health.writes));
+    data_ptr += sizeof(health.writes);
+
+    memcpy(&data_buf[data_ptr], &health.failures, sizeof(health.failures));
+    data_ptr += sizeof(health.failures);
+
+    memcpy(&data_buf[data_ptr], &health.bytes_written, sizeof(health.bytes_written));
+    data_ptr += sizeof(health.bytes_written);
+
+    memcpy(&data_buf[data_ptr], &health.bytes_per_sec, sizeof(health.bytes_per_sec));
+    data_ptr += sizeof(health.bytes_per_sec);
+
+    return(data_size);
+}
+
 std::string device_type_to_str(device_type type)
 {
     switch(type)
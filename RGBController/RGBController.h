@@ -18,6 +18,7 @@
 #include <thread>
 #include <chrono>
 #include <mutex>
+#include <condition_variable>
 
 /*------------------------------------------------------------------*\
 | RGB Color Type and Conversion Macros                               |
@@ -32,6 +33,24 @@ typedef unsigned int RGBColor;
 
 #define RGBToBGRColor(rgb) ((rgb & 0xFF) << 16 | (rgb & 0xFF00) | (rgb & 0xFF0000) >> 16)
 
+/*------------------------------------------------------------------*\
+| Encoded Color Run Types                                            |
+|   An encoded color description only carries the LEDs that changed  |
+|   since a reference frame, as runs of packed 3-byte RGB values.    |
+|   Unchanged gaps up to COLOR_RUN_MAX_GAP LEDs long are merged into |
+|   the surrounding run, and at least COLOR_RUN_MIN_FILL repeated    |
+|   colors are sent as a single fill run.                            |
+\*------------------------------------------------------------------*/
+enum
+{
+    COLOR_RUN_LITERAL           = 0,        /* One RGB value per LED in run     */
+    COLOR_RUN_FILL              = 1,        /* One RGB value for every LED      */
+};
+
+#define COLOR_RUN_MAX_LENGTH    0xFFFF
+#define COLOR_RUN_MAX_GAP       2
+#define COLOR_RUN_MIN_FILL      4
+
 /*------------------------------------------------------------------*\
 | Mode Flags                                                         |
 \*------------------------------------------------------------------*/
@@ -160,6 +179,129 @@ typedef struct
     unsigned int            leds_count;     /* Number of LEDs in segment*/
 } segment;
 
+/*------------------------------------------------------------------*\
+| LED Range Struct                                                   |
+\*------------------------------------------------------------------*/
+typedef struct
+{
+    unsigned int            start_idx;      /* First LED in the range   */
+    unsigned int            leds_count;     /* Number of LEDs in range  */
+} led_range;
+
+/*------------------------------------------------------------------*\
+| LED Position Struct                                                |
+|   Physical position of an LED.  The unit and origin are chosen by  |
+|   the user, but should be shared by every device in the system so  |
+|   that effects can span devices.                                   |
+\*------------------------------------------------------------------*/
+typedef struct
+{
+    float                   x;              /* X coordinate             */
+    float                   y;              /* Y coordinate             */
+    float                   z;              /* Z coordinate             */
+} led_position;
+
+/*------------------------------------------------------------------*\
+| Color Correction Struct                                            |
+\*------------------------------------------------------------------*/
+typedef struct
+{
+    float                   gamma;          /* Gamma exponent, 1 = off  */
+    float                   red_gain;       /* Red channel gain         */
+    float                   green_gain;     /* Green channel gain       */
+    float                   blue_gain;      /* Blue channel gain        */
+    unsigned char           brightness;     /* Brightness cap, 0-255    */
+} color_correction;
+
+/*------------------------------------------------------------------*\
+| Latency Stages                                                     |
+|   Each frame is timestamped when it is published, when the device  |
+|   update begins, and when DeviceUpdateLEDs() returns.              |
+\*------------------------------------------------------------------*/
+enum
+{
+    LATENCY_STAGE_QUEUE     = 0,    /* Published until update begins   */
+    LATENCY_STAGE_WRITE     = 1,    /* Duration of DeviceUpdateLEDs()   */
+    LATENCY_STAGE_TOTAL     = 2,    /* Published until write completes  */
+    LATENCY_STAGE_COUNT     = 3,    /* Number of latency stages         */
+};
+
+/*------------------------------------------------------------------*\
+| Latency Statistics Struct                                          |
+|   All times are in microseconds                                    |
+\*------------------------------------------------------------------*/
+typedef struct
+{
+    unsigned long long      count;          /* Number of samples        */
+    unsigned int            p50;            /* Median                   */
+    unsigned int            p99;            /* 99th percentile          */
+    unsigned int            max;            /* Largest sample           */
+    unsigned int            mean;           /* Average sample           */
+} latency_stats;
+
+/*------------------------------------------------------------------*\
+| Device Health States                                               |
+|   Devices start out unknown until their implementation reports the |
+|   result of a write.  A failed write makes the device degraded and |
+|   DEVICE_HEALTH_FAILURE_LIMIT consecutive failures make it failed. |
+|   Any successful write makes it healthy again, and a device that   |
+|   is reopened is unknown again until its next write.               |
+\*------------------------------------------------------------------*/
+typedef unsigned int device_health_state;
+
+enum
+{
+    DEVICE_HEALTH_UNKNOWN   = 0,    /* No writes reported yet          */
+    DEVICE_HEALTH_OK        = 1,    /* Last write succeeded            */
+    DEVICE_HEALTH_DEGRADED  = 2,    /* Last write failed               */
+    DEVICE_HEALTH_FAILED    = 3,    /* Writes keep failing             */
+};
+
+#define DEVICE_HEALTH_FAILURE_LIMIT 5
+
+/*------------------------------------------------------------------*\
+| Device Health Struct                                               |
+|   last_result is the byte count or negative error code of the last |
+|   write reported by the device implementation                      |
+\*------------------------------------------------------------------*/
+typedef struct
+{
+    device_health_state     state;          /* Health state             */
+    int                     last_result;    /* Last write result        */
+    unsigned int            failures_in_row;/* Consecutive failures     */
+    unsigned long long      writes;         /* Writes reported          */
+    unsigned long long      failures;       /* Failed writes reported   */
+    unsigned long long      bytes_written;  /* Bytes written            */
+    unsigned int            bytes_per_sec;  /* Recent write throughput  */
+} device_health;
+
+/*------------------------------------------------------------------*\
+| Latency Histogram Class                                            |
+|   Log-linear histogram of microsecond samples.  Values below 8 get |
+|   their own bucket and every power of two above that is split into |
+|   8 buckets, so percentiles are accurate to within 12.5%.          |
+\*------------------------------------------------------------------*/
+#define LATENCY_HISTOGRAM_BUCKETS   240
+
+class RGBControllerLatencyHistogram
+{
+public:
+    RGBControllerLatencyHistogram();
+
+    void                    Record(unsigned int value);
+    void                    Reset();
+    latency_stats           GetStats() const;
+
+private:
+    unsigned int            buckets[LATENCY_HISTOGRAM_BUCKETS];
+    unsigned long long      count;
+    unsigned long long      sum;
+    unsigned int            max;
+
+    static unsigned int     GetBucket(unsigned int value);
+    static unsigned int     GetBucketUpperBound(unsigned int bucket);
+};
+
 /*------------------------------------------------------------------*\
 | Zone Class                                                         |
 \*------------------------------------------------------------------*/
@@ -185,6 +327,51 @@ public:
     ~zone();
 };
 
+/*------------------------------------------------------------------*\
+| Controller Layout Class                                            |
+|   Flat copy of the zone and matrix geometry, rebuilt by            |
+|   SetupColors().  All indices and matrix maps share one arena so   |
+|   per-frame code can walk the layout without following the zone,   |
+|   LED, and matrix map pointers.  Matrix map entries are global     |
+|   LED indices, or LAYOUT_NO_LED where the matrix has no LED.       |
+\*------------------------------------------------------------------*/
+#define LAYOUT_NO_LED   0xFFFFFFFF
+
+class RGBControllerLayout
+{
+public:
+    RGBControllerLayout();
+
+    void                    Build(const std::vector<zone>& zones, const std::vector<unsigned int>& zone_led_counts);
+
+    unsigned int            GetZoneCount() const;
+    unsigned int            GetLEDCount() const;
+
+    unsigned int            GetZoneStart(unsigned int zone_idx) const;
+    unsigned int            GetZoneLEDCount(unsigned int zone_idx) const;
+    zone_type               GetZoneType(unsigned int zone_idx) const;
+    unsigned int            GetLEDZone(unsigned int led_idx) const;
+
+    unsigned int            GetMatrixHeight(unsigned int zone_idx) const;
+    unsigned int            GetMatrixWidth(unsigned int zone_idx) const;
+    const unsigned int *    GetMatrixMap(unsigned int zone_idx) const;
+
+private:
+    /*--------------------------------------------------------------*\
+    | Arena layout, for Z zones and L LEDs:                          |
+    |   zone starts     [0, Z]          (Z + 1 entries, last = L)    |
+    |   zone types      [Z + 1, 2Z + 1)                              |
+    |   matrix offsets  [2Z + 1, 3Z + 1) (0 = no matrix)             |
+    |   matrix heights  [3Z + 1, 4Z + 1)                             |
+    |   matrix widths   [4Z + 1, 5Z + 1)                             |
+    |   LED zones       [5Z + 1, 5Z + 1 + L)                         |
+    |   matrix maps     remainder                                    |
+    \*--------------------------------------------------------------*/
+    std::vector<unsigned int>   arena;
+    unsigned int                zone_count;
+    unsigned int                led_count;
+};
+
 /*------------------------------------------------------------------*\
 | Device Types                                                       |
 |   The enum order should be maintained as is for the API however    |
@@ -230,14 +417,40 @@ enum
 
     CONTROLLER_FLAG_RESET_BEFORE_UPDATE = (1 << 8), /* Device resets update flag before */
                                                     /* calling update function          */
+    CONTROLLER_FLAG_PRIVATE_THREAD      = (1 << 9), /* Device updates run on a private  */
+                                                    /* thread instead of the shared     */
+                                                    /* worker pool                      */
+    CONTROLLER_FLAG_DIRTY_TRACKING      = (1 << 10),/* Device tracks changed LEDs and   */
+                                                    /* skips unchanged frames           */
+    CONTROLLER_FLAG_REOPEN              = (1 << 11),/* Device implements DeviceReopen() */
+                                                    /* to recover from failed writes    */
+    CONTROLLER_FLAG_PARTIAL_UPDATES     = (1 << 12),/* Device update thread may call    */
+                                                    /* UpdateZoneLEDs() and             */
+                                                    /* UpdateSingleLED() for updates    */
+                                                    /* covering one zone or LED         */
 };
 
+/*------------------------------------------------------------------*\
+| Controller flags that describe how this instance drives the        |
+| device.  They are not sent to SDK clients, whose network           |
+| controllers are driven differently.                                |
+\*------------------------------------------------------------------*/
+#define CONTROLLER_FLAGS_IMPLEMENTATION (CONTROLLER_FLAG_PRIVATE_THREAD  \
+                                       | CONTROLLER_FLAG_DIRTY_TRACKING  \
+                                       | CONTROLLER_FLAG_REOPEN          \
+                                       | CONTROLLER_FLAG_PARTIAL_UPDATES)
+
 /*------------------------------------------------------------------*\
 | RGBController Callback Types                                       |
 \*------------------------------------------------------------------*/
 typedef void (*RGBControllerCallback)(void *);
 
+class RGBController;
+
+typedef void (*RGBControllerHealthCallback)(void *, RGBController *, device_health);
+
 std::string device_type_to_str(device_type type);
+unsigned int device_health_to_description(device_health health, std::vector<unsigned char>& data_vec);
 
 class RGBControllerInterface
 {
@@ -311,6 +524,66 @@ public:
     virtual void            DeviceSaveMode()                                                                    = 0;
 
     virtual void            SetCustomMode()                                                                     = 0;
+
+    /*---------------------------------------------------------*\
+    | Functions added in plugin API version 5.  New functions   |
+    | are appended here so that the entries above keep the      |
+    | order and signatures plugins were built against.          |
+    \*---------------------------------------------------------*/
+    virtual const RGBControllerLayout& GetLayout()                                                              = 0;
+    virtual unsigned int    GetDeviceDescription(std::vector<unsigned char>& data_vec, unsigned int protocol_version) = 0;
+    virtual unsigned int    GetModeDescription(std::vector<unsigned char>& data_vec, int mode, unsigned int protocol_version) = 0;
+
+    virtual unsigned char * GetColorDescription(unsigned int protocol_version)                                  = 0;
+    virtual unsigned int    GetColorDescription(std::vector<unsigned char>& data_vec, unsigned int protocol_version) = 0;
+    virtual void            SetColorDescription(unsigned char* data_buf, unsigned int protocol_version)         = 0;
+
+    virtual unsigned char * GetZoneColorDescription(int zone, unsigned int protocol_version)                    = 0;
+    virtual unsigned int    GetZoneColorDescription(std::vector<unsigned char>& data_vec, int zone, unsigned int protocol_version) = 0;
+    virtual void            SetZoneColorDescription(unsigned char* data_buf, unsigned int protocol_version)     = 0;
+
+    virtual unsigned int    GetSingleLEDColorDescription(std::vector<unsigned char>& data_vec, int led)         = 0;
+
+    virtual unsigned int    GetEncodedColorDescription(std::vector<unsigned char>& data_vec, std::vector<RGBColor>& reference) = 0;
+    virtual bool            SetEncodedColorDescription(unsigned char* data_buf, unsigned int data_size)         = 0;
+
+    virtual void            UpdateLEDsAt(std::chrono::steady_clock::time_point release_time)                    = 0;
+    virtual void            PublishFrame()                                                                      = 0;
+    virtual void            QueueZoneLEDs(int zone)                                                             = 0;
+    virtual void            QueueSingleLED(int led)                                                             = 0;
+    virtual void            SetLEDRange(unsigned int start_idx, const RGBColor* range_colors, unsigned int count) = 0;
+
+    virtual void            InvalidateMode()                                                                    = 0;
+    virtual void            RequestReopen()                                                                     = 0;
+
+    virtual unsigned int    GetDeviceCallLatency()                                                              = 0;
+    virtual unsigned int    GetDeviceCallLatencyMax()                                                           = 0;
+
+    virtual void            SetFrameRateLimit(unsigned int fps)                                                 = 0;
+    virtual unsigned int    GetFrameRateLimit()                                                                 = 0;
+    virtual unsigned long long GetFramesRequested()                                                             = 0;
+    virtual unsigned long long GetFramesTransmitted()                                                           = 0;
+    virtual unsigned long long GetFramesDropped()                                                               = 0;
+
+    virtual std::vector<latency_stats> GetLatencyStats()                                                        = 0;
+    virtual void            ResetLatencyStats()                                                                 = 0;
+    virtual unsigned int    GetLatencyStatsDescription(std::vector<unsigned char>& data_vec)                    = 0;
+
+    virtual device_health   GetHealth()                                                                         = 0;
+    virtual unsigned int    GetHealthDescription(std::vector<unsigned char>& data_vec)                          = 0;
+    virtual void            RegisterHealthCallback(RGBControllerHealthCallback new_callback, void * new_callback_arg) = 0;
+    virtual void            UnregisterHealthCallback(void * callback_arg)                                       = 0;
+
+    virtual void            SetColorCorrection(color_correction correction)                                     = 0;
+    virtual color_correction GetColorCorrection()                                                               = 0;
+
+    virtual void            SetLEDPositions(std::vector<led_position> positions)                                = 0;
+    virtual std::vector<led_position> GetLEDPositions()                                                         = 0;
+    virtual unsigned int    GetLEDPositionsDescription(std::vector<unsigned char>& data_vec)                    = 0;
+    virtual void            SetLEDPositionsDescription(unsigned char* data_buf, unsigned int data_size)         = 0;
+    virtual unsigned int    GetLEDPositionsGeneration()                                                         = 0;
+
+    virtual bool            DeviceReopen()                                                                      = 0;
 };
 
 class RGBController : public RGBControllerInterface
@@ -331,6 +604,8 @@ public:
     std::vector<std::string>
                             led_alt_names;  /* alternate LED names      */
     unsigned int            flags;          /* controller flags         */
+    std::vector<led_position>
+                            led_positions;  /* LED positions (optional) */
 
     /*---------------------------------------------------------*\
     | RGBController base class constructor                      |
@@ -414,16 +689,268 @@ public:
 
     void                    SetCustomMode();
 
+    /*---------------------------------------------------------*\
+    | Functions added in plugin API version 5                   |
+    \*---------------------------------------------------------*/
+    const RGBControllerLayout& GetLayout();
+    unsigned int            GetDeviceDescription(std::vector<unsigned char>& data_vec, unsigned int protocol_version);
+    unsigned int            GetModeDescription(std::vector<unsigned char>& data_vec, int mode, unsigned int protocol_version);
+
+    unsigned char *         GetColorDescription(unsigned int protocol_version);
+    unsigned int            GetColorDescription(std::vector<unsigned char>& data_vec, unsigned int protocol_version);
+    void                    SetColorDescription(unsigned char* data_buf, unsigned int protocol_version);
+
+    unsigned char *         GetZoneColorDescription(int zone, unsigned int protocol_version);
+    unsigned int            GetZoneColorDescription(std::vector<unsigned char>& data_vec, int zone, unsigned int protocol_version);
+    void                    SetZoneColorDescription(unsigned char* data_buf, unsigned int protocol_version);
+
+    unsigned int            GetSingleLEDColorDescription(std::vector<unsigned char>& data_vec, int led);
+
+    unsigned int            GetEncodedColorDescription(std::vector<unsigned char>& data_vec, std::vector<RGBColor>& reference);
+    bool                    SetEncodedColorDescription(unsigned char* data_buf, unsigned int data_size);
+
+    unsigned int            GetSegmentDescription(std::vector<unsigned char>& data_vec, int zone, segment new_segment);
+
+    void                    UpdateLEDsAt(std::chrono::steady_clock::time_point release_time);
+    void                    PublishFrame();
+    void                    QueueZoneLEDs(int zone);
+    void                    QueueSingleLED(int led);
+    void                    SetLEDRange(unsigned int start_idx, const RGBColor* range_colors, unsigned int count);
+
+    void                    InvalidateMode();
+    void                    RequestReopen();
+
+    unsigned int            GetDeviceCallLatency();
+    unsigned int            GetDeviceCallLatencyMax();
+
+    void                    SetFrameRateLimit(unsigned int fps);
+    unsigned int            GetFrameRateLimit();
+    unsigned long long      GetFramesRequested();
+    unsigned long long      GetFramesTransmitted();
+    unsigned long long      GetFramesDropped();
+
+    std::vector<latency_stats> GetLatencyStats();
+    void                    ResetLatencyStats();
+    unsigned int            GetLatencyStatsDescription(std::vector<unsigned char>& data_vec);
+
+    device_health           GetHealth();
+    unsigned int            GetHealthDescription(std::vector<unsigned char>& data_vec);
+    void                    RegisterHealthCallback(RGBControllerHealthCallback new_callback, void * new_callback_arg);
+    void                    UnregisterHealthCallback(void * callback_arg);
+
+    void                    SetColorCorrection(color_correction correction);
+    color_correction        GetColorCorrection();
+
+    void                    SetLEDPositions(std::vector<led_position> positions);
+    std::vector<led_position> GetLEDPositions();
+    unsigned int            GetLEDPositionsDescription(std::vector<unsigned char>& data_vec);
+    void                    SetLEDPositionsDescription(unsigned char* data_buf, unsigned int data_size);
+    unsigned int            GetLEDPositionsGeneration();
+
+    bool                    DeviceReopen();
+
+protected:
+    /*---------------------------------------------------------*\
+    | Frame access for device implementations.  Inside          |
+    | DeviceUpdateLEDs() on the device update thread this is    |
+    | the most recently published frame, which writers cannot   |
+    | modify while it is being transmitted.  Anywhere else it   |
+    | is the live colors vector, or a copy of it when color     |
+    | correction is enabled.  Either way the colors have color  |
+    | correction applied, so device implementations should      |
+    | read this instead of colors in every update function.     |
+    \*---------------------------------------------------------*/
+    const std::vector<RGBColor>&    GetFrame();
+
+    /*---------------------------------------------------------*\
+    | Dirty range access for device implementations that set    |
+    | CONTROLLER_FLAG_DIRTY_TRACKING.  Inside DeviceUpdateLEDs()|
+    | on the device update thread this lists the ranges of the  |
+    | frame that differ from the last frame sent.  Anywhere     |
+    | else, or without the flag, it covers every LED.           |
+    | InvalidateFrame() forces the next frame to be sent in     |
+    | full and must be called after writing LEDs outside of     |
+    | DeviceUpdateLEDs(), such as in UpdateSingleLED().         |
+    \*---------------------------------------------------------*/
+    std::vector<led_range>          GetDirtyRanges();
+    void                            InvalidateFrame();
+
+    /*---------------------------------------------------------*\
+    | Write result reporting for device implementations.  Call  |
+    | ReportWriteResult() after each hardware write with the    |
+    | number of bytes written or a negative error code, such as |
+    | the return value of hid_write().  Health callbacks are    |
+    | called with the controller and its new health whenever    |
+    | the health state changes.                                 |
+    \*---------------------------------------------------------*/
+    void                            ReportWriteResult(int result);
+    void                            SignalHealthChanged(device_health health);
+
 private:
+    friend class RGBControllerWorker;
+    friend class RGBControllerWorkerPool;
+
     std::thread*            DeviceCallThread;
     std::atomic<bool>       CallFlag_UpdateLEDs;
     std::atomic<bool>       CallFlag_UpdateMode;
     std::atomic<bool>       DeviceThreadRunning;
-    //bool                    CallFlag_UpdateZoneLEDs                     = false;
-    //bool                    CallFlag_UpdateSingleLED                    = false;
-    //bool                    CallFlag_UpdateMode                         = false;
 
     std::mutex                          UpdateMutex;
     std::vector<RGBControllerCallback>  UpdateCallbacks;
     std::vector<void *>                 UpdateCallbackArgs;
+
+    /*---------------------------------------------------------*\
+    | Scope of the LED updates requested since the last frame   |
+    | was sent.  Each is UPDATE_SCOPE_NONE, the one zone or LED |
+    | that all requests fell within, or UPDATE_SCOPE_ALL.       |
+    \*---------------------------------------------------------*/
+    std::mutex                              UpdateScopeMutex;
+    int                                     UpdateScopeZone;
+    int                                     UpdateScopeLED;
+
+    void                    MergeUpdateScope(int zone, int led);
+    void                    DeviceUpdateScope();
+
+    /*---------------------------------------------------------*\
+    | Device call scheduling.  Updates normally run on a worker |
+    | from the shared RGBControllerWorkerPool.  Controllers     |
+    | with CONTROLLER_FLAG_PRIVATE_THREAD instead get their own |
+    | thread, which sleeps on the condition variable until      |
+    | UpdateLEDs() or UpdateMode() signals it.                  |
+    \*---------------------------------------------------------*/
+    std::mutex                              DeviceCallMutex;
+    std::condition_variable                 DeviceCallCV;
+    int                                     DeviceCallWorker;
+    bool                                    DeviceCallQueued;
+    bool                                    DeviceCallDeferred;
+    bool                                    DeviceCallPending;
+    std::chrono::steady_clock::time_point   DeviceCallRequestTime;
+    std::atomic<unsigned int>               DeviceCallLatency;
+    std::atomic<unsigned int>               DeviceCallLatencyMax;
+
+    void                    SignalDeviceCall();
+    bool                    ProcessDeviceCalls(std::chrono::steady_clock::time_point& next_call_time);
+
+    /*---------------------------------------------------------*\
+    | State of the last mode sent to the device.  UpdateMode()  |
+    | skips the device call when the active mode and its        |
+    | settings still match, until InvalidateMode() is called.   |
+    \*---------------------------------------------------------*/
+    std::mutex                              ModeCacheMutex;
+    bool                                    ModeCacheValid;
+    int                                     ModeCacheActive;
+    mode                                    ModeCacheState;
+
+    bool                    UpdateModeCache();
+
+    /*---------------------------------------------------------*\
+    | Triple-buffered color frames.  PublishFrame() copies the  |
+    | colors vector into the write buffer and atomically swaps  |
+    | it with the published slot.  The device update thread     |
+    | swaps the published slot with its read buffer before      |
+    | calling DeviceUpdateLEDs(), so neither side ever waits on |
+    | the other and a frame is never modified while it is sent. |
+    \*---------------------------------------------------------*/
+    std::vector<RGBColor>                   FrameBuffers[3];
+    std::chrono::steady_clock::time_point   FrameTimes[3];
+    std::mutex                              FrameWriteMutex;
+    unsigned int                            FrameWriteIdx;
+    unsigned int                            FrameReadIdx;
+    std::atomic<unsigned int>               FramePublished;
+    std::atomic<std::thread::id>            FrameReaderThread;
+
+    /*---------------------------------------------------------*\
+    | Frame rate limit (0 = unlimited) and frame statistics     |
+    \*---------------------------------------------------------*/
+    std::atomic<unsigned int>               FrameRateLimit;
+    std::chrono::steady_clock::time_point   FrameNextTime;
+
+    /*---------------------------------------------------------*\
+    | Earliest time the latest frame may be sent, as steady     |
+    | clock ticks (0 = immediately).  Set by UpdateLEDsAt() so  |
+    | that grouped frames are released together.                |
+    \*---------------------------------------------------------*/
+    std::atomic<long long>                  FrameReleaseTime;
+    std::atomic<unsigned long long>         FramesRequested;
+    std::atomic<unsigned long long>         FramesTransmitted;
+    std::atomic<unsigned long long>         FramesDropped;
+
+    /*---------------------------------------------------------*\
+    | Hash of the last frame published, so that repeated frames |
+    | do not count as activity for the idle monitor             |
+    \*---------------------------------------------------------*/
+    unsigned long long                      FrameHash;
+
+    bool                    AcquireFrame();
+
+    /*---------------------------------------------------------*\
+    | Frame latency histograms, one per LATENCY_STAGE_*.  Each  |
+    | frame buffer carries the time it was published, so the    |
+    | latency is measured for the frame that is actually sent.  |
+    \*---------------------------------------------------------*/
+    std::mutex                              LatencyMutex;
+    RGBControllerLatencyHistogram           LatencyHistograms[LATENCY_STAGE_COUNT];
+
+    /*---------------------------------------------------------*\
+    | Dirty tracking state, only touched by the update thread   |
+    | apart from the invalidation flag.  FrameLast is updated   |
+    | from the dirty ranges only after a frame is written       |
+    | without a failure being reported.                         |
+    \*---------------------------------------------------------*/
+    std::vector<RGBColor>                   FrameLast;
+    std::vector<led_range>                  FrameDirtyRanges;
+    std::atomic<bool>                       FrameLastValid;
+
+    bool                    UpdateDirtyRanges(const std::vector<RGBColor>& frame);
+    void                    CommitDirtyRanges(const std::vector<RGBColor>& frame);
+
+    /*---------------------------------------------------------*\
+    | Color correction lookup tables, applied to each frame as  |
+    | it is acquired by the update thread.  Each of the three   |
+    | 256 entry tables (red, green, blue) holds the corrected   |
+    | value already shifted into its RGBColor position.         |
+    | FrameDirect holds the corrected colors returned by        |
+    | GetFrame() outside of the update thread.                  |
+    \*---------------------------------------------------------*/
+    std::mutex                              ColorCorrectionMutex;
+    color_correction                        ColorCorrection;
+    bool                                    ColorCorrectionEnabled;
+    unsigned int                            ColorCorrectionLUT[3 * 256];
+    std::vector<RGBColor>                   FrameDirect;
+
+    /*---------------------------------------------------------*\
+    | Incremented whenever the LED positions are replaced, so   |
+    | that cached copies of them can tell they are out of date  |
+    \*---------------------------------------------------------*/
+    std::atomic<unsigned int>               LEDPositionsGeneration;
+
+    RGBControllerLayout                 Layout;
+
+    /*---------------------------------------------------------*\
+    | Device health, updated by ReportWriteResult().  The byte  |
+    | rate is measured over windows of about one second.        |
+    \*---------------------------------------------------------*/
+    std::mutex                              HealthMutex;
+    device_health                           Health;
+    std::chrono::steady_clock::time_point   HealthWindowStart;
+    unsigned long long                      HealthWindowBytes;
+
+    void                    UpdateHealthRate(std::chrono::steady_clock::time_point now);
+
+    /*---------------------------------------------------------*\
+    | Device reopen state for CONTROLLER_FLAG_REOPEN devices.   |
+    | A reopen is requested when the device fails or by         |
+    | RequestReopen() and is attempted by the update thread,    |
+    | backing off between failed attempts.  The next attempt    |
+    | time is in steady clock ticks (0 = immediately).          |
+    \*---------------------------------------------------------*/
+    std::atomic<bool>                       ReopenPending;
+    std::atomic<long long>                  ReopenNextTime;
+    unsigned int                            ReopenBackoff;
+
+    bool                    ReopenDevice(std::chrono::steady_clock::time_point call_time);
+
+    std::mutex                          HealthCallbackMutex;
+    std::vector<RGBControllerHealthCallback> HealthCallbacks;
+    std::vector<void *>                 HealthCallbackArgs;
 };
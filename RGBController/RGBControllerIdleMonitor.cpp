@@ -0,0 +1,335 @@
+/*---------------------------------------------------------*\
+| RGBControllerIdleMonitor.cpp                              |
+|                                                           |
+|   Tracks whether device output is static so that device,  |
+|   keepalive, and SDK threads can wake up less often       |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstring>
+#include "RGBControllerIdleMonitor.h"
+#include "LogManager.h"
+
+/*---------------------------------------------------------*\
+| Time output must be static before it is idle, longest     |
+| single idle keepalive sleep, and wakeup rate window       |
+\*---------------------------------------------------------*/
+#define IDLE_DEFAULT_TIMEOUT_MS     10000
+#define IDLE_MAX_SLEEP_MS           60000
+#define IDLE_STATS_WINDOW_MS        10000
+
+RGBControllerIdleMonitor* RGBControllerIdleMonitor::get()
+{
+    /*-----------------------------------------------------*\
+    | Device, keepalive, and SDK threads may all call this  |
+    | first, so create the monitor as a function-local      |
+    | static, whose initialization is thread safe           |
+    \*-----------------------------------------------------*/
+    static RGBControllerIdleMonitor* instance = new RGBControllerIdleMonitor();
+
+    return(instance);
+}
+
+RGBControllerIdleMonitor::RGBControllerIdleMonitor()
+{
+    IdleTimeout         = IDLE_DEFAULT_TIMEOUT_MS;
+    LastActivityTime    = (long long)std::chrono::steady_clock::now().time_since_epoch().count();
+    Idle                = false;
+
+    StatsWindowStart    = std::chrono::steady_clock::now();
+
+    for(unsigned int source_idx = 0; source_idx < IDLE_WAKEUP_SOURCE_COUNT; source_idx++)
+    {
+        Wakeups[source_idx]             = 0;
+        StatsWindowWakeups[source_idx]  = 0;
+        StatsRates[source_idx]          = 0.0f;
+    }
+}
+
+RGBControllerIdleMonitor::~RGBControllerIdleMonitor()
+{
+
+}
+
+/*---------------------------------------------------------*\
+| NotifyActivity                                            |
+|   Called when the output changes.  Leaving the idle state |
+|   wakes any keepalive threads sleeping until their        |
+|   keepalive is due so that they resume polling.           |
+\*---------------------------------------------------------*/
+void RGBControllerIdleMonitor::NotifyActivity()
+{
+    LastActivityTime = (long long)std::chrono::steady_clock::now().time_since_epoch().count();
+
+    if(Idle.exchange(false))
+    {
+        LOG_DEBUG("[RGBControllerIdleMonitor] Output active");
+
+        WaitMutex.lock();
+        WaitMutex.unlock();
+
+        WaitCV.notify_all();
+    }
+}
+
+bool RGBControllerIdleMonitor::IsIdle()
+{
+    unsigned int timeout = IdleTimeout.load();
+
+    if(timeout == 0)
+    {
+        return(false);
+    }
+
+    std::chrono::steady_clock::time_point last_activity = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(LastActivityTime.load()));
+
+    if((std::chrono::steady_clock::now() - last_activity) < std::chrono::milliseconds(timeout))
+    {
+        return(false);
+    }
+
+    if(!Idle.exchange(true))
+    {
+        LOG_DEBUG("[RGBControllerIdleMonitor] Output idle");
+    }
+
+    return(true);
+}
+
+/*---------------------------------------------------------*\
+| SetIdleTimeout                                            |
+|   Set how long output must be static before it is idle.   |
+|   A timeout of 0 disables the idle state.                 |
+\*---------------------------------------------------------*/
+void RGBControllerIdleMonitor::SetIdleTimeout(unsigned int timeout_ms)
+{
+    IdleTimeout = timeout_ms;
+
+    if(timeout_ms == 0)
+    {
+        NotifyActivity();
+    }
+}
+
+unsigned int RGBControllerIdleMonitor::GetIdleTimeout()
+{
+    return(IdleTimeout.load());
+}
+
+void RGBControllerIdleMonitor::RecordWakeup(unsigned int source)
+{
+    if(source < IDLE_WAKEUP_SOURCE_COUNT)
+    {
+        Wakeups[source]++;
+    }
+}
+
+/*---------------------------------------------------------*\
+| WaitKeepalive                                             |
+|   Sleep a keepalive thread for one poll interval.  While  |
+|   output is idle, sleep until due_time instead, as no     |
+|   frames will be sent before then.  Returns early when    |
+|   running is cleared and Wake() is called, or when output |
+|   leaves the idle state.                                  |
+\*---------------------------------------------------------*/
+void RGBControllerIdleMonitor::WaitKeepalive(std::chrono::steady_clock::duration poll_interval, std::chrono::steady_clock::time_point due_time, const std::atomic<bool>& running)
+{
+    std::chrono::steady_clock::time_point now       = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point wake_time = now + poll_interval;
+
+    std::unique_lock<std::mutex> lock(WaitMutex);
+
+    if(IsIdle() && (due_time > wake_time))
+    {
+        wake_time = std::min(due_time, now + std::chrono::milliseconds(IDLE_MAX_SLEEP_MS));
+
+        WaitCV.wait_until(lock, wake_time, [this, &running]
+        {
+            return(!running.load() || !Idle.load());
+        });
+    }
+    else
+    {
+        WaitCV.wait_until(lock, wake_time, [&running]
+        {
+            return(!running.load());
+        });
+    }
+
+    RecordWakeup(IDLE_WAKEUP_KEEPALIVE);
+}
+
+/*---------------------------------------------------------*\
+| Wake                                                      |
+|   Wake all keepalive threads, such as after clearing a    |
+|   keepalive thread's running flag to stop it              |
+\*---------------------------------------------------------*/
+void RGBControllerIdleMonitor::Wake()
+{
+    WaitMutex.lock();
+    WaitMutex.unlock();
+
+    WaitCV.notify_all();
+}
+
+idle_stats RGBControllerIdleMonitor::GetStats()
+{
+    idle_stats                              stats;
+    std::chrono::steady_clock::time_point   now             = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point   last_activity   = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(LastActivityTime.load()));
+
+    stats.idle              = IsIdle() ? 1 : 0;
+    stats.idle_timeout_ms   = IdleTimeout.load();
+    stats.static_time_ms    = (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(now - last_activity).count();
+
+    /*-----------------------------------------------------*\
+    | Update the wakeup rates once at least a second of the |
+    | current window has passed, and start a new window     |
+    | once it is complete                                   |
+    \*-----------------------------------------------------*/
+    std::lock_guard<std::mutex> lock(StatsMutex);
+
+    long long window_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - StatsWindowStart).count();
+
+    for(unsigned int source_idx = 0; source_idx < IDLE_WAKEUP_SOURCE_COUNT; source_idx++)
+    {
+        unsigned long long wakeups = Wakeups[source_idx].load();
+
+        if(window_ms >= 1000)
+        {
+            StatsRates[source_idx] = (float)(wakeups - StatsWindowWakeups[source_idx]) * 1000.0f / (float)window_ms;
+        }
+
+        if(window_ms >= IDLE_STATS_WINDOW_MS)
+        {
+            StatsWindowWakeups[source_idx] = wakeups;
+        }
+
+        stats.wakeups[source_idx]           = wakeups;
+        stats.wakeups_per_sec[source_idx]   = StatsRates[source_idx];
+    }
+
+    if(window_ms >= IDLE_STATS_WINDOW_MS)
+    {
+        StatsWindowStart = now;
+    }
+
+    return(stats);
+}
+
+unsigned int RGBControllerIdleMonitor::GetStatsDescription(std::vector<unsigned char>& data_vec)
+{
+    idle_stats stats = GetStats();
+
+    unsigned int    data_ptr        = 0;
+    unsigned int    data_size       = 0;
+    unsigned int    num_sources     = IDLE_WAKEUP_SOURCE_COUNT;
+
+    /*---------------------------------------------------------*\
+    | Calculate data size                                       |
+    \*---------------------------------------------------------*/
+    data_size += sizeof(data_size);
+    data_size += sizeof(stats.idle);
+    data_size += sizeof(stats.idle_timeout_ms);
+    data_size += sizeof(stats.static_time_ms);
+    data_size += sizeof(num_sources);
+    data_size += num_sources * (sizeof(stats.wakeups[0]) + sizeof(stats.wakeups_per_sec[0]));
+
+    data_vec.resize(data_size);
+
+    unsigned char *data_buf = data_vec.data();
+
+    /*---------------------------------------------------------*\
+    | Copy in data size                                         |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &data_size, sizeof(data_size));
+    data_ptr += sizeof(data_size);
+
+    /*---------------------------------------------------------*\
+    | Copy in idle state fields                                 |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &stats.idle, sizeof(stats.idle));
+    data_ptr += sizeof(stats.idle);
+
+    memcpy(&data_buf[data_ptr], &stats.idle_timeout_ms, sizeof(stats.idle_timeout_ms));
+    data_ptr += sizeof(stats.idle_timeout_ms);
+
+    memcpy(&data_buf[data_ptr], &stats.static_time_ms, sizeof(stats.static_time_ms));
+    data_ptr += sizeof(stats.static_time_ms);
+
+    /*---------------------------------------------------------*\
+    | Copy in wakeup count and rate of each source              |
+    \*---------------------------------------------------------*/
+    memcpy(&data_buf[data_ptr], &num_sources, sizeof(num_sources));
+    data_ptr += sizeof(num_sources);
+
+    for(unsigned int source_idx = 0; source_idx < num_sources; source_idx++)
+    {
+        memcpy(&data_buf[data_ptr], &stats.wakeups[source_idx], sizeof(stats.wakeups[source_idx]));
+        data_ptr += sizeof(stats.wakeups[source_idx]);
+
+        memcpy(&data_buf[data_ptr], &stats.wakeups_per_sec[source_idx], sizeof(stats.wakeups_per_sec[source_idx]));
+        data_ptr += sizeof(stats.wakeups_per_sec[source_idx]);
+    }
+
+    return(data_size);
+}
+
+/*---------------------------------------------------------*\
+| ReadStatsDescription                                      |
+|   Parse idle statistics sent by GetStatsDescription().    |
+|   Sources this build does not know about are ignored and  |
+|   missing ones are left at zero.                          |
+\*---------------------------------------------------------*/
+bool RGBControllerIdleMonitor::ReadStatsDescription(unsigned char* data_buf, unsigned int data_size, idle_stats& stats)
+{
+    unsigned int data_ptr       = sizeof(unsigned int);
+    unsigned int num_sources    = 0;
+
+    memset(&stats, 0, sizeof(stats));
+
+    if(data_size < (data_ptr + sizeof(stats.idle) + sizeof(stats.idle_timeout_ms) + sizeof(stats.static_time_ms) + sizeof(num_sources)))
+    {
+        return(false);
+    }
+
+    memcpy(&stats.idle, &data_buf[data_ptr], sizeof(stats.idle));
+    data_ptr += sizeof(stats.idle);
+
+    memcpy(&stats.idle_timeout_ms, &data_buf[data_ptr], sizeof(stats.idle_timeout_ms));
+    data_ptr += sizeof(stats.idle_timeout_ms);
+
+    memcpy(&stats.static_time_ms, &data_buf[data_ptr], sizeof(stats.static_time_ms));
+    data_ptr += sizeof(stats.static_time_ms);
+
+    memcpy(&num_sources, &data_buf[data_ptr], sizeof(num_sources));
+    data_ptr += sizeof(num_sources);
+
+    for(unsigned int source_idx = 0; source_idx < num_sources; source_idx++)
+    {
+        unsigned long long  wakeups;
+        float               wakeups_per_sec;
+
+        if(data_size < (data_ptr + sizeof(wakeups) + sizeof(wakeups_per_sec)))
+        {
+            return(false);
+        }
+
+        memcpy(&wakeups, &data_buf[data_ptr], sizeof(wakeups));
+        data_ptr += sizeof(wakeups);
+
+        memcpy(&wakeups_per_sec, &data_buf[data_ptr], sizeof(wakeups_per_sec));
+        data_ptr += sizeof(wakeups_per_sec);
+
+        if(source_idx < IDLE_WAKEUP_SOURCE_COUNT)
+        {
+            stats.wakeups[source_idx]           = wakeups;
+            stats.wakeups_per_sec[source_idx]   = wakeups_per_sec;
+        }
+    }
+
+    return(true);
+}
@@ -0,0 +1,93 @@
+/*---------------------------------------------------------*\
+| RGBControllerIdleMonitor.h                                |
+|                                                           |
+|   Tracks whether device output is static so that device,  |
+|   keepalive, and SDK threads can wake up less often       |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+/*---------------------------------------------------------*\
+| Idle Wakeup Sources                                       |
+\*---------------------------------------------------------*/
+enum
+{
+    IDLE_WAKEUP_DEVICE_THREAD   = 0,    /* Device update threads            */
+    IDLE_WAKEUP_KEEPALIVE       = 1,    /* Device keepalive threads         */
+    IDLE_WAKEUP_SDK             = 2,    /* SDK server and client timeouts   */
+    IDLE_WAKEUP_SOURCE_COUNT    = 3,
+};
+
+/*---------------------------------------------------------*\
+| Idle Statistics                                           |
+|   Wakeup rates are measured over windows of about ten     |
+|   seconds                                                 |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    unsigned int            idle;                                       /* 1 if output is idle      */
+    unsigned int            idle_timeout_ms;                            /* Static time before idle  */
+    unsigned int            static_time_ms;                             /* Time since last change   */
+    unsigned long long      wakeups[IDLE_WAKEUP_SOURCE_COUNT];          /* Wakeups per source       */
+    float                   wakeups_per_sec[IDLE_WAKEUP_SOURCE_COUNT];  /* Wakeup rate per source   */
+} idle_stats;
+
+/*---------------------------------------------------------*\
+| RGBControllerIdleMonitor                                  |
+|   Output is idle once no controller has published a frame |
+|   with different colors or sent a mode update for the     |
+|   idle timeout.  While output is idle, keepalive threads  |
+|   waiting in WaitKeepalive() sleep until their keepalive  |
+|   is due instead of polling.                              |
+\*---------------------------------------------------------*/
+class RGBControllerIdleMonitor
+{
+public:
+    static RGBControllerIdleMonitor * get();
+
+    RGBControllerIdleMonitor();
+    ~RGBControllerIdleMonitor();
+
+    void                        NotifyActivity();
+    bool                        IsIdle();
+
+    void                        SetIdleTimeout(unsigned int timeout_ms);
+    unsigned int                GetIdleTimeout();
+
+    void                        RecordWakeup(unsigned int source);
+
+    void                        WaitKeepalive(std::chrono::steady_clock::duration poll_interval, std::chrono::steady_clock::time_point due_time, const std::atomic<bool>& running);
+    void                        Wake();
+
+    idle_stats                  GetStats();
+    unsigned int                GetStatsDescription(std::vector<unsigned char>& data_vec);
+    static bool                 ReadStatsDescription(unsigned char* data_buf, unsigned int data_size, idle_stats& stats);
+
+private:
+    std::atomic<unsigned int>               IdleTimeout;
+    std::atomic<long long>                  LastActivityTime;
+    std::atomic<bool>                       Idle;
+
+    /*-----------------------------------------------------*\
+    | Keepalive threads wait on this condition variable,    |
+    | which is notified when output leaves the idle state   |
+    \*-----------------------------------------------------*/
+    std::mutex                              WaitMutex;
+    std::condition_variable                 WaitCV;
+
+    std::atomic<unsigned long long>         Wakeups[IDLE_WAKEUP_SOURCE_COUNT];
+
+    std::mutex                              StatsMutex;
+    std::chrono::steady_clock::time_point   StatsWindowStart;
+    unsigned long long                      StatsWindowWakeups[IDLE_WAKEUP_SOURCE_COUNT];
+    float                                   StatsRates[IDLE_WAKEUP_SOURCE_COUNT];
+};
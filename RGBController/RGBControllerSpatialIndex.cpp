@@ -0,0 +1,312 @@
+/*---------------------------------------------------------*\
+| RGBControllerSpatialIndex.cpp                             |
+|                                                           |
+|   Index of LED positions across several RGBControllers    |
+|   for sampling position-based effects                     |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "RGBControllerSpatialIndex.h"
+
+/*---------------------------------------------------------*\
+| Largest number of grid cells along one axis               |
+\*---------------------------------------------------------*/
+#define SPATIAL_INDEX_MAX_GRID_SIZE 64
+
+RGBControllerSpatialIndex::RGBControllerSpatialIndex()
+{
+    Clear();
+}
+
+RGBControllerSpatialIndex::~RGBControllerSpatialIndex()
+{
+
+}
+
+void RGBControllerSpatialIndex::Build(const std::vector<RGBController*>& build_controllers)
+{
+    Clear();
+
+    /*-----------------------------------------------------*\
+    | Collect positions of every controller that has them   |
+    \*-----------------------------------------------------*/
+    float min_pos[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    float max_pos[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for(std::size_t controller_idx = 0; controller_idx < build_controllers.size(); controller_idx++)
+    {
+        RGBController* controller = build_controllers[controller_idx];
+
+        if((controller->led_positions.size() == 0)
+        || (controller->led_positions.size() != controller->colors.size()))
+        {
+            continue;
+        }
+
+        index_entry new_entry;
+
+        new_entry.controller    = controller;
+        new_entry.colors        = controller->colors.data();
+        new_entry.generation    = controller->GetLEDPositionsGeneration();
+        new_entry.first         = x_positions.size();
+        new_entry.count         = controller->led_positions.size();
+
+        for(std::size_t led_idx = 0; led_idx < new_entry.count; led_idx++)
+        {
+            const led_position& position = controller->led_positions[led_idx];
+
+            x_positions.push_back(position.x);
+            y_positions.push_back(position.y);
+            z_positions.push_back(position.z);
+            led_entries.push_back((unsigned int)entries.size());
+
+            min_pos[0] = std::min(min_pos[0], position.x);
+            min_pos[1] = std::min(min_pos[1], position.y);
+            min_pos[2] = std::min(min_pos[2], position.z);
+            max_pos[0] = std::max(max_pos[0], position.x);
+            max_pos[1] = std::max(max_pos[1], position.y);
+            max_pos[2] = std::max(max_pos[2], position.z);
+        }
+
+        entries.push_back(new_entry);
+        controllers.push_back(controller);
+    }
+
+    std::size_t num_leds = x_positions.size();
+
+    if(num_leds == 0)
+    {
+        return;
+    }
+
+    /*-----------------------------------------------------*\
+    | Normalize each axis to the shared bounding box.  An   |
+    | axis with no extent is placed at its center.          |
+    \*-----------------------------------------------------*/
+    std::vector<float>* axes[3]     = { &x_positions, &y_positions, &z_positions };
+    unsigned int        num_axes    = 0;
+
+    for(unsigned int axis = 0; axis < 3; axis++)
+    {
+        float extent = max_pos[axis] - min_pos[axis];
+
+        if(extent > 0.0f)
+        {
+            for(std::size_t led_idx = 0; led_idx < num_leds; led_idx++)
+            {
+                (*axes[axis])[led_idx] = ((*axes[axis])[led_idx] - min_pos[axis]) / extent;
+            }
+
+            num_axes++;
+        }
+        else
+        {
+            std::fill(axes[axis]->begin(), axes[axis]->end(), 0.5f);
+        }
+    }
+
+    /*-----------------------------------------------------*\
+    | Size the grid for about one LED per cell, using only  |
+    | the axes that have an extent                          |
+    \*-----------------------------------------------------*/
+    unsigned int cells_per_axis = 1;
+
+    if(num_axes > 0)
+    {
+        cells_per_axis = (unsigned int)std::ceil(std::pow((double)num_leds, 1.0 / (double)num_axes));
+        cells_per_axis = std::max(1u, std::min(cells_per_axis, (unsigned int)SPATIAL_INDEX_MAX_GRID_SIZE));
+    }
+
+    for(unsigned int axis = 0; axis < 3; axis++)
+    {
+        grid_size[axis] = (max_pos[axis] > min_pos[axis]) ? cells_per_axis : 1;
+    }
+
+    /*-----------------------------------------------------*\
+    | Counting sort of the LEDs into their cells            |
+    \*-----------------------------------------------------*/
+    std::size_t                 num_cells = (std::size_t)grid_size[0] * grid_size[1] * grid_size[2];
+    std::vector<unsigned int>   led_cells(num_leds);
+
+    cell_starts.assign(num_cells + 1, 0);
+    cell_leds.resize(num_leds);
+
+    for(std::size_t led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        led_cells[led_idx] = GetCell(x_positions[led_idx], y_positions[led_idx], z_positions[led_idx]);
+        cell_starts[led_cells[led_idx] + 1]++;
+    }
+
+    for(std::size_t cell_idx = 0; cell_idx < num_cells; cell_idx++)
+    {
+        cell_starts[cell_idx + 1] += cell_starts[cell_idx];
+    }
+
+    std::vector<unsigned int> cell_fill(cell_starts.begin(), cell_starts.end() - 1);
+
+    for(std::size_t led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        cell_leds[cell_fill[led_cells[led_idx]]++] = (unsigned int)led_idx;
+    }
+}
+
+void RGBControllerSpatialIndex::Clear()
+{
+    entries.clear();
+    controllers.clear();
+    x_positions.clear();
+    y_positions.clear();
+    z_positions.clear();
+    led_entries.clear();
+    cell_starts.clear();
+    cell_leds.clear();
+
+    grid_size[0] = 1;
+    grid_size[1] = 1;
+    grid_size[2] = 1;
+}
+
+std::size_t RGBControllerSpatialIndex::GetLEDCount() const
+{
+    return(x_positions.size());
+}
+
+const std::vector<RGBController*>& RGBControllerSpatialIndex::GetControllers() const
+{
+    return(controllers);
+}
+
+/*---------------------------------------------------------*\
+| IsStale                                                   |
+|   The index is stale once any indexed controller changes  |
+|   its LED count or color buffer, or its positions are     |
+|   replaced with SetLEDPositions()                         |
+\*---------------------------------------------------------*/
+bool RGBControllerSpatialIndex::IsStale() const
+{
+    for(std::size_t entry_idx = 0; entry_idx < entries.size(); entry_idx++)
+    {
+        const index_entry& entry = entries[entry_idx];
+
+        if((entry.controller->colors.data() != entry.colors)
+        || (entry.controller->colors.size() != entry.count)
+        || (entry.controller->led_positions.size() != entry.count)
+        || (entry.controller->GetLEDPositionsGeneration() != entry.generation))
+        {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+/*---------------------------------------------------------*| GetPositions                                              |
+|   Copy out the normalized positions of one indexed        |
+|   controller's LEDs.  Returns false if the controller is  |
+|   not in the index.                                       |
+\*---------------------------------------------------------*/
+bool RGBControllerSpatialIndex::GetPositions(const RGBController* controller, std::vector<led_position>& positions) const
+{
+    for(std::size_t entry_idx = 0; entry_idx < entries.size(); entry_idx++)
+    {
+        const index_entry& entry = entries[entry_idx];
+
+        if(entry.controller != controller)
+        {
+            continue;
+        }
+
+        positions.resize(entry.count);
+
+        for(std::size_t led_idx = 0; led_idx < entry.count; led_idx++)
+        {
+            positions[led_idx].x = x_positions[entry.first + led_idx];
+            positions[led_idx].y = y_positions[entry.first + led_idx];
+            positions[led_idx].z = z_positions[entry.first + led_idx];
+        }
+
+        return(true);
+    }
+
+    return(false);
+}
+
+/*---------------------------------------------------------*\
+| QueryRadius                                               |
+|   Find every LED within radius of the normalized position |
+|   (x, y, z).  Only grid cells that overlap the sphere's   |
+|   bounding box are searched.                              |
+\*---------------------------------------------------------*/
+void RGBControllerSpatialIndex::QueryRadius(float x, float y, float z, float radius, std::vector<spatial_led>& leds) const
+{
+    leds.clear();
+
+    if((x_positions.size() == 0) || (radius < 0.0f))
+    {
+        return;
+    }
+
+    float           center[3]   = { x, y, z };
+    unsigned int    cell_min[3];
+    unsigned int    cell_max[3];
+
+    for(unsigned int axis = 0; axis < 3; axis++)
+    {
+        cell_min[axis] = GetCellCoordinate(center[axis] - radius, axis);
+        cell_max[axis] = GetCellCoordinate(center[axis] + radius, axis);
+    }
+
+    float radius_sq = radius * radius;
+
+    for(unsigned int cell_z = cell_min[2]; cell_z <= cell_max[2]; cell_z++)
+    {
+        for(unsigned int cell_y = cell_min[1]; cell_y <= cell_max[1]; cell_y++)
+        {
+            for(unsigned int cell_x = cell_min[0]; cell_x <= cell_max[0]; cell_x++)
+            {
+                unsigned int cell = (((cell_z * grid_size[1]) + cell_y) * grid_size[0]) + cell_x;
+
+                for(unsigned int cell_led_idx = cell_starts[cell]; cell_led_idx < cell_starts[cell + 1]; cell_led_idx++)
+                {
+                    unsigned int    led_idx = cell_leds[cell_led_idx];
+                    float           dx      = x_positions[led_idx] - x;
+                    float           dy      = y_positions[led_idx] - y;
+                    float           dz      = z_positions[led_idx] - z;
+
+                    if(((dx * dx) + (dy * dy) + (dz * dz)) <= radius_sq)
+                    {
+                        const index_entry&  entry = entries[led_entries[led_idx]];
+                        spatial_led         found;
+
+                        found.controller    = entry.controller;
+                        found.led_idx       = (unsigned int)(led_idx - entry.first);
+
+                        leds.push_back(found);
+                    }
+                }
+            }
+        }
+    }
+}
+
+unsigned int RGBControllerSpatialIndex::GetCell(float x, float y, float z) const
+{
+    return((((GetCellCoordinate(z, 2) * grid_size[1]) + GetCellCoordinate(y, 1)) * grid_size[0]) + GetCellCoordinate(x, 0));
+}
+
+unsigned int RGBControllerSpatialIndex::GetCellCoordinate(float position, unsigned int axis) const
+{
+    if(!(position > 0.0f))
+    {
+        return(0);
+    }
+
+    unsigned int coordinate = (unsigned int)std::min(position * (float)grid_size[axis], (float)(grid_size[axis] - 1));
+
+    return(coordinate);
+}
@@ -0,0 +1,124 @@
+/*---------------------------------------------------------*\
+| RGBControllerSpatialIndex.h                               |
+|                                                           |
+|   Index of LED positions across several RGBControllers    |
+|   for sampling position-based effects                     |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "RGBController.h"
+
+/*---------------------------------------------------------*\
+| Spatial LED                                               |
+|   A single LED found by a spatial query                   |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    RGBController*          controller;     /* Controller owning LED    */
+    unsigned int            led_idx;        /* LED index in controller  */
+} spatial_led;
+
+/*---------------------------------------------------------*\
+| RGBControllerSpatialIndex                                 |
+|   Build() collects the positions of every controller that |
+|   has them into flat X, Y, and Z arrays normalized to the |
+|   shared bounding box, so that [0, 1] on each axis spans  |
+|   all of the indexed devices.  Controllers without LED    |
+|   positions are skipped.                                  |
+|                                                           |
+|   The index does not lock the controllers.  It is built   |
+|   and sampled from the thread that owns their colors, and |
+|   must be rebuilt when Sample() returns false.            |
+\*---------------------------------------------------------*/
+class RGBControllerSpatialIndex
+{
+public:
+    RGBControllerSpatialIndex();
+    ~RGBControllerSpatialIndex();
+
+    void                        Build(const std::vector<RGBController*>& controllers);
+    void                        Clear();
+
+    std::size_t                 GetLEDCount() const;
+    const std::vector<RGBController*>& GetControllers() const;
+
+    bool                        IsStale() const;
+
+    bool                        GetPositions(const RGBController* controller, std::vector<led_position>& positions) const;
+
+    void                        QueryRadius(float x, float y, float z, float radius, std::vector<spatial_led>& leds) const;
+
+    /*-----------------------------------------------------*\
+    | Sample                                                |
+    |   Call field(x, y, z) once per indexed LED with its   |
+    |   normalized position and store the returned RGBColor |
+    |   in the controller's colors.  Returns false without  |
+    |   writing anything if the index is stale.             |
+    \*-----------------------------------------------------*/
+    template<typename Field>
+    bool Sample(Field field)
+    {
+        if(IsStale())
+        {
+            return(false);
+        }
+
+        for(std::size_t entry_idx = 0; entry_idx < entries.size(); entry_idx++)
+        {
+            const index_entry&  entry   = entries[entry_idx];
+            RGBColor*           out     = entry.controller->colors.data();
+            const float*        ex      = &x_positions[entry.first];
+            const float*        ey      = &y_positions[entry.first];
+            const float*        ez      = &z_positions[entry.first];
+
+            for(std::size_t led_idx = 0; led_idx < entry.count; led_idx++)
+            {
+                out[led_idx] = field(ex[led_idx], ey[led_idx], ez[led_idx]);
+            }
+        }
+
+        return(true);
+    }
+
+private:
+    /*-----------------------------------------------------*\
+    | An indexed controller.  Its LEDs occupy count slots   |
+    | of the position arrays starting at first, and colors  |
+    | and generation record the color buffer and LED        |
+    | positions they were indexed against.                  |
+    \*-----------------------------------------------------*/
+    typedef struct
+    {
+        RGBController*          controller;
+        const RGBColor*         colors;
+        unsigned int            generation;
+        std::size_t             first;
+        std::size_t             count;
+    } index_entry;
+
+    std::vector<index_entry>    entries;
+    std::vector<RGBController*> controllers;
+
+    std::vector<float>          x_positions;
+    std::vector<float>          y_positions;
+    std::vector<float>          z_positions;
+    std::vector<unsigned int>   led_entries;
+
+    /*-----------------------------------------------------*\
+    | Uniform grid over the normalized bounding box.  The   |
+    | LEDs in cell c are cell_leds[cell_starts[c]] up to    |
+    | cell_leds[cell_starts[c + 1]].                        |
+    \*-----------------------------------------------------*/
+    unsigned int                grid_size[3];
+    std::vector<unsigned int>   cell_starts;
+    std::vector<unsigned int>   cell_leds;
+
+    unsigned int                GetCell(float x, float y, float z) const;
+    unsigned int                GetCellCoordinate(float position, unsigned int axis) const;
+};
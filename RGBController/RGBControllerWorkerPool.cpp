@@ -0,0 +1,285 @@
+/*---------------------------------------------------------*\
+| RGBControllerWorkerPool.cpp                               |
+|                                                           |
+|   Shared pool of worker threads that perform device       |
+|   updates on behalf of RGBControllers                     |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <algorithm>
+#include "RGBController.h"
+#include "RGBControllerIdleMonitor.h"
+#include "RGBControllerWorkerPool.h"
+
+RGBControllerWorker::RGBControllerWorker()
+{
+    active  = nullptr;
+    running = true;
+    thread  = new std::thread(&RGBControllerWorker::WorkerThreadFunction, this);
+}
+
+RGBControllerWorker::~RGBControllerWorker()
+{
+    mutex.lock();
+    running = false;
+    mutex.unlock();
+
+    work_cv.notify_all();
+
+    thread->join();
+    delete thread;
+}
+
+void RGBControllerWorker::WorkerThreadFunction()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(running)
+    {
+        /*-------------------------------------------------*\
+        | Move controllers whose frame rate limit has       |
+        | expired from the deferred list onto the queue     |
+        \*-------------------------------------------------*/
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        for(std::size_t deferred_idx = 0; deferred_idx < deferred.size();)
+        {
+            if(deferred[deferred_idx].first <= now)
+            {
+                RGBController * controller = deferred[deferred_idx].second;
+
+                controller->DeviceCallDeferred = false;
+
+                if(!controller->DeviceCallQueued)
+                {
+                    controller->DeviceCallQueued = true;
+                    queue.push_back(controller);
+                }
+
+                deferred.erase(deferred.begin() + deferred_idx);
+            }
+            else
+            {
+                deferred_idx++;
+            }
+        }
+
+        /*-------------------------------------------------*\
+        | Sleep until a controller is queued or the next    |
+        | deferred controller is due                        |
+        \*-------------------------------------------------*/
+        if(deferred.size() > 0 && queue.size() == 0)
+        {
+            std::chrono::steady_clock::time_point next_time = deferred[0].first;
+
+            for(std::size_t deferred_idx = 1; deferred_idx < deferred.size(); deferred_idx++)
+            {
+                next_time = std::min(next_time, deferred[deferred_idx].first);
+            }
+
+            work_cv.wait_until(lock, next_time, [this]
+            {
+                return((running == false) || (queue.size() > 0));
+            });
+
+            RGBControllerIdleMonitor::get()->RecordWakeup(IDLE_WAKEUP_DEVICE_THREAD);
+
+            if(running && queue.size() == 0)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            work_cv.wait(lock, [this]
+            {
+                return((running == false) || (queue.size() > 0));
+            });
+
+            RGBControllerIdleMonitor::get()->RecordWakeup(IDLE_WAKEUP_DEVICE_THREAD);
+        }
+
+        if(!running)
+        {
+            break;
+        }
+
+        /*-------------------------------------------------*\
+        | Take the next controller off the queue.  Once it  |
+        | is no longer queued, new requests made while it   |
+        | is being processed queue it again                 |
+        \*-------------------------------------------------*/
+        active = queue.front();
+        queue.pop_front();
+
+        active->DeviceCallQueued = false;
+
+        lock.unlock();
+
+        std::chrono::steady_clock::time_point next_call_time;
+        bool deferred_call = active->ProcessDeviceCalls(next_call_time);
+
+        lock.lock();
+
+        /*-------------------------------------------------*\
+        | If the LED update was held back by the frame rate |
+        | limit, park the controller until its next slot    |
+        \*-------------------------------------------------*/
+        if(deferred_call && !active->DeviceCallDeferred)
+        {
+            active->DeviceCallDeferred = true;
+            deferred.push_back(std::make_pair(next_call_time, active));
+        }
+
+        active = nullptr;
+
+        idle_cv.notify_all();
+    }
+}
+
+RGBControllerWorkerPool* RGBControllerWorkerPool::get()
+{
+    /*-----------------------------------------------------*\
+    | Controllers on different threads may attach at the    |
+    | same time, so create the pool as a function-local     |
+    | static, whose initialization is thread safe           |
+    \*-----------------------------------------------------*/
+    static RGBControllerWorkerPool* instance = new RGBControllerWorkerPool();
+
+    return instance;
+}
+
+RGBControllerWorkerPool::RGBControllerWorkerPool()
+{
+    /*-----------------------------------------------------*\
+    | Size the pool to the number of available cores        |
+    \*-----------------------------------------------------*/
+    unsigned int worker_count = std::max(1U, std::thread::hardware_concurrency());
+
+    next_affinity_worker = 0;
+
+    for(unsigned int worker_idx = 0; worker_idx < worker_count; worker_idx++)
+    {
+        workers.push_back(new RGBControllerWorker());
+    }
+}
+
+RGBControllerWorkerPool::~RGBControllerWorkerPool()
+{
+    for(std::size_t worker_idx = 0; worker_idx < workers.size(); worker_idx++)
+    {
+        delete workers[worker_idx];
+    }
+
+    workers.clear();
+}
+
+unsigned int RGBControllerWorkerPool::GetWorkerCount()
+{
+    return((unsigned int)workers.size());
+}
+
+std::string RGBControllerWorkerPool::GetAffinityKey(const std::string& location)
+{
+    /*-----------------------------------------------------*\
+    | Locations are formatted as "<transport>: <bus>" with  |
+    | optional per-device details after a comma, such as    |
+    | "I2C: <bus name>, address 0x71".  Stripping the       |
+    | details groups all controllers on the same bus.       |
+    \*-----------------------------------------------------*/
+    return(location.substr(0, location.find(',')));
+}
+
+int RGBControllerWorkerPool::AttachController(RGBController * controller)
+{
+    /*-----------------------------------------------------*\
+    | Controllers sharing a bus always map to the same      |
+    | worker so that their transfers are serialized.  Each  |
+    | new bus gets the next worker in turn, so that buses   |
+    | are spread evenly over the workers.                   |
+    \*-----------------------------------------------------*/
+    std::lock_guard<std::mutex> lock(affinity_mutex);
+
+    std::string                             affinity_key = GetAffinityKey(controller->location);
+    std::map<std::string, int>::iterator    affinity_it  = affinity_workers.find(affinity_key);
+
+    if(affinity_it != affinity_workers.end())
+    {
+        return(affinity_it->second);
+    }
+
+    int worker_idx = (int)(next_affinity_worker % workers.size());
+
+    next_affinity_worker++;
+
+    affinity_workers[affinity_key] = worker_idx;
+
+    return(worker_idx);
+}
+
+void RGBControllerWorkerPool::DetachController(RGBController * controller, int worker_idx)
+{
+    RGBControllerWorker *           worker = workers[worker_idx];
+    std::unique_lock<std::mutex>    lock(worker->mutex);
+
+    /*-----------------------------------------------------*\
+    | Remove any pending request for this controller and    |
+    | wait for an in-progress update to finish              |
+    \*-----------------------------------------------------*/
+    worker->queue.erase(std::remove(worker->queue.begin(), worker->queue.end(), controller), worker->queue.end());
+
+    controller->DeviceCallQueued = false;
+
+    worker->idle_cv.wait(lock, [worker, controller]
+    {
+        return(worker->active != controller);
+    });
+
+    /*-----------------------------------------------------*\
+    | The update may have deferred the controller again,    |
+    | so clear the deferred list after it has finished      |
+    \*-----------------------------------------------------*/
+    for(std::size_t deferred_idx = 0; deferred_idx < worker->deferred.size();)
+    {
+        if(worker->deferred[deferred_idx].second == controller)
+        {
+            worker->deferred.erase(worker->deferred.begin() + deferred_idx);
+        }
+        else
+        {
+            deferred_idx++;
+        }
+    }
+
+    controller->DeviceCallDeferred = false;
+}
+
+void RGBControllerWorkerPool::ScheduleController(RGBController * controller, int worker_idx)
+{
+    RGBControllerWorker * worker = workers[worker_idx];
+
+    worker->mutex.lock();
+
+    /*-----------------------------------------------------*\
+    | A controller waiting out its frame rate limit is      |
+    | picked up from the deferred list when its slot comes, |
+    | unless a mode update needs to go out right away       |
+    \*-----------------------------------------------------*/
+    if(controller->DeviceCallDeferred && !controller->CallFlag_UpdateMode.load())
+    {
+        worker->mutex.unlock();
+        return;
+    }
+
+    if(!controller->DeviceCallQueued)
+    {
+        controller->DeviceCallQueued = true;
+        worker->queue.push_back(controller);
+    }
+
+    worker->mutex.unlock();
+
+    worker->work_cv.notify_one();
+}
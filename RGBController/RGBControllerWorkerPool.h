@@ -0,0 +1,69 @@
+/*---------------------------------------------------------*\
+| RGBControllerWorkerPool.h                                 |
+|                                                           |
+|   Shared pool of worker threads that perform device       |
+|   updates on behalf of RGBControllers                     |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class RGBController;
+
+class RGBControllerWorker
+{
+public:
+    RGBControllerWorker();
+    ~RGBControllerWorker();
+
+    void                        WorkerThreadFunction();
+
+    std::thread *               thread;
+    std::mutex                  mutex;
+    std::condition_variable     work_cv;
+    std::condition_variable     idle_cv;
+    std::deque<RGBController *> queue;
+    std::vector<std::pair<std::chrono::steady_clock::time_point, RGBController *>> deferred;
+    RGBController *             active;
+    bool                        running;
+};
+
+class RGBControllerWorkerPool
+{
+public:
+    static RGBControllerWorkerPool * get();
+
+    RGBControllerWorkerPool();
+    ~RGBControllerWorkerPool();
+
+    unsigned int                GetWorkerCount();
+
+    int                         AttachController(RGBController * controller);
+    void                        DetachController(RGBController * controller, int worker_idx);
+    void                        ScheduleController(RGBController * controller, int worker_idx);
+
+private:
+    std::vector<RGBControllerWorker *>  workers;
+
+    /*---------------------------------------------------------*\
+    | Worker assigned to each bus, and the worker the next new  |
+    | bus is assigned to                                        |
+    \*---------------------------------------------------------*/
+    std::mutex                          affinity_mutex;
+    std::map<std::string, int>          affinity_workers;
+    unsigned int                        next_affinity_worker;
+
+    static std::string          GetAffinityKey(const std::string& location);
+};
@@ -14,10 +14,21 @@
 
 #include "RGBController_Network.h"
 
+/*---------------------------------------------------------*\
+| Encoded updates only carry the LEDs that changed, so the  |
+| full frame is sent this often to correct the server if    |
+| anything else has changed its colors                      |
+\*---------------------------------------------------------*/
+#define ENCODED_FULL_FRAME_INTERVAL_MS  1000
+
 RGBController_Network::RGBController_Network(NetworkClient * client_ptr, unsigned int dev_idx_val)
 {
     client  = client_ptr;
     dev_idx = dev_idx_val;
+
+    remote_stats_requested  = false;
+    remote_health           = RGBController::GetHealth();
+    remote_health_requested = false;
 }
 
 void RGBController_Network::SetupZones()
@@ -56,37 +67,90 @@ void RGBController_Network::ResizeZone(int zone, int new_size)
     client->WaitOnControllerData();
 }
 
+/*---------------------------------------------------------*\
+| LED updates serialize into a buffer kept by the           |
+| controller, so sending a frame does not allocate once the |
+| buffer has grown to the frame size                        |
+\*---------------------------------------------------------*/
 void RGBController_Network::DeviceUpdateLEDs()
 {
-    unsigned char * data = GetColorDescription();
-    unsigned int size;
+    send_buf_mutex.lock();
 
-    memcpy(&size, &data[0], sizeof(unsigned int));
+    /*---------------------------------------------------------*\
+    | From protocol 13, send only the LEDs that changed         |
+    \*---------------------------------------------------------*/
+    if(client->GetProtocolVersion() >= 13)
+    {
+        unsigned int size = EncodeColors(send_buf);
 
-    client->SendRequest_RGBController_UpdateLEDs(dev_idx, data, size);
+        client->SendRequest_RGBController_UpdateLEDsEncoded(dev_idx, send_buf.data(), size);
+    }
+    else
+    {
+        unsigned int size = GetColorDescription(send_buf, client->GetProtocolVersion());
 
-    delete[] data;
+        client->SendRequest_RGBController_UpdateLEDs(dev_idx, send_buf.data(), size);
+    }
+
+    send_buf_mutex.unlock();
+}
+
+/*---------------------------------------------------------*\
+| EncodeColors                                              |
+|   Encode the colors that changed since the last encoded   |
+|   update, or every color if the full frame is due         |
+\*---------------------------------------------------------*/
+unsigned int RGBController_Network::EncodeColors(std::vector<unsigned char>& data_vec)
+{
+    std::lock_guard<std::mutex> lock(sent_colors_mutex);
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if(now >= (sent_colors_full_time + std::chrono::milliseconds(ENCODED_FULL_FRAME_INTERVAL_MS)))
+    {
+        sent_colors.clear();
+        sent_colors_full_time = now;
+    }
+
+    return(GetEncodedColorDescription(data_vec, sent_colors));
+}
+
+/*---------------------------------------------------------*\
+| Zone and single LED updates change the server's colors    |
+| without the encoded update reference, so the next encoded |
+| update sends the full frame                               |
+\*---------------------------------------------------------*/
+void RGBController_Network::InvalidateSentColors()
+{
+    std::lock_guard<std::mutex> lock(sent_colors_mutex);
+
+    sent_colors.clear();
 }
 
 void RGBController_Network::UpdateZoneLEDs(int zone)
 {
-    unsigned char * data = GetZoneColorDescription(zone);
-    unsigned int size;
+    InvalidateSentColors();
 
-    memcpy(&size, &data[0], sizeof(unsigned int));
+    send_buf_mutex.lock();
 
-    client->SendRequest_RGBController_UpdateZoneLEDs(dev_idx, data, size);
+    unsigned int size = GetZoneColorDescription(send_buf, zone, client->GetProtocolVersion());
 
-    delete[] data;
+    client->SendRequest_RGBController_UpdateZoneLEDs(dev_idx, send_buf.data(), size);
+
+    send_buf_mutex.unlock();
 }
 
 void RGBController_Network::UpdateSingleLED(int led)
 {
-    unsigned char * data = GetSingleLEDColorDescription(led);
+    InvalidateSentColors();
 
-    client->SendRequest_RGBController_UpdateSingleLED(dev_idx, data, sizeof(int) + sizeof(RGBColor));
+    send_buf_mutex.lock();
 
-    delete[] data;
+    unsigned int size = GetSingleLEDColorDescription(send_buf, led);
+
+    client->SendRequest_RGBController_UpdateSingleLED(dev_idx, send_buf.data(), size);
+
+    send_buf_mutex.unlock();
 }
 
 void RGBController_Network::SetCustomMode()
@@ -99,26 +163,24 @@ void RGBController_Network::SetCustomMode()
 
 void RGBController_Network::DeviceUpdateMode()
 {
-    unsigned char * data = GetModeDescription(active_mode, client->GetProtocolVersion());
-    unsigned int size;
+    send_buf_mutex.lock();
 
-    memcpy(&size, &data[0], sizeof(unsigned int));
+    unsigned int size = GetModeDescription(send_buf, active_mode, client->GetProtocolVersion());
 
-    client->SendRequest_RGBController_UpdateMode(dev_idx, data, size);
+    client->SendRequest_RGBController_UpdateMode(dev_idx, send_buf.data(), size);
 
-    delete[] data;
+    send_buf_mutex.unlock();
 }
 
 void RGBController_Network::DeviceSaveMode()
 {
-    unsigned char * data = GetModeDescription(active_mode, client->GetProtocolVersion());
-    unsigned int size;
+    send_buf_mutex.lock();
 
-    memcpy(&size, &data[0], sizeof(unsigned int));
+    unsigned int size = GetModeDescription(send_buf, active_mode, client->GetProtocolVersion());
 
-    client->SendRequest_RGBController_SaveMode(dev_idx, data, size);
+    client->SendRequest_RGBController_SaveMode(dev_idx, send_buf.data(), size);
 
-    delete[] data;
+    send_buf_mutex.unlock();
 }
 
 /*-----------------------------------------------------*\
@@ -134,3 +196,216 @@ void RGBController_Network::UpdateLEDs()
 {
     DeviceUpdateLEDs();
 }
+
+void RGBController_Network::SetColorCorrection(color_correction correction)
+{
+    /*---------------------------------------------------------*\
+    | Correction is applied by the server's controller.  This   |
+    | controller sends colors without going through the frame   |
+    | buffers, so the local copy only serves                    |
+    | GetColorCorrection().                                     |
+    \*---------------------------------------------------------*/
+    client->SendRequest_RGBController_SetColorCorrection(dev_idx, correction);
+
+    RGBController::SetColorCorrection(correction);
+}
+
+void RGBController_Network::SetLEDPositions(std::vector<led_position> positions)
+{
+    RGBController::SetLEDPositions(positions);
+
+    /*---------------------------------------------------------*\
+    | Send the positions the local copy accepted so the server  |
+    | stores them with the device's sizes profile               |
+    \*---------------------------------------------------------*/
+    std::vector<unsigned char> positions_data;
+
+    unsigned int size = GetLEDPositionsDescription(positions_data);
+
+    client->SendRequest_RGBController_SetLEDPositions(dev_idx, positions_data.data(), size);
+}
+
+std::vector<latency_stats> RGBController_Network::GetLatencyStats()
+{
+    /*---------------------------------------------------------*\
+    | Servers older than protocol 8 do not report statistics.   |
+    | The local statistics then cover sending to the server.    |
+    \*---------------------------------------------------------*/
+    if(client->GetProtocolVersion() < 8)
+    {
+        return(RGBController::GetLatencyStats());
+    }
+
+    /*---------------------------------------------------------*\
+    | Return the statistics last received without waiting, and  |
+    | ask the server for newer ones unless a request is already |
+    | waiting for its reply.  A request that has not been       |
+    | answered within a second is sent again.                   |
+    \*---------------------------------------------------------*/
+    std::chrono::steady_clock::time_point   now = std::chrono::steady_clock::now();
+    std::vector<latency_stats>              stats;
+    bool                                    send_request;
+
+    remote_stats_mutex.lock();
+
+    send_request = (!remote_stats_requested) || ((now - remote_stats_request_time) >= std::chrono::seconds(1));
+
+    if(send_request)
+    {
+        remote_stats_requested      = true;
+        remote_stats_request_time   = now;
+    }
+
+    stats = remote_stats;
+
+    remote_stats_mutex.unlock();
+
+    if(send_request)
+    {
+        client->SendRequest_RGBController_GetLatencyStats(dev_idx);
+    }
+
+    return(stats);
+}
+
+void RGBController_Network::ReadLatencyStatsDescription(unsigned char* data_buf, unsigned int data_size)
+{
+    unsigned int    data_ptr    = sizeof(unsigned int);
+    unsigned short  num_stages  = 0;
+    unsigned int    stage_size  = sizeof(unsigned long long) + (4 * sizeof(unsigned int));
+
+    /*---------------------------------------------------------*\
+    | Copy in number of stages, ignoring the reply if it is too |
+    | short to hold them                                        |
+    \*---------------------------------------------------------*/
+    if(data_size < (data_ptr + sizeof(num_stages)))
+    {
+        return;
+    }
+
+    memcpy(&num_stages, &data_buf[data_ptr], sizeof(num_stages));
+    data_ptr += sizeof(num_stages);
+
+    if(data_size < (data_ptr + (num_stages * stage_size)))
+    {
+        return;
+    }
+
+    std::vector<latency_stats> new_stats(num_stages);
+
+    for(unsigned short stage_idx = 0; stage_idx < num_stages; stage_idx++)
+    {
+        memcpy(&new_stats[stage_idx].count, &data_buf[data_ptr], sizeof(new_stats[stage_idx].count));
+        data_ptr += sizeof(new_stats[stage_idx].count);
+
+        memcpy(&new_stats[stage_idx].p50, &data_buf[data_ptr], sizeof(new_stats[stage_idx].p50));
+        data_ptr += sizeof(new_stats[stage_idx].p50);
+
+        memcpy(&new_stats[stage_idx].p99, &data_buf[data_ptr], sizeof(new_stats[stage_idx].p99));
+        data_ptr += sizeof(new_stats[stage_idx].p99);
+
+        memcpy(&new_stats[stage_idx].max, &data_buf[data_ptr], sizeof(new_stats[stage_idx].max));
+        data_ptr += sizeof(new_stats[stage_idx].max);
+
+        memcpy(&new_stats[stage_idx].mean, &data_buf[data_ptr], sizeof(new_stats[stage_idx].mean));
+        data_ptr += sizeof(new_stats[stage_idx].mean);
+    }
+
+    remote_stats_mutex.lock();
+    remote_stats            = new_stats;
+    remote_stats_requested  = false;
+    remote_stats_mutex.unlock();
+}
+
+device_health RGBController_Network::GetHealth()
+{
+    /*---------------------------------------------------------*\
+    | Servers older than protocol 10 do not report health       |
+    \*---------------------------------------------------------*/
+    if(client->GetProtocolVersion() < 10)
+    {
+        return(RGBController::GetHealth());
+    }
+
+    /*---------------------------------------------------------*\
+    | Return the health last received without waiting.  Health  |
+    | change notifications keep the state current, and a        |
+    | request keeps the counters current unless one is already  |
+    | waiting for its reply.  A request that has not been       |
+    | answered within a second is sent again.                   |
+    \*---------------------------------------------------------*/
+    std::chrono::steady_clock::time_point   now = std::chrono::steady_clock::now();
+    device_health                           health;
+    bool                                    send_request;
+
+    remote_health_mutex.lock();
+
+    send_request = (!remote_health_requested) || ((now - remote_health_request_time) >= std::chrono::seconds(1));
+
+    if(send_request)
+    {
+        remote_health_requested     = true;
+        remote_health_request_time  = now;
+    }
+
+    health = remote_health;
+
+    remote_health_mutex.unlock();
+
+    if(send_request)
+    {
+        client->SendRequest_RGBController_GetHealth(dev_idx);
+    }
+
+    return(health);
+}
+
+/*---------------------------------------------------------*\
+| ReadHealthDescription                                     |
+|   Store health sent by the server, either in reply to     |
+|   GetHealth() or as a health change notification, and     |
+|   call the health callbacks if the state changed          |
+\*---------------------------------------------------------*/
+void RGBController_Network::ReadHealthDescription(unsigned char* data_buf, unsigned int data_size)
+{
+    unsigned int    data_ptr    = sizeof(unsigned int);
+    device_health   new_health;
+
+    if(data_size < (data_ptr + sizeof(new_health.state) + sizeof(new_health.last_result) + sizeof(new_health.failures_in_row)
+                 + sizeof(new_health.writes) + sizeof(new_health.failures) + sizeof(new_health.bytes_written) + sizeof(new_health.bytes_per_sec)))
+    {
+        return;
+    }
+
+    memcpy(&new_health.state, &data_buf[data_ptr], sizeof(new_health.state));
+    data_ptr += sizeof(new_health.state);
+
+    memcpy(&new_health.last_result, &data_buf[data_ptr], sizeof(new_health.last_result));
+    data_ptr += sizeof(new_health.last_result);
+
+    memcpy(&new_health.failures_in_row, &data_buf[data_ptr], sizeof(new_health.failures_in_row));
+    data_ptr += sizeof(new_health.failures_in_row);
+
+    memcpy(&new_health.writes, &data_buf[data_ptr], sizeof(new_health.writes));
+    data_ptr += sizeof(new_health.writes);
+
+    memcpy(&new_health.failures, &data_buf[data_ptr], sizeof(new_health.failures));
+    data_ptr += sizeof(new_health.failures);
+
+    memcpy(&new_health.bytes_written, &data_buf[data_ptr], sizeof(new_health.bytes_written));
+    data_ptr += sizeof(new_health.bytes_written);
+
+    memcpy(&new_health.bytes_per_sec, &data_buf[data_ptr], sizeof(new_health.bytes_per_sec));
+    data_ptr += sizeof(new_health.bytes_per_sec);
+
+    remote_health_mutex.lock();
+    bool changed            = (new_health.state != remote_health.state);
+    remote_health           = new_health;
+    remote_health_requested = false;
+    remote_health_mutex.unlock();
+
+    if(changed)
+    {
+        SignalHealthChanged(new_health);
+    }
+}
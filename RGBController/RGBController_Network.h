@@ -36,7 +36,50 @@ public:
 
     void        UpdateLEDs();
 
+    unsigned int EncodeColors(std::vector<unsigned char>& data_vec);
+
+    void        SetColorCorrection(color_correction correction);
+
+    void        SetLEDPositions(std::vector<led_position> positions);
+
+    std::vector<latency_stats> GetLatencyStats();
+    void        ReadLatencyStatsDescription(unsigned char* data_buf, unsigned int data_size);
+
+    device_health GetHealth();
+    void        ReadHealthDescription(unsigned char* data_buf, unsigned int data_size);
+
 private:
     NetworkClient *     client;
     unsigned int        dev_idx;
+
+    /*---------------------------------------------------------*\
+    | Latency statistics last received from the server, and     |
+    | when newer ones were requested if the reply is pending    |
+    \*---------------------------------------------------------*/
+    std::mutex                              remote_stats_mutex;
+    std::vector<latency_stats>              remote_stats;
+    bool                                    remote_stats_requested;
+    std::chrono::steady_clock::time_point   remote_stats_request_time;
+
+    /*---------------------------------------------------------*\
+    | Health last received from the server, and when newer      |
+    | health was requested if the reply is pending              |
+    \*---------------------------------------------------------*/
+    std::mutex                              remote_health_mutex;
+    device_health                           remote_health;
+    bool                                    remote_health_requested;
+    std::chrono::steady_clock::time_point   remote_health_request_time;
+
+    std::mutex                  send_buf_mutex;
+    std::vector<unsigned char>  send_buf;
+
+    /*---------------------------------------------------------*\
+    | Colors last sent to the server as encoded updates, and    |
+    | when they were last sent in full                          |
+    \*---------------------------------------------------------*/
+    std::mutex                              sent_colors_mutex;
+    std::vector<RGBColor>                   sent_colors;
+    std::chrono::steady_clock::time_point   sent_colors_full_time;
+
+    void        InvalidateSentColors();
 };
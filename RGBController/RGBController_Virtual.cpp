@@ -0,0 +1,405 @@
+/*---------------------------------------------------------*\
+| RGBController_Virtual.cpp                                 |
+|                                                           |
+|   Virtual RGBController that combines LEDs from several   |
+|   physical controllers into a single zone                 |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstring>
+#include "RGBController_Virtual.h"
+#include "ResourceManager.h"
+
+/**------------------------------------------------------------------*\
+    @name Virtual Device
+    @category Virtual
+    @type Virtual
+    @save :x:
+    @direct :white_check_mark:
+    @effects :x:
+    @detectors VirtualControllers settings
+    @comment Combines LEDs from several controllers into one linear or
+    matrix zone.  Each frame is copied in runs straight into the member
+    controllers, which are then updated as one frame group.
+*/
+
+RGBController_Virtual::RGBController_Virtual(std::string virtual_name, zone_type virtual_type, unsigned int virtual_width, unsigned int virtual_height)
+{
+    name                = virtual_name;
+    vendor              = "OpenRGB";
+    type                = DEVICE_TYPE_VIRTUAL;
+    description         = "Virtual Device";
+    location            = "Virtual: " + virtual_name;
+
+    virtual_zone_type   = virtual_type;
+    matrix_width        = virtual_width;
+    matrix_height       = virtual_height;
+
+    /*-----------------------------------------------------*\
+    | Set up modes                                          |
+    \*-----------------------------------------------------*/
+    mode Direct;
+    Direct.name         = "Direct";
+    Direct.value        = 0;
+    Direct.flags        = MODE_FLAG_HAS_PER_LED_COLOR;
+    Direct.color_mode   = MODE_COLORS_PER_LED;
+    modes.push_back(Direct);
+}
+
+RGBController_Virtual::~RGBController_Virtual()
+{
+
+}
+
+/*---------------------------------------------------------*\
+| AddMember                                                 |
+|   Append count LEDs of a member controller, starting at   |
+|   member_start within member_zone (or within the whole    |
+|   device if member_zone is -1), to the virtual zone.  In  |
+|   a matrix zone they fill row y from column x.            |
+|   SetupZones() must be called once all members are added. |
+\*---------------------------------------------------------*/
+void RGBController_Virtual::AddMember(RGBController* controller, int member_zone, unsigned int member_start, unsigned int count, unsigned int x, unsigned int y)
+{
+    if((member_zone >= 0) && ((std::size_t)member_zone >= controller->zones.size()))
+    {
+        return;
+    }
+
+    virtual_range new_range;
+
+    new_range.controller    = controller;
+    new_range.member_zone   = member_zone;
+    new_range.member_start  = member_start;
+    new_range.count         = count;
+    new_range.x             = x;
+    new_range.y             = y;
+    new_range.matrix        = false;
+
+    ranges.push_back(new_range);
+}
+
+/*---------------------------------------------------------*\
+| AddMatrixMember                                           |
+|   Append all LEDs of a member's matrix zone, placing the  |
+|   zone's matrix map with its top left corner at (x, y)    |
+\*---------------------------------------------------------*/
+void RGBController_Virtual::AddMatrixMember(RGBController* controller, unsigned int member_zone, unsigned int x, unsigned int y)
+{
+    if(member_zone >= controller->zones.size())
+    {
+        return;
+    }
+
+    virtual_range new_range;
+
+    new_range.controller    = controller;
+    new_range.member_zone   = (int)member_zone;
+    new_range.member_start  = 0;
+    new_range.count         = 0xFFFFFFFF;
+    new_range.x             = x;
+    new_range.y             = y;
+    new_range.matrix        = true;
+
+    ranges.push_back(new_range);
+}
+
+/*---------------------------------------------------------*\
+| ResolveRange                                              |
+|   Find the member LEDs a range currently covers.  Ranges  |
+|   are kept relative to their member zone so that they     |
+|   follow the zone when the member is resized, and are     |
+|   clipped to the LEDs the member has now.                 |
+\*---------------------------------------------------------*/
+void RGBController_Virtual::ResolveRange(const virtual_range& range, unsigned int& start, unsigned int& count)
+{
+    unsigned int zone_start = 0;
+    unsigned int zone_count = (unsigned int)range.controller->leds.size();
+
+    start = 0;
+    count = 0;
+
+    if(range.member_zone >= 0)
+    {
+        if((std::size_t)range.member_zone >= range.controller->zones.size())
+        {
+            return;
+        }
+
+        zone_start = range.controller->zones[range.member_zone].start_idx;
+        zone_count = range.controller->zones[range.member_zone].leds_count;
+    }
+
+    if(range.member_start >= zone_count)
+    {
+        return;
+    }
+
+    start = zone_start + range.member_start;
+    count = std::min(range.count, zone_count - range.member_start);
+}
+
+/*---------------------------------------------------------*\
+| RemoveMember                                              |
+|   Stop sending frames to a member controller, such as     |
+|   when it is unregistered.  Its LEDs stay in the virtual  |
+|   zone but are no longer shown anywhere.                  |
+\*---------------------------------------------------------*/
+void RGBController_Virtual::RemoveMember(RGBController* controller)
+{
+    std::lock_guard<std::mutex> lock(MembersMutex);
+
+    for(std::size_t member_idx = 0; member_idx < members.size(); member_idx++)
+    {
+        if(members[member_idx].controller == controller)
+        {
+            members.erase(members.begin() + member_idx);
+            break;
+        }
+    }
+
+    for(std::size_t range_idx = 0; range_idx < ranges.size(); range_idx++)
+    {
+        if(ranges[range_idx].controller == controller)
+        {
+            ranges[range_idx].controller = NULL;
+        }
+    }
+}
+
+void RGBController_Virtual::SetupZones()
+{
+    std::lock_guard<std::mutex> lock(MembersMutex);
+
+    leds.clear();
+    zones.clear();
+    members.clear();
+
+    /*-----------------------------------------------------*\
+    | Build the LED list and the per-member runs.  Virtual  |
+    | LEDs are numbered in the order the ranges were added, |
+    | so every range is one contiguous run.                 |
+    \*-----------------------------------------------------*/
+    unsigned int virtual_idx = 0;
+
+    for(std::size_t range_idx = 0; range_idx < ranges.size(); range_idx++)
+    {
+        virtual_range& range = ranges[range_idx];
+        unsigned int   range_start;
+        unsigned int   range_count;
+
+        if(range.controller == NULL)
+        {
+            continue;
+        }
+
+        ResolveRange(range, range_start, range_count);
+
+        for(unsigned int led_idx = 0; led_idx < range_count; led_idx++)
+        {
+            led new_led;
+
+            new_led.name    = range.controller->name + " " + range.controller->leds[range_start + led_idx].name;
+            new_led.value   = 0;
+
+            leds.push_back(new_led);
+        }
+
+        virtual_led_run new_run;
+
+        new_run.range_idx       = (unsigned int)range_idx;
+        new_run.virtual_start   = virtual_idx;
+        new_run.virtual_count   = range_count;
+        new_run.member_start    = range_start;
+        new_run.count           = range_count;
+
+        std::size_t member_idx;
+
+        for(member_idx = 0; member_idx < members.size(); member_idx++)
+        {
+            if(members[member_idx].controller == range.controller)
+            {
+                break;
+            }
+        }
+
+        if(member_idx == members.size())
+        {
+            virtual_member new_member;
+
+            new_member.controller = range.controller;
+
+            members.push_back(new_member);
+        }
+
+        members[member_idx].runs.push_back(new_run);
+
+        virtual_idx += range_count;
+    }
+
+    /*-----------------------------------------------------*\
+    | Set up the single virtual zone                        |
+    \*-----------------------------------------------------*/
+    zone virtual_zone;
+
+    virtual_zone.name       = name;
+    virtual_zone.type       = virtual_zone_type;
+    virtual_zone.leds_min   = virtual_idx;
+    virtual_zone.leds_max   = virtual_idx;
+    virtual_zone.leds_count = virtual_idx;
+    virtual_zone.matrix_map = NULL;
+
+    if(virtual_zone_type == ZONE_TYPE_MATRIX)
+    {
+        matrix_map_data.assign(matrix_width * matrix_height, 0xFFFFFFFF);
+
+        virtual_idx = 0;
+
+        for(std::size_t range_idx = 0; range_idx < ranges.size(); range_idx++)
+        {
+            virtual_range& range = ranges[range_idx];
+            zone*          member_zone = NULL;
+            unsigned int   range_start;
+            unsigned int   range_count;
+
+            if(range.controller == NULL)
+            {
+                continue;
+            }
+
+            ResolveRange(range, range_start, range_count);
+
+            if(range.matrix)
+            {
+                member_zone = &range.controller->zones[range.member_zone];
+            }
+
+            if((member_zone != NULL) && (member_zone->matrix_map != NULL))
+            {
+                /*-----------------------------------------*\
+                | Copy the member's matrix map, offsetting  |
+                | its zone-relative LED indices to virtual  |
+                | LED indices                               |
+                \*-----------------------------------------*/
+                for(unsigned int y = 0; y < member_zone->matrix_map->height; y++)
+                {
+                    for(unsigned int x = 0; x < member_zone->matrix_map->width; x++)
+                    {
+                        unsigned int value = member_zone->matrix_map->map[(y * member_zone->matrix_map->width) + x];
+
+                        if((value < range_count) && ((range.y + y) < matrix_height) && ((range.x + x) < matrix_width))
+                        {
+                            matrix_map_data[((range.y + y) * matrix_width) + range.x + x] = virtual_idx + value;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                for(unsigned int led_idx = 0; led_idx < range_count; led_idx++)
+                {
+                    if((range.y < matrix_height) && ((range.x + led_idx) < matrix_width))
+                    {
+                        matrix_map_data[(range.y * matrix_width) + range.x + led_idx] = virtual_idx + led_idx;
+                    }
+                }
+            }
+
+            virtual_idx += range_count;
+        }
+
+        virtual_matrix_map.height   = matrix_height;
+        virtual_matrix_map.width    = matrix_width;
+        virtual_matrix_map.map      = matrix_map_data.data();
+
+        virtual_zone.matrix_map     = &virtual_matrix_map;
+    }
+
+    zones.push_back(virtual_zone);
+
+    member_controllers.reserve(members.size());
+
+    SetupColors();
+}
+
+void RGBController_Virtual::ResizeZone(int /*zone*/, int /*new_size*/)
+{
+    /*-----------------------------------------------------*\
+    | This device does not support resizing zones           |
+    \*-----------------------------------------------------*/
+}
+
+/*---------------------------------------------------------*\
+| DeviceUpdateLEDs                                          |
+|   Copy each run of the frame into the member controllers  |
+|   through their frame write lock and commit the members   |
+|   as one frame group, so the whole scene takes a single   |
+|   update.  The members are local devices, so the group is |
+|   committed locally, which only publishes their frames.   |
+\*---------------------------------------------------------*/
+void RGBController_Virtual::DeviceUpdateLEDs()
+{
+    const std::vector<RGBColor>& frame = GetFrame();
+
+    std::lock_guard<std::mutex> lock(MembersMutex);
+
+    member_controllers.clear();
+
+    for(std::size_t member_idx = 0; member_idx < members.size(); member_idx++)
+    {
+        virtual_member& member = members[member_idx];
+
+        for(std::size_t run_idx = 0; run_idx < member.runs.size(); run_idx++)
+        {
+            virtual_led_run& run = member.runs[run_idx];
+
+            /*---------------------------------------------*\
+            | Follow the member range if the member has     |
+            | been resized since the runs were built.  The  |
+            | virtual LEDs stay the same until SetupZones() |
+            | is called again.                              |
+            \*---------------------------------------------*/
+            ResolveRange(ranges[run.range_idx], run.member_start, run.count);
+
+            run.count = std::min(run.count, run.virtual_count);
+
+            if((run.count > 0) && ((run.virtual_start + run.count) <= frame.size()))
+            {
+                member.controller->SetLEDRange(run.member_start, &frame[run.virtual_start], run.count);
+            }
+        }
+
+        member_controllers.push_back(member.controller);
+    }
+
+    ResourceManager::get()->CommitLocalFrameGroup(member_controllers);
+}
+
+void RGBController_Virtual::UpdateZoneLEDs(int /*zone*/)
+{
+    DeviceUpdateLEDs();
+}
+
+void RGBController_Virtual::UpdateSingleLED(int /*led*/)
+{
+    DeviceUpdateLEDs();
+}
+
+/*---------------------------------------------------------*\
+| DeviceUpdateMode                                          |
+|   The virtual device only has a Direct mode, so switch    |
+|   every member to its own custom mode                     |
+\*---------------------------------------------------------*/
+void RGBController_Virtual::DeviceUpdateMode()
+{
+    std::lock_guard<std::mutex> lock(MembersMutex);
+
+    for(std::size_t member_idx = 0; member_idx < members.size(); member_idx++)
+    {
+        members[member_idx].controller->SetCustomMode();
+        members[member_idx].controller->UpdateMode();
+    }
+}
@@ -0,0 +1,94 @@
+/*---------------------------------------------------------*\
+| RGBController_Virtual.h                                   |
+|                                                           |
+|   Virtual RGBController that combines LEDs from several   |
+|   physical controllers into a single zone                 |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#pragma once
+
+#include <mutex>
+#include "RGBController.h"
+
+/*---------------------------------------------------------*\
+| Virtual LED Run                                           |
+|   A contiguous block of virtual LEDs that maps onto a     |
+|   contiguous block of a member controller's LEDs.  The    |
+|   member side is resolved again for every frame, so it    |
+|   follows zone resizes on the member.                     |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    unsigned int            range_idx;      /* Range the run came from  */
+    unsigned int            virtual_start;  /* First virtual LED        */
+    unsigned int            virtual_count;  /* Virtual LEDs in run      */
+    unsigned int            member_start;   /* First member LED         */
+    unsigned int            count;          /* Number of LEDs in run    */
+} virtual_led_run;
+
+/*---------------------------------------------------------*\
+| Virtual Member                                            |
+|   A member controller and the runs of virtual LEDs that   |
+|   are sent to it                                          |
+\*---------------------------------------------------------*/
+typedef struct
+{
+    RGBController*                  controller;
+    std::vector<virtual_led_run>    runs;
+} virtual_member;
+
+class RGBController_Virtual : public RGBController
+{
+public:
+    RGBController_Virtual(std::string virtual_name, zone_type virtual_type, unsigned int virtual_width, unsigned int virtual_height);
+    ~RGBController_Virtual();
+
+    void        AddMember(RGBController* controller, int member_zone, unsigned int member_start, unsigned int count, unsigned int x, unsigned int y);
+    void        AddMatrixMember(RGBController* controller, unsigned int member_zone, unsigned int x, unsigned int y);
+    void        RemoveMember(RGBController* controller);
+
+    void        SetupZones();
+
+    void        ResizeZone(int zone, int new_size);
+
+    void        DeviceUpdateLEDs();
+    void        UpdateZoneLEDs(int zone);
+    void        UpdateSingleLED(int led);
+
+    void        DeviceUpdateMode();
+
+private:
+    /*-----------------------------------------------------*\
+    | A member LED range as it was added.  member_start is  |
+    | relative to member_zone, or to the whole device when  |
+    | member_zone is -1.  Matrix members place the member   |
+    | zone's matrix map at (x, y), other ranges fill row y  |
+    | from column x.                                        |
+    \*-----------------------------------------------------*/
+    typedef struct
+    {
+        RGBController*      controller;
+        int                 member_zone;
+        unsigned int        member_start;
+        unsigned int        count;
+        unsigned int        x;
+        unsigned int        y;
+        bool                matrix;
+    } virtual_range;
+
+    zone_type                       virtual_zone_type;
+    unsigned int                    matrix_width;
+    unsigned int                    matrix_height;
+    std::vector<virtual_range>      ranges;
+    std::vector<unsigned int>       matrix_map_data;
+    matrix_map_type                 virtual_matrix_map;
+
+    std::mutex                      MembersMutex;
+    std::vector<virtual_member>     members;
+    std::vector<RGBController*>     member_controllers;
+
+    void        ResolveRange(const virtual_range& range, unsigned int& start, unsigned int& count);
+};
@@ -22,7 +22,10 @@
 #include "cli.h"
 #include "pci_ids/pci_ids.h"
 #include "ResourceManager.h"
+#include "EffectsEngine.h"
 #include "ProfileManager.h"
+#include "RGBController_Virtual.h"
+#include "RGBControllerIdleMonitor.h"
 #include "LogManager.h"
 #include "SettingsManager.h"
 #include "NetworkClient.h"
@@ -183,18 +186,58 @@ ResourceManager::ResourceManager()
         server->SetLegacyWorkaroundEnable(true);
     }
 
+    /*-----------------------------------------------------*\
+    | Limit the number of connected clients if configured   |
+    \*-----------------------------------------------------*/
+    if(server_settings.contains("max_clients"))
+    {
+        server->SetMaxClients(server_settings["max_clients"]);
+    }
+
     /*-----------------------------------------------------*\
     | Load sizes list from file                             |
     \*-----------------------------------------------------*/
     profile_manager         = new ProfileManager(GetConfigurationDirectory());
     server->SetProfileManager(profile_manager);
     rgb_controllers_sizes   = profile_manager->LoadProfileToList("sizes", true);
+
+    /*-----------------------------------------------------*\
+    | Initialize the software effects engine.  Its thread   |
+    | is only started once an effect is running             |
+    \*-----------------------------------------------------*/
+    json effects_settings   = settings_manager->GetSettings("EffectsEngine");
+
+    effects_engine          = new EffectsEngine();
+
+    if(effects_settings.contains("frame_rate") && effects_settings["frame_rate"].is_number_unsigned())
+    {
+        effects_engine->SetFrameRate(effects_settings["frame_rate"]);
+    }
+
+    /*-----------------------------------------------------*\
+    | Create the idle monitor before any device threads can |
+    | use it and apply its idle timeout, where 0 disables   |
+    | the idle state                                        |
+    \*-----------------------------------------------------*/
+    RGBControllerIdleMonitor* idle_monitor  = RGBControllerIdleMonitor::get();
+    json                      idle_settings = settings_manager->GetSettings("IdleMonitor");
+
+    if(idle_settings.contains("idle_timeout_ms") && idle_settings["idle_timeout_ms"].is_number_unsigned())
+    {
+        idle_monitor->SetIdleTimeout(idle_settings["idle_timeout_ms"]);
+    }
 }
 
 ResourceManager::~ResourceManager()
 {
     Cleanup();
 
+    /*-----------------------------------------------------*\
+    | Stop the effects engine                               |
+    \*-----------------------------------------------------*/
+    delete effects_engine;
+    effects_engine = nullptr;
+
     /*-----------------------------------------------------*\
     | Mark the background detection thread as not running   |
     | and then wake it up so it knows that it has to stop   |
@@ -233,6 +276,13 @@ void ResourceManager::RegisterRGBController(RGBController *rgb_controller)
     rgb_controller->flags |= CONTROLLER_FLAG_LOCAL;
 
     LOG_INFO("[%s] Registering RGB controller", rgb_controller->GetName().c_str());
+
+    /*-----------------------------------------------------*\
+    | Apply per-controller settings such as the frame rate  |
+    | limit before the controller is used                   |
+    \*-----------------------------------------------------*/
+    LoadControllerSettings(rgb_controller);
+
     rgb_controllers_hw.push_back(rgb_controller);
 
     /*-----------------------------------------------------*\
@@ -262,10 +312,346 @@ void ResourceManager::RegisterRGBController(RGBController *rgb_controller)
     UpdateDeviceList();
 }
 
+void ResourceManager::LoadControllerSettings(RGBController *rgb_controller)
+{
+    json controller_settings = settings_manager->GetSettings("RGBControllerSettings");
+
+    if(!controller_settings.contains("devices"))
+    {
+        return;
+    }
+
+    for(unsigned int device_idx = 0; device_idx < controller_settings["devices"].size(); device_idx++)
+    {
+        json& device_settings = controller_settings["devices"][device_idx];
+
+        /*-------------------------------------------------*\
+        | Each entry may match on name, location, and       |
+        | serial.  Fields left out of an entry match any    |
+        | controller.                                       |
+        \*-------------------------------------------------*/
+        if(device_settings.contains("name") && device_settings["name"] != rgb_controller->GetName())
+        {
+            continue;
+        }
+
+        if(device_settings.contains("location") && device_settings["location"] != rgb_controller->GetLocation())
+        {
+            continue;
+        }
+
+        if(device_settings.contains("serial") && device_settings["serial"] != rgb_controller->GetSerial())
+        {
+            continue;
+        }
+
+        if(device_settings.contains("max_fps") && device_settings["max_fps"].is_number_unsigned())
+        {
+            unsigned int max_fps = device_settings["max_fps"];
+
+            LOG_INFO("[%s] Limiting updates to %u frames per second", rgb_controller->GetName().c_str(), max_fps);
+
+            rgb_controller->SetFrameRateLimit(max_fps);
+        }
+
+        /*-------------------------------------------------*\
+        | Color correction fields not given in the entry    |
+        | keep their current values                         |
+        \*-------------------------------------------------*/
+        if(device_settings.contains("gamma")
+        || device_settings.contains("red_gain")
+        || device_settings.contains("green_gain")
+        || device_settings.contains("blue_gain")
+        || device_settings.contains("brightness"))
+        {
+            color_correction correction = rgb_controller->GetColorCorrection();
+
+            if(device_settings.contains("gamma") && device_settings["gamma"].is_number())
+            {
+                correction.gamma = device_settings["gamma"];
+            }
+
+            if(device_settings.contains("red_gain") && device_settings["red_gain"].is_number())
+            {
+                correction.red_gain = device_settings["red_gain"];
+            }
+
+            if(device_settings.contains("green_gain") && device_settings["green_gain"].is_number())
+            {
+                correction.green_gain = device_settings["green_gain"];
+            }
+
+            if(device_settings.contains("blue_gain") && device_settings["blue_gain"].is_number())
+            {
+                correction.blue_gain = device_settings["blue_gain"];
+            }
+
+            if(device_settings.contains("brightness")
+            && device_settings["brightness"].is_number_unsigned()
+            && (device_settings["brightness"] <= 255))
+            {
+                correction.brightness = device_settings["brightness"];
+            }
+
+            LOG_INFO("[%s] Applying color correction", rgb_controller->GetName().c_str());
+
+            rgb_controller->SetColorCorrection(correction);
+        }
+    }
+}
+
+void ResourceManager::LoadEffectsSettings()
+{
+    json effects_settings = settings_manager->GetSettings("EffectsEngine");
+
+    if(!effects_settings.contains("effects") || !effects_settings["effects"].is_array())
+    {
+        return;
+    }
+
+    for(std::size_t controller_idx = 0; controller_idx < rgb_controllers_hw.size(); controller_idx++)
+    {
+        RGBController* rgb_controller = rgb_controllers_hw[controller_idx];
+
+        for(unsigned int effect_idx = 0; effect_idx < effects_settings["effects"].size(); effect_idx++)
+        {
+            json& effect_entry = effects_settings["effects"][effect_idx];
+
+            /*---------------------------------------------*\
+            | Entries match on name, location, and serial   |
+            | the same way as RGBControllerSettings         |
+            \*---------------------------------------------*/
+            if(effect_entry.contains("name") && effect_entry["name"] != rgb_controller->GetName())
+            {
+                continue;
+            }
+
+            if(effect_entry.contains("location") && effect_entry["location"] != rgb_controller->GetLocation())
+            {
+                continue;
+            }
+
+            if(effect_entry.contains("serial") && effect_entry["serial"] != rgb_controller->GetSerial())
+            {
+                continue;
+            }
+
+            if(!effect_entry.contains("effect") || !effect_entry["effect"].is_string())
+            {
+                continue;
+            }
+
+            effect_settings settings;
+
+            settings.effect = EffectsEngine::GetEffectType(effect_entry["effect"]);
+            settings.speed  = EFFECTS_ENGINE_DEFAULT_SPEED;
+
+            if(effect_entry.contains("speed") && effect_entry["speed"].is_number_unsigned())
+            {
+                settings.speed = effect_entry["speed"];
+            }
+
+            if(effect_entry.contains("colors") && effect_entry["colors"].is_array())
+            {
+                for(unsigned int color_idx = 0; color_idx < effect_entry["colors"].size(); color_idx++)
+                {
+                    if(effect_entry["colors"][color_idx].is_number_unsigned())
+                    {
+                        settings.colors.push_back(effect_entry["colors"][color_idx]);
+                    }
+                }
+            }
+
+            effects_engine->SetEffect(rgb_controller, settings);
+            break;
+        }
+    }
+}
+
+void ResourceManager::LoadVirtualControllers()
+{
+    json virtual_settings = settings_manager->GetSettings("VirtualControllers");
+
+    if(!virtual_settings.contains("devices") || !virtual_settings["devices"].is_array() || (rgb_controllers_virtual.size() > 0))
+    {
+        return;
+    }
+
+    for(unsigned int virtual_idx = 0; virtual_idx < virtual_settings["devices"].size(); virtual_idx++)
+    {
+        json&           virtual_entry   = virtual_settings["devices"][virtual_idx];
+        std::string     virtual_name    = "Virtual Device";
+        zone_type       virtual_type    = ZONE_TYPE_LINEAR;
+        unsigned int    virtual_width   = 0;
+        unsigned int    virtual_height  = 0;
+
+        if(virtual_entry.contains("name") && virtual_entry["name"].is_string())
+        {
+            virtual_name = virtual_entry["name"];
+        }
+
+        if(virtual_entry.contains("type") && virtual_entry["type"] == "matrix")
+        {
+            virtual_type = ZONE_TYPE_MATRIX;
+        }
+
+        if(virtual_entry.contains("width") && virtual_entry["width"].is_number_unsigned())
+        {
+            virtual_width = virtual_entry["width"];
+        }
+
+        if(virtual_entry.contains("height") && virtual_entry["height"].is_number_unsigned())
+        {
+            virtual_height = virtual_entry["height"];
+        }
+
+        if(!virtual_entry.contains("members") || !virtual_entry["members"].is_array())
+        {
+            continue;
+        }
+
+        RGBController_Virtual* virtual_controller = new RGBController_Virtual(virtual_name, virtual_type, virtual_width, virtual_height);
+        bool                   member_found       = false;
+
+        for(unsigned int member_idx = 0; member_idx < virtual_entry["members"].size(); member_idx++)
+        {
+            json&           member_entry    = virtual_entry["members"][member_idx];
+            RGBController*  member          = NULL;
+
+            /*---------------------------------------------*\
+            | Members match on name, location, and serial   |
+            | the same way as RGBControllerSettings         |
+            \*---------------------------------------------*/
+            for(std::size_t controller_idx = 0; controller_idx < rgb_controllers_hw.size(); controller_idx++)
+            {
+                RGBController* rgb_controller = rgb_controllers_hw[controller_idx];
+
+                if((rgb_controller->type == DEVICE_TYPE_VIRTUAL)
+                || (member_entry.contains("name") && member_entry["name"] != rgb_controller->GetName())
+                || (member_entry.contains("location") && member_entry["location"] != rgb_controller->GetLocation())
+                || (member_entry.contains("serial") && member_entry["serial"] != rgb_controller->GetSerial()))
+                {
+                    continue;
+                }
+
+                member = rgb_controller;
+                break;
+            }
+
+            if(member == NULL)
+            {
+                LOG_WARNING("[ResourceManager] Virtual controller %s: member %u not found", virtual_name.c_str(), member_idx);
+                continue;
+            }
+
+            /*---------------------------------------------*\
+            | A member may be limited to one zone by name,  |
+            | and to a range of LEDs within the zone or     |
+            | device with start and count                   |
+            \*---------------------------------------------*/
+            unsigned int    range_count     = (unsigned int)member->leds.size();
+            int             member_zone     = -1;
+            unsigned int    x               = 0;
+            unsigned int    y               = 0;
+
+            if(member_entry.contains("zone"))
+            {
+                for(std::size_t zone_idx = 0; zone_idx < member->zones.size(); zone_idx++)
+                {
+                    if(member_entry["zone"] == member->zones[zone_idx].name)
+                    {
+                        member_zone = (int)zone_idx;
+                        range_count = member->zones[zone_idx].leds_count;
+                        break;
+                    }
+                }
+
+                if(member_zone < 0)
+                {
+                    LOG_WARNING("[ResourceManager] Virtual controller %s: zone not found on %s", virtual_name.c_str(), member->GetName().c_str());
+                    continue;
+                }
+            }
+
+            if(member_entry.contains("x") && member_entry["x"].is_number_unsigned())
+            {
+                x = member_entry["x"];
+            }
+
+            if(member_entry.contains("y") && member_entry["y"].is_number_unsigned())
+            {
+                y = member_entry["y"];
+            }
+
+            if((virtual_type == ZONE_TYPE_MATRIX)
+            && (member_zone >= 0)
+            && (member->zones[member_zone].type == ZONE_TYPE_MATRIX)
+            && (member->zones[member_zone].matrix_map != NULL)
+            && !member_entry.contains("start")
+            && !member_entry.contains("count"))
+            {
+                virtual_controller->AddMatrixMember(member, (unsigned int)member_zone, x, y);
+            }
+            else
+            {
+                unsigned int start = 0;
+                unsigned int count = 0xFFFFFFFF;
+
+                if(member_entry.contains("start") && member_entry["start"].is_number_unsigned())
+                {
+                    start = member_entry["start"];
+                }
+
+                if(start >= range_count)
+                {
+                    continue;
+                }
+
+                if(member_entry.contains("count") && member_entry["count"].is_number_unsigned())
+                {
+                    count = member_entry["count"];
+                }
+
+                virtual_controller->AddMember(member, member_zone, start, count, x, y);
+            }
+
+            member_found = true;
+        }
+
+        if(!member_found)
+        {
+            LOG_WARNING("[ResourceManager] Virtual controller %s has no members, skipping", virtual_name.c_str());
+            delete virtual_controller;
+            continue;
+        }
+
+        virtual_controller->SetupZones();
+
+        rgb_controllers_virtual.push_back(virtual_controller);
+
+        RegisterRGBController(virtual_controller);
+    }
+}
+
 void ResourceManager::UnregisterRGBController(RGBController* rgb_controller)
 {
     LOG_INFO("[%s] Unregistering RGB controller", rgb_controller->GetName().c_str());
 
+    /*-----------------------------------------------------*\
+    | Stop any software effect before the controller goes   |
+    | away                                                  |
+    \*-----------------------------------------------------*/
+    effects_engine->ClearEffect(rgb_controller);
+
+    /*-----------------------------------------------------*\
+    | Remove the controller from any virtual controllers    |
+    | that send frames to it                                |
+    \*-----------------------------------------------------*/
+    for(std::size_t virtual_idx = 0; virtual_idx < rgb_controllers_virtual.size(); virtual_idx++)
+    {
+        rgb_controllers_virtual[virtual_idx]->RemoveMember(rgb_controller);
+    }
+
     /*-----------------------------------------------------*\
     | Clear callbacks from the controller before removal    |
     \*-----------------------------------------------------*/
@@ -301,6 +687,89 @@ std::vector<RGBController*> & ResourceManager::GetRGBControllers()
     return rgb_controllers;
 }
 
+/*---------------------------------------------------------*\
+| CommitFrameGroup                                          |
+|   Publish the current colors of every controller in the   |
+|   group so that the device writes finish together.        |
+|   Controllers from an SDK client are sent to their server |
+|   in one grouped packet per client, which the server      |
+|   commits as a group of its own.                          |
+\*---------------------------------------------------------*/
+void ResourceManager::CommitFrameGroup(std::vector<RGBController*>& controllers)
+{
+    ClientListMutex.lock();
+
+    if(clients.empty())
+    {
+        ClientListMutex.unlock();
+
+        CommitLocalFrameGroup(controllers);
+        return;
+    }
+
+    std::vector<RGBController*> local_controllers = controllers;
+
+    for(std::size_t client_idx = 0; client_idx < clients.size(); client_idx++)
+    {
+        clients[client_idx]->UpdateLEDsGroup(local_controllers, true);
+    }
+
+    ClientListMutex.unlock();
+
+    CommitLocalFrameGroup(local_controllers);
+}
+
+/*---------------------------------------------------------*\
+| CommitLocalFrameGroup                                     |
+|   Each controller's measured median write time is used as |
+|   its transport latency.  The common deadline leaves room |
+|   for the slowest device, and each frame is released that |
+|   far ahead of the deadline.                              |
+|   The local histograms are read directly, as the network  |
+|   controller's GetLatencyStats() override returns the     |
+|   server's statistics, which leave out sending to the     |
+|   server.                                                 |
+\*---------------------------------------------------------*/
+void ResourceManager::CommitLocalFrameGroup(std::vector<RGBController*>& controllers)
+{
+    std::vector<unsigned int> write_latencies(controllers.size());
+    unsigned int              max_latency = 0;
+
+    for(std::size_t controller_idx = 0; controller_idx < controllers.size(); controller_idx++)
+    {
+        std::vector<latency_stats> stats = controllers[controller_idx]->RGBController::GetLatencyStats();
+
+        if(stats.size() > LATENCY_STAGE_WRITE)
+        {
+            write_latencies[controller_idx] = stats[LATENCY_STAGE_WRITE].p50;
+        }
+
+        max_latency = std::max(max_latency, write_latencies[controller_idx]);
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+                                                   + std::chrono::microseconds(FRAME_GROUP_MARGIN_US + max_latency);
+
+    for(std::size_t controller_idx = 0; controller_idx < controllers.size(); controller_idx++)
+    {
+        controllers[controller_idx]->UpdateLEDsAt(deadline - std::chrono::microseconds(write_latencies[controller_idx]));
+    }
+}
+
+/*---------------------------------------------------------*\
+| ReopenDevices                                             |
+|   Ask every hardware controller to reopen its device and  |
+|   restore its last mode and frame, such as after a system |
+|   resume.  Controllers that cannot reopen ignore this.    |
+\*---------------------------------------------------------*/
+void ResourceManager::ReopenDevices()
+{
+    for(std::size_t controller_idx = 0; controller_idx < rgb_controllers_hw.size(); controller_idx++)
+    {
+        rgb_controllers_hw[controller_idx]->RequestReopen();
+    }
+}
+
 void ResourceManager::RegisterI2CBusDetector(I2CBusDetectorFunction detector)
 {
     i2c_bus_detectors.push_back(detector);
@@ -698,6 +1167,11 @@ NetworkServer* ResourceManager::GetServer()
     return(server);
 }
 
+EffectsEngine* ResourceManager::GetEffectsEngine()
+{
+    return(effects_engine);
+}
+
 static void NetworkClientInfoChangeCallback(void* this_ptr)
 {
     ResourceManager* this_obj = (ResourceManager*)this_ptr;
@@ -710,25 +1184,20 @@ void ResourceManager::RegisterNetworkClient(NetworkClient* new_client)
 {
     new_client->RegisterClientInfoChangeCallback(NetworkClientInfoChangeCallback, this);
 
+    ClientListMutex.lock();
     clients.push_back(new_client);
+    ClientListMutex.unlock();
 }
 
 void ResourceManager::UnregisterNetworkClient(NetworkClient* network_client)
 {
-    /*-----------------------------------------------------*\
-    | Stop the disconnecting client                         |
-    \*-----------------------------------------------------*/
-    network_client->StopClient();
-
-    /*-----------------------------------------------------*\
-    | Clear callbacks from the client before removal        |
-    \*-----------------------------------------------------*/
-    network_client->ClearCallbacks();
-
     /*-----------------------------------------------------*\
     | Find the client to remove and remove it from the      |
-    | clients list                                          |
+    | clients list first, so that frame group commits stop  |
+    | sending to it                                         |
     \*-----------------------------------------------------*/
+    ClientListMutex.lock();
+
     std::vector<NetworkClient*>::iterator client_it = std::find(clients.begin(), clients.end(), network_client);
 
     if(client_it != clients.end())
@@ -736,6 +1205,18 @@ void ResourceManager::UnregisterNetworkClient(NetworkClient* network_client)
         clients.erase(client_it);
     }
 
+    ClientListMutex.unlock();
+
+    /*-----------------------------------------------------*\
+    | Stop the disconnecting client                         |
+    \*-----------------------------------------------------*/
+    network_client->StopClient();
+
+    /*-----------------------------------------------------*\
+    | Clear callbacks from the client before removal        |
+    \*-----------------------------------------------------*/
+    network_client->ClearCallbacks();
+
     /*-----------------------------------------------------*\
     | Delete the client                                     |
     \*-----------------------------------------------------*/
@@ -848,6 +1329,28 @@ void ResourceManager::Cleanup()
 {
     ResourceManager::get()->WaitForDeviceDetection();
 
+    /*-----------------------------------------------------*\
+    | Stop all software effects before the hardware         |
+    | controllers are deleted                               |
+    \*-----------------------------------------------------*/
+    effects_engine->ClearEffects();
+
+    /*-----------------------------------------------------*\
+    | Delete virtual controllers before the controllers     |
+    | they send frames to                                   |
+    \*-----------------------------------------------------*/
+    for(std::size_t virtual_idx = 0; virtual_idx < rgb_controllers_virtual.size(); virtual_idx++)
+    {
+        RGBController* virtual_controller = rgb_controllers_virtual[virtual_idx];
+
+        rgb_controllers_hw.erase(std::remove(rgb_controllers_hw.begin(), rgb_controllers_hw.end(), virtual_controller), rgb_controllers_hw.end());
+        rgb_controllers.erase(std::remove(rgb_controllers.begin(), rgb_controllers.end(), virtual_controller), rgb_controllers.end());
+
+        delete virtual_controller;
+    }
+
+    rgb_controllers_virtual.clear();
+
     std::vector<RGBController *> rgb_controllers_hw_copy = rgb_controllers_hw;
 
     for(std::size_t hw_controller_idx = 0; hw_controller_idx < rgb_controllers_hw.size(); hw_controller_idx++)
@@ -1030,6 +1533,13 @@ void ResourceManager::ProcessPostDetection()
     detection_percent     = 100;
     DetectionProgressChanged();
 
+    /*-----------------------------------------------------*\
+    | Create virtual controllers from the detected devices  |
+    | and start any software effects configured in settings |
+    \*-----------------------------------------------------*/
+    LoadVirtualControllers();
+    LoadEffectsSettings();
+
     LOG_INFO("[ResourceManager] Calling Post-detection callbacks");
     /*-----------------------------------------------------*\
     | Call detection end callbacks                          |
@@ -32,11 +32,19 @@ using json = nlohmann::json;
 #define HID_USAGE_ANY       -1
 #define HID_USAGE_PAGE_ANY  -1
 
+/*---------------------------------------------------------*\
+| Scheduling margin added to a frame group's deadline so    |
+| that every device thread can wake before its release time |
+\*---------------------------------------------------------*/
+#define FRAME_GROUP_MARGIN_US   1000
+
 struct hid_device_info;
+class EffectsEngine;
 class NetworkClient;
 class NetworkServer;
 class ProfileManager;
 class RGBController;
+class RGBController_Virtual;
 class SettingsManager;
 
 typedef std::function<bool()>                                                                       I2CBusDetectorFunction;
@@ -119,6 +127,10 @@ public:
 
     std::vector<RGBController*> & GetRGBControllers();
 
+    void CommitFrameGroup(std::vector<RGBController*>& controllers);
+    void CommitLocalFrameGroup(std::vector<RGBController*>& controllers);
+    void ReopenDevices();
+
     void RegisterI2CBusDetector         (I2CBusDetectorFunction     detector);
     void RegisterDeviceDetector         (std::string name, DeviceDetectorFunction     detector);
     void RegisterI2CDeviceDetector      (std::string name, I2CDeviceDetectorFunction  detector);
@@ -167,6 +179,8 @@ public:
     std::vector<NetworkClient*>&    GetClients();
     NetworkServer*                  GetServer();
 
+    EffectsEngine*                  GetEffectsEngine();
+
     ProfileManager*                 GetProfileManager();
     SettingsManager*                GetSettingsManager();
 
@@ -202,6 +216,9 @@ private:
     bool ProcessPreDetection();
     void ProcessPostDetection();
     bool IsAnyDimmDetectorEnabled(json &detector_settings);
+    void LoadControllerSettings(RGBController *rgb_controller);
+    void LoadEffectsSettings();
+    void LoadVirtualControllers();
     void RunInBackgroundThread(std::function<void()>);
     void BackgroundThreadFunction();
 
@@ -275,15 +292,22 @@ private:
     std::vector<RGBController*>                 rgb_controllers_sizes;
     std::vector<RGBController*>                 rgb_controllers_hw;
     std::vector<RGBController*>                 rgb_controllers;
+    std::vector<RGBController_Virtual*>         rgb_controllers_virtual;
 
     /*-----------------------------------------------------*\
     | Network Server                                        |
     \*-----------------------------------------------------*/
     NetworkServer*                              server;
 
+    /*-----------------------------------------------------*\
+    | Software Effects Engine                               |
+    \*-----------------------------------------------------*/
+    EffectsEngine*                              effects_engine;
+
     /*-----------------------------------------------------*\
     | Network Clients                                       |
     \*-----------------------------------------------------*/
+    std::mutex                                  ClientListMutex;
     std::vector<NetworkClient*>                 clients;
 
     /*-----------------------------------------------------*\
@@ -65,4 +65,12 @@ public:
 
 protected:
     virtual                                    ~ResourceManagerInterface() {};
+
+public:
+    /*---------------------------------------------------------*\
+    | Functions added in plugin API version 5, appended after   |
+    | the destructor to keep the existing entries in place      |
+    \*---------------------------------------------------------*/
+    virtual void                                CommitFrameGroup(std::vector<RGBController*>& controllers)                                          = 0;
+    virtual void                                ReopenDevices()                                                                                     = 0;
 };
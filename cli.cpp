@@ -13,6 +13,7 @@
 #include <tuple>
 #include <iostream>
 #include "AutoStart.h"
+#include "EffectsEngine.h"
 #include "filesystem.h"
 #include "ProfileManager.h"
 #include "ResourceManager.h"
@@ -59,6 +60,7 @@ struct DeviceOptions
     int             zone            = -1;
     std::vector<std::tuple<unsigned char, unsigned char, unsigned char>> colors;
     std::string     mode;
+    std::string     effect;
     unsigned int    speed           = 100;
     unsigned int    brightness      = 100;
     unsigned int    size;
@@ -401,6 +403,8 @@ void OptionHelp()
     help_text += "--server-host                            Sets the SDK's server host. Default: 0.0.0.0 (all network interfaces)\n";
     help_text += "--server-port                            Sets the SDK's server port. Default: 6742 (1024-65535)\n";
     help_text += "-l,  --list-devices                      Lists every compatible device with their number\n";
+    help_text += "--latency-stats                          Prints frame counts and update latency statistics for every device\n";
+    help_text += "--idle-stats                             Prints the idle state and thread wakeup rates of this instance and connected servers\n";
     help_text += "-d,  --device [0-9 | \"name\"]             Selects device to apply colors and/or effect to, or applies to all devices if omitted\n";
     help_text += "                                           Basic string search is implemented 3 characters or more\n";
     help_text += "                                           Can be specified multiple times with different modes and colors\n";
@@ -409,6 +413,8 @@ void OptionHelp()
     help_text += "-c,  --color [random | FFFFF,00AAFF ...] Sets colors on each device directly if no effect is specified, and sets the effect color if an effect is specified\n";
     help_text += "                                           If there are more LEDs than colors given, the last color will be applied to the remaining LEDs\n";
     help_text += "-m,  --mode [breathing | static | ...]   Sets the mode to be applied, check --list-devices to see which modes are supported on your device\n";
+    help_text += "-e,  --effect [rainbow_wave | ...]       Runs a software effect (rainbow_wave, breathing, spectrum_cycle, gradient_scroll) in the OpenRGB process\n";
+    help_text += "                                           Uses --color and --speed, and runs until OpenRGB exits. Combine with --server for headless effects\n";
     help_text += "-b,  --brightness [0-100]                Sets the brightness as a percentage if the mode supports brightness\n";
     help_text += "-s, --speed [0-100]                      Sets the speed as a percentage if the mode supports speed\n";
     help_text += "-sz,  --size [0-N]                       Sets the new size of the specified device zone.\n";
@@ -748,6 +754,52 @@ bool OptionMode(std::vector<DeviceOptions>* current_devices, std::string argumen
     return found;
 }
 
+bool OptionEffect(std::vector<DeviceOptions>* current_devices, std::string argument, Options* options)
+{
+    if(argument.size() == 0)
+    {
+        std::cout << "Error: --effect passed with no argument" << std::endl;
+        return false;
+    }
+
+    if(EffectsEngine::GetEffectType(argument) == EFFECT_NONE && argument != "none")
+    {
+        std::cout << "Error: Unknown effect \"" << argument << "\"" << std::endl;
+        return false;
+    }
+
+    /*---------------------------------------------------------*\
+    | If a device is not selected  i.e. size() == 0             |
+    |   then add effect to allDeviceOptions                     |
+    \*---------------------------------------------------------*/
+    bool found                      = false;
+    DeviceOptions* currentDevOpts   = &options->allDeviceOptions;
+
+    if(current_devices->size() == 0)
+    {
+        currentDevOpts->effect = argument;
+        currentDevOpts->hasOption = true;
+        found = true;
+    }
+    else
+    {
+        for(size_t i = 0; i < current_devices->size(); i++)
+        {
+            currentDevOpts = &current_devices->at(i);
+
+            currentDevOpts->effect = argument;
+            currentDevOpts->hasOption = true;
+            found = true;
+        }
+    }
+
+    if(!found)
+    {
+        std::cout << "Error: No devices for effect \"" << argument << "\"" << std::endl;
+    }
+    return found;
+}
+
 bool OptionSpeed(std::vector<DeviceOptions>* current_devices, std::string argument, Options* options)
 {
     if(argument.size() == 0)
@@ -916,6 +968,102 @@ bool OptionSaveProfile(std::string argument)
     return(true);
 }
 
+void OptionLatencyStats(std::vector<RGBController *>& rgb_controllers)
+{
+    const char* stage_names[LATENCY_STAGE_COUNT] =
+    {
+        "  Queue:          ",
+        "  Write:          ",
+        "  Total:          ",
+    };
+
+    ResourceManager::get()->WaitForDeviceDetection();
+
+    for(std::size_t controller_idx = 0; controller_idx < rgb_controllers.size(); controller_idx++)
+    {
+        RGBController *controller = rgb_controllers[controller_idx];
+
+        /*---------------------------------------------------------*\
+        | Print device name                                         |
+        \*---------------------------------------------------------*/
+        std::cout << controller_idx << ": " << controller->GetName() << std::endl;
+
+        /*---------------------------------------------------------*\
+        | Print frame counters                                      |
+        \*---------------------------------------------------------*/
+        std::cout << "  Frames:         " << controller->GetFramesRequested()   << " requested, "
+                                          << controller->GetFramesTransmitted() << " transmitted, "
+                                          << controller->GetFramesDropped()     << " dropped" << std::endl;
+
+        /*---------------------------------------------------------*\
+        | Print latency statistics for each stage, in microseconds  |
+        \*---------------------------------------------------------*/
+        std::vector<latency_stats> stats = controller->GetLatencyStats();
+
+        for(std::size_t stage_idx = 0; (stage_idx < stats.size()) && (stage_idx < LATENCY_STAGE_COUNT); stage_idx++)
+        {
+            std::cout << stage_names[stage_idx] << stats[stage_idx].count << " samples, "
+                      << "p50 "  << stats[stage_idx].p50  << " us, "
+                      << "p99 "  << stats[stage_idx].p99  << " us, "
+                      << "max "  << stats[stage_idx].max  << " us, "
+                      << "mean " << stats[stage_idx].mean << " us" << std::endl;
+        }
+
+        std::cout << std::endl;
+    }
+}
+
+void PrintIdleStats(const idle_stats& stats)
+{
+    const char* source_names[IDLE_WAKEUP_SOURCE_COUNT] =
+    {
+        "  Device threads: ",
+        "  Keepalives:     ",
+        "  SDK:            ",
+    };
+
+    std::cout << "  Idle:           " << (stats.idle ? "yes" : "no") << ", "
+                                      << stats.static_time_ms  << " ms static, "
+                                      << stats.idle_timeout_ms << " ms timeout" << std::endl;
+
+    for(std::size_t source_idx = 0; source_idx < IDLE_WAKEUP_SOURCE_COUNT; source_idx++)
+    {
+        std::cout << source_names[source_idx] << stats.wakeups[source_idx] << " wakeups, "
+                  << stats.wakeups_per_sec[source_idx] << " wakeups/sec" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+void OptionIdleStats()
+{
+    ResourceManager::get()->WaitForDeviceDetection();
+
+    /*---------------------------------------------------------*\
+    | Print statistics of this instance                         |
+    \*---------------------------------------------------------*/
+    std::cout << "Local" << std::endl;
+
+    PrintIdleStats(RGBControllerIdleMonitor::get()->GetStats());
+
+    /*---------------------------------------------------------*\
+    | Print statistics of each connected server                 |
+    \*---------------------------------------------------------*/
+    std::vector<NetworkClient*>& clients = ResourceManager::get()->GetClients();
+
+    for(std::size_t client_idx = 0; client_idx < clients.size(); client_idx++)
+    {
+        if(!clients[client_idx]->GetOnline())
+        {
+            continue;
+        }
+
+        std::cout << clients[client_idx]->GetIP() << ":" << clients[client_idx]->GetPort() << std::endl;
+
+        PrintIdleStats(clients[client_idx]->GetServerIdleStats());
+    }
+}
+
 int ProcessOptions(Options* options, std::vector<RGBController *>& rgb_controllers)
 {
     unsigned int ret_flags  = 0;
@@ -958,6 +1106,24 @@ int ProcessOptions(Options* options, std::vector<RGBController *>& rgb_controlle
             exit(0);
         }
 
+        /*---------------------------------------------------------*\
+        | --latency-stats (no arguments)                            |
+        \*---------------------------------------------------------*/
+        else if(option == "--latency-stats")
+        {
+            OptionLatencyStats(rgb_controllers);
+            exit(0);
+        }
+
+        /*---------------------------------------------------------*\
+        | --idle-stats (no arguments)                               |
+        \*---------------------------------------------------------*/
+        else if(option == "--idle-stats")
+        {
+            OptionIdleStats();
+            exit(0);
+        }
+
         /*---------------------------------------------------------*\
         | -d / --device                                             |
         \*---------------------------------------------------------*/
@@ -1016,6 +1182,19 @@ int ProcessOptions(Options* options, std::vector<RGBController *>& rgb_controlle
             arg_index++;
         }
 
+        /*---------------------------------------------------------*\
+        | -e / --effect                                             |
+        \*---------------------------------------------------------*/
+        else if(option == "--effect" || option == "-e")
+        {
+            if(!OptionEffect(&current_devices, argument, options))
+            {
+                return RET_FLAG_PRINT_HELP;
+            }
+
+            arg_index++;
+        }
+
         /*---------------------------------------------------------*\
         | -b / --brightness                                         |
         \*---------------------------------------------------------*/
@@ -1159,6 +1338,29 @@ void ApplyOptions(DeviceOptions& options, std::vector<RGBController *>& rgb_cont
 {
     RGBController* device = rgb_controllers[options.device];
 
+    /*---------------------------------------------------------*\
+    | If a software effect is given, hand the device to the     |
+    | effects engine instead of setting a hardware mode.  The   |
+    | speed percentage maps to 1-120 effect cycles per minute   |
+    \*---------------------------------------------------------*/
+    if(options.effect != "")
+    {
+        effect_settings settings;
+
+        settings.effect = EffectsEngine::GetEffectType(options.effect);
+        settings.speed  = std::max(1U, (options.speed * 120) / speed_percentage);
+
+        for(std::size_t color_idx = 0; color_idx < options.colors.size(); color_idx++)
+        {
+            settings.colors.push_back(ToRGBColor(std::get<0>(options.colors[color_idx]),
+                                                 std::get<1>(options.colors[color_idx]),
+                                                 std::get<2>(options.colors[color_idx])));
+        }
+
+        ResourceManager::get()->GetEffectsEngine()->SetEffect(device, settings);
+        return;
+    }
+
     /*---------------------------------------------------------*\
     | Set mode first, in case it's 'direct' (which affects      |
     | SetLED below)                                             |
@@ -17,6 +17,7 @@
 #include <sys/ioctl.h>
 #include <netinet/tcp.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #endif
 #include <memory.h>
 #include <errno.h>
@@ -391,3 +392,170 @@ int net_port::tcp_write(char * buffer, int length)
     }
     return(ret);
 }
+
+int net_send_buffers(SOCKET sock, const char * buffers[], const int lengths[], int count, int flags)
+{
+    int total = 0;
+    int sent  = 0;
+
+    if(count > NET_SEND_MAX_BUFFERS)
+    {
+        return(-1);
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        total += lengths[i];
+    }
+
+#ifdef WIN32
+    /*-----------------------------------------------------*\
+    | WSASend on a blocking socket only completes once all  |
+    | buffers have been sent                                |
+    \*-----------------------------------------------------*/
+    WSABUF  wsa_buffers[NET_SEND_MAX_BUFFERS];
+    DWORD   bytes_sent = 0;
+
+    (void)flags;
+
+    for(int i = 0; i < count; i++)
+    {
+        wsa_buffers[i].buf = (char *)buffers[i];
+        wsa_buffers[i].len = (ULONG)lengths[i];
+    }
+
+    if(WSASend(sock, wsa_buffers, (DWORD)count, &bytes_sent, 0, NULL, NULL) == SOCKET_ERROR)
+    {
+        return(-1);
+    }
+
+    sent = (int)bytes_sent;
+#else
+    struct iovec    iov[NET_SEND_MAX_BUFFERS];
+    struct msghdr   msg;
+    int             iov_idx = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        iov[i].iov_base = (void *)buffers[i];
+        iov[i].iov_len  = (size_t)lengths[i];
+    }
+
+    /*-----------------------------------------------------*\
+    | A blocking sendmsg can still return early if it is    |
+    | interrupted, so continue from where it stopped        |
+    \*-----------------------------------------------------*/
+    while(sent < total)
+    {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov     = &iov[iov_idx];
+        msg.msg_iovlen  = count - iov_idx;
+
+        ssize_t result  = sendmsg(sock, &msg, flags);
+
+        if(result < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+
+            return(-1);
+        }
+
+        sent += (int)result;
+
+        /*-------------------------------------------------*\
+        | Skip the buffers that were sent completely and    |
+        | advance into the one that was sent partially      |
+        \*-------------------------------------------------*/
+        while(iov_idx < count && (size_t)result >= iov[iov_idx].iov_len)
+        {
+            result -= (ssize_t)iov[iov_idx].iov_len;
+            iov_idx++;
+        }
+
+        if(iov_idx < count)
+        {
+            iov[iov_idx].iov_base = (char *)iov[iov_idx].iov_base + result;
+            iov[iov_idx].iov_len -= (size_t)result;
+        }
+    }
+#endif
+
+    return(sent);
+}
+
+bool net_socket_pair(SOCKET socks[2])
+{
+#ifdef WIN32
+    SOCKET              listener;
+    struct sockaddr_in  addr;
+    int                 addr_len = sizeof(addr);
+
+    socks[0] = INVALID_SOCKET;
+    socks[1] = INVALID_SOCKET;
+
+    listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+    if(listener == INVALID_SOCKET)
+    {
+        return(false);
+    }
+
+    /*-----------------------------------------------------*\
+    | Listen on an ephemeral loopback port and connect to   |
+    | it, keeping both ends of the connection               |
+    \*-----------------------------------------------------*/
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    addr.sin_port           = 0;
+
+    if((bind(listener, (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR)
+    || (getsockname(listener, (struct sockaddr *)&addr, &addr_len) == SOCKET_ERROR)
+    || (listen(listener, 1) == SOCKET_ERROR))
+    {
+        closesocket(listener);
+        return(false);
+    }
+
+    socks[0] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+    if((socks[0] == INVALID_SOCKET)
+    || (connect(socks[0], (struct sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR))
+    {
+        closesocket(listener);
+        closesocket(socks[0]);
+        socks[0] = INVALID_SOCKET;
+        return(false);
+    }
+
+    socks[1] = accept(listener, NULL, NULL);
+
+    closesocket(listener);
+
+    if(socks[1] == INVALID_SOCKET)
+    {
+        closesocket(socks[0]);
+        socks[0] = INVALID_SOCKET;
+        return(false);
+    }
+
+    return(true);
+#else
+    int fds[2];
+
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+    {
+        socks[0] = INVALID_SOCKET;
+        socks[1] = INVALID_SOCKET;
+        return(false);
+    }
+
+    socks[0] = fds[0];
+    socks[1] = fds[1];
+
+    return(true);
+#endif
+}
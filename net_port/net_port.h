@@ -95,3 +95,21 @@ private:
     sockaddr addrDest;
     addrinfo*   result_list;
 };
+
+/*---------------------------------------------------------*\
+| Most buffers accepted by net_send_buffers()               |
+\*---------------------------------------------------------*/
+#define NET_SEND_MAX_BUFFERS    4
+
+//Function to send several buffers on a blocking socket with a
+//single vectored send, so that a packet header and its data go
+//out together instead of as separate writes (and, with
+//TCP_NODELAY set, separate TCP segments).  Returns the number of
+//bytes sent, or -1 on error
+int net_send_buffers(SOCKET sock, const char * buffers[], const int lengths[], int count, int flags);
+
+//Function to create a pair of connected stream sockets, such as to
+//wake a thread waiting in select() or epoll from another thread.
+//Windows has no socketpair(), so a loopback TCP connection is used
+//there.  Returns false on error
+bool net_socket_pair(SOCKET socks[2]);
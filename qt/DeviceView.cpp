@@ -1089,6 +1089,17 @@ void DeviceView::setSelectionColor(RGBColor color)
             controller->SetLED(led_idx, color);
         }
     }
-    controller->UpdateLEDs();
+
+    /*-----------------------------------------------------*\
+    | A single selected LED can be sent on its own          |
+    \*-----------------------------------------------------*/
+    if(selectedLeds.size() == 1)
+    {
+        controller->QueueSingleLED(selectedLeds[0]);
+    }
+    else
+    {
+        controller->UpdateLEDs();
+    }
     update();
 }
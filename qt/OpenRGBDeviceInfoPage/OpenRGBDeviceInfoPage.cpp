@@ -62,6 +62,24 @@ OpenRGBDeviceInfoPage::OpenRGBDeviceInfoPage(RGBController *dev, QWidget *parent
         flags_string   += "Reset Before Update";
         need_separator  = true;
     }
+    if(dev->flags & CONTROLLER_FLAG_PRIVATE_THREAD)
+    {
+        if(need_separator)
+        {
+            flags_string += ", ";
+        }
+        flags_string   += "Private Update Thread";
+        need_separator  = true;
+    }
+    if(dev->flags & CONTROLLER_FLAG_DIRTY_TRACKING)
+    {
+        if(need_separator)
+        {
+            flags_string += ", ";
+        }
+        flags_string   += "Dirty Tracking";
+        need_separator  = true;
+    }
 
     ui->FlagsValue->setText(QString::fromStdString(flags_string));
 }
@@ -1225,6 +1225,12 @@ void OpenRGBDialog::OnSuspend()
 
 void OpenRGBDialog::OnResume()
 {
+    /*-----------------------------------------------------*\
+    | Devices may have dropped off the bus while suspended, |
+    | so reopen them and restore their last state first     |
+    \*-----------------------------------------------------*/
+    ResourceManager::get()->ReopenDevices();
+
     if(SelectConfigProfile("resume_profile"))
     {
         on_ButtonLoadProfile_clicked();
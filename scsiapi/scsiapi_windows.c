@@ -225,7 +225,7 @@ int scsi_write(struct scsi_device * dev, const unsigned char * data, size_t data
     /*-----------------------------------------------------*\
     | Send pass through command                             |
     \*-----------------------------------------------------*/
-    DeviceIoControl(dev->fd, IOCTL_SCSI_PASS_THROUGH_DIRECT, command, buffer_length, command, buffer_length, NULL, NULL);
+    BOOL result = DeviceIoControl(dev->fd, IOCTL_SCSI_PASS_THROUGH_DIRECT, command, buffer_length, command, buffer_length, NULL, NULL);
 
     /*-----------------------------------------------------*\
     | Copy sense data out of buffer                         |
@@ -236,7 +236,8 @@ int scsi_write(struct scsi_device * dev, const unsigned char * data, size_t data
     | Free the buffer                                       |
     \*-----------------------------------------------------*/
     free(buffer);
-    return 0;
+
+    return(result ? 0 : -1);
 }
 #ifdef __cplusplus
 }
@@ -0,0 +1,425 @@
+/*---------------------------------------------------------*\
+| EncodedColorDescriptionTest.cpp                           |
+|                                                           |
+|   Round trips encoded color descriptions between two      |
+|   controllers and checks that malformed descriptions are  |
+|   rejected without changing any color                     |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "RGBController_Dummy.h"
+
+/*---------------------------------------------------------*\
+| Size of the description header (data size and number of   |
+| runs) and of each run header (start, length, and type)    |
+\*---------------------------------------------------------*/
+#define ENCODED_HEADER_SIZE     8
+#define RUN_HEADER_SIZE         7
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char* description)
+{
+    if(!ok)
+    {
+        printf("FAIL %s\n", description);
+        failures++;
+    }
+}
+
+static void SetupController(RGBController_Dummy& controller, unsigned int num_leds)
+{
+    zone new_zone;
+
+    new_zone.name       = "Linear";
+    new_zone.type       = ZONE_TYPE_LINEAR;
+    new_zone.leds_min   = num_leds;
+    new_zone.leds_max   = num_leds;
+    new_zone.leds_count = num_leds;
+    new_zone.matrix_map = NULL;
+
+    controller.zones.push_back(new_zone);
+
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        led new_led;
+
+        new_led.name  = "LED " + std::to_string(led_idx);
+        new_led.value = led_idx;
+
+        controller.leds.push_back(new_led);
+    }
+
+    controller.SetupColors();
+}
+
+/*---------------------------------------------------------*\
+| Encoded colors carry 3 bytes per LED, so test colors      |
+| leave the top byte clear                                  |
+\*---------------------------------------------------------*/
+static RGBColor RandomColor(std::mt19937& rng)
+{
+    return((RGBColor)(rng() & 0x00FFFFFF));
+}
+
+/*---------------------------------------------------------*\
+| Encode the sender's colors against the reference, apply   |
+| them to the receiver, and check that both match           |
+\*---------------------------------------------------------*/
+static std::vector<unsigned char> RoundTrip(RGBController_Dummy& sender, RGBController_Dummy& receiver, std::vector<RGBColor>& reference, const char* description)
+{
+    std::vector<unsigned char>  data;
+    unsigned int                size = sender.GetEncodedColorDescription(data, reference);
+
+    Check(size == data.size(), description);
+    Check(receiver.SetEncodedColorDescription(data.data(), size), description);
+    Check(receiver.colors == sender.colors, description);
+    Check(reference == sender.colors, description);
+
+    return(data);
+}
+
+static unsigned int GetNumRuns(const std::vector<unsigned char>& data)
+{
+    unsigned int num_runs = 0;
+
+    memcpy(&num_runs, &data[sizeof(unsigned int)], sizeof(num_runs));
+
+    return(num_runs);
+}
+
+static void TestRoundTrip()
+{
+    const unsigned int          num_leds = 300;
+    std::mt19937                rng(1);
+    RGBController_Dummy         sender;
+    RGBController_Dummy         receiver;
+    std::vector<RGBColor>       reference;
+    std::vector<unsigned char>  data;
+
+    SetupController(sender, num_leds);
+    SetupController(receiver, num_leds);
+
+    /*-----------------------------------------------------*\
+    | An empty reference sends every LED                    |
+    \*-----------------------------------------------------*/
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        sender.colors[led_idx] = RandomColor(rng);
+    }
+
+    RoundTrip(sender, receiver, reference, "round trip: full frame");
+
+    /*-----------------------------------------------------*\
+    | An unchanged frame has no runs                        |
+    \*-----------------------------------------------------*/
+    data = RoundTrip(sender, receiver, reference, "round trip: unchanged frame");
+
+    Check((data.size() == ENCODED_HEADER_SIZE) && (GetNumRuns(data) == 0), "round trip: unchanged frame has no runs");
+
+    /*-----------------------------------------------------*\
+    | A single changed LED is one literal run               |
+    \*-----------------------------------------------------*/
+    sender.colors[150] ^= 0x00010101;
+
+    data = RoundTrip(sender, receiver, reference, "round trip: single LED");
+
+    Check((data.size() == (ENCODED_HEADER_SIZE + RUN_HEADER_SIZE + 3)) && (GetNumRuns(data) == 1), "round trip: single LED is one run");
+
+    /*-----------------------------------------------------*\
+    | Changes separated by short gaps share a run, longer   |
+    | gaps start a new one                                  |
+    \*-----------------------------------------------------*/
+    sender.colors[10] ^= 0x00FF0000;
+    sender.colors[10 + COLOR_RUN_MAX_GAP + 1] ^= 0x00FF0000;
+
+    data = RoundTrip(sender, receiver, reference, "round trip: short gap");
+
+    Check(GetNumRuns(data) == 1, "round trip: short gap is merged");
+
+    sender.colors[20] ^= 0x0000FF00;
+    sender.colors[20 + COLOR_RUN_MAX_GAP + 2] ^= 0x0000FF00;
+
+    data = RoundTrip(sender, receiver, reference, "round trip: long gap");
+
+    Check(GetNumRuns(data) == 2, "round trip: long gap is split");
+
+    /*-----------------------------------------------------*\
+    | Repeated colors are sent as a fill run                |
+    \*-----------------------------------------------------*/
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        sender.colors[led_idx] = ToRGBColor(0x12, 0x34, 0x56);
+    }
+
+    data = RoundTrip(sender, receiver, reference, "round trip: solid color");
+
+    Check(data.size() == (ENCODED_HEADER_SIZE + RUN_HEADER_SIZE + 3), "round trip: solid color is one fill run");
+
+    /*-----------------------------------------------------*\
+    | Random frames with a mix of scattered changes,        |
+    | repeated colors, and unchanged stretches              |
+    \*-----------------------------------------------------*/
+    for(unsigned int frame_idx = 0; frame_idx < 500; frame_idx++)
+    {
+        unsigned int num_changes = rng() % 20;
+
+        for(unsigned int change_idx = 0; change_idx < num_changes; change_idx++)
+        {
+            unsigned int start  = rng() % num_leds;
+            unsigned int length = 1 + (rng() % 12);
+            bool         fill   = (rng() % 2) == 0;
+            RGBColor     color  = RandomColor(rng);
+
+            for(unsigned int led_idx = start; (led_idx < (start + length)) && (led_idx < num_leds); led_idx++)
+            {
+                sender.colors[led_idx] = fill ? color : RandomColor(rng);
+            }
+        }
+
+        RoundTrip(sender, receiver, reference, "round trip: random frame");
+    }
+
+    /*-----------------------------------------------------*\
+    | A reference of the wrong size sends every LED again   |
+    \*-----------------------------------------------------*/
+    reference.resize(num_leds - 1);
+
+    data = RoundTrip(sender, receiver, reference, "round trip: resized reference");
+}
+
+/*---------------------------------------------------------*\
+| Runs longer than COLOR_RUN_MAX_LENGTH are split           |
+\*---------------------------------------------------------*/
+static void TestLongRuns()
+{
+    const unsigned int          num_leds = COLOR_RUN_MAX_LENGTH + 5000;
+    std::mt19937                rng(2);
+    RGBController_Dummy         sender;
+    RGBController_Dummy         receiver;
+    std::vector<RGBColor>       reference;
+
+    SetupController(sender, num_leds);
+    SetupController(receiver, num_leds);
+
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        sender.colors[led_idx] = RandomColor(rng);
+    }
+
+    std::vector<unsigned char> data = RoundTrip(sender, receiver, reference, "long runs: literal");
+
+    Check(GetNumRuns(data) == 2, "long runs: literal run is split");
+
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        sender.colors[led_idx] = ToRGBColor(0xAB, 0xCD, 0xEF);
+    }
+
+    data = RoundTrip(sender, receiver, reference, "long runs: fill");
+
+    Check(GetNumRuns(data) == 2, "long runs: fill run is split");
+}
+
+/*---------------------------------------------------------*\
+| Build a description from raw runs.  Each run is a start,  |
+| a length, a type, and the number of color values to       |
+| append after its header.                                  |
+\*---------------------------------------------------------*/
+struct raw_run
+{
+    unsigned int    start;
+    unsigned short  length;
+    unsigned char   type;
+    unsigned int    num_values;
+};
+
+static std::vector<unsigned char> BuildDescription(const std::vector<raw_run>& runs)
+{
+    std::vector<unsigned char> data(ENCODED_HEADER_SIZE);
+
+    for(std::size_t run_idx = 0; run_idx < runs.size(); run_idx++)
+    {
+        unsigned char header[RUN_HEADER_SIZE];
+
+        memcpy(&header[0], &runs[run_idx].start, sizeof(runs[run_idx].start));
+        memcpy(&header[4], &runs[run_idx].length, sizeof(runs[run_idx].length));
+        header[6] = runs[run_idx].type;
+
+        data.insert(data.end(), header, header + RUN_HEADER_SIZE);
+        data.insert(data.end(), runs[run_idx].num_values * 3, 0x7F);
+    }
+
+    unsigned int data_size = (unsigned int)data.size();
+    unsigned int num_runs  = (unsigned int)runs.size();
+
+    memcpy(&data[0], &data_size, sizeof(data_size));
+    memcpy(&data[sizeof(data_size)], &num_runs, sizeof(num_runs));
+
+    return(data);
+}
+
+/*---------------------------------------------------------*\
+| Apply a description that must be rejected and check that  |
+| no color changed                                          |
+\*---------------------------------------------------------*/
+static void CheckRejected(RGBController_Dummy& receiver, unsigned char* data, unsigned int data_size, const char* description)
+{
+    std::vector<RGBColor> before = receiver.colors;
+
+    Check(!receiver.SetEncodedColorDescription(data, data_size), description);
+    Check(receiver.colors == before, description);
+}
+
+static void TestMalformed()
+{
+    const unsigned int      num_leds = 100;
+    std::mt19937            rng(3);
+    RGBController_Dummy     sender;
+    RGBController_Dummy     receiver;
+    std::vector<RGBColor>   reference;
+
+    SetupController(sender, num_leds);
+    SetupController(receiver, num_leds);
+
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        sender.colors[led_idx] = RandomColor(rng);
+    }
+
+    std::vector<unsigned char> valid;
+
+    sender.GetEncodedColorDescription(valid, reference);
+
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        receiver.colors[led_idx] = 0x00010203;
+    }
+
+    /*-----------------------------------------------------*\
+    | Too short for the header, and a data size that does   |
+    | not match the packet                                  |
+    \*-----------------------------------------------------*/
+    CheckRejected(receiver, valid.data(), 0, "malformed: empty");
+    CheckRejected(receiver, valid.data(), ENCODED_HEADER_SIZE - 1, "malformed: short header");
+    CheckRejected(receiver, valid.data(), (unsigned int)valid.size() - 1, "malformed: size mismatch");
+
+    /*-----------------------------------------------------*\
+    | Every truncation with a matching data size, so only   |
+    | the runs themselves show the damage                   |
+    \*-----------------------------------------------------*/
+    bool truncation_rejected = true;
+
+    for(unsigned int size = ENCODED_HEADER_SIZE; size < valid.size(); size++)
+    {
+        std::vector<unsigned char>  truncated(valid.begin(), valid.begin() + size);
+        std::vector<RGBColor>       before = receiver.colors;
+
+        memcpy(&truncated[0], &size, sizeof(size));
+
+        if(receiver.SetEncodedColorDescription(truncated.data(), size) || (receiver.colors != before))
+        {
+            truncation_rejected = false;
+        }
+    }
+
+    Check(truncation_rejected, "malformed: every truncation rejected");
+
+    /*-----------------------------------------------------*\
+    | Bad run headers                                       |
+    \*-----------------------------------------------------*/
+    std::vector<unsigned char> data;
+
+    data = BuildDescription({ { 0, 1, 2, 1 } });
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: unknown run type");
+
+    data = BuildDescription({ { num_leds + 1, 0, COLOR_RUN_LITERAL, 0 } });
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: start past the end");
+
+    data = BuildDescription({ { num_leds - 1, 2, COLOR_RUN_LITERAL, 2 } });
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: run past the end");
+
+    data = BuildDescription({ { 0xFFFFFFFF, 2, COLOR_RUN_FILL, 1 } });
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: start wraps around");
+
+    data = BuildDescription({ { 0, num_leds + 1, COLOR_RUN_FILL, 1 } });
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: fill longer than the device");
+
+    data = BuildDescription({ { 0, 10, COLOR_RUN_LITERAL, 9 } });
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: literal run missing a color");
+
+    /*-----------------------------------------------------*\
+    | A valid run followed by a bad one changes nothing     |
+    \*-----------------------------------------------------*/
+    data = BuildDescription({ { 0, 10, COLOR_RUN_LITERAL, 10 }, { 50, 0xFFFF, COLOR_RUN_FILL, 1 } });
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: bad second run");
+
+    /*-----------------------------------------------------*\
+    | A run count larger than the data                      |
+    \*-----------------------------------------------------*/
+    data = BuildDescription({ { 0, 1, COLOR_RUN_FILL, 1 } });
+
+    unsigned int num_runs = 0xFFFFFFFF;
+
+    memcpy(&data[sizeof(unsigned int)], &num_runs, sizeof(num_runs));
+    CheckRejected(receiver, data.data(), (unsigned int)data.size(), "malformed: too many runs");
+
+    /*-----------------------------------------------------*\
+    | Edge cases that are valid                             |
+    \*-----------------------------------------------------*/
+    data = BuildDescription({ { num_leds, 0, COLOR_RUN_LITERAL, 0 } });
+    Check(receiver.SetEncodedColorDescription(data.data(), (unsigned int)data.size()), "valid: empty run at the end");
+
+    data = BuildDescription({ { 0, num_leds, COLOR_RUN_FILL, 1 } });
+    Check(receiver.SetEncodedColorDescription(data.data(), (unsigned int)data.size()), "valid: fill of every LED");
+    Check(receiver.colors[num_leds - 1] == ToRGBColor(0x7F, 0x7F, 0x7F), "valid: fill applied");
+
+    /*-----------------------------------------------------*\
+    | Random corruption of valid descriptions is either     |
+    | applied or rejected as a whole                        |
+    \*-----------------------------------------------------*/
+    bool corruption_ok = true;
+
+    for(unsigned int trial_idx = 0; trial_idx < 20000; trial_idx++)
+    {
+        std::vector<unsigned char>  corrupted = valid;
+        unsigned int                num_flips = 1 + (rng() % 4);
+
+        for(unsigned int flip_idx = 0; flip_idx < num_flips; flip_idx++)
+        {
+            corrupted[rng() % corrupted.size()] ^= (unsigned char)(1 << (rng() % 8));
+        }
+
+        std::vector<RGBColor> before = receiver.colors;
+
+        if(!receiver.SetEncodedColorDescription(corrupted.data(), (unsigned int)corrupted.size()) && (receiver.colors != before))
+        {
+            corruption_ok = false;
+        }
+    }
+
+    Check(corruption_ok, "malformed: rejected corruption changes nothing");
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestLongRuns();
+    TestMalformed();
+
+    if(failures > 0)
+    {
+        printf("%u failures\n", failures);
+        return(1);
+    }
+
+    printf("PASS encoded color descriptions\n");
+
+    return(0);
+}
@@ -0,0 +1,12 @@
+#-----------------------------------------------------------------------------------------------#
+# EncodedColorDescriptionTest QMake Project                                                     #
+#                                                                                               #
+#   Round trips encoded color descriptions and checks malformed ones are rejected               #
+#-----------------------------------------------------------------------------------------------#
+include(../tests.pri)
+
+TARGET      = EncodedColorDescriptionTest
+
+SOURCES +=                                                                                      \
+    EncodedColorDescriptionTest.cpp                                                             \
+    $$RGBCONTROLLER_SOURCES                                                                     \
@@ -0,0 +1,359 @@
+/*---------------------------------------------------------*\
+| NetPacketReaderTest.cpp                                   |
+|                                                           |
+|   Checks NetPacketReader with pipelined, fragmented,      |
+|   oversized, and malformed SDK packet streams             |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "NetworkProtocol.h"
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char* description)
+{
+    if(!ok)
+    {
+        printf("FAIL %s\n", description);
+        failures++;
+    }
+}
+
+/*---------------------------------------------------------*\
+| Append a packet with the given ID and data to a stream    |
+\*---------------------------------------------------------*/
+static void AppendPacket(std::vector<char>& stream, unsigned int pkt_id, const std::vector<char>& data)
+{
+    NetPacketHeader header;
+
+    InitNetPacketHeader(&header, 0, pkt_id, (unsigned int)data.size());
+
+    stream.insert(stream.end(), (char*)&header, (char*)&header + sizeof(header));
+    stream.insert(stream.end(), data.begin(), data.end());
+}
+
+static std::vector<char> MakeData(unsigned int size, unsigned int seed)
+{
+    std::vector<char> data(size);
+
+    for(unsigned int byte_idx = 0; byte_idx < size; byte_idx++)
+    {
+        data[byte_idx] = (char)((byte_idx * 31) + seed);
+    }
+
+    return(data);
+}
+
+/*---------------------------------------------------------*\
+| Pass bytes to the reader as a socket would, at most       |
+| max_chunk bytes per receive call                          |
+\*---------------------------------------------------------*/
+static void Feed(NetPacketReader& reader, const char* bytes, std::size_t count, std::size_t max_chunk)
+{
+    std::size_t fed = 0;
+
+    while(fed < count)
+    {
+        unsigned int    free_size   = 0;
+        char*           buffer      = reader.GetReceiveBuffer(&free_size);
+        std::size_t     chunk       = std::min(std::min((std::size_t)free_size, max_chunk), count - fed);
+
+        memcpy(buffer, bytes + fed, chunk);
+        reader.Received((unsigned int)chunk);
+
+        fed += chunk;
+    }
+}
+
+static void TestPipelined()
+{
+    NetPacketReader     reader;
+    std::vector<char>   stream;
+    std::vector<char>   data_a = MakeData(5, 1);
+    std::vector<char>   data_b = MakeData(100, 2);
+
+    AppendPacket(stream, 10, std::vector<char>());
+    AppendPacket(stream, 11, data_a);
+    AppendPacket(stream, 12, data_b);
+
+    Feed(reader, stream.data(), stream.size(), stream.size());
+
+    NetPacketHeader header;
+    char*           data_0 = (char*)1;
+    char*           data_1 = NULL;
+    char*           data_2 = NULL;
+
+    Check(reader.NextPacket(&header, &data_0) == NET_PACKET_READY, "pipelined: first packet ready");
+    Check((header.pkt_id == 10) && (header.pkt_size == 0) && (data_0 == NULL), "pipelined: empty packet has no data");
+
+    Check(reader.NextPacket(&header, &data_1) == NET_PACKET_READY, "pipelined: second packet ready");
+    Check((header.pkt_id == 11) && (header.pkt_size == 5), "pipelined: second header");
+
+    Check(reader.NextPacket(&header, &data_2) == NET_PACKET_READY, "pipelined: third packet ready");
+    Check((header.pkt_id == 12) && (header.pkt_size == 100), "pipelined: third header");
+
+    /*-----------------------------------------------------*\
+    | All data stays valid until the next receive           |
+    \*-----------------------------------------------------*/
+    Check(memcmp(data_1, data_a.data(), data_a.size()) == 0, "pipelined: second data intact");
+    Check(memcmp(data_2, data_b.data(), data_b.size()) == 0, "pipelined: third data intact");
+
+    Check(reader.NextPacket(&header, &data_0) == NET_PACKET_INCOMPLETE, "pipelined: nothing left");
+}
+
+static void TestByteAtATime()
+{
+    NetPacketReader     reader;
+    std::vector<char>   stream;
+    std::vector<char>   data = MakeData(1000, 3);
+
+    AppendPacket(stream, 20, data);
+
+    NetPacketHeader header;
+    char*           packet_data = NULL;
+    bool            early_ready = false;
+
+    for(std::size_t byte_idx = 0; byte_idx < (stream.size() - 1); byte_idx++)
+    {
+        Feed(reader, &stream[byte_idx], 1, 1);
+
+        if(reader.NextPacket(&header, &packet_data) != NET_PACKET_INCOMPLETE)
+        {
+            early_ready = true;
+        }
+    }
+
+    Check(!early_ready, "byte at a time: incomplete until the last byte");
+
+    Feed(reader, &stream[stream.size() - 1], 1, 1);
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_READY, "byte at a time: ready after the last byte");
+    Check((header.pkt_id == 20) && (memcmp(packet_data, data.data(), data.size()) == 0), "byte at a time: data intact");
+}
+
+static void TestResync()
+{
+    NetPacketReader     reader;
+    std::vector<char>   data = MakeData(8, 4);
+    std::string         garbage = "xxORGxORxOxORGORG";
+    std::vector<char>   stream(garbage.begin(), garbage.end());
+
+    AppendPacket(stream, 30, data);
+
+    /*-----------------------------------------------------*\
+    | Garbage between two packets is skipped as well        |
+    \*-----------------------------------------------------*/
+    stream.insert(stream.end(), garbage.begin(), garbage.end());
+
+    AppendPacket(stream, 31, data);
+
+    Feed(reader, stream.data(), stream.size(), 7);
+
+    NetPacketHeader header;
+    char*           packet_data = NULL;
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_READY, "resync: packet after garbage ready");
+    Check((header.pkt_id == 30) && (memcmp(packet_data, data.data(), data.size()) == 0), "resync: first packet intact");
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_READY, "resync: packet after inner garbage ready");
+    Check(header.pkt_id == 31, "resync: second packet header");
+}
+
+static void TestPartialMagic()
+{
+    NetPacketReader     reader;
+    std::vector<char>   stream;
+    std::vector<char>   data = MakeData(16, 5);
+
+    AppendPacket(stream, 40, data);
+
+    NetPacketHeader header;
+    char*           packet_data = NULL;
+
+    /*-----------------------------------------------------*\
+    | A buffer ending in the start of the magic value must  |
+    | keep those bytes for the next receive                 |
+    \*-----------------------------------------------------*/
+    Feed(reader, "zzOR", 4, 4);
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_INCOMPLETE, "partial magic: incomplete");
+
+    Feed(reader, stream.data() + 2, stream.size() - 2, stream.size());
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_READY, "partial magic: ready after the rest");
+    Check((header.pkt_id == 40) && (memcmp(packet_data, data.data(), data.size()) == 0), "partial magic: data intact");
+}
+
+static void TestTruncatedHeader()
+{
+    NetPacketReader     reader;
+    std::vector<char>   stream;
+
+    AppendPacket(stream, 50, MakeData(4, 6));
+
+    NetPacketHeader header;
+    char*           packet_data = NULL;
+
+    Feed(reader, stream.data(), sizeof(NetPacketHeader) - 1, stream.size());
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_INCOMPLETE, "truncated header: incomplete");
+
+    Feed(reader, stream.data() + sizeof(NetPacketHeader) - 1, stream.size() - sizeof(NetPacketHeader) + 1, stream.size());
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_READY, "truncated header: ready after the rest");
+}
+
+static void TestTooLarge()
+{
+    NetPacketReader     reader;
+    NetPacketHeader     header;
+    char*               packet_data = NULL;
+
+    InitNetPacketHeader(&header, 0, 60, NET_PACKET_MAX_DATA_SIZE + 1);
+
+    Feed(reader, (char*)&header, sizeof(header), sizeof(header));
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_TOO_LARGE, "too large: rejected before the data arrives");
+
+    InitNetPacketHeader(&header, 0, 61, 0xFFFFFFFF);
+
+    reader.Reset();
+
+    Feed(reader, (char*)&header, sizeof(header), sizeof(header));
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_TOO_LARGE, "too large: maximum size rejected");
+
+    /*-----------------------------------------------------*\
+    | The reader is usable again after a reset              |
+    \*-----------------------------------------------------*/
+    std::vector<char> stream;
+
+    AppendPacket(stream, 62, MakeData(3, 7));
+
+    reader.Reset();
+
+    Feed(reader, stream.data(), stream.size(), stream.size());
+
+    Check((reader.NextPacket(&header, &packet_data) == NET_PACKET_READY) && (header.pkt_id == 62), "too large: reset reader reads again");
+}
+
+static void TestLargePacket()
+{
+    NetPacketReader     reader;
+    std::vector<char>   stream;
+    std::vector<char>   data = MakeData(1024 * 1024, 8);
+
+    AppendPacket(stream, 70, data);
+    AppendPacket(stream, 71, MakeData(10, 9));
+
+    unsigned int free_size = 0;
+
+    reader.GetReceiveBuffer(&free_size);
+
+    Check(free_size >= NET_PACKET_READER_CHUNK_SIZE, "large packet: receive buffer offers a whole chunk");
+
+    Feed(reader, stream.data(), stream.size(), 3000);
+
+    NetPacketHeader header;
+    char*           packet_data = NULL;
+
+    Check(reader.NextPacket(&header, &packet_data) == NET_PACKET_READY, "large packet: ready");
+    Check((header.pkt_id == 70) && (memcmp(packet_data, data.data(), data.size()) == 0), "large packet: data intact");
+    Check((reader.NextPacket(&header, &packet_data) == NET_PACKET_READY) && (header.pkt_id == 71), "large packet: following packet ready");
+}
+
+/*---------------------------------------------------------*\
+| A long stream of random packets and garbage delivered in  |
+| random chunk sizes, read as a server would after each     |
+| receive                                                   |
+\*---------------------------------------------------------*/
+static void TestRandomStream()
+{
+    NetPacketReader             reader;
+    std::mt19937                rng(1);
+    std::vector<char>           stream;
+    std::vector<unsigned int>   sizes;
+
+    for(unsigned int packet_idx = 0; packet_idx < 5000; packet_idx++)
+    {
+        unsigned int size = (rng() % 4) ? (rng() % 64) : (rng() % 70000);
+
+        if((rng() % 8) == 0)
+        {
+            /*---------------------------------------------*\
+            | Garbage without the letter O cannot look like |
+            | the start of a packet                         |
+            \*---------------------------------------------*/
+            unsigned int garbage_size = rng() % 16;
+
+            for(unsigned int byte_idx = 0; byte_idx < garbage_size; byte_idx++)
+            {
+                stream.push_back((char)('a' + (rng() % 14)));
+            }
+        }
+
+        AppendPacket(stream, packet_idx, MakeData(size, packet_idx));
+        sizes.push_back(size);
+    }
+
+    std::size_t     fed             = 0;
+    unsigned int    packets_read    = 0;
+    bool            in_order        = true;
+
+    while(fed < stream.size())
+    {
+        std::size_t chunk = std::min((std::size_t)(1 + (rng() % 20000)), stream.size() - fed);
+
+        Feed(reader, stream.data() + fed, chunk, chunk);
+        fed += chunk;
+
+        NetPacketHeader header;
+        char*           packet_data = NULL;
+
+        while(reader.NextPacket(&header, &packet_data) == NET_PACKET_READY)
+        {
+            std::vector<char> expected = MakeData(sizes[packets_read], packets_read);
+
+            if((header.pkt_id != packets_read)
+            || (header.pkt_size != sizes[packets_read])
+            || ((header.pkt_size > 0) && (memcmp(packet_data, expected.data(), expected.size()) != 0)))
+            {
+                in_order = false;
+            }
+
+            packets_read++;
+        }
+    }
+
+    Check(in_order, "random stream: every packet read in order and intact");
+    Check(packets_read == sizes.size(), "random stream: every packet read");
+}
+
+int main()
+{
+    TestPipelined();
+    TestByteAtATime();
+    TestResync();
+    TestPartialMagic();
+    TestTruncatedHeader();
+    TestTooLarge();
+    TestLargePacket();
+    TestRandomStream();
+
+    if(failures > 0)
+    {
+        printf("%u failures\n", failures);
+        return(1);
+    }
+
+    printf("PASS NetPacketReader\n");
+
+    return(0);
+}
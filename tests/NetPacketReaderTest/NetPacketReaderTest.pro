@@ -0,0 +1,12 @@
+#-----------------------------------------------------------------------------------------------#
+# NetPacketReaderTest QMake Project                                                             #
+#                                                                                               #
+#   Checks NetPacketReader with pipelined, fragmented, oversized, and malformed streams         #
+#-----------------------------------------------------------------------------------------------#
+include(../tests.pri)
+
+TARGET      = NetPacketReaderTest
+
+SOURCES +=                                                                                      \
+    NetPacketReaderTest.cpp                                                                     \
+    $$OPENRGB_ROOT/NetworkProtocol.cpp                                                          \
@@ -0,0 +1,613 @@
+/*---------------------------------------------------------*\
+| NetworkGroupUpdateTest.cpp                                |
+|                                                           |
+|   Round trips grouped LED updates from a NetworkClient to |
+|   a NetworkServer, and checks that malformed group        |
+|   packets disconnect the client without changing colors,  |
+|   that short plugin and segment packets are ignored, and  |
+|   that a blocking plugin request does not hold up others  |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+#include "NetworkClient.h"
+#include "NetworkServer.h"
+#include "RGBController_Dummy.h"
+
+/*---------------------------------------------------------*\
+| The server only listens on the loopback address, on a     |
+| port away from the default SDK port                       |
+\*---------------------------------------------------------*/
+#define TEST_SERVER_HOST    "127.0.0.1"
+#define TEST_SERVER_PORT    16742
+#define NUM_CONTROLLERS     3
+
+static const unsigned int controller_sizes[NUM_CONTROLLERS] = { 10, 300, 5000 };
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char* description)
+{
+    if(!ok)
+    {
+        printf("FAIL %s\n", description);
+        failures++;
+    }
+}
+
+static void SetupController(RGBController_Dummy& controller, unsigned int num_leds)
+{
+    mode new_mode;
+
+    new_mode.name       = "Direct";
+    new_mode.flags      = MODE_FLAG_HAS_PER_LED_COLOR;
+    new_mode.color_mode = MODE_COLORS_PER_LED;
+
+    controller.name = "Dummy " + std::to_string(num_leds);
+    controller.modes.push_back(new_mode);
+
+    zone new_zone;
+
+    new_zone.name       = "Linear";
+    new_zone.type       = ZONE_TYPE_LINEAR;
+    new_zone.leds_min   = num_leds;
+    new_zone.leds_max   = num_leds;
+    new_zone.leds_count = num_leds;
+    new_zone.matrix_map = NULL;
+
+    controller.zones.push_back(new_zone);
+
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        led new_led;
+
+        new_led.name  = "LED " + std::to_string(led_idx);
+        new_led.value = led_idx;
+
+        controller.leds.push_back(new_led);
+    }
+
+    controller.SetupColors();
+}
+
+/*---------------------------------------------------------*\
+| Encoded colors carry 3 bytes per LED, so test colors      |
+| leave the top byte clear                                  |
+\*---------------------------------------------------------*/
+static RGBColor RandomColor(std::mt19937& rng)
+{
+    return((RGBColor)(rng() & 0x00FFFFFF));
+}
+
+static bool WaitFor(std::function<bool()> condition)
+{
+    for(unsigned int wait_idx = 0; wait_idx < 1000; wait_idx++)
+    {
+        if(condition())
+        {
+            return(true);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return(false);
+}
+
+/*---------------------------------------------------------*\
+| A raw SDK connection for sending packets that the         |
+| NetworkClient would never send                            |
+\*---------------------------------------------------------*/
+class RawClient
+{
+public:
+    bool Connect(unsigned int protocol_version)
+    {
+        char port_string[16];
+
+        snprintf(port_string, sizeof(port_string), "%d", TEST_SERVER_PORT);
+
+        if(!port.tcp_client(TEST_SERVER_HOST, port_string) || !port.tcp_client_connect())
+        {
+            return(false);
+        }
+
+        port.set_receive_timeout(5, 0);
+
+        /*-------------------------------------------------*\
+        | Negotiate the protocol version                    |
+        \*-------------------------------------------------*/
+        Send(NET_PACKET_ID_REQUEST_PROTOCOL_VERSION, &protocol_version, sizeof(protocol_version));
+
+        return(ReadReply(NET_PACKET_ID_REQUEST_PROTOCOL_VERSION));
+    }
+
+    void Close()
+    {
+        port.tcp_close();
+    }
+
+    void Send(unsigned int pkt_id, const void* data, unsigned int size)
+    {
+        NetPacketHeader     header;
+        std::vector<char>   packet(sizeof(header) + size);
+
+        InitNetPacketHeader(&header, 0, pkt_id, size);
+
+        memcpy(packet.data(), &header, sizeof(header));
+
+        if(size > 0)
+        {
+            memcpy(packet.data() + sizeof(header), data, size);
+        }
+
+        port.tcp_client_write(packet.data(), (int)packet.size());
+    }
+
+    /*-----------------------------------------------------*\
+    | Requests are handled in order, so a protocol version  |
+    | reply means every earlier request has been applied    |
+    \*-----------------------------------------------------*/
+    bool Barrier()
+    {
+        unsigned int protocol_version = OPENRGB_SDK_PROTOCOL_VERSION;
+
+        Send(NET_PACKET_ID_REQUEST_PROTOCOL_VERSION, &protocol_version, sizeof(protocol_version));
+
+        return(ReadReply(NET_PACKET_ID_REQUEST_PROTOCOL_VERSION));
+    }
+
+    /*-----------------------------------------------------*\
+    | Returns true if the server closed the connection      |
+    \*-----------------------------------------------------*/
+    bool Closed()
+    {
+        char byte;
+
+        return(port.tcp_listen(&byte, 1) == 0);
+    }
+
+    /*-----------------------------------------------------*\
+    | Read the next reply and check its packet ID           |
+    \*-----------------------------------------------------*/
+    bool ReadReply(unsigned int pkt_id)
+    {
+        NetPacketHeader     header;
+        std::vector<char>   data;
+
+        if(!Read((char*)&header, sizeof(header)))
+        {
+            return(false);
+        }
+
+        data.resize(header.pkt_size);
+
+        return(Read(data.data(), header.pkt_size) && (header.pkt_id == pkt_id));
+    }
+
+private:
+    bool Read(char* buffer, unsigned int size)
+    {
+        unsigned int received = 0;
+
+        while(received < size)
+        {
+            int result = port.tcp_listen(buffer + received, (int)(size - received));
+
+            if(result <= 0)
+            {
+                return(false);
+            }
+
+            received += result;
+        }
+
+        return(true);
+    }
+
+    net_port port;
+};
+
+/*---------------------------------------------------------*\
+| Build a group packet from device indices and color        |
+| descriptions                                              |
+\*---------------------------------------------------------*/
+static std::vector<unsigned char> BuildGroup(unsigned int group_flags, const std::vector<unsigned int>& dev_idxs, const std::vector<std::vector<unsigned char>>& descriptions)
+{
+    std::vector<unsigned char>  data(3 * sizeof(unsigned int));
+    unsigned int                num_devices = (unsigned int)dev_idxs.size();
+
+    for(std::size_t device_idx = 0; device_idx < dev_idxs.size(); device_idx++)
+    {
+        const unsigned char* dev_idx = (const unsigned char*)&dev_idxs[device_idx];
+
+        data.insert(data.end(), dev_idx, dev_idx + sizeof(unsigned int));
+        data.insert(data.end(), descriptions[device_idx].begin(), descriptions[device_idx].end());
+    }
+
+    unsigned int data_size = (unsigned int)data.size();
+
+    memcpy(&data[0], &data_size, sizeof(data_size));
+    memcpy(&data[sizeof(data_size)], &group_flags, sizeof(group_flags));
+    memcpy(&data[2 * sizeof(data_size)], &num_devices, sizeof(num_devices));
+
+    return(data);
+}
+
+/*---------------------------------------------------------*\
+| Send random color changes to random subsets of the        |
+| client's controllers and check the server has them        |
+\*---------------------------------------------------------*/
+static void TestClientGroup(NetworkClient& client, RGBController_Dummy* server_devices)
+{
+    std::mt19937        rng(1);
+    RGBController_Dummy local_device;
+
+    SetupController(local_device, 4);
+
+    for(unsigned int round_idx = 0; round_idx < 20; round_idx++)
+    {
+        std::vector<RGBController*> group;
+        std::vector<RGBColor>       before[NUM_CONTROLLERS];
+        bool                        sent[NUM_CONTROLLERS];
+
+        for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+        {
+            RGBController* controller = client.server_controllers[controller_idx];
+
+            before[controller_idx] = server_devices[controller_idx].colors;
+            sent[controller_idx]   = (round_idx == 0) || (rng() % 2);
+
+            if(sent[controller_idx])
+            {
+                /*-----------------------------------------*\
+                | Change every LED in the first round, then |
+                | a few scattered LEDs and short runs       |
+                \*-----------------------------------------*/
+                unsigned int num_changes = (round_idx == 0) ? (unsigned int)controller->colors.size() : (1 + (rng() % 20));
+
+                for(unsigned int change_idx = 0; change_idx < num_changes; change_idx++)
+                {
+                    unsigned int led_idx = (round_idx == 0) ? change_idx : (unsigned int)(rng() % controller->colors.size());
+
+                    controller->colors[led_idx] = RandomColor(rng);
+                }
+
+                group.push_back(controller);
+            }
+        }
+
+        /*-------------------------------------------------*\
+        | A controller from another source stays in the     |
+        | group for the caller to update                    |
+        \*-------------------------------------------------*/
+        group.push_back(&local_device);
+
+        client.UpdateLEDsGroup(group, false);
+
+        Check((group.size() == 1) && (group[0] == &local_device), "client group: sent controllers removed from the group");
+
+        client.GetServerIdleStats();
+
+        for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+        {
+            RGBController* controller = client.server_controllers[controller_idx];
+
+            Check(server_devices[controller_idx].colors == controller->colors, "client group: server colors match the client");
+            Check(sent[controller_idx] || (server_devices[controller_idx].colors == before[controller_idx]), "client group: other controllers unchanged");
+        }
+    }
+}
+
+/*---------------------------------------------------------*\
+| Protocol 12 clients send plain color descriptions         |
+\*---------------------------------------------------------*/
+static void TestRawGroup(RGBController_Dummy* server_devices)
+{
+    RawClient           raw;
+    std::mt19937        rng(2);
+    RGBController_Dummy local_devices[NUM_CONTROLLERS];
+
+    Check(raw.Connect(12), "protocol 12 group: connected");
+
+    std::vector<unsigned int>               dev_idxs;
+    std::vector<std::vector<unsigned char>> descriptions;
+
+    for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+    {
+        SetupController(local_devices[controller_idx], controller_sizes[controller_idx]);
+
+        for(std::size_t led_idx = 0; led_idx < local_devices[controller_idx].colors.size(); led_idx++)
+        {
+            local_devices[controller_idx].colors[led_idx] = (RGBColor)rng();
+        }
+
+        std::vector<unsigned char> description;
+
+        local_devices[controller_idx].GetColorDescription(description, 12);
+
+        dev_idxs.push_back(controller_idx);
+        descriptions.push_back(description);
+    }
+
+    std::vector<unsigned char> group = BuildGroup(0, dev_idxs, descriptions);
+
+    raw.Send(NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSGROUP, group.data(), (unsigned int)group.size());
+
+    Check(raw.Barrier(), "protocol 12 group: connection kept");
+
+    for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+    {
+        Check(server_devices[controller_idx].colors == local_devices[controller_idx].colors, "protocol 12 group: server colors match");
+    }
+
+    raw.Close();
+}
+
+/*---------------------------------------------------------*\
+| Send one malformed group packet on a new connection and   |
+| check that the server disconnects without changing any    |
+| colors                                                    |
+\*---------------------------------------------------------*/
+static void CheckRejected(RGBController_Dummy* server_devices, unsigned int protocol_version, const std::vector<unsigned char>& group, const char* description)
+{
+    RawClient               raw;
+    std::vector<RGBColor>   before[NUM_CONTROLLERS];
+
+    for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+    {
+        before[controller_idx] = server_devices[controller_idx].colors;
+    }
+
+    Check(raw.Connect(protocol_version), description);
+
+    raw.Send(NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSGROUP, group.data(), (unsigned int)group.size());
+
+    Check(raw.Closed(), description);
+
+    for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+    {
+        Check(server_devices[controller_idx].colors == before[controller_idx], description);
+    }
+
+    raw.Close();
+}
+
+static void TestMalformedGroups(RGBController_Dummy* server_devices)
+{
+    RGBController_Dummy         small_device;
+    RGBController_Dummy         large_device;
+    std::vector<RGBColor>       reference;
+    std::vector<unsigned char>  plain;
+    std::vector<unsigned char>  encoded;
+    std::vector<unsigned char>  too_long;
+
+    SetupController(small_device, controller_sizes[0]);
+    SetupController(large_device, controller_sizes[2]);
+
+    for(std::size_t led_idx = 0; led_idx < small_device.colors.size(); led_idx++)
+    {
+        small_device.colors[led_idx] = 0x00123456;
+    }
+
+    for(std::size_t led_idx = 0; led_idx < large_device.colors.size(); led_idx++)
+    {
+        large_device.colors[led_idx] = 0x00654321;
+    }
+
+    small_device.GetColorDescription(plain, 12);
+    small_device.GetEncodedColorDescription(encoded, reference);
+
+    /*-----------------------------------------------------*\
+    | An encoded description of the large device has runs   |
+    | past the end of the small one                         |
+    \*-----------------------------------------------------*/
+    reference.clear();
+    large_device.GetEncodedColorDescription(too_long, reference);
+
+    std::vector<unsigned char> group;
+
+    group = BuildGroup(NET_UPDATELEDSGROUP_FLAG_ENCODED, { 0 }, { encoded });
+    group.resize(2 * sizeof(unsigned int));
+    CheckRejected(server_devices, 13, group, "malformed group: shorter than its header");
+
+    group = BuildGroup(NET_UPDATELEDSGROUP_FLAG_ENCODED, { 0 }, { encoded });
+    group[0]++;
+    CheckRejected(server_devices, 13, group, "malformed group: size does not match the packet");
+
+    group = BuildGroup(NET_UPDATELEDSGROUP_FLAG_ENCODED, { 0 }, { encoded });
+    group[2 * sizeof(unsigned int)] = 2;
+    CheckRejected(server_devices, 13, group, "malformed group: more devices than data");
+
+    std::vector<unsigned char> large_size = encoded;
+    unsigned int               colors_size = (unsigned int)encoded.size() + 1;
+
+    memcpy(&large_size[0], &colors_size, sizeof(colors_size));
+    CheckRejected(server_devices, 13, BuildGroup(NET_UPDATELEDSGROUP_FLAG_ENCODED, { 0 }, { large_size }), "malformed group: colors past the end of the packet");
+
+    std::vector<unsigned char> small_size = encoded;
+
+    colors_size = 4;
+    memcpy(&small_size[0], &colors_size, sizeof(colors_size));
+    CheckRejected(server_devices, 13, BuildGroup(NET_UPDATELEDSGROUP_FLAG_ENCODED, { 0 }, { small_size }), "malformed group: colors smaller than their header");
+
+    std::vector<unsigned char> large_count = plain;
+    unsigned int               num_colors  = controller_sizes[0] + 1;
+
+    memcpy(&large_count[sizeof(unsigned int)], &num_colors, sizeof(num_colors));
+    CheckRejected(server_devices, 12, BuildGroup(0, { 0 }, { large_count }), "malformed group: more colors than data");
+
+    CheckRejected(server_devices, 13, BuildGroup(NET_UPDATELEDSGROUP_FLAG_ENCODED, { 0 }, { too_long }), "malformed group: encoded runs past the last LED");
+
+    /*-----------------------------------------------------*\
+    | An unknown device index is skipped and the rest of    |
+    | the group is still applied                            |
+    \*-----------------------------------------------------*/
+    RawClient raw;
+
+    Check(raw.Connect(13), "unknown device: connected");
+
+    group = BuildGroup(NET_UPDATELEDSGROUP_FLAG_ENCODED, { NUM_CONTROLLERS, 0 }, { encoded, encoded });
+
+    raw.Send(NET_PACKET_ID_RGBCONTROLLER_UPDATELEDSGROUP, group.data(), (unsigned int)group.size());
+
+    Check(raw.Barrier(), "unknown device: connection kept");
+    Check(server_devices[0].colors == small_device.colors, "unknown device: known device updated");
+
+    raw.Close();
+}
+
+/*---------------------------------------------------------*\
+| Packets too short to hold the size or type field that     |
+| leads their data are ignored                              |
+\*---------------------------------------------------------*/
+static void TestShortPackets()
+{
+    RawClient       raw;
+    unsigned char   short_data[2] = { 0, 0 };
+
+    Check(raw.Connect(OPENRGB_SDK_PROTOCOL_VERSION), "short packets: connected");
+
+    raw.Send(NET_PACKET_ID_PLUGIN_SPECIFIC, NULL, 0);
+    raw.Send(NET_PACKET_ID_PLUGIN_SPECIFIC, short_data, sizeof(short_data));
+    raw.Send(NET_PACKET_ID_RGBCONTROLLER_ADDSEGMENT, NULL, 0);
+    raw.Send(NET_PACKET_ID_RGBCONTROLLER_ADDSEGMENT, short_data, sizeof(short_data));
+
+    Check(raw.Barrier(), "short packets: connection kept");
+
+    raw.Close();
+}
+
+/*---------------------------------------------------------*| A plugin callback that waits until it is released, to     |
+| stand in for a plugin request that blocks                 |
+\*---------------------------------------------------------*/
+static unsigned char* BlockingPluginCallback(void* callback_arg, unsigned int /*pkt_type*/, unsigned char* /*data*/, unsigned int* data_size)
+{
+    std::atomic<bool>* released = (std::atomic<bool>*)callback_arg;
+
+    WaitFor([released]{ return(released->load()); });
+
+    *data_size = 1;
+
+    return(new unsigned char[1]());
+}
+
+/*---------------------------------------------------------*| A blocked plugin request must not hold up other requests, |
+| and its reply is still sent once the plugin returns       |
+\*---------------------------------------------------------*/
+static void TestBlockingPlugin(std::atomic<bool>& released)
+{
+    RawClient       raw;
+    RawClient       other;
+    unsigned int    plugin_pkt_type = 1;
+
+    Check(raw.Connect(OPENRGB_SDK_PROTOCOL_VERSION), "blocking plugin: connected");
+    Check(other.Connect(OPENRGB_SDK_PROTOCOL_VERSION), "blocking plugin: other client connected");
+
+    raw.Send(NET_PACKET_ID_PLUGIN_SPECIFIC, &plugin_pkt_type, sizeof(plugin_pkt_type));
+
+    Check(raw.Barrier(), "blocking plugin: same client served while the plugin blocks");
+    Check(other.Barrier(), "blocking plugin: other client served while the plugin blocks");
+
+    released = true;
+
+    Check(raw.ReadReply(NET_PACKET_ID_PLUGIN_SPECIFIC), "blocking plugin: reply sent after the plugin returns");
+
+    other.Close();
+    raw.Close();
+}
+
+int main()
+{
+    RGBController_Dummy         server_devices[NUM_CONTROLLERS];
+    std::vector<RGBController*> server_controllers;
+
+    for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+    {
+        SetupController(server_devices[controller_idx], controller_sizes[controller_idx]);
+        server_controllers.push_back(&server_devices[controller_idx]);
+    }
+
+    /*-----------------------------------------------------*\
+    | A server device that tracks dirty ranges must not     |
+    | make its network controller skip repeated frames      |
+    \*-----------------------------------------------------*/
+    server_devices[0].flags |= CONTROLLER_FLAG_DIRTY_TRACKING;
+
+    NetworkServer       server(server_controllers);
+    NetworkPlugin       blocking_plugin;
+    std::atomic<bool>   plugin_released(false);
+
+    blocking_plugin.name             = "Blocking";
+    blocking_plugin.callback         = BlockingPluginCallback;
+    blocking_plugin.callback_arg     = &plugin_released;
+    blocking_plugin.protocol_version = 0;
+
+    server.RegisterPlugin(blocking_plugin);
+
+    server.SetHost(TEST_SERVER_HOST);
+    server.SetPort(TEST_SERVER_PORT);
+    server.StartServer();
+
+    if(!WaitFor([&server]{ return(server.GetListening()); }))
+    {
+        printf("FAIL server did not start listening on port %d\n", TEST_SERVER_PORT);
+        return(1);
+    }
+
+    std::vector<RGBController*> client_controllers;
+    NetworkClient               client(client_controllers);
+
+    client.SetIP(TEST_SERVER_HOST);
+    client.SetPort(TEST_SERVER_PORT);
+    client.StartClient();
+
+    if(!WaitFor([&client]{ return(client.GetOnline() && (client.server_controllers.size() == NUM_CONTROLLERS)); }))
+    {
+        printf("FAIL client did not connect\n");
+        server.StopServer();
+        return(1);
+    }
+
+    Check(client.GetProtocolVersion() == OPENRGB_SDK_PROTOCOL_VERSION, "client negotiated the current protocol");
+
+    for(unsigned int controller_idx = 0; controller_idx < NUM_CONTROLLERS; controller_idx++)
+    {
+        unsigned int client_flags = client.server_controllers[controller_idx]->flags;
+
+        Check((client_flags & CONTROLLER_FLAG_REMOTE) && !(client_flags & CONTROLLER_FLAG_DIRTY_TRACKING), "client controllers are remote without implementation flags");
+    }
+
+    TestClientGroup(client, server_devices);
+    TestRawGroup(server_devices);
+    TestMalformedGroups(server_devices);
+    TestShortPackets();
+    TestBlockingPlugin(plugin_released);
+
+    /*-----------------------------------------------------*\
+    | Malformed packets only disconnect their own client    |
+    \*-----------------------------------------------------*/
+    Check(client.GetOnline(), "client still online after malformed packets");
+
+    client.StopClient();
+    server.StopServer();
+
+    if(failures > 0)
+    {
+        printf("%u failures\n", failures);
+        return(1);
+    }
+
+    printf("PASS NetworkGroupUpdate\n");
+
+    return(0);
+}
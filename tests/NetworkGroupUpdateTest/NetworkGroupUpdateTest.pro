@@ -0,0 +1,27 @@
+#-----------------------------------------------------------------------------------------------#
+# NetworkGroupUpdateTest QMake Project                                                          #
+#                                                                                               #
+#   Round trips grouped LED updates between a NetworkClient and a NetworkServer                 #
+#-----------------------------------------------------------------------------------------------#
+include(../tests.pri)
+
+TARGET      = NetworkGroupUpdateTest
+
+#-----------------------------------------------------------------------------------------------#
+# hidapi.h is only needed for declarations, so the bundled copy is used on every platform       #
+#-----------------------------------------------------------------------------------------------#
+INCLUDEPATH +=                                                                                  \
+    $$OPENRGB_ROOT/dependencies/hidapi-win/include                                              \
+
+SOURCES +=                                                                                      \
+    NetworkGroupUpdateTest.cpp                                                                  \
+    ResourceManagerStub.cpp                                                                     \
+    $$OPENRGB_ROOT/NetworkClient.cpp                                                            \
+    $$OPENRGB_ROOT/NetworkProtocol.cpp                                                          \
+    $$OPENRGB_ROOT/NetworkServer.cpp                                                            \
+    $$OPENRGB_ROOT/net_port/net_port.cpp                                                        \
+    $$OPENRGB_ROOT/RGBController/RGBController_Network.cpp                                      \
+    $$RGBCONTROLLER_SOURCES                                                                     \
+
+win32:LIBS +=                                                                                   \
+    -lws2_32                                                                                    \
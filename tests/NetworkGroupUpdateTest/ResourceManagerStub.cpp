@@ -0,0 +1,23 @@
+/*---------------------------------------------------------*\
+| ResourceManagerStub.cpp                                   |
+|                                                           |
+|   Stands in for the ResourceManager functions that        |
+|   NetworkServer calls, so the server can be tested        |
+|   without detecting any devices.  The tests do not use    |
+|   frame group commits or rescans.                         |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include "ResourceManager.h"
+
+ResourceManager* ResourceManager::get()
+{
+    return(NULL);
+}
+
+void ResourceManager::RescanDevices()
+{
+
+}
@@ -0,0 +1,217 @@
+/*---------------------------------------------------------*\
+| RGBColorKernelsBenchmark.cpp                              |
+|                                                           |
+|   Times each RGBColorKernels kernel at every supported    |
+|   level for a range of frame sizes                        |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "RGBColorKernels.h"
+
+/*---------------------------------------------------------*\
+| Each measurement repeats the kernel for at least this     |
+| long and keeps the fastest of several runs                |
+\*---------------------------------------------------------*/
+#define BENCHMARK_RUN_US    20000
+#define BENCHMARK_RUNS      5
+
+enum
+{
+    KERNEL_PACK,
+    KERNEL_UNPACK,
+    KERNEL_PACK_PADDED,
+    KERNEL_SCALE,
+    KERNEL_LUT,
+    KERNEL_COUNT
+};
+
+static const char* kernel_names[KERNEL_COUNT] =
+{
+    "PackRGBColors",
+    "UnpackRGBColors",
+    "PackRGBColorsPadded",
+    "ScaleRGBColors",
+    "ApplyRGBColorLUT",
+};
+
+static const char* level_names[] =
+{
+    "scalar",
+    "128-bit",
+    "AVX2",
+};
+
+struct benchmark_buffers
+{
+    std::vector<RGBColor>       colors;
+    std::vector<RGBColor>       colors_out;
+    std::vector<unsigned char>  bytes;
+    std::vector<unsigned int>   lut;
+};
+
+static void RunKernel(unsigned int kernel, benchmark_buffers& buffers, std::size_t count)
+{
+    switch(kernel)
+    {
+        case KERNEL_PACK:
+            PackRGBColors(buffers.bytes.data(), buffers.colors.data(), count, RGB_ORDER_GRB);
+            break;
+
+        case KERNEL_UNPACK:
+            UnpackRGBColors(buffers.colors_out.data(), buffers.bytes.data(), count, RGB_ORDER_GRB);
+            break;
+
+        case KERNEL_PACK_PADDED:
+            PackRGBColorsPadded(buffers.bytes.data(), buffers.colors.data(), count, RGB_ORDER_BGR);
+            break;
+
+        case KERNEL_SCALE:
+            ScaleRGBColors(buffers.colors_out.data(), buffers.colors.data(), count, 200);
+            break;
+
+        case KERNEL_LUT:
+            ApplyRGBColorLUT(buffers.colors_out.data(), buffers.colors.data(), count, buffers.lut.data());
+            break;
+    }
+}
+
+/*---------------------------------------------------------*\
+| Returns the fastest time per LED in nanoseconds           |
+\*---------------------------------------------------------*/
+static double TimeKernel(unsigned int kernel, benchmark_buffers& buffers, std::size_t count)
+{
+    double best = 0.0;
+
+    for(unsigned int run_idx = 0; run_idx < BENCHMARK_RUNS; run_idx++)
+    {
+        std::chrono::steady_clock::time_point   start       = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point   end;
+        unsigned long long                      iterations  = 0;
+
+        do
+        {
+            for(unsigned int batch_idx = 0; batch_idx < 16; batch_idx++)
+            {
+                RunKernel(kernel, buffers, count);
+            }
+
+            iterations += 16;
+            end         = std::chrono::steady_clock::now();
+        } while(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() < BENCHMARK_RUN_US);
+
+        double ns_per_led = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / ((double)iterations * (double)count);
+
+        if((run_idx == 0) || (ns_per_led < best))
+        {
+            best = ns_per_led;
+        }
+    }
+
+    return(best);
+}
+
+int main()
+{
+    const std::size_t   counts[]    = { 15, 64, 300, 1024, 16384 };
+    const std::size_t   max_count   = 16384;
+
+    benchmark_buffers   buffers;
+    std::mt19937        rng(1);
+
+    buffers.colors.resize(max_count);
+    buffers.colors_out.resize(max_count);
+    buffers.bytes.resize(max_count * 4);
+    buffers.lut.resize(3 * 256);
+
+    for(std::size_t led_idx = 0; led_idx < max_count; led_idx++)
+    {
+        buffers.colors[led_idx] = (RGBColor)rng();
+    }
+
+    for(std::size_t byte_idx = 0; byte_idx < buffers.bytes.size(); byte_idx++)
+    {
+        buffers.bytes[byte_idx] = (unsigned char)rng();
+    }
+
+    for(unsigned int entry_idx = 0; entry_idx < 256; entry_idx++)
+    {
+        buffers.lut[  0 + entry_idx] = (rng() & 0xFF) << 0;
+        buffers.lut[256 + entry_idx] = (rng() & 0xFF) << 8;
+        buffers.lut[512 + entry_idx] = (rng() & 0xFF) << 16;
+    }
+
+    /*-----------------------------------------------------*\
+    | Find the supported levels                             |
+    \*-----------------------------------------------------*/
+    std::vector<unsigned int> levels;
+
+    for(unsigned int level = RGB_KERNELS_SCALAR; level <= RGB_KERNELS_AVX2; level++)
+    {
+        SetRGBColorKernelsLimit(level);
+
+        if(GetRGBColorKernelsLevel() == level)
+        {
+            levels.push_back(level);
+        }
+    }
+
+    printf("%-20s %6s", "kernel", "leds");
+
+    for(std::size_t level_idx = 0; level_idx < levels.size(); level_idx++)
+    {
+        printf(" %10s", level_names[levels[level_idx]]);
+    }
+
+    printf(" %8s\n", "speedup");
+
+    for(unsigned int kernel = 0; kernel < KERNEL_COUNT; kernel++)
+    {
+        for(std::size_t count_idx = 0; count_idx < (sizeof(counts) / sizeof(counts[0])); count_idx++)
+        {
+            double scalar_ns    = 0.0;
+            double best_ns      = 0.0;
+
+            printf("%-20s %6zu", kernel_names[kernel], counts[count_idx]);
+
+            for(std::size_t level_idx = 0; level_idx < levels.size(); level_idx++)
+            {
+                SetRGBColorKernelsLimit(levels[level_idx]);
+
+                double ns_per_led = TimeKernel(kernel, buffers, counts[count_idx]);
+
+                if(level_idx == 0)
+                {
+                    scalar_ns = ns_per_led;
+                }
+
+                best_ns = ns_per_led;
+
+                printf(" %8.3fns", ns_per_led);
+            }
+
+            printf(" %7.2fx\n", scalar_ns / best_ns);
+        }
+    }
+
+    SetRGBColorKernelsLimit(RGB_KERNELS_AVX2);
+
+    /*-----------------------------------------------------*\
+    | Use the outputs so the kernels are not optimized away |
+    \*-----------------------------------------------------*/
+    unsigned int checksum = 0;
+
+    for(std::size_t led_idx = 0; led_idx < max_count; led_idx++)
+    {
+        checksum ^= buffers.colors_out[led_idx] ^ buffers.bytes[led_idx];
+    }
+
+    printf("checksum %08X\n", checksum);
+
+    return(0);
+}
@@ -0,0 +1,17 @@
+#-----------------------------------------------------------------------------------------------#
+# RGBColorKernelsBenchmark QMake Project                                                        #
+#                                                                                               #
+#   Times the RGBColorKernels kernels at every supported level                                  #
+#-----------------------------------------------------------------------------------------------#
+include(../tests.pri)
+
+TARGET      = RGBColorKernelsBenchmark
+
+SOURCES +=                                                                                      \
+    RGBColorKernelsBenchmark.cpp                                                                \
+    $$OPENRGB_ROOT/RGBController/RGBColorKernels.cpp                                            \
+
+#-----------------------------------------------------------------------------------------------#
+# Benchmarks are always built with optimizations                                                #
+#-----------------------------------------------------------------------------------------------#
+CONFIG += release
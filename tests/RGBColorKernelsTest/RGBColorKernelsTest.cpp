@@ -0,0 +1,293 @@
+/*---------------------------------------------------------*\
+| RGBColorKernelsTest.cpp                                   |
+|                                                           |
+|   Checks every RGBColorKernels level against a plain      |
+|   reference implementation, including tail lengths that   |
+|   are not a multiple of the vector width                  |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "RGBColorKernels.h"
+
+/*---------------------------------------------------------*\
+| Guard bytes written after each output buffer, which no    |
+| kernel may overwrite                                      |
+\*---------------------------------------------------------*/
+#define GUARD_SIZE      64
+#define GUARD_BYTE      0xA5
+
+static const char* level_names[] =
+{
+    "scalar",
+    "128-bit",
+    "AVX2",
+};
+
+static const unsigned char order_channels[6][3] =
+{
+    { 0, 1, 2 },    /* RGB */
+    { 0, 2, 1 },    /* RBG */
+    { 1, 0, 2 },    /* GRB */
+    { 1, 2, 0 },    /* GBR */
+    { 2, 0, 1 },    /* BRG */
+    { 2, 1, 0 },    /* BGR */
+};
+
+static unsigned int failures = 0;
+
+/*---------------------------------------------------------*\
+| Reference implementations, written independently of the   |
+| kernels                                                   |
+\*---------------------------------------------------------*/
+static unsigned char RefChannel(RGBColor color, unsigned int channel)
+{
+    return((unsigned char)((color >> (8 * channel)) & 0xFF));
+}
+
+static unsigned char RefScale(unsigned int value, unsigned int scale)
+{
+    return((unsigned char)(((value * scale) + 127) / 255));
+}
+
+static void RefPack(unsigned char* dst, const RGBColor* src, std::size_t count, unsigned int order, unsigned int stride)
+{
+    for(std::size_t led_idx = 0; led_idx < count; led_idx++)
+    {
+        for(unsigned int byte_idx = 0; byte_idx < 3; byte_idx++)
+        {
+            dst[(led_idx * stride) + byte_idx] = RefChannel(src[led_idx], order_channels[order][byte_idx]);
+        }
+
+        if(stride == 4)
+        {
+            dst[(led_idx * stride) + 3] = 0;
+        }
+    }
+}
+
+static void RefUnpack(RGBColor* dst, const unsigned char* src, std::size_t count, unsigned int order)
+{
+    for(std::size_t led_idx = 0; led_idx < count; led_idx++)
+    {
+        dst[led_idx] = 0;
+
+        for(unsigned int byte_idx = 0; byte_idx < 3; byte_idx++)
+        {
+            dst[led_idx] |= (RGBColor)src[(led_idx * 3) + byte_idx] << (8 * order_channels[order][byte_idx]);
+        }
+    }
+}
+
+static void RefScaleColors(RGBColor* dst, const RGBColor* src, std::size_t count, unsigned char scale)
+{
+    for(std::size_t led_idx = 0; led_idx < count; led_idx++)
+    {
+        dst[led_idx] = 0;
+
+        for(unsigned int channel = 0; channel < 4; channel++)
+        {
+            dst[led_idx] |= (RGBColor)RefScale(RefChannel(src[led_idx], channel), scale) << (8 * channel);
+        }
+    }
+}
+
+static void RefApplyLUT(RGBColor* dst, const RGBColor* src, std::size_t count, const unsigned int* lut)
+{
+    for(std::size_t led_idx = 0; led_idx < count; led_idx++)
+    {
+        dst[led_idx] = lut[  0 + RefChannel(src[led_idx], 0)]
+                     | lut[256 + RefChannel(src[led_idx], 1)]
+                     | lut[512 + RefChannel(src[led_idx], 2)];
+    }
+}
+
+/*---------------------------------------------------------*\
+| Compare an output buffer against the expected result and  |
+| check that the guard bytes after it are untouched         |
+\*---------------------------------------------------------*/
+static void Check(const char* kernel, unsigned int level, std::size_t count, std::size_t offset, unsigned int param, const void* result, const void* expected, std::size_t size)
+{
+    const unsigned char* guard = (const unsigned char*)result + size;
+    bool                 ok    = (memcmp(result, expected, size) == 0);
+
+    for(std::size_t guard_idx = 0; guard_idx < GUARD_SIZE; guard_idx++)
+    {
+        if(guard[guard_idx] != GUARD_BYTE)
+        {
+            ok = false;
+        }
+    }
+
+    if(!ok)
+    {
+        printf("FAIL %s %s count %zu offset %zu param %u\n", kernel, level_names[level], count, offset, param);
+        failures++;
+    }
+}
+
+static void TestLevel(unsigned int level, const std::vector<std::size_t>& counts)
+{
+    std::mt19937                rng(level + 1);
+    std::vector<unsigned int>   lut(3 * 256);
+
+    for(unsigned int entry_idx = 0; entry_idx < 256; entry_idx++)
+    {
+        lut[  0 + entry_idx] = (rng() & 0xFF) << 0;
+        lut[256 + entry_idx] = (rng() & 0xFF) << 8;
+        lut[512 + entry_idx] = (rng() & 0xFF) << 16;
+    }
+
+    for(std::size_t count_idx = 0; count_idx < counts.size(); count_idx++)
+    {
+        std::size_t count = counts[count_idx];
+
+        /*-------------------------------------------------*\
+        | Start the buffers at several element offsets so   |
+        | the kernels also see unaligned pointers.  Each    |
+        | buffer has one spare element so that it is never  |
+        | empty.                                            |
+        \*-------------------------------------------------*/
+        for(std::size_t offset = 0; offset < 4; offset++)
+        {
+            std::vector<RGBColor>       src_buf(offset + count + 1);
+            std::vector<unsigned char>  bytes_buf(offset + (count * 3) + 1);
+            RGBColor*                   src         = src_buf.data() + offset;
+            unsigned char*              bytes       = bytes_buf.data() + offset;
+
+            for(std::size_t led_idx = 0; led_idx < count; led_idx++)
+            {
+                src[led_idx] = (RGBColor)rng();
+            }
+
+            for(std::size_t byte_idx = 0; byte_idx < (count * 3); byte_idx++)
+            {
+                bytes[byte_idx] = (unsigned char)rng();
+            }
+
+            for(unsigned int order = RGB_ORDER_RGB; order <= RGB_ORDER_BGR; order++)
+            {
+                std::vector<unsigned char>  packed((offset + (count * 4) + GUARD_SIZE), GUARD_BYTE);
+                std::vector<unsigned char>  packed_ref((count * 4) + 1);
+                std::vector<RGBColor>       unpacked(offset + count + (GUARD_SIZE / sizeof(RGBColor)));
+                std::vector<RGBColor>       unpacked_ref(count + 1);
+
+                PackRGBColors(packed.data() + offset, src, count, order);
+                RefPack(packed_ref.data(), src, count, order, 3);
+                Check("PackRGBColors", level, count, offset, order, packed.data() + offset, packed_ref.data(), count * 3);
+
+                std::fill(packed.begin(), packed.end(), GUARD_BYTE);
+
+                PackRGBColorsPadded(packed.data() + offset, src, count, order);
+                RefPack(packed_ref.data(), src, count, order, 4);
+                Check("PackRGBColorsPadded", level, count, offset, order, packed.data() + offset, packed_ref.data(), count * 4);
+
+                memset(unpacked.data(), GUARD_BYTE, unpacked.size() * sizeof(RGBColor));
+
+                UnpackRGBColors(unpacked.data() + offset, bytes, count, order);
+                RefUnpack(unpacked_ref.data(), bytes, count, order);
+                Check("UnpackRGBColors", level, count, offset, order, unpacked.data() + offset, unpacked_ref.data(), count * sizeof(RGBColor));
+            }
+
+            const unsigned char scales[] = { 0, 1, 127, 128, 254, 255 };
+
+            for(std::size_t scale_idx = 0; scale_idx < sizeof(scales); scale_idx++)
+            {
+                std::vector<RGBColor> scaled(offset + count + (GUARD_SIZE / sizeof(RGBColor)));
+                std::vector<RGBColor> scaled_ref(count + 1);
+
+                memset(scaled.data(), GUARD_BYTE, scaled.size() * sizeof(RGBColor));
+
+                ScaleRGBColors(scaled.data() + offset, src, count, scales[scale_idx]);
+                RefScaleColors(scaled_ref.data(), src, count, scales[scale_idx]);
+                Check("ScaleRGBColors", level, count, offset, scales[scale_idx], scaled.data() + offset, scaled_ref.data(), count * sizeof(RGBColor));
+
+                /*---------------------------------------------*\
+                | In place, as used for brightness scaling      |
+                \*---------------------------------------------*/
+                memcpy(scaled.data() + offset, src, count * sizeof(RGBColor));
+
+                ScaleRGBColors(scaled.data() + offset, scaled.data() + offset, count, scales[scale_idx]);
+                Check("ScaleRGBColors in place", level, count, offset, scales[scale_idx], scaled.data() + offset, scaled_ref.data(), count * sizeof(RGBColor));
+            }
+
+            std::vector<RGBColor> mapped(offset + count + (GUARD_SIZE / sizeof(RGBColor)));
+            std::vector<RGBColor> mapped_ref(count + 1);
+
+            memset(mapped.data(), GUARD_BYTE, mapped.size() * sizeof(RGBColor));
+
+            ApplyRGBColorLUT(mapped.data() + offset, src, count, lut.data());
+            RefApplyLUT(mapped_ref.data(), src, count, lut.data());
+            Check("ApplyRGBColorLUT", level, count, offset, 0, mapped.data() + offset, mapped_ref.data(), count * sizeof(RGBColor));
+
+            /*-------------------------------------------------*\
+            | In place, as used for color correction            |
+            \*-------------------------------------------------*/
+            memcpy(mapped.data() + offset, src, count * sizeof(RGBColor));
+
+            ApplyRGBColorLUT(mapped.data() + offset, mapped.data() + offset, count, lut.data());
+            Check("ApplyRGBColorLUT in place", level, count, offset, 0, mapped.data() + offset, mapped_ref.data(), count * sizeof(RGBColor));
+        }
+    }
+}
+
+int main()
+{
+    /*-----------------------------------------------------*\
+    | Every length up to several vector widths, so each     |
+    | tail length is covered, plus some larger frames       |
+    \*-----------------------------------------------------*/
+    std::vector<std::size_t> counts;
+
+    for(std::size_t count = 0; count <= 80; count++)
+    {
+        counts.push_back(count);
+    }
+
+    counts.push_back(255);
+    counts.push_back(256);
+    counts.push_back(257);
+    counts.push_back(1021);
+    counts.push_back(1024);
+
+    unsigned int levels_tested = 0;
+
+    for(unsigned int level = RGB_KERNELS_SCALAR; level <= RGB_KERNELS_AVX2; level++)
+    {
+        SetRGBColorKernelsLimit(level);
+
+        /*-------------------------------------------------*\
+        | Skip levels the CPU does not support              |
+        \*-------------------------------------------------*/
+        if(GetRGBColorKernelsLevel() != level)
+        {
+            printf("SKIP %s, not supported\n", level_names[level]);
+            continue;
+        }
+
+        unsigned int failures_before = failures;
+
+        TestLevel(level, counts);
+
+        levels_tested++;
+
+        printf("%s %s\n", (failures == failures_before) ? "PASS" : "FAIL", level_names[level]);
+    }
+
+    SetRGBColorKernelsLimit(RGB_KERNELS_AVX2);
+
+    if(failures > 0)
+    {
+        printf("%u failures\n", failures);
+        return(1);
+    }
+
+    printf("All %u kernel levels match the reference\n", levels_tested);
+
+    return(0);
+}
@@ -0,0 +1,12 @@
+#-----------------------------------------------------------------------------------------------#
+# RGBColorKernelsTest QMake Project                                                             #
+#                                                                                               #
+#   Checks every RGBColorKernels level against a reference implementation                       #
+#-----------------------------------------------------------------------------------------------#
+include(../tests.pri)
+
+TARGET      = RGBColorKernelsTest
+
+SOURCES +=                                                                                      \
+    RGBColorKernelsTest.cpp                                                                     \
+    $$OPENRGB_ROOT/RGBController/RGBColorKernels.cpp                                            \
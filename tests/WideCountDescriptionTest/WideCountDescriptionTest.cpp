@@ -0,0 +1,415 @@
+/*---------------------------------------------------------*\
+| WideCountDescriptionTest.cpp                              |
+|                                                           |
+|   Round trips device, color, and zone color descriptions  |
+|   at protocol versions with 16 and 32 bit counts,         |
+|   including controllers with more than 65535 LEDs, and    |
+|   checks the controller flags that are sent               |
+|                                                           |
+|   This file is part of the OpenRGB project                |
+|   SPDX-License-Identifier: GPL-2.0-or-later               |
+\*---------------------------------------------------------*/
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "NetworkProtocol.h"
+#include "RGBController_Dummy.h"
+
+/*---------------------------------------------------------*\
+| The wide controller has a linear zone and a matrix zone   |
+| whose map is too large for a 16 bit size                  |
+\*---------------------------------------------------------*/
+#define WIDE_LINEAR_LEDS    50000
+#define WIDE_MATRIX_HEIGHT  100
+#define WIDE_MATRIX_WIDTH   200
+#define WIDE_LEDS           (WIDE_LINEAR_LEDS + (WIDE_MATRIX_HEIGHT * WIDE_MATRIX_WIDTH))
+#define SMALL_LEDS          300
+
+/*---------------------------------------------------------*\
+| The last protocol version with 16 bit counts              |
+\*---------------------------------------------------------*/
+#define LEGACY_PROTOCOL_VERSION 6
+
+static unsigned int failures = 0;
+
+static void Check(bool ok, const char* description)
+{
+    if(!ok)
+    {
+        printf("FAIL %s\n", description);
+        failures++;
+    }
+}
+
+static unsigned int CountSize(unsigned int protocol_version)
+{
+    return((protocol_version > LEGACY_PROTOCOL_VERSION) ? sizeof(unsigned int) : sizeof(unsigned short));
+}
+
+static void AddLEDs(RGBController_Dummy& controller, unsigned int num_leds)
+{
+    for(unsigned int led_idx = 0; led_idx < num_leds; led_idx++)
+    {
+        led new_led;
+
+        new_led.name  = "LED " + std::to_string(controller.leds.size());
+        new_led.value = (unsigned int)controller.leds.size();
+
+        controller.leds.push_back(new_led);
+    }
+}
+
+static void SetupController(RGBController_Dummy& controller, unsigned int linear_leds, bool with_matrix)
+{
+    mode new_mode;
+
+    new_mode.name       = "Direct";
+    new_mode.flags      = MODE_FLAG_HAS_PER_LED_COLOR;
+    new_mode.color_mode = MODE_COLORS_PER_LED;
+
+    controller.name = "Dummy";
+    controller.modes.push_back(new_mode);
+
+    zone linear_zone;
+
+    linear_zone.name       = "Linear";
+    linear_zone.type       = ZONE_TYPE_LINEAR;
+    linear_zone.leds_min   = linear_leds;
+    linear_zone.leds_max   = linear_leds;
+    linear_zone.leds_count = linear_leds;
+    linear_zone.matrix_map = NULL;
+
+    controller.zones.push_back(linear_zone);
+
+    AddLEDs(controller, linear_leds);
+
+    if(with_matrix)
+    {
+        zone matrix_zone;
+
+        matrix_zone.name               = "Matrix";
+        matrix_zone.type               = ZONE_TYPE_MATRIX;
+        matrix_zone.leds_min           = WIDE_MATRIX_HEIGHT * WIDE_MATRIX_WIDTH;
+        matrix_zone.leds_max           = WIDE_MATRIX_HEIGHT * WIDE_MATRIX_WIDTH;
+        matrix_zone.leds_count         = WIDE_MATRIX_HEIGHT * WIDE_MATRIX_WIDTH;
+        matrix_zone.matrix_map         = new matrix_map_type;
+        matrix_zone.matrix_map->height = WIDE_MATRIX_HEIGHT;
+        matrix_zone.matrix_map->width  = WIDE_MATRIX_WIDTH;
+        matrix_zone.matrix_map->map    = new unsigned int[WIDE_MATRIX_HEIGHT * WIDE_MATRIX_WIDTH];
+
+        for(unsigned int map_idx = 0; map_idx < (WIDE_MATRIX_HEIGHT * WIDE_MATRIX_WIDTH); map_idx++)
+        {
+            matrix_zone.matrix_map->map[map_idx] = (map_idx % 7) ? map_idx : 0xFFFFFFFF;
+        }
+
+        controller.zones.push_back(matrix_zone);
+
+        AddLEDs(controller, WIDE_MATRIX_HEIGHT * WIDE_MATRIX_WIDTH);
+    }
+
+    controller.SetupColors();
+
+    std::mt19937                rng((unsigned int)controller.leds.size());
+    std::vector<led_position>   positions(controller.leds.size());
+
+    for(std::size_t led_idx = 0; led_idx < controller.leds.size(); led_idx++)
+    {
+        controller.colors[led_idx] = (RGBColor)rng();
+        controller.led_alt_names.push_back("Alt " + std::to_string(led_idx));
+
+        positions[led_idx].x = (float)led_idx;
+        positions[led_idx].y = (float)(led_idx % 100);
+        positions[led_idx].z = 0.5f;
+    }
+
+    controller.SetLEDPositions(positions);
+}
+
+/*---------------------------------------------------------*\
+| The receiving side of a device description does not own   |
+| the matrix maps it creates                                |
+\*---------------------------------------------------------*/
+static void FreeMatrixMaps(RGBController_Dummy& controller)
+{
+    for(std::size_t zone_idx = 0; zone_idx < controller.zones.size(); zone_idx++)
+    {
+        if(controller.zones[zone_idx].matrix_map != NULL)
+        {
+            delete[] controller.zones[zone_idx].matrix_map->map;
+            delete controller.zones[zone_idx].matrix_map;
+
+            controller.zones[zone_idx].matrix_map = NULL;
+        }
+    }
+}
+
+static bool SameZones(RGBController_Dummy& sender, RGBController_Dummy& receiver)
+{
+    if(sender.zones.size() != receiver.zones.size())
+    {
+        return(false);
+    }
+
+    for(std::size_t zone_idx = 0; zone_idx < sender.zones.size(); zone_idx++)
+    {
+        zone& sent     = sender.zones[zone_idx];
+        zone& received = receiver.zones[zone_idx];
+
+        if((sent.name != received.name)
+        || (sent.type != received.type)
+        || (sent.leds_count != received.leds_count)
+        || ((sent.matrix_map == NULL) != (received.matrix_map == NULL)))
+        {
+            return(false);
+        }
+
+        if(sent.matrix_map != NULL)
+        {
+            unsigned int map_size = sent.matrix_map->height * sent.matrix_map->width;
+
+            if((sent.matrix_map->height != received.matrix_map->height)
+            || (sent.matrix_map->width != received.matrix_map->width)
+            || (memcmp(sent.matrix_map->map, received.matrix_map->map, map_size * sizeof(unsigned int)) != 0))
+            {
+                return(false);
+            }
+        }
+    }
+
+    return(true);
+}
+
+static bool SameLEDs(RGBController_Dummy& sender, RGBController_Dummy& receiver)
+{
+    if(sender.leds.size() != receiver.leds.size())
+    {
+        return(false);
+    }
+
+    for(std::size_t led_idx = 0; led_idx < sender.leds.size(); led_idx++)
+    {
+        if((sender.leds[led_idx].name != receiver.leds[led_idx].name)
+        || (sender.leds[led_idx].value != receiver.leds[led_idx].value))
+        {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+static bool SamePositions(RGBController_Dummy& sender, RGBController_Dummy& receiver)
+{
+    if(sender.led_positions.size() != receiver.led_positions.size())
+    {
+        return(false);
+    }
+
+    for(std::size_t led_idx = 0; led_idx < sender.led_positions.size(); led_idx++)
+    {
+        if((sender.led_positions[led_idx].x != receiver.led_positions[led_idx].x)
+        || (sender.led_positions[led_idx].y != receiver.led_positions[led_idx].y)
+        || (sender.led_positions[led_idx].z != receiver.led_positions[led_idx].z))
+        {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+/*---------------------------------------------------------*\
+| Send a device description and read it into a new          |
+| controller, as the SDK client does                        |
+\*---------------------------------------------------------*/
+static void TestDeviceDescription(RGBController_Dummy& sender, unsigned int protocol_version, const char* description)
+{
+    std::vector<unsigned char>  data;
+    unsigned int                size = sender.GetDeviceDescription(data, protocol_version);
+    RGBController_Dummy         receiver;
+    unsigned int                sent_size = 0;
+
+    memcpy(&sent_size, data.data(), sizeof(sent_size));
+
+    Check((size == data.size()) && (sent_size == size), description);
+
+    receiver.ReadDeviceDescription(data.data(), protocol_version);
+
+    Check(receiver.name == sender.name, description);
+    Check(receiver.modes.size() == sender.modes.size(), description);
+    Check(SameZones(sender, receiver), description);
+    Check(SameLEDs(sender, receiver), description);
+    Check(receiver.colors == sender.colors, description);
+
+    if(protocol_version >= 5)
+    {
+        Check(receiver.led_alt_names == sender.led_alt_names, description);
+    }
+
+    if(protocol_version >= 9)
+    {
+        Check(SamePositions(sender, receiver), description);
+    }
+
+    FreeMatrixMaps(receiver);
+}
+
+static void TestColorDescription(RGBController_Dummy& sender, RGBController_Dummy& receiver, unsigned int protocol_version, const char* description)
+{
+    std::vector<unsigned char>  data;
+    unsigned int                size = sender.GetColorDescription(data, protocol_version);
+
+    Check(size == (sizeof(unsigned int) + CountSize(protocol_version) + (sender.colors.size() * sizeof(RGBColor))), description);
+    Check(size == data.size(), description);
+
+    std::fill(receiver.colors.begin(), receiver.colors.end(), 0);
+
+    receiver.SetColorDescription(data.data(), protocol_version);
+
+    Check(receiver.colors == sender.colors, description);
+}
+
+static void TestZoneColorDescription(RGBController_Dummy& sender, RGBController_Dummy& receiver, int zone_idx, unsigned int protocol_version, const char* description)
+{
+    std::vector<unsigned char>  data;
+    unsigned int                size        = sender.GetZoneColorDescription(data, zone_idx, protocol_version);
+    unsigned int                leds_count  = sender.zones[zone_idx].leds_count;
+
+    Check(size == (sizeof(unsigned int) + sizeof(int) + CountSize(protocol_version) + (leds_count * sizeof(RGBColor))), description);
+
+    std::fill(receiver.colors.begin(), receiver.colors.end(), 0);
+
+    receiver.SetZoneColorDescription(data.data(), protocol_version);
+
+    Check(memcmp(receiver.zones[zone_idx].colors, sender.zones[zone_idx].colors, leds_count * sizeof(RGBColor)) == 0, description);
+}
+
+/*---------------------------------------------------------*\
+| The color description functions without a protocol        |
+| version send the same bytes as protocol 6                 |
+\*---------------------------------------------------------*/
+static void TestLegacySignatures(RGBController_Dummy& sender, RGBController_Dummy& receiver)
+{
+    std::vector<unsigned char>  data;
+    unsigned int                size        = sender.GetColorDescription(data, LEGACY_PROTOCOL_VERSION);
+    unsigned char*              legacy      = sender.GetColorDescription();
+
+    Check(memcmp(legacy, data.data(), size) == 0, "legacy color description: same bytes as protocol 6");
+
+    std::fill(receiver.colors.begin(), receiver.colors.end(), 0);
+
+    receiver.SetColorDescription(legacy);
+
+    Check(receiver.colors == sender.colors, "legacy color description: round trip");
+
+    delete[] legacy;
+
+    size   = sender.GetZoneColorDescription(data, 0, LEGACY_PROTOCOL_VERSION);
+    legacy = sender.GetZoneColorDescription(0);
+
+    Check(memcmp(legacy, data.data(), size) == 0, "legacy zone color description: same bytes as protocol 6");
+
+    std::fill(receiver.colors.begin(), receiver.colors.end(), 0);
+
+    receiver.SetZoneColorDescription(legacy);
+
+    Check(receiver.colors == sender.colors, "legacy zone color description: round trip");
+
+    delete[] legacy;
+}
+
+/*---------------------------------------------------------*\
+| At protocol 6 the count of a wide controller is cut to    |
+| its low 16 bits, but the size must still match the data   |
+\*---------------------------------------------------------*/
+static void TestLegacyWideCount(RGBController_Dummy& sender, RGBController_Dummy& receiver)
+{
+    std::vector<unsigned char>  data;
+    unsigned int                size        = sender.GetColorDescription(data, LEGACY_PROTOCOL_VERSION);
+    unsigned short              num_colors  = 0;
+
+    memcpy(&num_colors, &data[sizeof(unsigned int)], sizeof(num_colors));
+
+    Check(num_colors == (unsigned short)WIDE_LEDS, "protocol 6 wide colors: count is the low 16 bits");
+    Check(size == (sizeof(unsigned int) + sizeof(unsigned short) + (num_colors * sizeof(RGBColor))), "protocol 6 wide colors: size matches the count");
+
+    std::fill(receiver.colors.begin(), receiver.colors.end(), 0);
+
+    receiver.SetColorDescription(data.data(), LEGACY_PROTOCOL_VERSION);
+
+    Check(memcmp(receiver.colors.data(), sender.colors.data(), num_colors * sizeof(RGBColor)) == 0, "protocol 6 wide colors: counted colors applied");
+}
+
+/*---------------------------------------------------------*\
+| Flags that only describe how the sending instance drives  |
+| the device are not sent                                   |
+\*---------------------------------------------------------*/
+static void TestImplementationFlags(RGBController_Dummy& sender)
+{
+    unsigned int                sent_flags  = CONTROLLER_FLAG_LOCAL | CONTROLLER_FLAG_RESET_BEFORE_UPDATE;
+    unsigned int                saved_flags = sender.flags;
+    std::vector<unsigned char>  data;
+    RGBController_Dummy         receiver;
+
+    sender.flags = sent_flags | CONTROLLER_FLAGS_IMPLEMENTATION;
+
+    sender.GetDeviceDescription(data, OPENRGB_SDK_PROTOCOL_VERSION);
+    receiver.ReadDeviceDescription(data.data(), OPENRGB_SDK_PROTOCOL_VERSION);
+
+    Check(receiver.flags == sent_flags, "device description: implementation flags not sent");
+    Check(sender.flags == (sent_flags | CONTROLLER_FLAGS_IMPLEMENTATION), "device description: sender flags unchanged");
+
+    sender.flags = saved_flags;
+}
+
+int main()
+{
+    RGBController_Dummy wide_sender;
+    RGBController_Dummy wide_receiver;
+    RGBController_Dummy small_sender;
+    RGBController_Dummy small_receiver;
+
+    SetupController(wide_sender, WIDE_LINEAR_LEDS, true);
+    SetupController(wide_receiver, WIDE_LINEAR_LEDS, true);
+    SetupController(small_sender, SMALL_LEDS, false);
+    SetupController(small_receiver, SMALL_LEDS, false);
+
+    Check(wide_sender.leds.size() > 65535, "wide controller has more than 65535 LEDs");
+    Check(wide_sender.led_positions.size() == wide_sender.leds.size(), "wide controller has LED positions");
+
+    TestDeviceDescription(wide_sender, 7, "protocol 7 wide device description");
+    TestDeviceDescription(wide_sender, OPENRGB_SDK_PROTOCOL_VERSION, "current protocol wide device description");
+    TestDeviceDescription(small_sender, LEGACY_PROTOCOL_VERSION, "protocol 6 device description");
+    TestDeviceDescription(small_sender, 7, "protocol 7 device description");
+    TestDeviceDescription(small_sender, OPENRGB_SDK_PROTOCOL_VERSION, "current protocol device description");
+
+    TestColorDescription(wide_sender, wide_receiver, 7, "protocol 7 wide color description");
+    TestColorDescription(wide_sender, wide_receiver, OPENRGB_SDK_PROTOCOL_VERSION, "current protocol wide color description");
+    TestColorDescription(small_sender, small_receiver, LEGACY_PROTOCOL_VERSION, "protocol 6 color description");
+    TestColorDescription(small_sender, small_receiver, 7, "protocol 7 color description");
+    TestColorDescription(small_sender, small_receiver, OPENRGB_SDK_PROTOCOL_VERSION, "current protocol color description");
+
+    TestZoneColorDescription(wide_sender, wide_receiver, 0, 7, "protocol 7 wide zone color description");
+    TestZoneColorDescription(wide_sender, wide_receiver, 1, OPENRGB_SDK_PROTOCOL_VERSION, "current protocol matrix zone color description");
+    TestZoneColorDescription(small_sender, small_receiver, 0, LEGACY_PROTOCOL_VERSION, "protocol 6 zone color description");
+    TestZoneColorDescription(small_sender, small_receiver, 0, OPENRGB_SDK_PROTOCOL_VERSION, "current protocol zone color description");
+
+    TestImplementationFlags(small_sender);
+    TestLegacySignatures(small_sender, small_receiver);
+    TestLegacyWideCount(wide_sender, wide_receiver);
+
+    FreeMatrixMaps(wide_sender);
+    FreeMatrixMaps(wide_receiver);
+
+    if(failures > 0)
+    {
+        printf("%u failures\n", failures);
+        return(1);
+    }
+
+    printf("PASS WideCountDescription\n");
+
+    return(0);
+}
@@ -0,0 +1,12 @@
+#-----------------------------------------------------------------------------------------------#
+# WideCountDescriptionTest QMake Project                                                        #
+#                                                                                               #
+#   Round trips descriptions with 16 and 32 bit counts, including more than 65535 LEDs          #
+#-----------------------------------------------------------------------------------------------#
+include(../tests.pri)
+
+TARGET      = WideCountDescriptionTest
+
+SOURCES +=                                                                                      \
+    WideCountDescriptionTest.cpp                                                                \
+    $$RGBCONTROLLER_SOURCES                                                                     \
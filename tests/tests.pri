@@ -0,0 +1,54 @@
+#-----------------------------------------------------------------------------------------------#
+# OpenRGB tests shared QMake configuration                                                      #
+#                                                                                               #
+#   Included by each test and benchmark project                                                 #
+#-----------------------------------------------------------------------------------------------#
+
+#-----------------------------------------------------------------------------------------------#
+# Plain console applications without Qt                                                         #
+#-----------------------------------------------------------------------------------------------#
+CONFIG +=   c++17                                                                               \
+            console                                                                             \
+
+CONFIG -=   qt                                                                                  \
+            app_bundle                                                                          \
+
+TEMPLATE    = app
+
+#-----------------------------------------------------------------------------------------------#
+# Paths relative to the repository root                                                         #
+#-----------------------------------------------------------------------------------------------#
+OPENRGB_ROOT = $$PWD/..
+
+INCLUDEPATH +=                                                                                  \
+    $$OPENRGB_ROOT                                                                              \
+    $$OPENRGB_ROOT/RGBController                                                                \
+    $$OPENRGB_ROOT/dependencies/json                                                            \
+    $$OPENRGB_ROOT/net_port                                                                     \
+    $$OPENRGB_ROOT/i2c_smbus                                                                    \
+    $$OPENRGB_ROOT/hidapi_wrapper                                                               \
+    $$OPENRGB_ROOT/SPDAccessor                                                                  \
+    $$OPENRGB_ROOT/KeyboardLayoutManager                                                        \
+
+#-----------------------------------------------------------------------------------------------#
+# Version strings used by the SDK protocol and log sources                                      #
+#-----------------------------------------------------------------------------------------------#
+DEFINES +=                                                                                      \
+    VERSION_STRING=\\"\"\"test\\"\"\"                                                           \
+    BUILDDATE_STRING=\\"\"\"test\\"\"\"                                                         \
+    GIT_COMMIT_ID=\\"\"\"test\\"\"\"                                                            \
+    GIT_COMMIT_DATE=\\"\"\"test\\"\"\"                                                          \
+    GIT_BRANCH=\\"\"\"test\\"\"\"                                                               \
+
+#-----------------------------------------------------------------------------------------------#
+# Sources needed by tests that create RGBControllers                                            #
+#-----------------------------------------------------------------------------------------------#
+RGBCONTROLLER_SOURCES =                                                                         \
+    $$OPENRGB_ROOT/LogManager.cpp                                                               \
+    $$OPENRGB_ROOT/RGBController/RGBColorKernels.cpp                                            \
+    $$OPENRGB_ROOT/RGBController/RGBController.cpp                                              \
+    $$OPENRGB_ROOT/RGBController/RGBController_Dummy.cpp                                        \
+    $$OPENRGB_ROOT/RGBController/RGBControllerIdleMonitor.cpp                                   \
+    $$OPENRGB_ROOT/RGBController/RGBControllerWorkerPool.cpp                                    \
+
+unix:LIBS += -lpthread
@@ -0,0 +1,14 @@
+#-----------------------------------------------------------------------------------------------#
+# OpenRGB Tests QMake Project                                                                   #
+#                                                                                               #
+#   Builds the tests and benchmarks.  See README.md for how to run them.                        #
+#-----------------------------------------------------------------------------------------------#
+TEMPLATE    = subdirs
+
+SUBDIRS +=                                                                                      \
+    RGBColorKernelsTest                                                                         \
+    RGBColorKernelsBenchmark                                                                    \
+    NetPacketReaderTest                                                                         \
+    EncodedColorDescriptionTest                                                                 \
+    NetworkGroupUpdateTest                                                                      \
+    WideCountDescriptionTest                                                                    \